@@ -358,10 +358,11 @@ void FetchResult<T>::SetAssetUri(FileAsset *fileAsset)
 }
 
 template<class T>
-void FetchResult<T>::SetFileAsset(FileAsset *fileAsset, shared_ptr<NativeRdb::ResultSet> &resultSet)
+void FetchResult<T>::ResolveFileAssetSchema(shared_ptr<NativeRdb::ResultSet> &resultSet)
 {
-    if ((resultset_ == nullptr) && (resultSet == nullptr)) {
-        MEDIA_ERR_LOG("SetFileAsset fail, result is nullptr");
+    bool isSameResultSet = (resultSet == nullptr) ? !isRdbSchema_ :
+        (isRdbSchema_ && (schemaResultSet_.lock() == resultSet));
+    if ((fileAssetSchema_ != nullptr) && isSameResultSet) {
         return;
     }
     vector<string> columnNames;
@@ -370,19 +371,42 @@ void FetchResult<T>::SetFileAsset(FileAsset *fileAsset, shared_ptr<NativeRdb::Re
     } else {
         resultset_->GetAllColumnNames(columnNames);
     }
-    int32_t index = -1;
-    auto &map = fileAsset->GetMemberMap();
-    for (const auto &name : columnNames) {
-        index++;
-        if (GetResultTypeMap().count(name) == 0) {
+    auto schema = make_shared<FileAssetSchema>();
+    const auto &resultTypeMap = GetResultTypeMap();
+    for (size_t index = 0; index < columnNames.size(); index++) {
+        auto iter = resultTypeMap.find(columnNames[index]);
+        if (iter != resultTypeMap.end()) {
+            schema->AddMember(columnNames[index], iter->second, static_cast<int32_t>(index));
+        }
+    }
+    /* always set by SetAssetUri */
+    schema->AddMember(MEDIA_DATA_DB_URI, TYPE_STRING);
+    fileAssetSchema_ = schema;
+    schemaResultSet_ = resultSet;
+    isRdbSchema_ = (resultSet != nullptr);
+    isCountQuery_ = !columnNames.empty() && (columnNames[0].find("count(") != string::npos);
+}
+
+template<class T>
+void FetchResult<T>::SetFileAsset(FileAsset *fileAsset, shared_ptr<NativeRdb::ResultSet> &resultSet)
+{
+    if ((resultset_ == nullptr) && (resultSet == nullptr)) {
+        MEDIA_ERR_LOG("SetFileAsset fail, result is nullptr");
+        return;
+    }
+    ResolveFileAssetSchema(resultSet);
+    fileAsset->SetSchema(fileAssetSchema_);
+    size_t slotCount = fileAssetSchema_->GetSlotCount();
+    for (size_t slot = 0; slot < slotCount; slot++) {
+        int32_t index = fileAssetSchema_->GetColumnIndex(slot);
+        if (index < 0) {
             continue;
         }
-        auto memberType = GetResultTypeMap().at(name);
-        fileAsset->SetResultTypeMap(name, memberType);
-        map.emplace(move(name), move(GetValByIndex(index, memberType, resultSet)));
+        fileAsset->SetSlotValue(static_cast<int32_t>(slot),
+            GetValByIndex(index, fileAssetSchema_->GetType(slot), resultSet));
     }
     fileAsset->SetResultNapiType(resultNapiType_);
-    if (!columnNames.empty() && columnNames[0].find("count(") != string::npos) {
+    if (isCountQuery_) {
         int count = 1;
         if (resultset_) {
             resultset_->GetInt(0, count);
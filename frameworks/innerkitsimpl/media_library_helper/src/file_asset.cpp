@@ -39,12 +39,76 @@ using namespace std;
 
 namespace OHOS {
 namespace Media {
-static constexpr int MAP_INT_MAX = 50;
 using json = nlohmann::json;
+
+void FileAssetSchema::AddMember(const string &name, ResultSetDataType type, int32_t columnIndex)
+{
+    if (slotMap_.count(name) != 0) {
+        return;
+    }
+    slotMap_.emplace(name, static_cast<int32_t>(slots_.size()));
+    slots_.push_back({ name, type, columnIndex });
+}
+
+int32_t FileAssetSchema::GetSlot(const string &name) const
+{
+    auto iter = slotMap_.find(name);
+    return (iter != slotMap_.end()) ? iter->second : -1;
+}
+
+size_t FileAssetSchema::GetSlotCount() const
+{
+    return slots_.size();
+}
+
+const string &FileAssetSchema::GetName(size_t slot) const
+{
+    return slots_[slot].name;
+}
+
+ResultSetDataType FileAssetSchema::GetType(size_t slot) const
+{
+    return slots_[slot].type;
+}
+
+int32_t FileAssetSchema::GetColumnIndex(size_t slot) const
+{
+    return slots_[slot].columnIndex;
+}
+
 FileAsset::FileAsset()
     : albumUri_(DEFAULT_MEDIA_ALBUM_URI), resultNapiType_(ResultNapiType::TYPE_NAPI_MAX)
 {
-    member_.reserve(MAP_INT_MAX);
+}
+
+void FileAsset::SetSchema(const shared_ptr<const FileAssetSchema> &schema)
+{
+    // members which were set before move into their slots, the other slots start with the type default
+    schema_ = schema;
+    slots_.clear();
+    if (schema_ == nullptr) {
+        return;
+    }
+    slots_.resize(schema_->GetSlotCount());
+    for (size_t slot = 0; slot < slots_.size(); slot++) {
+        auto iter = member_.find(schema_->GetName(slot));
+        if (iter != member_.end()) {
+            slots_[slot] = move(iter->second);
+            member_.erase(iter);
+        } else if (schema_->GetType(slot) == TYPE_STRING) {
+            slots_[slot] = string();
+        } else if (schema_->GetType(slot) == TYPE_INT64) {
+            slots_[slot] = DEFAULT_INT64;
+        }
+    }
+}
+
+void FileAsset::SetSlotValue(int32_t slot, variant<int32_t, int64_t, string> &&value)
+{
+    if ((slot < 0) || (static_cast<size_t>(slot) >= slots_.size())) {
+        return;
+    }
+    slots_[slot] = move(value);
 }
 
 int32_t FileAsset::GetId() const
@@ -54,7 +118,7 @@ int32_t FileAsset::GetId() const
 
 void FileAsset::SetId(int32_t id)
 {
-    member_[MEDIA_DATA_DB_ID] = id;
+    SetMember(MEDIA_DATA_DB_ID, id);
 }
 
 int32_t FileAsset::GetCount() const
@@ -64,7 +128,7 @@ int32_t FileAsset::GetCount() const
 
 void FileAsset::SetCount(int32_t count)
 {
-    member_[MEDIA_DATA_DB_COUNT] = count;
+    SetMember(MEDIA_DATA_DB_COUNT, count);
 }
 
 const string &FileAsset::GetUri() const
@@ -74,7 +138,7 @@ const string &FileAsset::GetUri() const
 
 void FileAsset::SetUri(const string &uri)
 {
-    member_[MEDIA_DATA_DB_URI] = uri;
+    SetMember(MEDIA_DATA_DB_URI, uri);
 }
 
 const string &FileAsset::GetPath() const
@@ -84,7 +148,7 @@ const string &FileAsset::GetPath() const
 
 void FileAsset::SetPath(const string &path)
 {
-    member_[MEDIA_DATA_DB_FILE_PATH] = path;
+    SetMember(MEDIA_DATA_DB_FILE_PATH, path);
 }
 
 const string &FileAsset::GetRelativePath() const
@@ -94,7 +158,7 @@ const string &FileAsset::GetRelativePath() const
 
 void FileAsset::SetRelativePath(const string &relativePath)
 {
-    member_[MEDIA_DATA_DB_RELATIVE_PATH] = relativePath;
+    SetMember(MEDIA_DATA_DB_RELATIVE_PATH, relativePath);
 }
 
 const string &FileAsset::GetMimeType() const
@@ -104,7 +168,7 @@ const string &FileAsset::GetMimeType() const
 
 void FileAsset::SetMimeType(const string &mimeType)
 {
-    member_[MEDIA_DATA_DB_MIME_TYPE] = mimeType;
+    SetMember(MEDIA_DATA_DB_MIME_TYPE, mimeType);
 }
 
 MediaType FileAsset::GetMediaType() const
@@ -114,7 +178,7 @@ MediaType FileAsset::GetMediaType() const
 
 void FileAsset::SetMediaType(MediaType mediaType)
 {
-    member_[MEDIA_DATA_DB_MEDIA_TYPE] = mediaType;
+    SetMember(MEDIA_DATA_DB_MEDIA_TYPE, mediaType);
 }
 
 const string &FileAsset::GetDisplayName() const
@@ -124,7 +188,7 @@ const string &FileAsset::GetDisplayName() const
 
 void FileAsset::SetDisplayName(const string &displayName)
 {
-    member_[MEDIA_DATA_DB_NAME] = displayName;
+    SetMember(MEDIA_DATA_DB_NAME, displayName);
 }
 
 int64_t FileAsset::GetSize() const
@@ -134,7 +198,7 @@ int64_t FileAsset::GetSize() const
 
 void FileAsset::SetSize(int64_t size)
 {
-    member_[MEDIA_DATA_DB_SIZE] = size;
+    SetMember(MEDIA_DATA_DB_SIZE, size);
 }
 
 int64_t FileAsset::GetDateAdded() const
@@ -144,7 +208,7 @@ int64_t FileAsset::GetDateAdded() const
 
 void FileAsset::SetDateAdded(int64_t dateAdded)
 {
-    member_[MEDIA_DATA_DB_DATE_ADDED] = dateAdded;
+    SetMember(MEDIA_DATA_DB_DATE_ADDED, dateAdded);
 }
 
 int64_t FileAsset::GetDateModified() const
@@ -154,7 +218,7 @@ int64_t FileAsset::GetDateModified() const
 
 void FileAsset::SetDateModified(int64_t dateModified)
 {
-    member_[MEDIA_DATA_DB_DATE_MODIFIED] = dateModified;
+    SetMember(MEDIA_DATA_DB_DATE_MODIFIED, dateModified);
 }
 
 const string &FileAsset::GetTitle() const
@@ -164,7 +228,7 @@ const string &FileAsset::GetTitle() const
 
 void FileAsset::SetTitle(const string &title)
 {
-    member_[MEDIA_DATA_DB_TITLE] = title;
+    SetMember(MEDIA_DATA_DB_TITLE, title);
 }
 
 const string &FileAsset::GetArtist() const
@@ -174,7 +238,7 @@ const string &FileAsset::GetArtist() const
 
 void FileAsset::SetArtist(const string &artist)
 {
-    member_[MEDIA_DATA_DB_ARTIST] = artist;
+    SetMember(MEDIA_DATA_DB_ARTIST, artist);
 }
 
 const string &FileAsset::GetAlbum() const
@@ -184,7 +248,7 @@ const string &FileAsset::GetAlbum() const
 
 void FileAsset::SetAlbum(const string &album)
 {
-    member_[MEDIA_DATA_DB_ALBUM] = album;
+    SetMember(MEDIA_DATA_DB_ALBUM, album);
 }
 
 int32_t FileAsset::GetPosition() const
@@ -194,7 +258,7 @@ int32_t FileAsset::GetPosition() const
 
 void FileAsset::SetPosition(int32_t position)
 {
-    member_[MEDIA_DATA_DB_POSITION] = position;
+    SetMember(MEDIA_DATA_DB_POSITION, position);
 }
 
 int32_t FileAsset::GetWidth() const
@@ -204,7 +268,7 @@ int32_t FileAsset::GetWidth() const
 
 void FileAsset::SetWidth(int32_t width)
 {
-    member_[MEDIA_DATA_DB_WIDTH] = width;
+    SetMember(MEDIA_DATA_DB_WIDTH, width);
 }
 
 int32_t FileAsset::GetHeight() const
@@ -214,7 +278,7 @@ int32_t FileAsset::GetHeight() const
 
 void FileAsset::SetHeight(int32_t height)
 {
-    member_[MEDIA_DATA_DB_HEIGHT] = height;
+    SetMember(MEDIA_DATA_DB_HEIGHT, height);
 }
 
 int32_t FileAsset::GetDuration() const
@@ -224,7 +288,7 @@ int32_t FileAsset::GetDuration() const
 
 void FileAsset::SetDuration(int32_t duration)
 {
-    member_[MEDIA_DATA_DB_DURATION] = duration;
+    SetMember(MEDIA_DATA_DB_DURATION, duration);
 }
 
 int32_t FileAsset::GetOrientation() const
@@ -234,7 +298,7 @@ int32_t FileAsset::GetOrientation() const
 
 void FileAsset::SetOrientation(int32_t orientation)
 {
-    member_[MEDIA_DATA_DB_ORIENTATION] = orientation;
+    SetMember(MEDIA_DATA_DB_ORIENTATION, orientation);
 }
 
 int32_t FileAsset::GetAlbumId() const
@@ -244,7 +308,7 @@ int32_t FileAsset::GetAlbumId() const
 
 void FileAsset::SetAlbumId(int32_t albumId)
 {
-    member_[MEDIA_DATA_DB_BUCKET_ID] = albumId;
+    SetMember(MEDIA_DATA_DB_BUCKET_ID, albumId);
 }
 
 const string &FileAsset::GetAlbumName() const
@@ -254,7 +318,7 @@ const string &FileAsset::GetAlbumName() const
 
 void FileAsset::SetAlbumName(const string &albumName)
 {
-    member_[MEDIA_DATA_DB_BUCKET_NAME] = albumName;
+    SetMember(MEDIA_DATA_DB_BUCKET_NAME, albumName);
 }
 
 int32_t FileAsset::GetParent() const
@@ -264,7 +328,7 @@ int32_t FileAsset::GetParent() const
 
 void FileAsset::SetParent(int32_t parent)
 {
-    member_[MEDIA_DATA_DB_PARENT_ID] = parent;
+    SetMember(MEDIA_DATA_DB_PARENT_ID, parent);
 }
 
 const string &FileAsset::GetAlbumUri() const
@@ -284,7 +348,7 @@ int64_t FileAsset::GetDateTaken() const
 
 void FileAsset::SetDateTaken(int64_t dateTaken)
 {
-    member_[MEDIA_DATA_DB_DATE_TAKEN] = dateTaken;
+    SetMember(MEDIA_DATA_DB_DATE_TAKEN, dateTaken);
 }
 
 int64_t FileAsset::GetTimePending() const
@@ -294,7 +358,7 @@ int64_t FileAsset::GetTimePending() const
 
 void FileAsset::SetTimePending(int64_t timePending)
 {
-    member_[MEDIA_DATA_DB_TIME_PENDING] = timePending;
+    SetMember(MEDIA_DATA_DB_TIME_PENDING, timePending);
 }
 
 bool FileAsset::IsFavorite() const
@@ -304,7 +368,7 @@ bool FileAsset::IsFavorite() const
 
 void FileAsset::SetFavorite(bool isFavorite)
 {
-    member_[MEDIA_DATA_DB_IS_FAV] = isFavorite;
+    SetMember(MEDIA_DATA_DB_IS_FAV, isFavorite);
 }
 
 int64_t FileAsset::GetDateTrashed() const
@@ -314,7 +378,7 @@ int64_t FileAsset::GetDateTrashed() const
 
 void FileAsset::SetDateTrashed(int64_t dateTrashed)
 {
-    member_[MEDIA_DATA_DB_DATE_TRASHED] = dateTrashed;
+    SetMember(MEDIA_DATA_DB_DATE_TRASHED, dateTrashed);
 }
 
 const string &FileAsset::GetSelfId() const
@@ -324,7 +388,7 @@ const string &FileAsset::GetSelfId() const
 
 void FileAsset::SetSelfId(const string &selfId)
 {
-    member_[MEDIA_DATA_DB_SELF_ID] = selfId;
+    SetMember(MEDIA_DATA_DB_SELF_ID, selfId);
 }
 
 int32_t FileAsset::GetIsTrash() const
@@ -339,7 +403,7 @@ int32_t FileAsset::GetIsTrash() const
 
 void FileAsset::SetIsTrash(int32_t isTrash)
 {
-    member_[MEDIA_DATA_DB_IS_TRASH] = isTrash;
+    SetMember(MEDIA_DATA_DB_IS_TRASH, isTrash);
 }
 
 const string &FileAsset::GetRecyclePath() const
@@ -349,7 +413,7 @@ const string &FileAsset::GetRecyclePath() const
 
 void FileAsset::SetRecyclePath(const string &recyclePath)
 {
-    member_[MEDIA_DATA_DB_RECYCLE_PATH] = recyclePath;
+    SetMember(MEDIA_DATA_DB_RECYCLE_PATH, recyclePath);
 }
 
 const string FileAsset::GetOwnerPackage() const
@@ -359,7 +423,7 @@ const string FileAsset::GetOwnerPackage() const
 
 void FileAsset::SetOwnerPackage(const string &ownerPackage)
 {
-    member_[MEDIA_DATA_DB_OWNER_PACKAGE] = ownerPackage;
+    SetMember(MEDIA_DATA_DB_OWNER_PACKAGE, ownerPackage);
 }
 
 ResultNapiType FileAsset::GetResultNapiType() const
@@ -374,7 +438,7 @@ const string FileAsset::GetPackageName() const
 
 void FileAsset::SetPackageName(const string &packageName)
 {
-    member_[MediaColumn::MEDIA_PACKAGE_NAME] = packageName;
+    SetMember(MediaColumn::MEDIA_PACKAGE_NAME, packageName);
 }
 
 void FileAsset::SetResultNapiType(const ResultNapiType type)
@@ -389,7 +453,7 @@ int32_t FileAsset::GetPhotoSubType() const
 
 void FileAsset::SetPhotoSubType(int32_t photoSubType)
 {
-    member_[PhotoColumn::PHOTO_SUBTYPE] = photoSubType;
+    SetMember(PhotoColumn::PHOTO_SUBTYPE, photoSubType);
 }
 
 const std::string &FileAsset::GetCameraShotKey() const
@@ -399,7 +463,7 @@ const std::string &FileAsset::GetCameraShotKey() const
 
 void FileAsset::SetCameraShotKey(const std::string &cameraShotKey)
 {
-    member_[PhotoColumn::CAMERA_SHOT_KEY] = cameraShotKey;
+    SetMember(PhotoColumn::CAMERA_SHOT_KEY, cameraShotKey);
 }
 
 bool FileAsset::IsHidden() const
@@ -409,7 +473,7 @@ bool FileAsset::IsHidden() const
 
 void FileAsset::SetHidden(bool isHidden)
 {
-    member_[MediaColumn::MEDIA_HIDDEN] = isHidden;
+    SetMember(MediaColumn::MEDIA_HIDDEN, isHidden);
 }
 
 const std::string &FileAsset::GetAllExif() const
@@ -419,7 +483,7 @@ const std::string &FileAsset::GetAllExif() const
 
 void FileAsset::SetAllExif(const string &allExif)
 {
-    member_[PhotoColumn::PHOTO_ALL_EXIF] = allExif;
+    SetMember(PhotoColumn::PHOTO_ALL_EXIF, allExif);
 }
 
 const std::string &FileAsset::GetUserComment() const
@@ -429,7 +493,7 @@ const std::string &FileAsset::GetUserComment() const
 
 void FileAsset::SetUserComment(const string &userComment)
 {
-    member_[PhotoColumn::PHOTO_USER_COMMENT] = userComment;
+    SetMember(PhotoColumn::PHOTO_USER_COMMENT, userComment);
 }
 
 const std::string &FileAsset::GetFilePath() const
@@ -439,7 +503,7 @@ const std::string &FileAsset::GetFilePath() const
 
 void FileAsset::SetFilePath(const std::string &filePath)
 {
-    member_[MediaColumn::MEDIA_FILE_PATH] = filePath;
+    SetMember(MediaColumn::MEDIA_FILE_PATH, filePath);
 }
 
 void FileAsset::SetOpenStatus(int32_t fd, int32_t openStatus)
@@ -476,27 +540,66 @@ int32_t FileAsset::GetOpenStatus(int32_t fd)
 
 unordered_map<string, variant<int32_t, int64_t, string>> &FileAsset::GetMemberMap()
 {
+    // the caller may read or change any member through the map, so move the slots back into it
+    if (schema_ != nullptr) {
+        for (size_t slot = 0; slot < slots_.size(); slot++) {
+            const string &name = schema_->GetName(slot);
+            if (schema_->GetColumnIndex(slot) >= 0) {
+                SetResultTypeMap(name, schema_->GetType(slot));
+            }
+            member_.emplace(name, move(slots_[slot]));
+        }
+        slots_.clear();
+        schema_ = nullptr;
+    }
     return member_;
 }
 
 variant<int32_t, int64_t, string> &FileAsset::GetMemberValue(const string &name)
 {
+    int32_t slot = (schema_ != nullptr) ? schema_->GetSlot(name) : -1;
+    if (slot >= 0) {
+        return slots_[slot];
+    }
     return member_[name];
 }
 
+const variant<int32_t, int64_t, string> *FileAsset::FindMember(const string &name) const
+{
+    int32_t slot = (schema_ != nullptr) ? schema_->GetSlot(name) : -1;
+    if (slot >= 0) {
+        return &slots_[slot];
+    }
+    auto iter = member_.find(name);
+    return (iter != member_.end()) ? &iter->second : nullptr;
+}
+
+void FileAsset::SetMember(const string &name, variant<int32_t, int64_t, string> value)
+{
+    int32_t slot = (schema_ != nullptr) ? schema_->GetSlot(name) : -1;
+    if (slot >= 0) {
+        slots_[slot] = move(value);
+        return;
+    }
+    member_[name] = move(value);
+}
+
 const string &FileAsset::GetStrMember(const string &name) const
 {
-    return (member_.count(name) > 0) ? get<string>(member_.at(name)) : DEFAULT_STR;
+    auto value = FindMember(name);
+    return (value != nullptr) ? get<string>(*value) : DEFAULT_STR;
 }
 
 int32_t FileAsset::GetInt32Member(const string &name) const
 {
-    return (member_.count(name) > 0) ? get<int32_t>(member_.at(name)) : DEFAULT_INT32;
+    auto value = FindMember(name);
+    return (value != nullptr) ? get<int32_t>(*value) : DEFAULT_INT32;
 }
 
 int64_t FileAsset::GetInt64Member(const string &name) const
 {
-    return (member_.count(name) > 0) ? get<int64_t>(member_.at(name)) : DEFAULT_INT64;
+    auto value = FindMember(name);
+    return (value != nullptr) ? get<int64_t>(*value) : DEFAULT_INT64;
 }
 
 int32_t FileAsset::GetPhotoIndex() const
@@ -514,6 +617,27 @@ void FileAsset::SetResultTypeMap(const string &colName, ResultSetDataType type)
 string FileAsset::GetAssetJson()
 {
     json jsonObject;
+    if (schema_ != nullptr) {
+        for (size_t slot = 0; slot < slots_.size(); slot++) {
+            if (schema_->GetColumnIndex(slot) < 0) {
+                continue;
+            }
+            const string &colName = schema_->GetName(slot);
+            switch (schema_->GetType(slot)) {
+                case TYPE_STRING:
+                    jsonObject[colName] = get<string>(slots_[slot]);
+                    break;
+                case TYPE_INT32:
+                    jsonObject[colName] = get<int32_t>(slots_[slot]);
+                    break;
+                case TYPE_INT64:
+                    jsonObject[colName] = get<int64_t>(slots_[slot]);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
     for (auto &[colName, _]  : member_) {
         if (resultTypeMap_.count(colName) == 0) {
             continue;
@@ -66,6 +66,13 @@ public:
 
     void OnStop() override;
 
+    /**
+     * @brief Called when the system is short of memory, frees the memory the extension keeps for reuse.
+     *
+     * @param level Indicates the memory level of the system.
+     */
+    void OnMemoryLevel(int level) override;
+
     /**
      * @brief Called when this datashare extension ability is connected for the first time.
      *
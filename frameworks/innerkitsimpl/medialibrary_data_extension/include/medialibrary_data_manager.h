@@ -75,6 +75,8 @@ public:
     EXPORT void InterruptBgworker();
     EXPORT int32_t DoAging();
     EXPORT int32_t DoTrashAging(std::shared_ptr<int> countPtr = nullptr);
+    /* recomputes every album, repairs counts and covers the incremental refresh may have left off */
+    EXPORT int32_t RefreshAlbums();
     /**
      * @brief Revert the pending state through the package name
      * @param bundleName packageName
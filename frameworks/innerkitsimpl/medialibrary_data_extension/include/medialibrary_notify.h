@@ -18,10 +18,10 @@
 #include <cstddef>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "dataobs_mgr_client.h"
 #include "file_asset.h"
-#include "medialibrary_async_worker.h"
 #include "parcel.h"
 #include "rdb_predicates.h"
 #include "timer.h"
@@ -30,17 +30,33 @@
 
 namespace OHOS {
 namespace Media {
-class NotifyTaskData : public AsyncTaskData {
-public:
-    NotifyTaskData(const std::string &uri, const NotifyType &notifyType, const int albumId)
-        : uri_(std::move(uri)), notifyType_(notifyType), albumId_(albumId) {}
-    virtual ~NotifyTaskData() override = default;
-    std::string uri_;
-    NotifyType notifyType_;
-    int albumId_;
+/* pending changes of one notify uri, one merged change per asset uri, in arrival order */
+struct NotifyDataList {
+    std::unordered_map<std::string, NotifyType> types;
+    // may still hold uris whose changes cancelled out, they are skipped at flush and compacted once they pile up
+    std::vector<std::string> uris;
+};
+
+struct NotifyStats {
+    uint64_t received = 0;
+    // changes folded into a pending change of the same asset, and pairs of changes that cancelled out
+    uint64_t merged = 0;
+    uint64_t cancelled = 0;
+    uint64_t flushes = 0;
+    // observer calls and the uris carried by them
+    uint64_t sentChanges = 0;
+    uint64_t sentUris = 0;
+    // longest time a change waited for its flush, in ms
+    int64_t maxLatency = 0;
 };
+
+// flush tick, a tick that saw more changes than MAX_NOTIFY_LIST_SIZE arrive holds the flush back
 constexpr size_t MAX_NOTIFY_LIST_SIZE = 32;
 constexpr size_t MNOTIFY_TIME_INTERVAL = 100;
+// a burst is flushed anyway once it is this old in ms or has this many changes pending
+constexpr int64_t MAX_NOTIFY_WINDOW = 1000;
+constexpr size_t MAX_NOTIFY_PENDING_SIZE = 4096;
+constexpr size_t MAX_NOTIFY_URIS_PER_CHANGE = 512;
 class MediaLibraryNotify {
 public:
     static std::shared_ptr<MediaLibraryNotify> GetInstance();
@@ -49,14 +65,25 @@ public:
     int32_t Notify(const std::shared_ptr<FileAsset> &closeAsset);
     int32_t GetAlbumIdBySubType(const PhotoAlbumSubType subType);
     static void GetNotifyUris(const NativeRdb::RdbPredicates &predicates, std::vector<std::string> &notifyUris);
+    static NotifyStats GetStats();
+    static void ResetStats();
 
     static Utils::Timer timer_;
     static uint32_t timerId_;
     static std::mutex mutex_;
-    static std::unordered_map<std::string, std::unordered_map<NotifyType, std::list<Uri>>> nfListMap_;
+    // keyed by the type uri of assets or by the album uri
+    static std::unordered_map<std::string, NotifyDataList> nfListMap_;
+    // album additions notified without an album id, sent at flush to every album holding the asset
+    static NotifyDataList albumAssetList_;
+    static size_t pendingCount_;
+    static size_t lastPendingCount_;
+    static int64_t windowStart_;
+    static NotifyStats stats_;
 private:
     MediaLibraryNotify();
     int32_t Init();
+    // a forced push sends every pending change without waiting for a burst to end
+    static void PushNotification(bool isForced = false);
     int32_t GetDefaultAlbums(std::unordered_map<PhotoAlbumSubType, int> &outAlbums);
     static std::shared_ptr<MediaLibraryNotify> instance_;
     std::unordered_map<PhotoAlbumSubType, int> defaultAlbums_;
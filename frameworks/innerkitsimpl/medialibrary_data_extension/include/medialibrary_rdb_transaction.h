@@ -42,7 +42,7 @@ public:
     TransactionOperations(const std::shared_ptr<OHOS::NativeRdb::RdbStore> &rdbStore);
     ~TransactionOperations();
     int32_t Start();
-    void Finish();
+    int32_t Finish();
 
 private:
     int32_t BeginTransaction();
@@ -16,12 +16,27 @@
 #ifndef OHOS_MEDIALIBRARY_RDB_UTILS_H
 #define OHOS_MEDIALIBRARY_RDB_UTILS_H
 
+#include <atomic>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "rdb_store.h"
 
 namespace OHOS::Media {
+/* the albums a set of assets belongs to, captured around an operation to refresh only the albums it touched */
+struct AlbumMembership {
+    std::vector<std::string> fileIds;
+    /* album id -> the file ids of fileIds which are members of the album */
+    std::unordered_map<int32_t, std::unordered_set<int32_t>> albums;
+    /* when set, only these user albums are tracked and the system albums are left alone */
+    std::vector<std::string> userAlbumIds;
+    /* too many assets to track, every tracked album gets recomputed */
+    bool isFullRefresh = false;
+};
+
 class MediaLibraryRdbUtils {
 public:
     static void UpdateSystemAlbumInternal(const std::shared_ptr<NativeRdb::RdbStore> &rdbStore,
@@ -29,7 +44,23 @@ public:
     static void UpdateUserAlbumInternal(const std::shared_ptr<NativeRdb::RdbStore> &rdbStore,
         const std::vector<std::string> &userAlbumIds = {});
 
+    /* incremental album refresh, capture before the assets change and update the albums after */
+    static void CaptureAlbumMembership(const std::shared_ptr<NativeRdb::RdbStore> &rdbStore,
+        const std::vector<std::string> &fileIds, AlbumMembership &membership);
+    static void CaptureAlbumMembership(const std::shared_ptr<NativeRdb::RdbStore> &rdbStore,
+        const NativeRdb::AbsRdbPredicates &predicates, AlbumMembership &membership);
+    static void UpdateAlbumsByMembership(const std::shared_ptr<NativeRdb::RdbStore> &rdbStore,
+        const AlbumMembership &before);
+    /* cross check every incremental update against a full recompute, and repair the album on mismatch */
+    static void SetAlbumRefreshVerify(bool isVerify);
+    /* albums repaired since verify was last set, a non zero count means the incremental refresh drifted */
+    static uint32_t GetAlbumRefreshMismatches();
+
     static void AddQueryFilter(NativeRdb::AbsRdbPredicates &predicates);
+
+private:
+    static std::atomic<bool> isAlbumRefreshVerify_;
+    static std::atomic<uint32_t> albumRefreshMismatches_;
 };
 } // namespace OHOS::Media
 #endif // OHOS_MEDIALIBRARY_RDB_UTILS_H
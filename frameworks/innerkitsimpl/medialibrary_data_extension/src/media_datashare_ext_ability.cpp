@@ -40,6 +40,8 @@
 #include "runtime.h"
 #include "singleton.h"
 #include "system_ability_definition.h"
+#include "thumbnail_buffer_pool.h"
+#include "thumbnail_uri_utils.h"
 #include "uri_permission_manager_client.h"
 #include "want.h"
 #ifdef MEDIALIBRARY_SECURITY_OPEN
@@ -133,6 +135,14 @@ void MediaDataShareExtAbility::OnStop()
     MEDIA_INFO_LOG("%{public}s end.", __func__);
 }
 
+void MediaDataShareExtAbility::OnMemoryLevel(int level)
+{
+    MEDIA_INFO_LOG("%{public}s level %{public}d", __func__, level);
+    Extension::OnMemoryLevel(level);
+    // idle thumbnail buffers are kept across generate tasks and only given back when the system asks for memory
+    ThumbnailBufferPool::GetInstance().Trim();
+}
+
 sptr<IRemoteObject> MediaDataShareExtAbility::OnConnect(const AAFwk::Want &want)
 {
     MEDIA_INFO_LOG("%{public}s begin. ", __func__);
@@ -479,7 +489,11 @@ int MediaDataShareExtAbility::OpenFile(const Uri &uri, const string &mode)
     transform(unifyMode.begin(), unifyMode.end(), unifyMode.begin(), ::tolower);
 
     int err = CheckOpenFilePermission(command, unifyMode);
-    if (err == E_PERMISSION_DENIED) {
+    if (err == E_PERMISSION_DENIED && ThumbnailUriUtils::IsBatchThumbnailUri(command.GetUri().ToString())) {
+        // grants are per asset, a batch needs the read permission itself
+        MEDIA_ERR_LOG("Permission Denied for batch thumbnail");
+        return err;
+    } else if (err == E_PERMISSION_DENIED) {
         err = UriPermissionOperations::CheckUriPermission(command.GetUriStringWithoutSegment(), unifyMode);
         if (err != E_OK) {
             auto& uriPermissionClient = AAFwk::UriPermissionManagerClient::GetInstance();
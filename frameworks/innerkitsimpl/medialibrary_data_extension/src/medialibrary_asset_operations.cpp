@@ -16,6 +16,7 @@
 #include "medialibrary_asset_operations.h"
 
 #include <algorithm>
+#include <atomic>
 #include <dirent.h>
 #include <memory>
 #include <mutex>
@@ -64,6 +65,12 @@ namespace OHOS {
 namespace Media {
 
 mutex g_uniqueNumberLock;
+// image, video and audio ids are reserved from the unique number table a block at a time
+constexpr int32_t UNIQUE_ID_BLOCK_SIZE = 64;
+constexpr size_t UNIQUE_ID_TYPE_COUNT = 3;
+constexpr uint32_t UNIQUE_ID_END_SHIFT = 32;
+// per type, the next id to hand out in the low half and the end of the reserved block in the high half
+atomic<uint64_t> g_uniqueIdBlocks[UNIQUE_ID_TYPE_COUNT];
 
 const string DEFAULT_IMAGE_NAME = "IMG_";
 const string DEFAULT_VIDEO_NAME = "VID_";
@@ -1018,10 +1025,6 @@ int32_t MediaLibraryAssetOperations::SendTrashNotify(MediaLibraryCommand &cmd, i
     if (!cmd.GetValueBucket().GetObject(PhotoColumn::MEDIA_DATE_TRASHED, value)) {
         return E_DO_NOT_NEDD_SEND_NOTIFY;
     }
-    auto rdbStore = MediaLibraryUnistoreManager::GetInstance().GetRdbStoreRaw()->GetRaw();
-    MediaLibraryRdbUtils::UpdateUserAlbumInternal(rdbStore);
-    MediaLibraryRdbUtils::UpdateSystemAlbumInternal(rdbStore);
-
     value.GetLong(trashDate);
 
     string prefix;
@@ -1060,9 +1063,6 @@ void MediaLibraryAssetOperations::SendFavoriteNotify(MediaLibraryCommand &cmd, i
         return;
     }
     value.GetInt(isFavorite);
-    MediaLibraryRdbUtils::UpdateSystemAlbumInternal(
-        MediaLibraryUnistoreManager::GetInstance().GetRdbStoreRaw()->GetRaw(),
-        { to_string(PhotoAlbumSubType::FAVORITE) });
     auto watch = MediaLibraryNotify::GetInstance();
     if (cmd.GetOprnObject() != OperationObject::FILESYSTEM_PHOTO) {
         return;
@@ -1085,10 +1085,6 @@ int32_t MediaLibraryAssetOperations::SendHideNotify(MediaLibraryCommand &cmd, in
         return E_DO_NOT_NEDD_SEND_NOTIFY;
     }
     value.GetInt(hiddenState);
-    auto rdbStore = MediaLibraryUnistoreManager::GetInstance().GetRdbStoreRaw()->GetRaw();
-    MediaLibraryRdbUtils::UpdateUserAlbumInternal(rdbStore);
-    MediaLibraryRdbUtils::UpdateSystemAlbumInternal(rdbStore);
-
     string prefix;
     if (cmd.GetOprnObject() == OperationObject::FILESYSTEM_PHOTO) {
         prefix = PhotoColumn::PHOTO_URI_PREFIX;
@@ -1312,45 +1308,89 @@ bool MediaLibraryAssetOperations::GetStringFromValuesBucket(const NativeRdb::Val
     return true;
 }
 
+static bool TakeUniqueId(atomic<uint64_t> &block, int32_t &uniqueId)
+{
+    uint64_t current = block.load();
+    while (static_cast<uint32_t>(current) < static_cast<uint32_t>(current >> UNIQUE_ID_END_SHIFT)) {
+        if (block.compare_exchange_weak(current, current + 1)) {
+            uniqueId = static_cast<int32_t>(static_cast<uint32_t>(current));
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Moves the stored number past a new block before any id of it is handed out, so ids are never reused after a
+ * restart. The number never goes below the block in memory, which keeps ids unique if the table is rolled back.
+ */
+static int32_t ReserveUniqueIdBlock(const shared_ptr<MediaLibraryRdbStore> &rdbStore, const string &typeString,
+    atomic<uint64_t> &block)
+{
+    uint32_t end = static_cast<uint32_t>(block.load() >> UNIQUE_ID_END_SHIFT);
+    const string updateSql = "UPDATE " + ASSET_UNIQUE_NUMBER_TABLE + " SET " + UNIQUE_NUMBER +
+        "=MAX(" + UNIQUE_NUMBER + "," + to_string((end > 0) ? (end - 1) : 0) + ")+" +
+        to_string(UNIQUE_ID_BLOCK_SIZE) + " WHERE " + ASSET_MEDIA_TYPE + "='" + typeString + "';";
+    const string querySql = "SELECT " + UNIQUE_NUMBER + " FROM " + ASSET_UNIQUE_NUMBER_TABLE +
+        " WHERE " + ASSET_MEDIA_TYPE + "='" + typeString + "';";
+
+    int32_t errCode = rdbStore->ExecuteSql(updateSql);
+    if (errCode < 0) {
+        MEDIA_ERR_LOG("execute update unique number failed, ret=%{public}d", errCode);
+        return errCode;
+    }
+    auto resultSet = rdbStore->QuerySql(querySql);
+    if (resultSet == nullptr || resultSet->GoToFirstRow() != NativeRdb::E_OK) {
+        return E_HAS_DB_ERROR;
+    }
+    int32_t lastId = GetInt32Val(UNIQUE_NUMBER, resultSet);
+    if (lastId < UNIQUE_ID_BLOCK_SIZE) {
+        MEDIA_ERR_LOG("invalid unique number %{public}d", lastId);
+        return E_HAS_DB_ERROR;
+    }
+    uint64_t blockEnd = static_cast<uint64_t>(lastId) + 1;
+    block.store((blockEnd << UNIQUE_ID_END_SHIFT) | (blockEnd - UNIQUE_ID_BLOCK_SIZE));
+    return E_OK;
+}
+
 int32_t MediaLibraryAssetOperations::CreateAssetUniqueId(int32_t type)
 {
     string typeString;
+    size_t typeIndex = 0;
     switch (type) {
         case MediaType::MEDIA_TYPE_IMAGE:
             typeString += IMAGE_ASSET_TYPE;
             break;
         case MediaType::MEDIA_TYPE_VIDEO:
             typeString += VIDEO_ASSET_TYPE;
+            typeIndex = 1;
             break;
         case MediaType::MEDIA_TYPE_AUDIO:
             typeString += AUDIO_ASSET_TYPE;
+            typeIndex = 2;
             break;
         default:
             MEDIA_ERR_LOG("This type %{public}d can not get unique id", type);
             return E_INVALID_VALUES;
     }
 
-    const string updateSql = "UPDATE " + ASSET_UNIQUE_NUMBER_TABLE + " SET " + UNIQUE_NUMBER +
-        "=" + UNIQUE_NUMBER + "+1" " WHERE " + ASSET_MEDIA_TYPE + "='" + typeString + "';";
-    const string querySql = "SELECT " + UNIQUE_NUMBER + " FROM " + ASSET_UNIQUE_NUMBER_TABLE +
-        " WHERE " + ASSET_MEDIA_TYPE + "='" + typeString + "';";
-
+    int32_t uniqueId = 0;
+    atomic<uint64_t> &block = g_uniqueIdBlocks[typeIndex];
+    if (TakeUniqueId(block, uniqueId)) {
+        return uniqueId;
+    }
     auto rdbStore = MediaLibraryUnistoreManager::GetInstance().GetRdbStoreRaw();
     if (rdbStore == nullptr) {
         return E_HAS_DB_ERROR;
     }
     lock_guard<mutex> lock(g_uniqueNumberLock);
-    int32_t errCode = rdbStore->ExecuteSql(updateSql);
-    if (errCode < 0) {
-        MEDIA_ERR_LOG("execute update unique number failed, ret=%{public}d", errCode);
-        return errCode;
-    }
-
-    auto resultSet = rdbStore->QuerySql(querySql);
-    if (resultSet == nullptr || resultSet->GoToFirstRow() != NativeRdb::E_OK) {
-        return E_HAS_DB_ERROR;
+    while (!TakeUniqueId(block, uniqueId)) {
+        int32_t errCode = ReserveUniqueIdBlock(rdbStore, typeString, block);
+        if (errCode != E_OK) {
+            return errCode;
+        }
     }
-    return GetInt32Val(UNIQUE_NUMBER, resultSet);
+    return uniqueId;
 }
 
 int32_t MediaLibraryAssetOperations::CreateAssetBucket(int32_t fileId, int32_t &bucketNum)
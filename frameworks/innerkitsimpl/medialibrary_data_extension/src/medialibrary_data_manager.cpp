@@ -48,6 +48,7 @@
 #include "medialibrary_file_operations.h"
 #include "medialibrary_inotify.h"
 #include "medialibrary_object_utils.h"
+#include "medialibrary_rdb_utils.h"
 #include "medialibrary_smartalbum_map_operations.h"
 #include "medialibrary_smartalbum_operations.h"
 #include "medialibrary_sync_operation.h"
@@ -1094,6 +1095,18 @@ int32_t MediaLibraryDataManager::DoTrashAging(shared_ptr<int> countPtr)
     return E_SUCCESS;
 }
 
+int32_t MediaLibraryDataManager::RefreshAlbums()
+{
+    shared_lock<shared_mutex> sharedLock(mgrSharedMutex_);
+    if (rdbStore_ == nullptr) {
+        MEDIA_ERR_LOG("rdbStore is nullptr");
+        return E_FAIL;
+    }
+    MediaLibraryRdbUtils::UpdateUserAlbumInternal(rdbStore_);
+    MediaLibraryRdbUtils::UpdateSystemAlbumInternal(rdbStore_);
+    return E_SUCCESS;
+}
+
 int32_t MediaLibraryDataManager::RevertPendingByFileId(const std::string &fileId)
 {
     MediaLibraryCommand cmd(OperationObject::FILESYSTEM_ASSET, OperationType::UPDATE);
@@ -14,6 +14,10 @@
  */
 #define MLOG_TAG "FileNotify"
 #include "medialibrary_notify.h"
+
+#include <algorithm>
+#include <unordered_set>
+
 #include "data_ability_helper_impl.h"
 #include "media_file_utils.h"
 #include "media_log.h"
@@ -35,9 +39,15 @@ using ChangeType = AAFwk::ChangeInfo::ChangeType;
 using NotifyDataMap = unordered_map<NotifyType, list<Uri>>;
 shared_ptr<MediaLibraryNotify> MediaLibraryNotify::instance_;
 mutex MediaLibraryNotify::mutex_;
-unordered_map<string, NotifyDataMap> MediaLibraryNotify::nfListMap_ = {};
+unordered_map<string, NotifyDataList> MediaLibraryNotify::nfListMap_ = {};
+NotifyDataList MediaLibraryNotify::albumAssetList_;
+size_t MediaLibraryNotify::pendingCount_ = 0;
+size_t MediaLibraryNotify::lastPendingCount_ = 0;
+int64_t MediaLibraryNotify::windowStart_ = 0;
+NotifyStats MediaLibraryNotify::stats_;
 Utils::Timer MediaLibraryNotify::timer_("on_notify");
 uint32_t MediaLibraryNotify::timerId_ = 0;
+constexpr size_t MAX_ALBUM_LOOKUP_SIZE = 500;
 
 shared_ptr<MediaLibraryNotify> MediaLibraryNotify::GetInstance()
 {
@@ -113,150 +123,262 @@ static int SolveAlbumUri(const Uri &notifyUri, NotifyType type, list<Uri> &uris)
     }
 }
 
-static void PushNotifyDataMap(const string &uri, NotifyDataMap notifyDataMap)
+static int32_t SendNotifyUris(const string &keyUri, NotifyType type, list<Uri> &uris)
 {
-    int ret;
-    for (auto &[type, uris] : notifyDataMap) {
-        if (uri.find(PhotoAlbumColumns::ALBUM_URI_PREFIX) != string::npos) {
-            Uri notifyUri = Uri(uri);
-            ret = SolveAlbumUri(notifyUri, type, uris);
-        } else {
-            auto obsMgrClient = AAFwk::DataObsMgrClient::GetInstance();
-            ret = obsMgrClient->NotifyChangeExt({static_cast<ChangeType>(type), uris});
-        }
-        if (ret != E_OK) {
-            MEDIA_ERR_LOG("PushNotification failed, errorCode = %{public}d", ret);
-        }
+    if (keyUri.find(PhotoAlbumColumns::ALBUM_URI_PREFIX) != string::npos) {
+        Uri notifyUri = Uri(keyUri);
+        return SolveAlbumUri(notifyUri, type, uris);
     }
-    return;
+    auto obsMgrClient = AAFwk::DataObsMgrClient::GetInstance();
+    return obsMgrClient->NotifyChangeExt({static_cast<ChangeType>(type), uris});
 }
 
-static void PushNotification()
+static void PushNotifyDataList(const string &keyUri, NotifyDataList &dataList, NotifyStats &stats)
 {
-    unordered_map<string, NotifyDataMap> tmpNfListMap;
-    {
-        lock_guard<mutex> lock(MediaLibraryNotify::mutex_);
-        if (MediaLibraryNotify::nfListMap_.empty()) {
-            return;
+    NotifyDataMap notifyDataMap;
+    for (const auto &uri : dataList.uris) {
+        auto iter = dataList.types.find(uri);
+        if (iter == dataList.types.end()) {
+            continue;
         }
-        MediaLibraryNotify::nfListMap_.swap(tmpNfListMap);
-        MediaLibraryNotify::nfListMap_.clear();
+        notifyDataMap[iter->second].emplace_back(uri);
+        dataList.types.erase(iter);
     }
-    for (auto &[uri, notifyDataMap] : tmpNfListMap) {
-        if (notifyDataMap.empty()) {
-            continue;
+    for (auto &[type, uris] : notifyDataMap) {
+        while (!uris.empty()) {
+            list<Uri> sendUris;
+            auto end = uris.begin();
+            advance(end, min(uris.size(), MAX_NOTIFY_URIS_PER_CHANGE));
+            sendUris.splice(sendUris.begin(), uris, uris.begin(), end);
+            int32_t ret = SendNotifyUris(keyUri, type, sendUris);
+            if (ret != E_OK) {
+                MEDIA_ERR_LOG("PushNotification failed, errorCode = %{public}d", ret);
+            }
+            stats.sentChanges++;
+            stats.sentUris += sendUris.size();
         }
-        PushNotifyDataMap(uri, notifyDataMap);
     }
 }
 
-static void AddNotify(const string &srcUri, const string &keyUri, NotifyTaskData* taskData)
+/*
+ * Folds a change of an asset into its pending change, returns false when the two cancel out.
+ * add then update stays add, add then remove cancels, remove then add is an update, and an album add and
+ * an album remove of the same asset cancel each other.
+ */
+static bool MergeNotifyType(NotifyType pendingType, NotifyType type, NotifyType &outType)
 {
-    NotifyDataMap notifyDataMap;
-    list<Uri> sendUris;
-    Uri uri(srcUri);
-    MEDIA_DEBUG_LOG("AddNotify ,keyUri = %{private}s, uri = %{private}s, "
-        "notifyType = %{private}d", keyUri.c_str(), uri.ToString().c_str(), taskData->notifyType_);
-    lock_guard<mutex> lock(MediaLibraryNotify::mutex_);
-    if (MediaLibraryNotify::nfListMap_.count(keyUri) == 0) {
-        sendUris.emplace_back(uri);
-        notifyDataMap.insert(make_pair(taskData->notifyType_, sendUris));
-        MediaLibraryNotify::nfListMap_.insert(make_pair(keyUri, notifyDataMap));
-    } else {
-        auto iter = MediaLibraryNotify::nfListMap_.find(keyUri);
-        if (iter->second.count(taskData->notifyType_) == 0) {
-            sendUris.emplace_back(uri);
-            iter->second.insert(make_pair(taskData->notifyType_, sendUris));
-        } else {
-            auto haveIter = find_if(
-                iter->second.at(taskData->notifyType_).begin(),
-                iter->second.at(taskData->notifyType_).end(),
-                [uri](const Uri &listUri) { return uri.Equals(listUri); });
-            if (haveIter == iter->second.at(taskData->notifyType_).end()) {
-                iter->second.find(taskData->notifyType_)->second.emplace_back(uri);
+    outType = type;
+    switch (pendingType) {
+        case NotifyType::NOTIFY_ADD:
+            outType = NotifyType::NOTIFY_ADD;
+            return type != NotifyType::NOTIFY_REMOVE;
+        case NotifyType::NOTIFY_UPDATE:
+            if (type == NotifyType::NOTIFY_ADD) {
+                outType = NotifyType::NOTIFY_UPDATE;
             }
-        }
+            return true;
+        case NotifyType::NOTIFY_REMOVE:
+            outType = (type == NotifyType::NOTIFY_ADD) ? NotifyType::NOTIFY_UPDATE : NotifyType::NOTIFY_REMOVE;
+            return true;
+        case NotifyType::NOTIFY_ALBUM_ADD_ASSERT:
+            return type != NotifyType::NOTIFY_ALBUM_REMOVE_ASSET;
+        case NotifyType::NOTIFY_ALBUM_REMOVE_ASSET:
+            return type != NotifyType::NOTIFY_ALBUM_ADD_ASSERT;
+        default:
+            return true;
+    }
+}
+
+/* drops the uris whose changes cancelled out, and the older copy of a uri notified again after that */
+static void CompactNotifyUris(NotifyDataList &dataList)
+{
+    unordered_set<string> kept;
+    auto end = remove_if(dataList.uris.begin(), dataList.uris.end(), [&dataList, &kept](const string &uri) {
+        return (dataList.types.count(uri) == 0) || !kept.insert(uri).second;
+    });
+    dataList.uris.erase(end, dataList.uris.end());
+}
+
+static void AddNotify(NotifyDataList &dataList, const string &uri, NotifyType type, NotifyStats &stats)
+{
+    auto iter = dataList.types.find(uri);
+    if (iter == dataList.types.end()) {
+        dataList.types.emplace(uri, type);
+        dataList.uris.push_back(uri);
+        return;
+    }
+    if (MergeNotifyType(iter->second, type, iter->second)) {
+        stats.merged++;
+        return;
+    }
+    dataList.types.erase(iter);
+    stats.cancelled++;
+    if (dataList.uris.size() > dataList.types.size() * 2 + MAX_NOTIFY_LIST_SIZE) {
+        CompactNotifyUris(dataList);
     }
 }
 
-static int32_t GetAlbumUrisById(const string &fileId, list<string> &albumUriList)
+static int32_t QueryAlbumIds(const vector<string> &fileIds, unordered_map<string, vector<int32_t>> &albumIds)
 {
     auto uniStore = MediaLibraryUnistoreManager::GetInstance().GetRdbStore();
+    CHECK_AND_RETURN_RET_LOG(uniStore != nullptr, E_HAS_DB_ERROR, "UniStore is nullptr!");
     MediaLibraryCommand queryAlbumMapCmd(OperationObject::PHOTO_MAP, OperationType::QUERY);
-    queryAlbumMapCmd.GetAbsRdbPredicates()->EqualTo(PhotoMap::ASSET_ID, fileId);
-    auto resultSet = uniStore->Query(queryAlbumMapCmd, {PhotoMap::ALBUM_ID});
+    queryAlbumMapCmd.GetAbsRdbPredicates()->In(PhotoMap::ASSET_ID, fileIds);
+    auto resultSet = uniStore->Query(queryAlbumMapCmd, {PhotoMap::ASSET_ID, PhotoMap::ALBUM_ID});
     if (resultSet == nullptr) {
-        MEDIA_ERR_LOG("GetAlbumUrisById failed");
+        MEDIA_ERR_LOG("QueryAlbumIds failed");
         return E_INVALID_FILEID;
     }
-    int32_t count = -1;
-    int32_t ret = resultSet->GetRowCount(count);
-    CHECK_AND_RETURN_RET_LOG(ret == E_OK, ret, "Failed to get count");
-    ret = resultSet->GoToFirstRow();
-    CHECK_AND_RETURN_RET_LOG(ret == E_OK, ret, "Failed to GoToFirstRow");
-    do {
+    while (resultSet->GoToNextRow() == NativeRdb::E_OK) {
+        int32_t fileId = get<int32_t>(ResultSetUtils::GetValFromColumn(PhotoMap::ASSET_ID, resultSet, TYPE_INT32));
         int32_t albumId = get<int32_t>(ResultSetUtils::GetValFromColumn(PhotoMap::ALBUM_ID, resultSet,
             TYPE_INT32));
-        string albumUri = PhotoAlbumColumns::ALBUM_URI_PREFIX  + to_string(albumId);
-        albumUriList.emplace_back(albumUri);
-    } while (!resultSet->GoToNextRow());
+        albumIds[to_string(fileId)].push_back(albumId);
+    }
     return E_OK;
 }
 
-static void AddNfListMap(AsyncTaskData *data)
+/* looks up the albums of every asset in one PhotoMap query per MAX_ALBUM_LOOKUP_SIZE assets */
+static void ResolveAlbumAssets(NotifyDataList &albumAssetList, unordered_map<string, NotifyDataList> &nfListMap,
+    NotifyStats &stats)
 {
-    if (data == nullptr) {
+    if (albumAssetList.types.empty()) {
         return;
     }
-    auto* taskData = static_cast<NotifyTaskData*>(data);
-    if ((taskData->notifyType_ == NotifyType::NOTIFY_ALBUM_ADD_ASSERT) ||
-        (taskData->notifyType_ == NotifyType::NOTIFY_ALBUM_REMOVE_ASSET)) {
-        if (taskData->albumId_ > 0) {
-            AddNotify(taskData->uri_,
-                PhotoAlbumColumns::ALBUM_URI_PREFIX  + to_string(taskData->albumId_), taskData);
-        } else {
-            list<string> albumUriList;
-            string id = MediaLibraryDataManagerUtils::GetIdFromUri(taskData->uri_);
-            int err = GetAlbumUrisById(id, albumUriList);
-            CHECK_AND_RETURN_LOG(err == E_OK, "Fail to get albumId");
-            for (string uri : albumUriList) {
-                AddNotify(taskData->uri_, uri, taskData);
+    vector<string> fileIds;
+    fileIds.reserve(albumAssetList.types.size());
+    for (const auto &item : albumAssetList.types) {
+        fileIds.push_back(MediaLibraryDataManagerUtils::GetIdFromUri(item.first));
+    }
+    unordered_map<string, vector<int32_t>> albumIds;
+    for (size_t begin = 0; begin < fileIds.size(); begin += MAX_ALBUM_LOOKUP_SIZE) {
+        size_t end = min(fileIds.size(), begin + MAX_ALBUM_LOOKUP_SIZE);
+        int32_t err = QueryAlbumIds(vector<string>(fileIds.begin() + begin, fileIds.begin() + end), albumIds);
+        CHECK_AND_RETURN_LOG(err == E_OK, "Fail to get albumId");
+    }
+    for (const auto &uri : albumAssetList.uris) {
+        auto typeIter = albumAssetList.types.find(uri);
+        if (typeIter == albumAssetList.types.end()) {
+            continue;
+        }
+        auto albumIter = albumIds.find(MediaLibraryDataManagerUtils::GetIdFromUri(uri));
+        if (albumIter != albumIds.end()) {
+            for (int32_t albumId : albumIter->second) {
+                AddNotify(nfListMap[PhotoAlbumColumns::ALBUM_URI_PREFIX + to_string(albumId)], uri,
+                    typeIter->second, stats);
             }
         }
-    } else {
-        string typeUri = MediaLibraryDataManagerUtils::GetTypeUriByUri(taskData->uri_);
-        AddNotify(taskData->uri_, typeUri, taskData);
+        albumAssetList.types.erase(typeIter);
+    }
+}
+
+/*
+ * Runs every MNOTIFY_TIME_INTERVAL. Quiet changes are sent at the next tick, while a burst keeps being
+ * coalesced as long as it grows by more than MAX_NOTIFY_LIST_SIZE a tick, up to MAX_NOTIFY_WINDOW ms or
+ * MAX_NOTIFY_PENDING_SIZE changes.
+ */
+void MediaLibraryNotify::PushNotification(bool isForced)
+{
+    unordered_map<string, NotifyDataList> tmpNfListMap;
+    NotifyDataList tmpAlbumAssetList;
+    NotifyStats stats;
+    {
+        lock_guard<mutex> lock(MediaLibraryNotify::mutex_);
+        if (MediaLibraryNotify::pendingCount_ == 0) {
+            return;
+        }
+        int64_t age = MediaFileUtils::UTCTimeMilliSeconds() - MediaLibraryNotify::windowStart_;
+        // cancelled changes lower the count, so it may be below the one of the last tick
+        size_t arrived = (MediaLibraryNotify::pendingCount_ > MediaLibraryNotify::lastPendingCount_) ?
+            (MediaLibraryNotify::pendingCount_ - MediaLibraryNotify::lastPendingCount_) : 0;
+        if (!isForced && (arrived > MAX_NOTIFY_LIST_SIZE) && (age < MAX_NOTIFY_WINDOW) &&
+            (MediaLibraryNotify::pendingCount_ < MAX_NOTIFY_PENDING_SIZE)) {
+            MediaLibraryNotify::lastPendingCount_ = MediaLibraryNotify::pendingCount_;
+            return;
+        }
+        MediaLibraryNotify::nfListMap_.swap(tmpNfListMap);
+        swap(MediaLibraryNotify::albumAssetList_, tmpAlbumAssetList);
+        MediaLibraryNotify::pendingCount_ = 0;
+        MediaLibraryNotify::lastPendingCount_ = 0;
+        MediaLibraryNotify::stats_.flushes++;
+        MediaLibraryNotify::stats_.maxLatency = max(MediaLibraryNotify::stats_.maxLatency, age);
     }
+    ResolveAlbumAssets(tmpAlbumAssetList, tmpNfListMap, stats);
+    for (auto &[uri, dataList] : tmpNfListMap) {
+        PushNotifyDataList(uri, dataList, stats);
+    }
+    lock_guard<mutex> lock(MediaLibraryNotify::mutex_);
+    MediaLibraryNotify::stats_.merged += stats.merged;
+    MediaLibraryNotify::stats_.cancelled += stats.cancelled;
+    MediaLibraryNotify::stats_.sentChanges += stats.sentChanges;
+    MediaLibraryNotify::stats_.sentUris += stats.sentUris;
 }
 
 int32_t MediaLibraryNotify::Init()
 {
-    MediaLibraryNotify::timerId_ = MediaLibraryNotify::timer_.Register(PushNotification, MNOTIFY_TIME_INTERVAL);
+    MediaLibraryNotify::timerId_ = MediaLibraryNotify::timer_.Register([]() { PushNotification(); },
+        MNOTIFY_TIME_INTERVAL);
     MediaLibraryNotify::timer_.Setup();
     return E_OK;
 }
 
+/* folds a change into a pending list and keeps pendingCount_ at the number of pending changes, needs mutex_ */
+static void AddPendingNotify(NotifyDataList &dataList, const string &uri, NotifyType type)
+{
+    if (MediaLibraryNotify::pendingCount_ == 0) {
+        MediaLibraryNotify::windowStart_ = MediaFileUtils::UTCTimeMilliSeconds();
+    }
+    size_t size = dataList.types.size();
+    AddNotify(dataList, uri, type, MediaLibraryNotify::stats_);
+    MediaLibraryNotify::pendingCount_ = MediaLibraryNotify::pendingCount_ + dataList.types.size() - size;
+}
+
 int32_t MediaLibraryNotify::Notify(const string &uri, const NotifyType notifyType, const int albumId)
 {
-    if (MediaLibraryNotify::nfListMap_.size() > MAX_NOTIFY_LIST_SIZE) {
-        MediaLibraryNotify::timer_.Shutdown();
-        PushNotification();
-        MediaLibraryNotify::timer_.Register(PushNotification, MNOTIFY_TIME_INTERVAL);
-        MediaLibraryNotify::timer_.Setup();
-    }
-    shared_ptr<MediaLibraryAsyncWorker> asyncWorker = MediaLibraryAsyncWorker::GetInstance();
-    CHECK_AND_RETURN_RET_LOG(asyncWorker != nullptr, E_ASYNC_WORKER_IS_NULL, "AsyncWorker is null");
-    auto *taskData = new (nothrow) NotifyTaskData(uri, notifyType, albumId);
-    CHECK_AND_RETURN_RET_LOG(taskData != nullptr, E_NOTIFY_TASK_DATA_IS_NULL, "taskData is null");
     MEDIA_DEBUG_LOG("Notify ,uri = %{private}s, notifyType = %{private}d, albumId = %{private}d",
         uri.c_str(), notifyType, albumId);
-    shared_ptr<MediaLibraryAsyncTask> notifyAsyncTask = make_shared<MediaLibraryAsyncTask>(AddNfListMap, taskData);
-    if (notifyAsyncTask != nullptr) {
-        asyncWorker->AddTask(notifyAsyncTask, true);
+    bool isAlbumChange = (notifyType == NotifyType::NOTIFY_ALBUM_ADD_ASSERT) ||
+        (notifyType == NotifyType::NOTIFY_ALBUM_REMOVE_ASSET);
+    vector<int32_t> albumIds;
+    if (isAlbumChange && (albumId > 0)) {
+        albumIds.push_back(albumId);
+    } else if (notifyType == NotifyType::NOTIFY_ALBUM_REMOVE_ASSET) {
+        // the PhotoMap rows of a removed asset may be gone by the flush, so its albums are looked up now
+        unordered_map<string, vector<int32_t>> assetAlbums;
+        string fileId = MediaLibraryDataManagerUtils::GetIdFromUri(uri);
+        if (QueryAlbumIds({ fileId }, assetAlbums) != E_OK) {
+            MEDIA_ERR_LOG("Fail to get albumId of removed asset");
+        }
+        albumIds = move(assetAlbums[fileId]);
+    }
+
+    lock_guard<mutex> lock(mutex_);
+    stats_.received++;
+    if (!isAlbumChange) {
+        string srcUri = uri;
+        AddPendingNotify(nfListMap_[MediaLibraryDataManagerUtils::GetTypeUriByUri(srcUri)], uri, notifyType);
+    } else if ((albumId > 0) || (notifyType == NotifyType::NOTIFY_ALBUM_REMOVE_ASSET)) {
+        for (int32_t id : albumIds) {
+            AddPendingNotify(nfListMap_[PhotoAlbumColumns::ALBUM_URI_PREFIX + to_string(id)], uri, notifyType);
+        }
+    } else {
+        AddPendingNotify(albumAssetList_, uri, notifyType);
     }
     return E_OK;
 }
 
+NotifyStats MediaLibraryNotify::GetStats()
+{
+    lock_guard<mutex> lock(mutex_);
+    return stats_;
+}
+
+void MediaLibraryNotify::ResetStats()
+{
+    lock_guard<mutex> lock(mutex_);
+    stats_ = NotifyStats();
+}
+
 int32_t MediaLibraryNotify::Notify(const shared_ptr<FileAsset> &closeAsset)
 {
     bool isCreateFile = false;
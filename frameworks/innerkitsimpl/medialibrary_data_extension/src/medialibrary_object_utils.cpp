@@ -51,6 +51,7 @@
 #include "sandbox_helper.h"
 #include "string_ex.h"
 #include "thumbnail_service.h"
+#include "thumbnail_uri_utils.h"
 #include "value_object.h"
 #include "medialibrary_tracer.h"
 #include "post_event_utils.h"
@@ -773,6 +774,9 @@ int32_t MediaLibraryObjectUtils::OpenFile(MediaLibraryCommand &cmd, const string
 
     string uriString = cmd.GetUri().ToString();
     if (cmd.GetOprnObject() == OperationObject::THUMBNAIL) {
+        if (ThumbnailUriUtils::IsBatchThumbnailUri(uriString)) {
+            return ThumbnailService::GetInstance()->GetBatchThumbnailFd(uriString);
+        }
         return ThumbnailService::GetInstance()->GetThumbnailFd(uriString);
     } else if (IsDocumentUri(uriString)) {
         return OpenDocument(uriString, mode);
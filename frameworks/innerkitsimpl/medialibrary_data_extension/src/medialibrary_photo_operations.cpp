@@ -605,6 +605,8 @@ int32_t MediaLibraryPhotoOperations::TrashPhotos(MediaLibraryCommand &cmd)
         PhotoColumn::PHOTOS_TABLE);
     vector<string> notifyUris = rdbPredicate.GetWhereArgs();
     MediaLibraryRdbStore::ReplacePredicatesUriToId(rdbPredicate);
+    AlbumMembership membership;
+    MediaLibraryRdbUtils::CaptureAlbumMembership(rdbStore->GetRaw(), rdbPredicate, membership);
     ValuesBucket values;
     values.Put(MediaColumn::MEDIA_DATE_TRASHED, MediaFileUtils::UTCTimeSeconds());
     cmd.SetValueBucket(values);
@@ -614,8 +616,7 @@ int32_t MediaLibraryPhotoOperations::TrashPhotos(MediaLibraryCommand &cmd)
         return E_HAS_DB_ERROR;
     }
 
-    MediaLibraryRdbUtils::UpdateUserAlbumInternal(rdbStore->GetRaw());
-    MediaLibraryRdbUtils::UpdateSystemAlbumInternal(rdbStore->GetRaw());
+    MediaLibraryRdbUtils::UpdateAlbumsByMembership(rdbStore->GetRaw(), membership);
     if (static_cast<size_t>(updatedRows) != notifyUris.size()) {
         MEDIA_WARN_LOG("Try to notify %{public}zu items, but only %{public}d items updated.",
             notifyUris.size(), updatedRows);
@@ -624,6 +625,15 @@ int32_t MediaLibraryPhotoOperations::TrashPhotos(MediaLibraryCommand &cmd)
     return updatedRows;
 }
 
+/* trash, hide and favorite change which albums the asset is counted in */
+static bool IsAlbumChanged(MediaLibraryCommand &cmd)
+{
+    ValueObject value;
+    const ValuesBucket &values = cmd.GetValueBucket();
+    return values.GetObject(MediaColumn::MEDIA_DATE_TRASHED, value) ||
+        values.GetObject(MediaColumn::MEDIA_HIDDEN, value) || values.GetObject(MediaColumn::MEDIA_IS_FAV, value);
+}
+
 int32_t MediaLibraryPhotoOperations::UpdateV10(MediaLibraryCommand &cmd)
 {
     if (cmd.GetOprnType() == OperationType::TRASH_PHOTO) {
@@ -656,7 +666,13 @@ int32_t MediaLibraryPhotoOperations::UpdateV10(MediaLibraryCommand &cmd)
     CHECK_AND_RETURN_RET_LOG(errCode == E_OK, errCode, "Update Photo Name failed, fileName=%{private}s",
         fileAsset->GetDisplayName().c_str());
 
-    TransactionOperations transactionOprn(MediaLibraryUnistoreManager::GetInstance().GetRdbStoreRaw()->GetRaw());
+    auto rdbStore = MediaLibraryUnistoreManager::GetInstance().GetRdbStoreRaw()->GetRaw();
+    AlbumMembership membership;
+    bool isAlbumChanged = IsAlbumChanged(cmd);
+    if (isAlbumChanged) {
+        MediaLibraryRdbUtils::CaptureAlbumMembership(rdbStore, { to_string(fileAsset->GetId()) }, membership);
+    }
+    TransactionOperations transactionOprn(rdbStore);
     errCode = transactionOprn.Start();
     if (errCode != E_OK) {
         return errCode;
@@ -668,6 +684,9 @@ int32_t MediaLibraryPhotoOperations::UpdateV10(MediaLibraryCommand &cmd)
         return rowId;
     }
     transactionOprn.Finish();
+    if (isAlbumChanged) {
+        MediaLibraryRdbUtils::UpdateAlbumsByMembership(rdbStore, membership);
+    }
 
     string extraUri = MediaFileUtils::GetExtraUri(fileAsset->GetDisplayName(), fileAsset->GetPath());
     errCode = SendTrashNotify(cmd, fileAsset->GetId(), extraUri);
@@ -710,7 +729,13 @@ int32_t MediaLibraryPhotoOperations::UpdateV9(MediaLibraryCommand &cmd)
         UpdateVirtualPath(cmd, fileAsset);
     }
 
-    TransactionOperations transactionOprn(MediaLibraryUnistoreManager::GetInstance().GetRdbStoreRaw()->GetRaw());
+    auto rdbStore = MediaLibraryUnistoreManager::GetInstance().GetRdbStoreRaw()->GetRaw();
+    AlbumMembership membership;
+    bool isAlbumChanged = IsAlbumChanged(cmd);
+    if (isAlbumChanged) {
+        MediaLibraryRdbUtils::CaptureAlbumMembership(rdbStore, { to_string(fileAsset->GetId()) }, membership);
+    }
+    TransactionOperations transactionOprn(rdbStore);
     errCode = transactionOprn.Start();
     if (errCode != E_OK) {
         return errCode;
@@ -722,6 +747,9 @@ int32_t MediaLibraryPhotoOperations::UpdateV9(MediaLibraryCommand &cmd)
         return rowId;
     }
     transactionOprn.Finish();
+    if (isAlbumChanged) {
+        MediaLibraryRdbUtils::UpdateAlbumsByMembership(rdbStore, membership);
+    }
 
     errCode = SendTrashNotify(cmd, fileAsset->GetId());
     if (errCode == E_OK) {
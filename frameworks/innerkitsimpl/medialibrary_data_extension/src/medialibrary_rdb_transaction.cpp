@@ -50,17 +50,17 @@ int32_t TransactionOperations::Start()
     return errCode;
 }
 
-void TransactionOperations::Finish()
+int32_t TransactionOperations::Finish()
 {
     if (!isStart) {
-        return;
+        return E_OK;
     }
-    if (!isFinish) {
-        int32_t ret = TransactionCommit();
-        if (ret == 0) {
-            isFinish = true;
-        }
+    if (isFinish) {
+        return E_OK;
     }
+    int32_t ret = TransactionCommit();
+    isFinish = true;
+    return ret;
 }
 
 int32_t TransactionOperations::BeginTransaction()
@@ -105,6 +105,10 @@ int32_t TransactionOperations::TransactionCommit()
     }
 
     int32_t errCode = rdbStore_->Commit();
+    if (errCode != NativeRdb::E_OK && rdbStore_->IsInTransaction()) {
+        // roll back before the next transaction may begin on the shared store, or its work goes with this one
+        rdbStore_->RollBack();
+    }
     isInTransaction_.store(false);
     transactionCV_.notify_all();
     if (errCode != NativeRdb::E_OK) {
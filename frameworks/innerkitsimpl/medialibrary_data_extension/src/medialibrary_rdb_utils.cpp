@@ -15,6 +15,8 @@
 
 #include "medialibrary_rdb_utils.h"
 
+#include <algorithm>
+#include <cstdlib>
 #include <iomanip>
 #include <sstream>
 #include <string>
@@ -34,6 +36,10 @@ using namespace NativeRdb;
 
 constexpr int32_t E_HAS_DB_ERROR = -222;
 constexpr int32_t E_SUCCESS = 0;
+constexpr size_t MAX_INCREMENTAL_REFRESH_ASSETS = 100;
+
+atomic<bool> MediaLibraryRdbUtils::isAlbumRefreshVerify_(false);
+atomic<uint32_t> MediaLibraryRdbUtils::albumRefreshMismatches_(0);
 
 static inline string GetStringValFromColumn(const shared_ptr<ResultSet> &resultSet, const int index)
 {
@@ -336,6 +342,7 @@ static int32_t SetUpdateValues(const shared_ptr<NativeRdb::RdbStore> &rdbStore,
         PhotoAlbumColumns::GetUserAlbumPredicates(GetAlbumId(albumResult), predicates);
     }
     predicates.OrderByDesc(PhotoColumn::MEDIA_DATE_ADDED);
+    predicates.OrderByDesc(PhotoColumn::MEDIA_ID);
     auto fileResult = QueryAlbumAssets(rdbStore, predicates, columns);
     if (fileResult == nullptr) {
         return E_HAS_DB_ERROR;
@@ -445,4 +452,297 @@ void MediaLibraryRdbUtils::UpdateSystemAlbumInternal(const shared_ptr<RdbStore>
 
     ForEachRow(rdbStore, albumResult, UpdateSysAlbumIfNeeded);
 }
+
+static void GetAlbumPredicates(int32_t albumId, PhotoAlbumSubType subtype, RdbPredicates &predicates)
+{
+    if (subtype == PhotoAlbumSubType::USER_GENERIC) {
+        PhotoAlbumColumns::GetUserAlbumPredicates(albumId, predicates);
+    } else {
+        PhotoAlbumColumns::GetSystemAlbumPredicates(subtype, predicates);
+    }
+}
+
+static int32_t GetCoverFileId(const string &cover)
+{
+    const string &prefix = PhotoColumn::PHOTO_URI_PREFIX;
+    if (cover.compare(0, prefix.size(), prefix) != 0) {
+        return 0;
+    }
+    return atoi(cover.c_str() + prefix.size());
+}
+
+static void CaptureMembers(const shared_ptr<RdbStore> &rdbStore, int32_t albumId, PhotoAlbumSubType subtype,
+    const vector<string> &fileIds, AlbumMembership &membership)
+{
+    RdbPredicates predicates(PhotoColumn::PHOTOS_TABLE);
+    GetAlbumPredicates(albumId, subtype, predicates);
+    predicates.In(PhotoColumn::MEDIA_ID, fileIds);
+    auto resultSet = Query(rdbStore, predicates, { PhotoColumn::MEDIA_ID });
+    if (resultSet == nullptr) {
+        membership.isFullRefresh = true;
+        return;
+    }
+    while (resultSet->GoToNextRow() == E_OK) {
+        membership.albums[albumId].insert(GetIntValFromColumn(resultSet, 0));
+    }
+}
+
+void MediaLibraryRdbUtils::CaptureAlbumMembership(const shared_ptr<RdbStore> &rdbStore,
+    const vector<string> &fileIds, AlbumMembership &membership)
+{
+    MediaLibraryTracer tracer;
+    tracer.Start("CaptureAlbumMembership");
+    membership.fileIds = fileIds;
+    membership.albums.clear();
+    membership.isFullRefresh = (fileIds.size() > MAX_INCREMENTAL_REFRESH_ASSETS);
+    if (membership.isFullRefresh || fileIds.empty()) {
+        return;
+    }
+
+    if (!membership.userAlbumIds.empty()) {
+        for (const auto &albumId : membership.userAlbumIds) {
+            CaptureMembers(rdbStore, atoi(albumId.c_str()), PhotoAlbumSubType::USER_GENERIC, fileIds, membership);
+        }
+        return;
+    }
+
+    auto albumResult = GetSystemAlbum(rdbStore, {}, { PhotoAlbumColumns::ALBUM_ID, PhotoAlbumColumns::ALBUM_SUBTYPE });
+    if (albumResult == nullptr) {
+        membership.isFullRefresh = true;
+        return;
+    }
+    while (albumResult->GoToNextRow() == E_OK) {
+        CaptureMembers(rdbStore, GetAlbumId(albumResult), static_cast<PhotoAlbumSubType>(GetAlbumSubType(albumResult)),
+            fileIds, membership);
+    }
+
+    /* only the user albums mapped to one of the assets can change */
+    RdbPredicates mapPredicates(PhotoMap::TABLE);
+    mapPredicates.In(PhotoMap::ASSET_ID, fileIds);
+    mapPredicates.Distinct();
+    auto mapResult = Query(rdbStore, mapPredicates, { PhotoMap::ALBUM_ID });
+    if (mapResult == nullptr) {
+        membership.isFullRefresh = true;
+        return;
+    }
+    while (mapResult->GoToNextRow() == E_OK) {
+        CaptureMembers(rdbStore, GetIntValFromColumn(mapResult, 0), PhotoAlbumSubType::USER_GENERIC, fileIds,
+            membership);
+    }
+}
+
+void MediaLibraryRdbUtils::CaptureAlbumMembership(const shared_ptr<RdbStore> &rdbStore,
+    const AbsRdbPredicates &predicates, AlbumMembership &membership)
+{
+    RdbPredicates filePredicates(PhotoColumn::PHOTOS_TABLE);
+    filePredicates.SetWhereClause(predicates.GetWhereClause());
+    filePredicates.SetWhereArgs(predicates.GetWhereArgs());
+    vector<string> fileIds;
+    if (rdbStore != nullptr) {
+        auto resultSet = rdbStore->Query(filePredicates, { PhotoColumn::MEDIA_ID });
+        while ((resultSet != nullptr) && (resultSet->GoToNextRow() == E_OK)) {
+            fileIds.push_back(to_string(GetIntValFromColumn(resultSet, 0)));
+        }
+    }
+    CaptureAlbumMembership(rdbStore, fileIds, membership);
+}
+
+/* the newest asset among the candidates, or of the whole album when candidates is empty */
+static int32_t QueryCover(const shared_ptr<RdbStore> &rdbStore, int32_t albumId, PhotoAlbumSubType subtype,
+    const vector<string> &candidates, string &cover)
+{
+    RdbPredicates predicates(PhotoColumn::PHOTOS_TABLE);
+    GetAlbumPredicates(albumId, subtype, predicates);
+    if (!candidates.empty()) {
+        predicates.In(PhotoColumn::MEDIA_ID, candidates);
+    }
+    predicates.OrderByDesc(PhotoColumn::MEDIA_DATE_ADDED);
+    predicates.OrderByDesc(PhotoColumn::MEDIA_ID);
+    predicates.Limit(1);
+    auto resultSet = Query(rdbStore, predicates,
+        { PhotoColumn::MEDIA_ID, PhotoColumn::MEDIA_FILE_PATH, PhotoColumn::MEDIA_NAME });
+    if (resultSet == nullptr) {
+        return E_HAS_DB_ERROR;
+    }
+    cover = (resultSet->GoToFirstRow() == E_OK) ? GetCover(resultSet) : "";
+    return E_SUCCESS;
+}
+
+static int32_t SetDeltaValues(const shared_ptr<RdbStore> &rdbStore, const shared_ptr<ResultSet> &albumResult,
+    const unordered_set<int32_t> &before, const unordered_set<int32_t> &after, const AlbumMembership &membership,
+    ValuesBucket &values)
+{
+    int32_t albumId = GetAlbumId(albumResult);
+    auto subtype = static_cast<PhotoAlbumSubType>(GetAlbumSubType(albumResult));
+    int32_t oldCount = GetAlbumCount(albumResult);
+    int32_t newCount = oldCount + static_cast<int32_t>(after.size()) - static_cast<int32_t>(before.size());
+    if (newCount < 0) {
+        return E_HAS_DB_ERROR;
+    }
+    if (newCount != oldCount) {
+        values.PutInt(PhotoAlbumColumns::ALBUM_COUNT, newCount);
+    }
+
+    string oldCover = GetAlbumCover(albumResult);
+    int32_t coverId = GetCoverFileId(oldCover);
+    bool isCoverChanged = find(membership.fileIds.begin(), membership.fileIds.end(), to_string(coverId)) !=
+        membership.fileIds.end();
+    if (!isCoverChanged && after.empty()) {
+        return E_SUCCESS;
+    }
+
+    /* the cover itself changed, pick the newest asset again, otherwise only the changed assets can beat it */
+    vector<string> candidates;
+    if (!isCoverChanged && !oldCover.empty()) {
+        candidates.push_back(to_string(coverId));
+        for (int32_t fileId : after) {
+            candidates.push_back(to_string(fileId));
+        }
+    }
+    string newCover;
+    int32_t err = QueryCover(rdbStore, albumId, subtype, candidates, newCover);
+    if (err != E_SUCCESS) {
+        return err;
+    }
+    if (newCover != oldCover) {
+        values.PutString(PhotoAlbumColumns::ALBUM_COVER_URI, newCover);
+    }
+    return E_SUCCESS;
+}
+
+/* returns true when the stored album differed from the full recompute and got repaired */
+static bool VerifyAlbum(const shared_ptr<RdbStore> &rdbStore, int32_t albumId)
+{
+    vector<string> columns = {
+        PhotoAlbumColumns::ALBUM_ID,
+        PhotoAlbumColumns::ALBUM_SUBTYPE,
+        PhotoAlbumColumns::ALBUM_COVER_URI,
+        PhotoAlbumColumns::ALBUM_COUNT,
+    };
+    RdbPredicates predicates(PhotoAlbumColumns::TABLE);
+    predicates.EqualTo(PhotoAlbumColumns::ALBUM_ID, to_string(albumId));
+    auto albumResult = Query(rdbStore, predicates, columns);
+    if ((albumResult == nullptr) || (albumResult->GoToFirstRow() != E_OK)) {
+        return false;
+    }
+    auto subtype = static_cast<PhotoAlbumSubType>(GetAlbumSubType(albumResult));
+    ValuesBucket values;
+    if (SetUpdateValues(rdbStore, albumResult, values,
+        (subtype == PhotoAlbumSubType::USER_GENERIC) ? static_cast<PhotoAlbumSubType>(0) : subtype) < 0) {
+        return false;
+    }
+    if (values.IsEmpty()) {
+        return false;
+    }
+    MEDIA_ERR_LOG("Incremental refresh of album %{public}d differs from the full recompute, repair it", albumId);
+    int32_t changedRows = 0;
+    rdbStore->Update(changedRows, values, predicates);
+    return true;
+}
+
+static int32_t UpdateAlbumByDelta(const shared_ptr<RdbStore> &rdbStore, const shared_ptr<ResultSet> &albumResult,
+    const AlbumMembership &before, const AlbumMembership &after, bool isVerify, uint32_t &mismatches)
+{
+    static const unordered_set<int32_t> noMembers;
+    int32_t albumId = GetAlbumId(albumResult);
+    auto beforeItr = before.albums.find(albumId);
+    auto afterItr = after.albums.find(albumId);
+    ValuesBucket values;
+    int32_t err = SetDeltaValues(rdbStore, albumResult,
+        (beforeItr == before.albums.end()) ? noMembers : beforeItr->second,
+        (afterItr == after.albums.end()) ? noMembers : afterItr->second, before, values);
+    if (err < 0) {
+        /* the stored count is off, fall back to a full recompute of this album */
+        MEDIA_WARN_LOG("Failed to refresh album %{public}d incrementally", albumId);
+        if (VerifyAlbum(rdbStore, albumId)) {
+            mismatches++;
+        }
+        return err;
+    }
+    if (!values.IsEmpty()) {
+        RdbPredicates predicates(PhotoAlbumColumns::TABLE);
+        predicates.EqualTo(PhotoAlbumColumns::ALBUM_ID, to_string(albumId));
+        int32_t changedRows = 0;
+        err = rdbStore->Update(changedRows, values, predicates);
+        if (err < 0) {
+            MEDIA_WARN_LOG("Failed to update album count and cover! err: %{public}d", err);
+        }
+    }
+    if (isVerify && VerifyAlbum(rdbStore, albumId)) {
+        mismatches++;
+    }
+    return E_SUCCESS;
+}
+
+static void UpdateAllAlbums(const shared_ptr<RdbStore> &rdbStore, const AlbumMembership &membership)
+{
+    if (!membership.userAlbumIds.empty()) {
+        MediaLibraryRdbUtils::UpdateUserAlbumInternal(rdbStore, membership.userAlbumIds);
+        return;
+    }
+    MediaLibraryRdbUtils::UpdateUserAlbumInternal(rdbStore);
+    MediaLibraryRdbUtils::UpdateSystemAlbumInternal(rdbStore);
+}
+
+void MediaLibraryRdbUtils::UpdateAlbumsByMembership(const shared_ptr<RdbStore> &rdbStore,
+    const AlbumMembership &before)
+{
+    if (before.isFullRefresh) {
+        UpdateAllAlbums(rdbStore, before);
+        return;
+    }
+    MediaLibraryTracer tracer;
+    tracer.Start("UpdateAlbumsByMembership");
+    AlbumMembership after;
+    after.userAlbumIds = before.userAlbumIds;
+    CaptureAlbumMembership(rdbStore, before.fileIds, after);
+    if (after.isFullRefresh) {
+        UpdateAllAlbums(rdbStore, before);
+        return;
+    }
+
+    vector<string> albumIds;
+    for (const auto &album : before.albums) {
+        albumIds.push_back(to_string(album.first));
+    }
+    for (const auto &album : after.albums) {
+        if (before.albums.count(album.first) == 0) {
+            albumIds.push_back(to_string(album.first));
+        }
+    }
+    if (albumIds.empty()) {
+        return;
+    }
+
+    vector<string> columns = {
+        PhotoAlbumColumns::ALBUM_ID,
+        PhotoAlbumColumns::ALBUM_SUBTYPE,
+        PhotoAlbumColumns::ALBUM_COVER_URI,
+        PhotoAlbumColumns::ALBUM_COUNT,
+    };
+    RdbPredicates albumPredicates(PhotoAlbumColumns::TABLE);
+    albumPredicates.In(PhotoAlbumColumns::ALBUM_ID, albumIds);
+    auto albumResult = Query(rdbStore, albumPredicates, columns);
+    if (albumResult == nullptr) {
+        return;
+    }
+    bool isVerify = isAlbumRefreshVerify_.load();
+    uint32_t mismatches = 0;
+    ForEachRow(rdbStore, albumResult, [&before, &after, isVerify, &mismatches](const shared_ptr<RdbStore> &store,
+        const shared_ptr<ResultSet> &album) {
+        return UpdateAlbumByDelta(store, album, before, after, isVerify, mismatches);
+    });
+    albumRefreshMismatches_ += mismatches;
+}
+
+void MediaLibraryRdbUtils::SetAlbumRefreshVerify(bool isVerify)
+{
+    isAlbumRefreshVerify_ = isVerify;
+    albumRefreshMismatches_ = 0;
+}
+
+uint32_t MediaLibraryRdbUtils::GetAlbumRefreshMismatches()
+{
+    return albumRefreshMismatches_.load();
+}
 } // namespace OHOS::Media
@@ -16,7 +16,11 @@
 
 #include "medialibrary_rdbstore.h"
 
+#include <atomic>
 #include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "cloud_sync_helper.h"
 #include "ipc_skeleton.h"
@@ -29,6 +33,7 @@
 #endif
 #include "medialibrary_errno.h"
 #include "medialibrary_object_utils.h"
+#include "medialibrary_rdb_transaction.h"
 #include "medialibrary_tracer.h"
 #include "media_scanner.h"
 #include "media_scanner_manager.h"
@@ -56,6 +61,8 @@ public:
 }
 namespace OHOS::Media {
 shared_ptr<NativeRdb::RdbStore> MediaLibraryRdbStore::rdbStore_;
+constexpr size_t DELETE_BATCH_SIZE = 500;
+constexpr size_t DELETE_IO_THREAD_NUM = 4;
 struct UniqueMemberValuesBucket {
     std::string assetMediaType;
     int32_t startNumber;
@@ -460,23 +467,236 @@ shared_ptr<NativeRdb::RdbStore> MediaLibraryRdbStore::GetRaw() const
     return rdbStore_;
 }
 
-static inline int32_t DeleteDbByFileId(const string &table, int32_t fileId, const bool compatible)
+struct DeleteEntry {
+    std::string fileId;
+    std::string filePath;
+    bool claimed = false;
+    bool removed = false;
+    // the whole row as it was before the delete, written back when the file can not be removed
+    ValuesBucket row;
+};
+
+static void AddDeletePredicates(AbsRdbPredicates &predicates, const vector<string> &fileIds, const bool compatible)
 {
-    AbsRdbPredicates predicates(table);
-    predicates.EqualTo(MediaColumn::MEDIA_ID, to_string(fileId));
+    predicates.In(MediaColumn::MEDIA_ID, fileIds);
     if (!compatible) {
         predicates.GreaterThan(MediaColumn::MEDIA_DATE_TRASHED, to_string(0));
     }
-    return MediaLibraryRdbStore::Delete(predicates);
 }
 
-int32_t MediaLibraryRdbStore::DeleteFromDisk(const AbsRdbPredicates &predicates, const bool compatible)
+static int32_t GetRowValues(const shared_ptr<ResultSet> &resultSet, ValuesBucket &values)
+{
+    vector<string> columnNames;
+    int32_t err = resultSet->GetAllColumnNames(columnNames);
+    if (err != NativeRdb::E_OK) {
+        return E_HAS_DB_ERROR;
+    }
+    for (int32_t i = 0; i < static_cast<int32_t>(columnNames.size()); i++) {
+        ColumnType type = ColumnType::TYPE_NULL;
+        if (resultSet->GetColumnType(i, type) != NativeRdb::E_OK) {
+            return E_HAS_DB_ERROR;
+        }
+        switch (type) {
+            case ColumnType::TYPE_INTEGER: {
+                int64_t value = 0;
+                resultSet->GetLong(i, value);
+                values.PutLong(columnNames[i], value);
+                break;
+            }
+            case ColumnType::TYPE_FLOAT: {
+                double value = 0;
+                resultSet->GetDouble(i, value);
+                values.PutDouble(columnNames[i], value);
+                break;
+            }
+            case ColumnType::TYPE_STRING: {
+                string value;
+                resultSet->GetString(i, value);
+                values.PutString(columnNames[i], value);
+                break;
+            }
+            case ColumnType::TYPE_BLOB: {
+                vector<uint8_t> value;
+                resultSet->GetBlob(i, value);
+                values.PutBlob(columnNames[i], value);
+                break;
+            }
+            default:
+                values.PutNull(columnNames[i]);
+                break;
+        }
+    }
+    return E_OK;
+}
+
+/* keeps the entries whose rows still match, along with their rows */
+static int32_t ClaimDeleteEntries(RdbStore &rdb, const string &table, vector<DeleteEntry> &entries,
+    const bool compatible)
+{
+    vector<string> fileIds;
+    fileIds.reserve(entries.size());
+    for (const auto &entry : entries) {
+        fileIds.push_back(entry.fileId);
+    }
+    AbsRdbPredicates predicates(table);
+    AddDeletePredicates(predicates, fileIds, compatible);
+    auto resultSet = rdb.Query(predicates, {});
+    if (resultSet == nullptr) {
+        return E_HAS_DB_ERROR;
+    }
+    unordered_map<string, ValuesBucket> rows;
+    while (resultSet->GoToNextRow() == NativeRdb::E_OK) {
+        ValuesBucket row;
+        if (GetRowValues(resultSet, row) != E_OK) {
+            return E_HAS_DB_ERROR;
+        }
+        rows.emplace(to_string(MediaLibraryRdbStore::GetInt(resultSet, MediaColumn::MEDIA_ID)), move(row));
+    }
+    for (auto &entry : entries) {
+        auto itr = rows.find(entry.fileId);
+        entry.claimed = (itr != rows.end());
+        if (entry.claimed) {
+            entry.row = move(itr->second);
+        }
+    }
+    return E_OK;
+}
+
+static void RemoveEntryFiles(const string &table, vector<DeleteEntry> &entries)
+{
+    // unlinks are independent of each other, so they are spread over a few threads
+    atomic<size_t> next(0);
+    auto removeFiles = [&table, &entries, &next]() {
+        for (size_t i = next++; i < entries.size(); i = next++) {
+            DeleteEntry &entry = entries[i];
+            if (!entry.claimed) {
+                continue;
+            }
+            if (!MediaFileUtils::DeleteFile(entry.filePath) && (errno != ENOENT)) {
+                MEDIA_ERR_LOG("Failed to delete file, errno: %{public}d, path: %{private}s", errno,
+                    entry.filePath.c_str());
+                continue;
+            }
+            entry.removed = true;
+            MediaLibraryObjectUtils::InvalidateThumbnail(entry.fileId, table, entry.filePath);
+        }
+    };
+    size_t threadNum = min(DELETE_IO_THREAD_NUM, entries.size());
+    vector<thread> threads;
+    threads.reserve(threadNum);
+    for (size_t i = 1; i < threadNum; i++) {
+        threads.emplace_back(removeFiles);
+    }
+    removeFiles();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+/* deletes the claimed rows of a batch and commits, the files are only removed once the rows are gone */
+static int32_t DeleteEntryRows(const shared_ptr<RdbStore> &rdbStore, const string &table,
+    vector<DeleteEntry> &entries, const bool compatible)
+{
+    TransactionOperations transactionOprn(rdbStore);
+    int32_t err = transactionOprn.Start();
+    if (err != NativeRdb::E_OK) {
+        MEDIA_ERR_LOG("Failed to start transaction, err: %{public}d", err);
+        return E_HAS_DB_ERROR;
+    }
+    err = ClaimDeleteEntries(*rdbStore, table, entries, compatible);
+    if (err != E_OK) {
+        return err;
+    }
+    vector<string> claimedIds;
+    for (const auto &entry : entries) {
+        if (entry.claimed) {
+            claimedIds.push_back(entry.fileId);
+        }
+    }
+    if (claimedIds.empty()) {
+        return 0;
+    }
+    AbsRdbPredicates predicates(table);
+    AddDeletePredicates(predicates, claimedIds, compatible);
+    int32_t deletedRows = 0;
+    err = DoDeleteFromPredicates(*rdbStore, predicates, deletedRows);
+    if (err != NativeRdb::E_OK) {
+        MEDIA_ERR_LOG("Failed to execute delete, err: %{public}d", err);
+        return E_HAS_DB_ERROR;
+    }
+    err = transactionOprn.Finish();
+    if (err != E_OK) {
+        MEDIA_ERR_LOG("Failed to commit delete, err: %{public}d", err);
+        return E_HAS_DB_ERROR;
+    }
+    return deletedRows;
+}
+
+/* puts back the rows of the files that could not be removed, so a later delete retries them */
+static int32_t RestoreEntryRows(const shared_ptr<RdbStore> &rdbStore, const string &table,
+    const vector<DeleteEntry> &entries)
+{
+    TransactionOperations transactionOprn(rdbStore);
+    int32_t err = transactionOprn.Start();
+    if (err != NativeRdb::E_OK) {
+        MEDIA_ERR_LOG("Failed to start transaction, err: %{public}d", err);
+        return E_HAS_DB_ERROR;
+    }
+    int32_t restoredRows = 0;
+    for (const auto &entry : entries) {
+        if (!entry.claimed || entry.removed) {
+            continue;
+        }
+        // the row is either only marked as deleted or already gone, replace covers both
+        int64_t rowId = 0;
+        err = rdbStore->Replace(rowId, table, entry.row);
+        if (err != NativeRdb::E_OK) {
+            MEDIA_ERR_LOG("Failed to restore row of file %{public}s, err: %{public}d", entry.fileId.c_str(), err);
+            continue;
+        }
+        restoredRows++;
+    }
+    err = transactionOprn.Finish();
+    if (err != E_OK) {
+        MEDIA_ERR_LOG("Failed to commit restored rows, err: %{public}d", err);
+        return 0;
+    }
+    return restoredRows;
+}
+
+/*
+ * Deletes one batch: the rows still matching are deleted and committed first, then their files are removed
+ * outside of the transaction, and the rows of the files that could not be removed are written back for a retry.
+ */
+static int32_t DeleteBatchFromDisk(const shared_ptr<RdbStore> &rdbStore, const string &table,
+    vector<DeleteEntry> &entries, const bool compatible, bool &hasFsError)
+{
+    int32_t deletedRows = DeleteEntryRows(rdbStore, table, entries, compatible);
+    if (deletedRows <= 0) {
+        return deletedRows;
+    }
+    RemoveEntryFiles(table, entries);
+    bool hasKeptFile = false;
+    for (const auto &entry : entries) {
+        if (entry.claimed && !entry.removed) {
+            hasKeptFile = true;
+            break;
+        }
+    }
+    if (!hasKeptFile) {
+        return deletedRows;
+    }
+    hasFsError = true;
+    return max(deletedRows - RestoreEntryRows(rdbStore, table, entries), 0);
+}
+
+static int32_t QueryDeleteEntries(const AbsRdbPredicates &predicates, vector<DeleteEntry> &entries)
 {
     vector<string> columns = {
         MediaColumn::MEDIA_ID,
         MediaColumn::MEDIA_FILE_PATH
     };
-    auto resultSet = Query(predicates, columns);
+    auto resultSet = MediaLibraryRdbStore::Query(predicates, columns);
     if (resultSet == nullptr) {
         return E_HAS_DB_ERROR;
     }
@@ -485,41 +705,54 @@ int32_t MediaLibraryRdbStore::DeleteFromDisk(const AbsRdbPredicates &predicates,
     if (err != E_OK) {
         return E_HAS_DB_ERROR;
     }
-    int32_t deletedRows = 0;
+    entries.reserve(count);
     for (int32_t i = 0; i < count; i++) {
         err = resultSet->GoToNextRow();
         if (err != E_OK) {
             return E_HAS_DB_ERROR;
         }
-
-        // Delete file from db.
-        int32_t fileId = get<int32_t>(ResultSetUtils::GetValFromColumn(MediaColumn::MEDIA_ID, resultSet, TYPE_INT32));
-        if (fileId <= 0) {
-            return E_HAS_DB_ERROR;
-        }
-        int32_t deletedRow = DeleteDbByFileId(predicates.GetTableName(), fileId, compatible);
-        if (deletedRow < 0) {
+        int32_t fileId = MediaLibraryRdbStore::GetInt(resultSet, MediaColumn::MEDIA_ID);
+        string filePath = MediaLibraryRdbStore::GetString(resultSet, MediaColumn::MEDIA_FILE_PATH);
+        if ((fileId <= 0) || filePath.empty()) {
             return E_HAS_DB_ERROR;
         }
-        // If deletedRow is 0, the file may be deleted already somewhere else, so just continue.
-        if (deletedRow == 0) {
-            continue;
-        }
+        entries.push_back({ to_string(fileId), filePath });
+    }
+    return E_OK;
+}
 
-        // Delete file from file system.
-        string filePath = get<string>(ResultSetUtils::GetValFromColumn(MediaColumn::MEDIA_FILE_PATH, resultSet,
-                                                                       TYPE_STRING));
-        if (filePath.empty()) {
-            return E_HAS_DB_ERROR;
-        }
-        if (!MediaFileUtils::DeleteFile(filePath) && (errno != ENOENT)) {
-            MEDIA_ERR_LOG("Failed to delete file, errno: %{public}d, path: %{private}s", errno, filePath.c_str());
-            return E_HAS_FS_ERROR;
+int32_t MediaLibraryRdbStore::DeleteFromDisk(const AbsRdbPredicates &predicates, const bool compatible)
+{
+    if (rdbStore_ == nullptr) {
+        MEDIA_ERR_LOG("Pointer rdbStore_ is nullptr. Maybe it didn't init successfully.");
+        return E_HAS_DB_ERROR;
+    }
+    vector<DeleteEntry> entries;
+    int32_t err = QueryDeleteEntries(predicates, entries);
+    if (err != E_OK) {
+        return err;
+    }
+
+    int32_t deletedRows = 0;
+    bool hasFsError = false;
+    for (size_t begin = 0; begin < entries.size(); begin += DELETE_BATCH_SIZE) {
+        vector<DeleteEntry> batch(entries.begin() + begin,
+            entries.begin() + min(entries.size(), begin + DELETE_BATCH_SIZE));
+        int32_t batchRows = DeleteBatchFromDisk(rdbStore_, predicates.GetTableName(), batch, compatible,
+            hasFsError);
+        if (batchRows < 0) {
+            err = batchRows;
+            break;
         }
-        MediaLibraryObjectUtils::InvalidateThumbnail(to_string(fileId), predicates.GetTableName(), filePath);
-        deletedRows += deletedRow;
+        deletedRows += batchRows;
     }
-    return deletedRows;
+    if (deletedRows > 0) {
+        CloudSyncHelper::GetInstance()->StartSync();
+    }
+    if (err != E_OK) {
+        return err;
+    }
+    return hasFsError ? E_HAS_FS_ERROR : deletedRows;
 }
 
 void MediaLibraryRdbStore::ReplacePredicatesUriToId(AbsRdbPredicates &predicates)
@@ -868,6 +1101,7 @@ static int32_t ExecuteSql(RdbStore &store)
         CREATE_MEDIATYPE_DIRECTORY_TABLE,
         CREATE_BUNDLE_PREMISSION_TABLE,
         CREATE_MEDIALIBRARY_ERROR_TABLE,
+        CREATE_MEDIALIBRARY_SCAN_JOURNAL_TABLE,
         CREATE_REMOTE_THUMBNAIL_TABLE,
         CREATE_FILES_DELETE_TRIGGER,
         CREATE_FILES_MDIRTY_TRIGGER,
@@ -1362,6 +1596,14 @@ static void AddVisionTables(RdbStore &store)
     ExecSqls(executeSqlStrs, store);
 }
 
+static void AddScanJournalTable(RdbStore &store)
+{
+    const vector<string> sqls = {
+        CREATE_MEDIALIBRARY_SCAN_JOURNAL_TABLE,
+    };
+    ExecSqls(sqls, store);
+}
+
 int32_t MediaLibraryDataCallBack::OnUpgrade(RdbStore &store, int32_t oldVersion, int32_t newVersion)
 {
     MEDIA_DEBUG_LOG("OnUpgrade old:%d, new:%d", oldVersion, newVersion);
@@ -1412,6 +1654,10 @@ int32_t MediaLibraryDataCallBack::OnUpgrade(RdbStore &store, int32_t oldVersion,
     if (oldVersion < VERSION_ADD_VISION_TABLE) {
         AddVisionTables(store);
     }
+
+    if (oldVersion < VERSION_ADD_SCAN_JOURNAL) {
+        AddScanJournalTable(store);
+    }
     return NativeRdb::E_OK;
 }
 
@@ -30,6 +30,7 @@
 #include "media_log.h"
 #include "media_scanner_manager.h"
 #include "medialibrary_inotify.h"
+#include "thumbnail_generate_engine.h"
 #include "application_context.h"
 #include "ability_manager_client.h"
 using namespace OHOS::AAFwk;
@@ -41,9 +42,13 @@ const std::vector<std::string> MedialibrarySubscriber::events_ = {
     EventFwk::CommonEventSupport::COMMON_EVENT_POWER_DISCONNECTED,
     EventFwk::CommonEventSupport::COMMON_EVENT_SCREEN_OFF,
     EventFwk::CommonEventSupport::COMMON_EVENT_SCREEN_ON,
-    EventFwk::CommonEventSupport::COMMON_EVENT_PACKAGE_REMOVED
+    EventFwk::CommonEventSupport::COMMON_EVENT_PACKAGE_REMOVED,
+    EventFwk::CommonEventSupport::COMMON_EVENT_THERMAL_LEVEL_CHANGED
 };
 
+// the thermal manager puts the level under its ThermalCommonEventCode::CODE_THERMAL_LEVEL_CHANGED
+static const std::string THERMAL_LEVEL_KEY = "0";
+
 MedialibrarySubscriber::MedialibrarySubscriber(const EventFwk::CommonEventSubscribeInfo &subscriberInfo)
     : EventFwk::CommonEventSubscriber(subscriberInfo)
 {
@@ -84,6 +89,8 @@ void MedialibrarySubscriber::OnReceiveEvent(const EventFwk::CommonEventData &eve
         string packageName = want.GetElement().GetBundleName();
         RevertPendingByPackage(packageName);
         MediaLibraryBundleManager::GetInstance()->Clear();
+    } else if (action.compare(EventFwk::CommonEventSupport::COMMON_EVENT_THERMAL_LEVEL_CHANGED) == 0) {
+        ThumbnailGenerateEngine::GetInstance().SetThermalLevel(want.GetIntParam(THERMAL_LEVEL_KEY, 0));
     }
 }
 
@@ -132,6 +139,11 @@ void MedialibrarySubscriber::DoBackgroundOperation()
             MEDIA_ERR_LOG("DoTrashAging faild");
         }
 
+        result = dataManager->RefreshAlbums();
+        if (result != E_OK) {
+            MEDIA_ERR_LOG("RefreshAlbums faild");
+        }
+
         VariantMap map = {{KEY_COUNT, *trashCountPtr}};
         PostEventUtils::GetInstance().PostStatProcess(StatType::AGING_STAT, map);
 
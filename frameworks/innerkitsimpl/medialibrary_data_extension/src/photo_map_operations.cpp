@@ -95,6 +95,26 @@ int32_t PhotoMapOperations::AddPhotoAssets(const vector<DataShareValuesBucket> &
         return E_HAS_DB_ERROR;
     }
 
+    /* only the album the assets are added to can change */
+    AlbumMembership membership;
+    bool isValid = false;
+    int32_t albumId = 0;
+    if (!values.empty()) {
+        albumId = values[0].Get(PhotoMap::ALBUM_ID, isValid);
+    }
+    if (isValid && (albumId > 0)) {
+        vector<string> fileIds;
+        for (const auto &value : values) {
+            bool isAssetValid = false;
+            string assetUri = value.Get(PhotoMap::ASSET_ID, isAssetValid);
+            if (isAssetValid) {
+                fileIds.push_back(MediaFileUri::GetPhotoId(assetUri));
+            }
+        }
+        membership.userAlbumIds = { to_string(albumId) };
+        MediaLibraryRdbUtils::CaptureAlbumMembership(rdbStore->GetRaw(), fileIds, membership);
+    }
+
     vector<string> notifyUris;
     TransactionOperations op(rdbStore->GetRaw());
     int32_t changedRows = 0;
@@ -116,13 +136,11 @@ int32_t PhotoMapOperations::AddPhotoAssets(const vector<DataShareValuesBucket> &
         return changedRows;
     }
 
-    bool isValid = false;
-    int32_t albumId = values[0].Get(PhotoMap::ALBUM_ID, isValid);
     if (!isValid || albumId <= 0) {
         MEDIA_WARN_LOG("Ignore failure on get album id when add assets, album updating would be lost");
         return changedRows;
     }
-    MediaLibraryRdbUtils::UpdateUserAlbumInternal(rdbStore->GetRaw(), { to_string(albumId) });
+    MediaLibraryRdbUtils::UpdateAlbumsByMembership(rdbStore->GetRaw(), membership);
 
     auto watch = MediaLibraryNotify::GetInstance();
     for (const auto &uri : notifyUris) {
@@ -136,6 +154,15 @@ int32_t PhotoMapOperations::RemovePhotoAssets(RdbPredicates &predicates)
 {
     vector<string> whereArgs = predicates.GetWhereArgs();
     MediaLibraryRdbStore::ReplacePredicatesUriToId(predicates);
+    /* the first argument is the album id, the rest are the asset ids */
+    AlbumMembership membership;
+    const vector<string> &args = predicates.GetWhereArgs();
+    auto rdbStore = MediaLibraryUnistoreManager::GetInstance().GetRdbStoreRaw()->GetRaw();
+    if (!args.empty()) {
+        membership.userAlbumIds = { args[0] };
+        MediaLibraryRdbUtils::CaptureAlbumMembership(rdbStore, vector<string>(args.begin() + 1, args.end()),
+            membership);
+    }
     int deleteRow = MediaLibraryRdbStore::Delete(predicates);
     if (deleteRow <= 0) {
         return deleteRow;
@@ -151,8 +178,7 @@ int32_t PhotoMapOperations::RemovePhotoAssets(RdbPredicates &predicates)
         MEDIA_WARN_LOG("Ignore failure on get album id when remove assets, album updating would be lost");
         return deleteRow;
     }
-    MediaLibraryRdbUtils::UpdateUserAlbumInternal(
-        MediaLibraryUnistoreManager::GetInstance().GetRdbStoreRaw()->GetRaw(), { strAlbumId });
+    MediaLibraryRdbUtils::UpdateAlbumsByMembership(rdbStore, membership);
 
     auto watch = MediaLibraryNotify::GetInstance();
     for (size_t i = 1; i < whereArgs.size(); i++) {
@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "medialibrary_async_worker_test.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "medialibrary_async_worker.h"
+
+using namespace std;
+using namespace testing::ext;
+
+namespace OHOS {
+namespace Media {
+constexpr chrono::seconds TASK_TIMEOUT = chrono::seconds(5);
+constexpr int32_t TEST_TASK_COUNT = 8;
+static int32_t g_threadNum = 0;
+
+/* tasks that hold their worker until the gate opens, and the order tasks ran in, shared with the tasks */
+class TaskRecorder {
+public:
+    void Block()
+    {
+        unique_lock<mutex> lock(lock_);
+        started_++;
+        cv_.notify_all();
+        cv_.wait_for(lock, TASK_TIMEOUT, [this]() { return isOpen_; });
+    }
+
+    void Open()
+    {
+        lock_guard<mutex> lock(lock_);
+        isOpen_ = true;
+        cv_.notify_all();
+    }
+
+    void Record(int32_t id)
+    {
+        lock_guard<mutex> lock(lock_);
+        order_.push_back(id);
+        cv_.notify_all();
+    }
+
+    bool WaitStarted(int32_t count)
+    {
+        unique_lock<mutex> lock(lock_);
+        return cv_.wait_for(lock, TASK_TIMEOUT, [this, count]() { return started_ >= count; });
+    }
+
+    bool WaitRecorded(size_t count)
+    {
+        unique_lock<mutex> lock(lock_);
+        return cv_.wait_for(lock, TASK_TIMEOUT, [this, count]() { return order_.size() >= count; });
+    }
+
+    vector<int32_t> GetOrder()
+    {
+        lock_guard<mutex> lock(lock_);
+        return order_;
+    }
+
+private:
+    mutex lock_;
+    condition_variable cv_;
+    bool isOpen_ = false;
+    int32_t started_ = 0;
+    vector<int32_t> order_;
+};
+
+static void AddBlockTask(const shared_ptr<TaskRecorder> &recorder, AsyncTaskPriority priority)
+{
+    auto task = make_shared<MediaLibraryAsyncTask>([recorder]() { recorder->Block(); });
+    MediaLibraryAsyncWorker::GetInstance()->AddTask(task, priority);
+}
+
+static void AddRecordTask(const shared_ptr<TaskRecorder> &recorder, int32_t id, AsyncTaskPriority priority)
+{
+    auto task = make_shared<MediaLibraryAsyncTask>([recorder, id]() { recorder->Record(id); });
+    MediaLibraryAsyncWorker::GetInstance()->AddTask(task, priority);
+}
+
+void MediaLibraryAsyncWorkerTest::SetUpTestCase(void)
+{
+    g_threadNum = MediaLibraryAsyncWorker::GetInstance()->GetThreadNum();
+}
+
+void MediaLibraryAsyncWorkerTest::TearDownTestCase(void)
+{
+    MediaLibraryAsyncWorker::GetInstance()->SetThreadNum(g_threadNum);
+}
+
+void MediaLibraryAsyncWorkerTest::SetUp() {}
+
+void MediaLibraryAsyncWorkerTest::TearDown(void) {}
+
+HWTEST_F(MediaLibraryAsyncWorkerTest, medialib_AsyncWorker_Priority_test_001, TestSize.Level0)
+{
+    auto asyncWorker = MediaLibraryAsyncWorker::GetInstance();
+    ASSERT_NE(asyncWorker, nullptr);
+    asyncWorker->SetThreadNum(1);
+    auto recorder = make_shared<TaskRecorder>();
+    AddBlockTask(recorder, AsyncTaskPriority::HIGH);
+    ASSERT_TRUE(recorder->WaitStarted(1));
+
+    // queued lowest class first, run highest class first
+    AddRecordTask(recorder, static_cast<int32_t>(AsyncTaskPriority::IDLE), AsyncTaskPriority::IDLE);
+    AddRecordTask(recorder, static_cast<int32_t>(AsyncTaskPriority::BACKGROUND), AsyncTaskPriority::BACKGROUND);
+    AddRecordTask(recorder, static_cast<int32_t>(AsyncTaskPriority::FOREGROUND), AsyncTaskPriority::FOREGROUND);
+    AddRecordTask(recorder, static_cast<int32_t>(AsyncTaskPriority::HIGH), AsyncTaskPriority::HIGH);
+    recorder->Open();
+    ASSERT_TRUE(recorder->WaitRecorded(static_cast<size_t>(AsyncTaskPriority::COUNT)));
+
+    vector<int32_t> expected = { static_cast<int32_t>(AsyncTaskPriority::HIGH),
+        static_cast<int32_t>(AsyncTaskPriority::FOREGROUND), static_cast<int32_t>(AsyncTaskPriority::BACKGROUND),
+        static_cast<int32_t>(AsyncTaskPriority::IDLE) };
+    EXPECT_EQ(recorder->GetOrder(), expected);
+}
+
+HWTEST_F(MediaLibraryAsyncWorkerTest, medialib_AsyncWorker_Priority_test_002, TestSize.Level0)
+{
+    auto asyncWorker = MediaLibraryAsyncWorker::GetInstance();
+    ASSERT_NE(asyncWorker, nullptr);
+    asyncWorker->SetThreadNum(1);
+    auto recorder = make_shared<TaskRecorder>();
+    AddBlockTask(recorder, AsyncTaskPriority::FOREGROUND);
+    ASSERT_TRUE(recorder->WaitStarted(1));
+
+    // tasks of one class run in submission order, and a cancelled one is dropped
+    vector<shared_ptr<MediaLibraryAsyncTask>> tasks;
+    for (int32_t i = 0; i < TEST_TASK_COUNT; i++) {
+        tasks.push_back(make_shared<MediaLibraryAsyncTask>([recorder, i]() { recorder->Record(i); }));
+        asyncWorker->AddTask(tasks.back(), AsyncTaskPriority::BACKGROUND);
+    }
+    tasks[0]->Cancel();
+    recorder->Open();
+    ASSERT_TRUE(recorder->WaitRecorded(TEST_TASK_COUNT - 1));
+
+    vector<int32_t> expected;
+    for (int32_t i = 1; i < TEST_TASK_COUNT; i++) {
+        expected.push_back(i);
+    }
+    EXPECT_EQ(recorder->GetOrder(), expected);
+}
+
+HWTEST_F(MediaLibraryAsyncWorkerTest, medialib_AsyncWorker_Steal_test_001, TestSize.Level0)
+{
+    auto asyncWorker = MediaLibraryAsyncWorker::GetInstance();
+    ASSERT_NE(asyncWorker, nullptr);
+    asyncWorker->SetThreadNum(2);
+    auto recorder = make_shared<TaskRecorder>();
+    AddBlockTask(recorder, AsyncTaskPriority::FOREGROUND);
+    ASSERT_TRUE(recorder->WaitStarted(1));
+
+    // half of the tasks land on the queue of the blocked worker, the other worker steals them
+    for (int32_t i = 0; i < TEST_TASK_COUNT; i++) {
+        AddRecordTask(recorder, i, AsyncTaskPriority::FOREGROUND);
+    }
+    EXPECT_TRUE(recorder->WaitRecorded(TEST_TASK_COUNT));
+    recorder->Open();
+}
+
+HWTEST_F(MediaLibraryAsyncWorkerTest, medialib_AsyncWorker_Retire_test_001, TestSize.Level0)
+{
+    auto asyncWorker = MediaLibraryAsyncWorker::GetInstance();
+    ASSERT_NE(asyncWorker, nullptr);
+    asyncWorker->SetThreadNum(2);
+    auto recorder = make_shared<TaskRecorder>();
+    AddBlockTask(recorder, AsyncTaskPriority::FOREGROUND);
+    AddBlockTask(recorder, AsyncTaskPriority::FOREGROUND);
+    ASSERT_TRUE(recorder->WaitStarted(2));
+
+    // the tasks alternate between the two queues, the queue of the retired worker is drained oldest first
+    for (int32_t i = 0; i < TEST_TASK_COUNT; i++) {
+        AddRecordTask(recorder, i, AsyncTaskPriority::FOREGROUND);
+    }
+    asyncWorker->SetThreadNum(1);
+    recorder->Open();
+    ASSERT_TRUE(recorder->WaitRecorded(TEST_TASK_COUNT));
+
+    vector<int32_t> order = recorder->GetOrder();
+    int32_t lastEven = -1;
+    int32_t lastOdd = -1;
+    for (int32_t id : order) {
+        int32_t &last = (id % 2 == 0) ? lastEven : lastOdd;
+        EXPECT_GT(id, last);
+        last = id;
+    }
+}
+} // namespace Media
+} // namespace OHOS
@@ -13,6 +13,10 @@
  * limitations under the License.
  */
 #include "medialibrary_common_utils_test.h"
+
+#include <chrono>
+
+#include "media_log.h"
 #include "medialibrary_errno.h"
 #include "thumbnail_utils.h"
 #define private public
@@ -113,39 +117,34 @@ HWTEST_F(MediaLibraryCommonUtilsTest, medialib_CheckKeyWord_test_001, TestSize.L
     EXPECT_EQ(ret, false);
 }
 
-HWTEST_F(MediaLibraryCommonUtilsTest, medialib_SeprateSelection_test_001, TestSize.Level0)
+HWTEST_F(MediaLibraryCommonUtilsTest, medialib_NormalizeSelection_test_001, TestSize.Level0)
 {
-    string strCondition = "SeprateSelection";
-    vector<string> sepratedStr;
-    MediaLibraryCommonUtils::SeprateSelection(strCondition, sepratedStr);
-    EXPECT_NE(sepratedStr.size(), 0);
+    string selection;
+    MediaLibraryCommonUtils::NormalizeSelection("", selection);
+    EXPECT_EQ(selection, "");
+    MediaLibraryCommonUtils::NormalizeSelection("Media_Type = ?  AND\t(Date_Added > ?)", selection);
+    EXPECT_EQ(selection, "media_type = ? and date_added > ?");
 }
 
-HWTEST_F(MediaLibraryCommonUtilsTest, medialib_CheckExpressValidation_test_001, TestSize.Level0)
+HWTEST_F(MediaLibraryCommonUtilsTest, medialib_CheckSelection_test_001, TestSize.Level0)
 {
-    vector<string> sepratedStr;
-    bool ret = MediaLibraryCommonUtils::CheckExpressValidation(sepratedStr);
-    EXPECT_EQ(ret, true);
-    sepratedStr.push_back(">=");
-    ret = MediaLibraryCommonUtils::CheckExpressValidation(sepratedStr);
-    EXPECT_EQ(ret, true);
-    sepratedStr.push_back("CheckExpressValidation");
-    ret = MediaLibraryCommonUtils::CheckExpressValidation(sepratedStr);
-    EXPECT_EQ(ret, false);
+    EXPECT_EQ(MediaLibraryCommonUtils::CheckSelection(""), true);
+    EXPECT_EQ(MediaLibraryCommonUtils::CheckSelection(">="), true);
+    EXPECT_EQ(MediaLibraryCommonUtils::CheckSelection(">= and checkexpressvalidation"), false);
+    EXPECT_EQ(MediaLibraryCommonUtils::CheckSelection("parent"), true);
+    EXPECT_EQ(MediaLibraryCommonUtils::CheckSelection(">=date_added "), true);
+    EXPECT_EQ(MediaLibraryCommonUtils::CheckSelection(" date_added>="), true);
 }
 
-HWTEST_F(MediaLibraryCommonUtilsTest, medialib_CheckExpressValidation_test_002, TestSize.Level0)
+HWTEST_F(MediaLibraryCommonUtilsTest, medialib_CheckSelection_test_002, TestSize.Level0)
 {
-    vector<string> sepratedStr;
-    sepratedStr.push_back("parent");
-    bool ret = MediaLibraryCommonUtils::CheckExpressValidation(sepratedStr);
-    EXPECT_EQ(ret, true);
-    sepratedStr.push_back(">=date_added ");
-    ret = MediaLibraryCommonUtils::CheckExpressValidation(sepratedStr);
-    EXPECT_EQ(ret, true);
-    sepratedStr.push_back(" date_added>=");
-    ret = MediaLibraryCommonUtils::CheckExpressValidation(sepratedStr);
-    EXPECT_EQ(ret, true);
+    EXPECT_EQ(MediaLibraryCommonUtils::CheckSelection("media_type=? and date_added>=?"), true);
+    EXPECT_EQ(MediaLibraryCommonUtils::CheckSelection("media_type<>? or file_id!=?"), true);
+    EXPECT_EQ(MediaLibraryCommonUtils::CheckSelection("file_id in ?,? and title like ?"), true);
+    EXPECT_EQ(MediaLibraryCommonUtils::CheckSelection("media_type=?and hacker=?"), false);
+    EXPECT_EQ(MediaLibraryCommonUtils::CheckSelection("media_type=? or hacker"), false);
+    EXPECT_EQ(MediaLibraryCommonUtils::CheckSelection("brand = ?"), false);
+    EXPECT_EQ(MediaLibraryCommonUtils::CheckSelection("media_type=? and "), true);
 }
 
 HWTEST_F(MediaLibraryCommonUtilsTest, medialib_CheckWhiteList_test_001, TestSize.Level0)
@@ -158,21 +157,6 @@ HWTEST_F(MediaLibraryCommonUtilsTest, medialib_CheckWhiteList_test_001, TestSize
     EXPECT_EQ(ret, true);
 }
 
-HWTEST_F(MediaLibraryCommonUtilsTest, medialib_ExtractKeyWord_test_001, TestSize.Level0)
-{
-    string str = "";
-    MediaLibraryCommonUtils::ExtractKeyWord(str);
-    str = ">=";
-    MediaLibraryCommonUtils::ExtractKeyWord(str);
-    EXPECT_EQ(str, "");
-    str = ">=date_added";
-    MediaLibraryCommonUtils::ExtractKeyWord(str);
-    EXPECT_EQ(str, "date_added");
-    str = "date_added>=";
-    MediaLibraryCommonUtils::ExtractKeyWord(str);
-    EXPECT_EQ(str, "date_added");
-}
-
 HWTEST_F(MediaLibraryCommonUtilsTest, medialib_removeSpecialCondition_test_001, TestSize.Level0)
 {
     string hacker = "";
@@ -191,5 +175,76 @@ HWTEST_F(MediaLibraryCommonUtilsTest, medialib_removeSpecialCondition_test_002,
     MediaLibraryCommonUtils::removeSpecialCondition(hacker, pattern);
     EXPECT_EQ(hacker, "removeSpecialCondition ");
 }
+
+HWTEST_F(MediaLibraryCommonUtilsTest, medialib_removeSpecialCondition_test_003, TestSize.Level0)
+{
+    string hacker = "date_added between ? and ? and hacker = ?";
+    MediaLibraryCommonUtils::removeSpecialCondition(hacker);
+    EXPECT_EQ(hacker, "date_added   and hacker = ?");
+}
+
+HWTEST_F(MediaLibraryCommonUtilsTest, medialib_CheckWhereClause_test_002, TestSize.Level0)
+{
+    EXPECT_EQ(MediaLibraryCommonUtils::CheckWhereClause("media_type = ? AND (date_added BETWEEN ? AND ?)"), true);
+    EXPECT_EQ(MediaLibraryCommonUtils::CheckWhereClause("date_added BETWEEN ? AND ? AND hacker = ?"), false);
+    EXPECT_EQ(MediaLibraryCommonUtils::CheckWhereClause("media_type = ? AND title = ?) UNION (file_id = ?"), false);
+}
+
+HWTEST_F(MediaLibraryCommonUtilsTest, medialib_CheckWhereClause_test_003, TestSize.Level0)
+{
+    string whereClause = "media_type = ? AND date_trashed = ?";
+    EXPECT_EQ(MediaLibraryCommonUtils::CheckWhereClause(whereClause), true);
+    EXPECT_EQ(MediaLibraryCommonUtils::IsCheckedSelection("media_type = ? and date_trashed = ?"), true);
+    /* the same shape with other spelling hits the same entry */
+    EXPECT_EQ(MediaLibraryCommonUtils::CheckWhereClause("MEDIA_TYPE = ?   AND  date_trashed = ?"), true);
+    /* a rejected selection never enters the cache */
+    EXPECT_EQ(MediaLibraryCommonUtils::CheckWhereClause("hacker = ?"), false);
+    EXPECT_EQ(MediaLibraryCommonUtils::IsCheckedSelection("hacker = ?"), false);
+    for (int32_t i = 0; i < 200; i++) {
+        MediaLibraryCommonUtils::CheckWhereClause("file_id = " + to_string(i));
+    }
+    EXPECT_EQ(MediaLibraryCommonUtils::selectionLru_.size(), MediaLibraryCommonUtils::selectionCache_.size());
+    EXPECT_LE(MediaLibraryCommonUtils::selectionCache_.size(), 128);
+    EXPECT_EQ(MediaLibraryCommonUtils::IsCheckedSelection("media_type = ? and date_trashed = ?"), false);
+    EXPECT_EQ(MediaLibraryCommonUtils::IsCheckedSelection("file_id = 199"), true);
+}
+
+HWTEST_F(MediaLibraryCommonUtilsTest, medialib_CheckWhereClause_perf_001, TestSize.Level1)
+{
+    const vector<string> whereClauses = {
+        "media_type = ? AND date_trashed = ? AND (relative_path LIKE ?)",
+        "file_id IN (?,?,?,?) AND is_trash = 0",
+        "bucket_id = ? AND date_added > ? OR media_type = ?",
+    };
+    {
+        lock_guard<mutex> lock(MediaLibraryCommonUtils::selectionMutex_);
+        MediaLibraryCommonUtils::selectionCache_.clear();
+        MediaLibraryCommonUtils::selectionLru_.clear();
+        MediaLibraryCommonUtils::selectionHits_ = 0;
+        MediaLibraryCommonUtils::selectionMisses_ = 0;
+    }
+    const int32_t loops = 10000;
+    auto start = chrono::steady_clock::now();
+    for (int32_t i = 0; i < loops; i++) {
+        EXPECT_EQ(MediaLibraryCommonUtils::CheckWhereClause(whereClauses[i % whereClauses.size()]), true);
+    }
+    auto cost = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    MEDIA_INFO_LOG("CheckWhereClause cost per query: %{public}lld ns", static_cast<long long>(cost / loops));
+    /* only the first check of every shape runs the full check, all the others hit the cache */
+    EXPECT_EQ(MediaLibraryCommonUtils::selectionMisses_, whereClauses.size());
+    EXPECT_EQ(MediaLibraryCommonUtils::selectionHits_, loops - whereClauses.size());
+    EXPECT_EQ(MediaLibraryCommonUtils::selectionCache_.size(), whereClauses.size());
+
+    /* a selection over the length limit is checked every time and never cached */
+    string longClause = "media_type = ?";
+    while (longClause.size() <= 1024) {
+        longClause += " AND media_type = ?";
+    }
+    EXPECT_EQ(MediaLibraryCommonUtils::CheckWhereClause(longClause), true);
+    EXPECT_EQ(MediaLibraryCommonUtils::CheckWhereClause(longClause), true);
+    EXPECT_EQ(MediaLibraryCommonUtils::selectionMisses_, whereClauses.size() + 2);
+    EXPECT_EQ(MediaLibraryCommonUtils::selectionHits_, loops - whereClauses.size());
+    EXPECT_EQ(MediaLibraryCommonUtils::selectionCache_.size(), whereClauses.size());
+}
 } // namespace Media
 } // namespace OHOS
\ No newline at end of file
@@ -13,6 +13,11 @@
  * limitations under the License.
  */
 #include "medialibrary_common_utils_test.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "medialibrary_device.h"
 #include "medialibrary_errno.h"
 #define private public
@@ -115,5 +120,66 @@ HWTEST_F(MediaLibraryCommonUtilsTest, medialib_Open_test_010, TestSize.Level0)
     int32_t ret = mediaPrivacyManager.Open();
     EXPECT_EQ(ret, E_ERR);
 }
+
+/* a 1x1 gray jpeg without exif, the location check parses it and caches its empty ranges */
+static const uint8_t TEST_JPEG[] = {
+    0xff, 0xd8, 0xff, 0xdb, 0x00, 0x43, 0x00, 0x10, 0x0b, 0x0c, 0x0e, 0x0c, 0x0a, 0x10, 0x0e, 0x0d,
+    0x0e, 0x12, 0x11, 0x10, 0x13, 0x18, 0x28, 0x1a, 0x18, 0x16, 0x16, 0x18, 0x31, 0x23, 0x25, 0x1d,
+    0x28, 0x3a, 0x33, 0x3d, 0x3c, 0x39, 0x33, 0x38, 0x37, 0x40, 0x48, 0x5c, 0x4e, 0x40, 0x44, 0x57,
+    0x45, 0x37, 0x38, 0x50, 0x6d, 0x51, 0x57, 0x5f, 0x62, 0x67, 0x68, 0x67, 0x3e, 0x4d, 0x71, 0x79,
+    0x70, 0x64, 0x78, 0x5c, 0x65, 0x67, 0x63, 0xff, 0xc0, 0x00, 0x0b, 0x08, 0x00, 0x01, 0x00, 0x01,
+    0x01, 0x01, 0x11, 0x00, 0xff, 0xc4, 0x00, 0x14, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0xff, 0xc4, 0x00, 0x14, 0x10, 0x01,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0xff, 0xda, 0x00, 0x08, 0x01, 0x01, 0x00, 0x00, 0x3f, 0x00, 0x3f, 0x7f, 0xff, 0xd9,
+};
+
+static void OpenAndCheckCache(const string &path, uint64_t expectHits, uint64_t expectMisses)
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    MediaPrivacyManager::GetRangesCacheStats(hits, misses);
+    MediaPrivacyManager privacyManager(path, "r");
+    int32_t fd = privacyManager.Open();
+    EXPECT_GE(fd, 0);
+    if (fd >= 0) {
+        close(fd);
+    }
+    EXPECT_TRUE(privacyManager.ranges_.empty());
+    uint64_t newHits = 0;
+    uint64_t newMisses = 0;
+    MediaPrivacyManager::GetRangesCacheStats(newHits, newMisses);
+    EXPECT_EQ(newHits - hits, expectHits);
+    EXPECT_EQ(newMisses - misses, expectMisses);
+}
+
+HWTEST_F(MediaLibraryCommonUtilsTest, medialib_Open_test_011, TestSize.Level0)
+{
+    string path = "/data/local/tmp/privacy_cache_test.jpg";
+    int32_t fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0664);
+    ASSERT_GE(fd, 0);
+    EXPECT_EQ(write(fd, TEST_JPEG, sizeof(TEST_JPEG)), static_cast<ssize_t>(sizeof(TEST_JPEG)));
+    close(fd);
+
+    /* the first open parses the file, the second one is served by the cache */
+    OpenAndCheckCache(path, 0, 1);
+    OpenAndCheckCache(path, 1, 0);
+
+    /* a new mtime with the same size drops the entry */
+    struct timespec times[] = { { 0, UTIME_OMIT }, { 1, 0 } };
+    EXPECT_EQ(utimensat(AT_FDCWD, path.c_str(), times, 0), 0);
+    OpenAndCheckCache(path, 0, 1);
+    OpenAndCheckCache(path, 1, 0);
+
+    /* so does a new size with the same mtime */
+    fd = open(path.c_str(), O_WRONLY | O_APPEND);
+    ASSERT_GE(fd, 0);
+    EXPECT_EQ(write(fd, TEST_JPEG, 1), 1);
+    close(fd);
+    EXPECT_EQ(utimensat(AT_FDCWD, path.c_str(), times, 0), 0);
+    OpenAndCheckCache(path, 0, 1);
+    OpenAndCheckCache(path, 1, 0);
+    unlink(path.c_str());
+}
 } // namespace Media
 } // namespace OHOS
\ No newline at end of file
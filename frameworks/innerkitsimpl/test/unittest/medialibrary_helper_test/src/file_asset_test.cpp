@@ -172,5 +172,50 @@ HWTEST_F(MediaLibraryHelperUnitTest, FileAsset_GetMemberValue_Test_001, TestSize
     fileAsset.SetId(TEST_FILE_ID);
     EXPECT_EQ(get<int32_t>(fileAsset.GetMemberValue(MEDIA_DATA_DB_ID)), TEST_FILE_ID);
 }
+
+HWTEST_F(MediaLibraryHelperUnitTest, FileAsset_Schema_Test_001, TestSize.Level0)
+{
+    auto schema = make_shared<FileAssetSchema>();
+    schema->AddMember(MEDIA_DATA_DB_ID, TYPE_INT32, 0);
+    schema->AddMember(MEDIA_DATA_DB_NAME, TYPE_STRING, 1);
+    schema->AddMember(MEDIA_DATA_DB_SIZE, TYPE_INT64, 2);
+    schema->AddMember(MEDIA_DATA_DB_ID, TYPE_INT32, 3);
+    schema->AddMember(MEDIA_DATA_DB_URI, TYPE_STRING);
+    EXPECT_EQ(schema->GetSlotCount(), 4);
+    EXPECT_EQ(schema->GetSlot(MEDIA_DATA_DB_ID), 0);
+    EXPECT_EQ(schema->GetColumnIndex(schema->GetSlot(MEDIA_DATA_DB_URI)), -1);
+    EXPECT_EQ(schema->GetSlot(MEDIA_DATA_DB_TITLE), -1);
+
+    const int32_t TEST_FILE_ID = 1;
+    const int64_t TEST_SIZE = 1024;
+    const string TEST_DISPLAY_NAME = "test.jpg";
+    const string TEST_TITLE = "test";
+    FileAsset fileAsset;
+    fileAsset.SetTitle(TEST_TITLE);
+    fileAsset.SetSchema(schema);
+    EXPECT_EQ(fileAsset.GetDisplayName(), "");
+    fileAsset.SetSlotValue(schema->GetSlot(MEDIA_DATA_DB_ID), TEST_FILE_ID);
+    fileAsset.SetSlotValue(schema->GetSlot(MEDIA_DATA_DB_NAME), string(TEST_DISPLAY_NAME));
+    fileAsset.SetSlotValue(schema->GetSlot(MEDIA_DATA_DB_SIZE), TEST_SIZE);
+    EXPECT_EQ(fileAsset.GetId(), TEST_FILE_ID);
+    EXPECT_EQ(fileAsset.GetDisplayName(), TEST_DISPLAY_NAME);
+    EXPECT_EQ(fileAsset.GetSize(), TEST_SIZE);
+    EXPECT_EQ(fileAsset.GetTitle(), TEST_TITLE);
+    EXPECT_EQ(fileAsset.GetMediaType(), DEFAULT_INT32);
+
+    const int64_t TEST_NEW_SIZE = 2048;
+    fileAsset.SetSize(TEST_NEW_SIZE);
+    fileAsset.SetUri("file://media/Photo/1");
+    EXPECT_EQ(fileAsset.GetSize(), TEST_NEW_SIZE);
+    EXPECT_EQ(get<string>(fileAsset.GetMemberValue(MEDIA_DATA_DB_URI)), "file://media/Photo/1");
+    EXPECT_NE(fileAsset.GetAssetJson().find(TEST_DISPLAY_NAME), string::npos);
+
+    auto &memberMap = fileAsset.GetMemberMap();
+    EXPECT_EQ(memberMap.size(), 5);
+    EXPECT_EQ(get<int64_t>(memberMap.at(MEDIA_DATA_DB_SIZE)), TEST_NEW_SIZE);
+    memberMap[MEDIA_DATA_DB_NAME] = string("new.jpg");
+    EXPECT_EQ(fileAsset.GetDisplayName(), "new.jpg");
+    EXPECT_EQ(fileAsset.GetUri(), "file://media/Photo/1");
+}
 } // namespace Media
 } // namespace OHOS
\ No newline at end of file
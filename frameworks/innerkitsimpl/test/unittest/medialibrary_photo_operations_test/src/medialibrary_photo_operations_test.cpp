@@ -1766,5 +1766,50 @@ HWTEST_F(MediaLibraryPhotoOperationsTest, photo_oprn_pending_api9_test_001, Test
 
     MEDIA_INFO_LOG("end tdd photo_oprn_pending_api9_test_001");
 }
+
+HWTEST_F(MediaLibraryPhotoOperationsTest, photo_oprn_unique_id_test_001, TestSize.Level0)
+{
+    // ids come from reserved blocks, stay unique and never run ahead of the stored number
+    MEDIA_INFO_LOG("start tdd photo_oprn_unique_id_test_001");
+    ClearAndRestart();
+    const int32_t idCount = 10000;
+    const string updateSql = "UPDATE " + ASSET_UNIQUE_NUMBER_TABLE + " SET " + UNIQUE_NUMBER + "=" +
+        UNIQUE_NUMBER + "+1 WHERE " + ASSET_MEDIA_TYPE + "='" + VIDEO_ASSET_TYPE + "';";
+    const string videoQuerySql = "SELECT " + UNIQUE_NUMBER + " FROM " + ASSET_UNIQUE_NUMBER_TABLE + " WHERE " +
+        ASSET_MEDIA_TYPE + "='" + VIDEO_ASSET_TYPE + "';";
+    const string imageQuerySql = "SELECT " + UNIQUE_NUMBER + " FROM " + ASSET_UNIQUE_NUMBER_TABLE + " WHERE " +
+        ASSET_MEDIA_TYPE + "='" + IMAGE_ASSET_TYPE + "';";
+
+    int64_t start = MediaFileUtils::UTCTimeMilliSeconds();
+    int32_t lastId = 0;
+    for (int32_t i = 0; i < idCount; i++) {
+        int32_t uniqueId = MediaLibraryAssetOperations::CreateAssetUniqueId(MediaType::MEDIA_TYPE_IMAGE);
+        ASSERT_GT(uniqueId, lastId);
+        lastId = uniqueId;
+    }
+    int64_t blockCost = MediaFileUtils::UTCTimeMilliSeconds() - start;
+
+    // the same number of ids taken one statement pair at a time, as before blocks were reserved
+    start = MediaFileUtils::UTCTimeMilliSeconds();
+    for (int32_t i = 0; i < idCount; i++) {
+        ASSERT_EQ(g_rdbStore->ExecuteSql(updateSql), NativeRdb::E_OK);
+        auto resultSet = g_rdbStore->QuerySql(videoQuerySql);
+        ASSERT_NE(resultSet, nullptr);
+        ASSERT_EQ(resultSet->GoToFirstRow(), NativeRdb::E_OK);
+    }
+    int64_t sqlCost = MediaFileUtils::UTCTimeMilliSeconds() - start;
+    GTEST_LOG_(INFO) << idCount << " unique ids cost " << blockCost << "ms, one update and query each cost " <<
+        sqlCost << "ms";
+
+    auto resultSet = g_rdbStore->QuerySql(imageQuerySql);
+    ASSERT_NE(resultSet, nullptr);
+    ASSERT_EQ(resultSet->GoToFirstRow(), NativeRdb::E_OK);
+    EXPECT_GE(GetInt32Val(UNIQUE_NUMBER, resultSet), lastId);
+
+    // a table that went back does not bring ids that were handed out already
+    ClearAndRestart();
+    EXPECT_GT(MediaLibraryAssetOperations::CreateAssetUniqueId(MediaType::MEDIA_TYPE_IMAGE), lastId);
+    MEDIA_INFO_LOG("end tdd photo_oprn_unique_id_test_001");
+}
 } // namespace Media
-} // namespace OHOS
\ No newline at end of file
+} // namespace OHOS
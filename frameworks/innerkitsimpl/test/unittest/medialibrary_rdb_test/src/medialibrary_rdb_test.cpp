@@ -22,7 +22,9 @@
 #include "ability_context_impl.h"
 #include "js_runtime.h"
 #include "photo_album_column.h"
+#include "media_column.h"
 #include "media_file_utils.h"
+#include "medialibrary_errno.h"
 #include "medialibrary_rdb_transaction.h"
 #include "medialibrary_sync_operation.h"
 #define private public
@@ -419,5 +421,52 @@ HWTEST_F(MediaLibraryRdbTest, medialib_TransactionOperations_test_003, TestSize.
     MEDIA_INFO_LOG("medialib_TransactionOperations_test_003 finish");
 }
 
+HWTEST_F(MediaLibraryRdbTest, medialib_DeleteFromDisk_test_001, TestSize.Level0)
+{
+    // more assets than one delete batch, one of them can not be removed from disk
+    MEDIA_INFO_LOG("medialib_DeleteFromDisk_test_001 begin");
+    const string dir = "/data/local/tmp/delete_from_disk_test/";
+    const int32_t assetCount = 600;
+    const int32_t busyIndex = 550;
+    rdbStorePtr->Init();
+    ASSERT_TRUE(MediaFileUtils::CreateDirectory(dir));
+    for (int32_t i = 0; i < assetCount; i++) {
+        string path = dir + "IMG_" + to_string(i) + ".jpg";
+        if (i == busyIndex) {
+            ASSERT_TRUE(MediaFileUtils::CreateDirectory(path));
+            ASSERT_TRUE(MediaFileUtils::CreateFile(path + "/busy"));
+        } else {
+            ASSERT_TRUE(MediaFileUtils::CreateFile(path));
+        }
+        ValuesBucket values;
+        values.PutString(MediaColumn::MEDIA_FILE_PATH, path);
+        values.PutString(MediaColumn::MEDIA_NAME, "IMG_" + to_string(i) + ".jpg");
+        values.PutLong(MediaColumn::MEDIA_DATE_TRASHED, MediaFileUtils::UTCTimeSeconds());
+        int64_t rowId = 0;
+        ASSERT_EQ(rdbStorePtr->GetRaw()->Insert(rowId, PhotoColumn::PHOTOS_TABLE, values), NativeRdb::E_OK);
+    }
+
+    AbsRdbPredicates predicates(PhotoColumn::PHOTOS_TABLE);
+    predicates.Like(MediaColumn::MEDIA_FILE_PATH, dir + "%");
+    EXPECT_EQ(MediaLibraryRdbStore::DeleteFromDisk(predicates, false), E_HAS_FS_ERROR);
+    auto resultSet = MediaLibraryRdbStore::Query(predicates, { MediaColumn::MEDIA_FILE_PATH });
+    ASSERT_NE(resultSet, nullptr);
+    int32_t count = 0;
+    EXPECT_EQ(resultSet->GetRowCount(count), NativeRdb::E_OK);
+    EXPECT_EQ(count, 1);
+    // the row of the kept file is written back as it was
+    ASSERT_EQ(resultSet->GoToFirstRow(), NativeRdb::E_OK);
+    EXPECT_EQ(MediaLibraryRdbStore::GetString(resultSet, MediaColumn::MEDIA_FILE_PATH),
+        dir + "IMG_" + to_string(busyIndex) + ".jpg");
+    EXPECT_FALSE(MediaFileUtils::IsFileExists(dir + "IMG_0.jpg"));
+    EXPECT_TRUE(MediaFileUtils::IsFileExists(dir + "IMG_" + to_string(busyIndex) + ".jpg"));
+
+    // the kept row is deleted by a retry once its file can be removed
+    MediaFileUtils::DeleteFile(dir + "IMG_" + to_string(busyIndex) + ".jpg/busy");
+    EXPECT_EQ(MediaLibraryRdbStore::DeleteFromDisk(predicates, false), 1);
+    MediaFileUtils::DeleteDir(dir);
+    rdbStorePtr->Stop();
+    MEDIA_INFO_LOG("medialib_DeleteFromDisk_test_001 end");
+}
 } // namespace Media
-} // namespace OHOS
\ No newline at end of file
+} // namespace OHOS
@@ -29,7 +29,7 @@ namespace Media {
 HWTEST_F(MediaLibraryScannerDbTest, medialib_Extract_test_001, TestSize.Level0)
 {
     unique_ptr<Metadata> data = make_unique<Metadata>();
-    unique_ptr<MediaScannerDb> mediaScannerDb;
+    unique_ptr<MediaScannerDb> mediaScannerDb = MediaScannerDb::GetDatabaseInstance();
     string path = "/storage/cloud/files/";
     mediaScannerDb->GetFileBasicInfo(path, data);
     data->SetFileMediaType(static_cast<MediaType>(MEDIA_TYPE_ALBUM));
@@ -40,7 +40,7 @@ HWTEST_F(MediaLibraryScannerDbTest, medialib_Extract_test_001, TestSize.Level0)
 HWTEST_F(MediaLibraryScannerDbTest, medialib_Extract_test_002, TestSize.Level0)
 {
     unique_ptr<Metadata> data = make_unique<Metadata>();
-    unique_ptr<MediaScannerDb> mediaScannerDb;
+    unique_ptr<MediaScannerDb> mediaScannerDb = MediaScannerDb::GetDatabaseInstance();
     string path = "/storage/cloud/files/";
     mediaScannerDb->GetFileBasicInfo(path, data);
     data->SetFileMediaType(static_cast<MediaType>(MEDIA_TYPE_DEVICE));
@@ -51,7 +51,7 @@ HWTEST_F(MediaLibraryScannerDbTest, medialib_Extract_test_002, TestSize.Level0)
 HWTEST_F(MediaLibraryScannerDbTest, medialib_ExtractAVMetadata_test_001, TestSize.Level0)
 {
     unique_ptr<Metadata> data = make_unique<Metadata>();
-    unique_ptr<MediaScannerDb> mediaScannerDb;
+    unique_ptr<MediaScannerDb> mediaScannerDb = MediaScannerDb::GetDatabaseInstance();
     string path = "/storage/cloud/files/";
     mediaScannerDb->GetFileBasicInfo(path, data);
     data->SetFileMediaType(static_cast<MediaType>(MEDIA_TYPE_DEVICE));
@@ -68,7 +68,7 @@ HWTEST_F(MediaLibraryScannerDbTest, medialib_ExtractAVMetadata_test_001, TestSiz
 HWTEST_F(MediaLibraryScannerDbTest, medialib_ExtractImageMetadata_test_001, TestSize.Level0)
 {
     unique_ptr<Metadata> data = make_unique<Metadata>();
-    unique_ptr<MediaScannerDb> mediaScannerDb;
+    unique_ptr<MediaScannerDb> mediaScannerDb = MediaScannerDb::GetDatabaseInstance();
     string path = "/storage/cloud/files/";
     mediaScannerDb->GetFileBasicInfo(path, data);
     data->SetFileMediaType(static_cast<MediaType>(MEDIA_TYPE_DEVICE));
@@ -79,7 +79,7 @@ HWTEST_F(MediaLibraryScannerDbTest, medialib_ExtractImageMetadata_test_001, Test
 HWTEST_F(MediaLibraryScannerDbTest, medialib_FillExtractedMetadata_test_001, TestSize.Level0)
 {
     unique_ptr<Metadata> data = make_unique<Metadata>();
-    unique_ptr<MediaScannerDb> mediaScannerDb;
+    unique_ptr<MediaScannerDb> mediaScannerDb = MediaScannerDb::GetDatabaseInstance();
     string path = "/storage/cloud/files/";
     mediaScannerDb->GetFileBasicInfo(path, data);
     data->SetFileMediaType(static_cast<MediaType>(MEDIA_TYPE_DEVICE));
@@ -96,7 +96,7 @@ HWTEST_F(MediaLibraryScannerDbTest, medialib_FillExtractedMetadata_test_001, Tes
 HWTEST_F(MediaLibraryScannerDbTest, medialib_FillExtractedMetadata_test_002, TestSize.Level0)
 {
     unique_ptr<Metadata> data = make_unique<Metadata>();
-    unique_ptr<MediaScannerDb> mediaScannerDb;
+    unique_ptr<MediaScannerDb> mediaScannerDb = MediaScannerDb::GetDatabaseInstance();
     string path = "/storage/cloud/files/";
     mediaScannerDb->GetFileBasicInfo(path, data);
     data->SetFileMediaType(static_cast<MediaType>(MEDIA_TYPE_DEVICE));
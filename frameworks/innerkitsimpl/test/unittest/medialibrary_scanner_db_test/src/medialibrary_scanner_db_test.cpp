@@ -343,5 +343,83 @@ HWTEST_F(MediaLibraryScannerDbTest, medialib_BatchInsert_test_001, TestSize.Leve
     EXPECT_EQ(ret.size(), 0);
 }
 
+HWTEST_F(MediaLibraryScannerDbTest, medialib_PrefetchFileBasicInfo_test_001, TestSize.Level0)
+{
+    MediaScannerDb mediaScannerDb;
+    int32_t ret = mediaScannerDb.PrefetchFileBasicInfo("");
+    EXPECT_EQ(ret, E_INVALID_ARGUMENTS);
+    EXPECT_EQ(mediaScannerDb.indexedDir_.empty(), true);
+
+    ret = mediaScannerDb.PrefetchFileBasicInfo("/storage/cloud/files");
+    EXPECT_EQ(ret, E_OK);
+    EXPECT_EQ(mediaScannerDb.indexedDir_, "/storage/cloud/files/");
+
+    // a path missing from the index reads as a new file without querying the db
+    unique_ptr<Metadata> data = make_unique<Metadata>();
+    ret = mediaScannerDb.GetFileBasicInfo("/storage/cloud/files/Pictures/Prefetch_test_001.jpg", data);
+    EXPECT_EQ(ret, E_OK);
+    EXPECT_EQ(data->GetFileId(), FILE_ID_DEFAULT);
+    EXPECT_EQ(data->GetFileDateModified(), FILE_DATE_MODIFIED_DEFAULT);
+
+    mediaScannerDb.ClearFileBasicInfo();
+    EXPECT_EQ(mediaScannerDb.indexedDir_.empty(), true);
+    EXPECT_EQ(mediaScannerDb.basicInfoIndex_.empty(), true);
+}
+
+HWTEST_F(MediaLibraryScannerDbTest, medialib_CommitMetadataBatch_test_001, TestSize.Level0)
+{
+    MediaScannerDb mediaScannerDb;
+    vector<unique_ptr<Metadata>> metadataList;
+    vector<ScanCommitResult> results;
+    int32_t ret = mediaScannerDb.CommitMetadataBatch(metadataList, results);
+    EXPECT_EQ(ret, E_OK);
+    EXPECT_EQ(results.size(), 0);
+
+    metadataList.push_back(make_unique<Metadata>());
+    metadataList.push_back(make_unique<Metadata>());
+    ret = mediaScannerDb.CommitMetadataBatch(metadataList, results);
+    EXPECT_EQ(ret, E_OK);
+    ASSERT_EQ(results.size(), metadataList.size());
+    for (const auto &result : results) {
+        EXPECT_EQ(result.err, E_OK);
+        EXPECT_GT(result.fileId, 0);
+        EXPECT_NE(result.uri, "");
+    }
+    EXPECT_NE(results[0].fileId, results[1].fileId);
+}
+
+HWTEST_F(MediaLibraryScannerDbTest, medialib_ScanJournal_test_001, TestSize.Level0)
+{
+    MediaScannerDb mediaScannerDb;
+    string dir = "/storage/cloud/files/Pictures/journal_test_001";
+    ScanJournal journal = {
+        { dir, { 1, 100 } },
+        { dir + "/a", { 2, 200 } },
+    };
+    int32_t ret = mediaScannerDb.UpdateScanJournal(dir, journal);
+    EXPECT_EQ(ret, E_OK);
+
+    ScanJournal readJournal;
+    ret = mediaScannerDb.ReadScanJournal(dir, readJournal);
+    EXPECT_EQ(ret, E_OK);
+    EXPECT_EQ(readJournal.size(), 2);
+    EXPECT_EQ(readJournal[dir + "/a"].mtime, 200);
+
+    // a rescan of a subdir replaces only its own entries
+    ScanJournal subJournal = { { dir + "/a", { 2, 300 } } };
+    ret = mediaScannerDb.UpdateScanJournal(dir + "/a", subJournal);
+    EXPECT_EQ(ret, E_OK);
+    ret = mediaScannerDb.ReadScanJournal(dir, readJournal);
+    EXPECT_EQ(ret, E_OK);
+    EXPECT_EQ(readJournal.size(), 2);
+    EXPECT_EQ(readJournal[dir].mtime, 100);
+    EXPECT_EQ(readJournal[dir + "/a"].mtime, 300);
+
+    // files are only resolved from a prefetched index
+    string tableName;
+    int32_t fileId = FILE_ID_DEFAULT;
+    EXPECT_EQ(mediaScannerDb.GetIndexedFileId(dir + "/1.jpg", tableName, fileId), false);
+}
+
 } // namespace Media
 } // namespace OHOS
\ No newline at end of file
@@ -14,8 +14,11 @@
  */
 #define MLOG_TAG "FileExtUnitTest"
 
+#include "media_file_utils.h"
 #include "media_log.h"
+#include "media_scan_walker.h"
 #include "medialibrary_db_const.h"
+#include "medialibrary_errno.h"
 #include "medialibrary_scanner_test.h"
 #include "medialibrary_unittest_utils.h"
 #include "mimetype_utils.h"
@@ -217,5 +220,86 @@ HWTEST_F(MediaLibraryScannerTest, medialib_CheckSkipScanList_test_001, TestSize.
     EXPECT_EQ(ret, true);
 }
 
+HWTEST_F(MediaLibraryScannerTest, medialib_MediaScanWalker_test_001, TestSize.Level0)
+{
+    string root = ROOT_MEDIA_DIR + "Pictures/walker_test_001";
+    ASSERT_EQ(MediaFileUtils::CreateDirectory(root + "/a/b"), true);
+    ASSERT_EQ(MediaFileUtils::CreateDirectory(root + "/c"), true);
+    ASSERT_EQ(MediaFileUtils::CreateDirectory(root + "/.hidden"), true);
+    EXPECT_EQ(MediaLibraryUnitTestUtils::CreateFileFS(root + "/a/1.jpg"), true);
+    EXPECT_EQ(MediaLibraryUnitTestUtils::CreateFileFS(root + "/a/b/2.jpg"), true);
+    EXPECT_EQ(MediaLibraryUnitTestUtils::CreateFileFS(root + "/c/3.jpg"), true);
+    EXPECT_EQ(MediaLibraryUnitTestUtils::CreateFileFS(root + "/.hidden/4.jpg"), true);
+
+    auto stopFlag = make_shared<bool>(false);
+    MediaScanWalker walker(root, stopFlag);
+    walker.Start();
+
+    set<string> seenDirs = { root };
+    size_t fileCount = 0;
+    ScanDirListing listing;
+    while (walker.Fetch(listing)) {
+        EXPECT_EQ(listing.err, E_OK);
+        // parent listing is always fetched before the listing of its children
+        EXPECT_EQ(seenDirs.count(listing.path), 1);
+        for (const auto &dir : listing.dirs) {
+            seenDirs.insert(dir.path);
+        }
+        fileCount += listing.files.size();
+    }
+    EXPECT_EQ(seenDirs.size(), 4);
+    EXPECT_EQ(fileCount, 3);
+}
+
+HWTEST_F(MediaLibraryScannerTest, medialib_MediaScanWalker_test_002, TestSize.Level0)
+{
+    auto stopFlag = make_shared<bool>(false);
+    MediaScanWalker walker("/storage/media/medialib_MediaScanWalker_test_002", stopFlag, 1);
+    walker.Start();
+
+    ScanDirListing listing;
+    EXPECT_EQ(walker.Fetch(listing), true);
+    EXPECT_EQ(listing.err, ERR_NOT_ACCESSIBLE);
+    EXPECT_EQ(walker.Fetch(listing), false);
+}
+
+HWTEST_F(MediaLibraryScannerTest, medialib_MediaScanWalker_test_003, TestSize.Level0)
+{
+    string root = ROOT_MEDIA_DIR + "Pictures/walker_test_003";
+    ASSERT_EQ(MediaFileUtils::CreateDirectory(root + "/a"), true);
+    EXPECT_EQ(MediaLibraryUnitTestUtils::CreateFileFS(root + "/1.jpg"), true);
+    EXPECT_EQ(MediaLibraryUnitTestUtils::CreateFileFS(root + "/a/2.jpg"), true);
+
+    auto stopFlag = make_shared<bool>(false);
+    auto journal = make_shared<ScanJournal>();
+    {
+        MediaScanWalker walker(root, stopFlag, 1);
+        walker.Start();
+        ScanDirListing listing;
+        while (walker.Fetch(listing)) {
+            EXPECT_EQ(listing.unchanged, false);
+            EXPECT_NE(listing.fingerprint.inode, 0);
+            journal->emplace(listing.path, listing.fingerprint);
+        }
+    }
+    EXPECT_EQ(journal->size(), 2);
+
+    // only the dir that gained an entry is listed as changed
+    EXPECT_EQ(MediaLibraryUnitTestUtils::CreateFileFS(root + "/a/3.jpg"), true);
+    MediaScanWalker walker(root, stopFlag, 1);
+    walker.SetJournal(journal);
+    walker.Start();
+    ScanDirListing listing;
+    while (walker.Fetch(listing)) {
+        if (listing.path == root) {
+            EXPECT_EQ(listing.unchanged, true);
+            EXPECT_EQ(listing.files.size(), 1);
+        } else {
+            EXPECT_EQ(listing.unchanged, false);
+            EXPECT_EQ(listing.files.size(), 2);
+        }
+    }
+}
+
 } // namespace Media
 } // namespace OHOS
\ No newline at end of file
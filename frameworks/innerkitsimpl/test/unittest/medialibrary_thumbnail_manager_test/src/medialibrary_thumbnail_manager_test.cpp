@@ -0,0 +1,259 @@
+/*
+ * Copyright (C) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "medialibrary_thumbnail_manager_test.h"
+
+#include "pixel_map.h"
+#include "thumbnail_manager.h"
+
+using namespace std;
+using namespace testing::ext;
+
+namespace OHOS {
+namespace Media {
+// a 16x16 RGBA map is 1024 bytes, so a budget of eight of them caches each of them
+constexpr int32_t TEST_MAP_SIDE = 16;
+constexpr size_t TEST_MAP_BYTES = TEST_MAP_SIDE * TEST_MAP_SIDE * 4;
+constexpr size_t TEST_CACHE_ENTRIES = 8;
+constexpr size_t TEST_CACHE_BYTES = TEST_MAP_BYTES * TEST_CACHE_ENTRIES;
+
+void MediaLibraryThumbnailManagerTest::SetUpTestCase(void) {}
+
+void MediaLibraryThumbnailManagerTest::TearDownTestCase(void) {}
+
+void MediaLibraryThumbnailManagerTest::SetUp() {}
+
+void MediaLibraryThumbnailManagerTest::TearDown(void) {}
+
+static unique_ptr<PixelMap> CreateTestPixelMap(int32_t side)
+{
+    InitializationOptions opts = {
+        .size = { side, side },
+        .pixelFormat = PixelFormat::RGBA_8888,
+        .alphaType = AlphaType::IMAGE_ALPHA_TYPE_PREMUL
+    };
+    return PixelMap::Create(opts);
+}
+
+static string GetTestKey(size_t index)
+{
+    return ThumbnailCache::GetKey("file://media/Photo/" + to_string(index), { TEST_MAP_SIDE, TEST_MAP_SIDE }, 0);
+}
+
+static void FillCache(ThumbnailCache &cache, size_t count)
+{
+    auto pixelMap = CreateTestPixelMap(TEST_MAP_SIDE);
+    ASSERT_NE(pixelMap, nullptr);
+    for (size_t i = 0; i < count; i++) {
+        cache.Put(GetTestKey(i), *pixelMap);
+    }
+}
+
+HWTEST_F(MediaLibraryThumbnailManagerTest, medialib_ThumbnailCache_Put_test_001, TestSize.Level0)
+{
+    ThumbnailCache cache(TEST_CACHE_BYTES);
+    FillCache(cache, TEST_CACHE_ENTRIES);
+    ThumbnailCacheStats stats = cache.GetStats();
+    EXPECT_EQ(stats.count, TEST_CACHE_ENTRIES);
+    EXPECT_EQ(stats.bytes, TEST_CACHE_BYTES);
+    EXPECT_EQ(stats.evictions, 0);
+
+    auto pixelMap = cache.Get(GetTestKey(0));
+    ASSERT_NE(pixelMap, nullptr);
+    EXPECT_EQ(pixelMap->GetWidth(), TEST_MAP_SIDE);
+    EXPECT_EQ(cache.Get(GetTestKey(TEST_CACHE_ENTRIES)), nullptr);
+    stats = cache.GetStats();
+    EXPECT_EQ(stats.hits, 1);
+    EXPECT_EQ(stats.misses, 1);
+
+    // a different date_modified is another key, an edited asset never hits the old entry
+    EXPECT_EQ(cache.Get(ThumbnailCache::GetKey("file://media/Photo/0", { TEST_MAP_SIDE, TEST_MAP_SIDE }, 1)),
+        nullptr);
+}
+
+HWTEST_F(MediaLibraryThumbnailManagerTest, medialib_ThumbnailCache_Evict_test_001, TestSize.Level0)
+{
+    ThumbnailCache cache(TEST_CACHE_BYTES);
+    FillCache(cache, TEST_CACHE_ENTRIES);
+
+    // entry 0 becomes the most recently used, so entry 1 is the first out once the budget is passed
+    EXPECT_NE(cache.Get(GetTestKey(0)), nullptr);
+    auto pixelMap = CreateTestPixelMap(TEST_MAP_SIDE);
+    ASSERT_NE(pixelMap, nullptr);
+    cache.Put(GetTestKey(TEST_CACHE_ENTRIES), *pixelMap);
+
+    ThumbnailCacheStats stats = cache.GetStats();
+    EXPECT_EQ(stats.evictions, 1);
+    EXPECT_EQ(stats.count, TEST_CACHE_ENTRIES);
+    EXPECT_LE(stats.bytes, TEST_CACHE_BYTES);
+    EXPECT_EQ(cache.Get(GetTestKey(1)), nullptr);
+    EXPECT_NE(cache.Get(GetTestKey(0)), nullptr);
+    EXPECT_NE(cache.Get(GetTestKey(TEST_CACHE_ENTRIES)), nullptr);
+}
+
+HWTEST_F(MediaLibraryThumbnailManagerTest, medialib_ThumbnailCache_Oversize_test_001, TestSize.Level0)
+{
+    ThumbnailCache cache(TEST_CACHE_BYTES);
+    FillCache(cache, TEST_CACHE_ENTRIES);
+
+    // a map above an eighth of the budget is not cached and pushes nothing out
+    auto pixelMap = CreateTestPixelMap(TEST_MAP_SIDE * 2);
+    ASSERT_NE(pixelMap, nullptr);
+    cache.Put(GetTestKey(TEST_CACHE_ENTRIES), *pixelMap);
+
+    ThumbnailCacheStats stats = cache.GetStats();
+    EXPECT_EQ(stats.evictions, 0);
+    EXPECT_EQ(stats.count, TEST_CACHE_ENTRIES);
+    EXPECT_EQ(stats.bytes, TEST_CACHE_BYTES);
+    EXPECT_EQ(cache.Get(GetTestKey(TEST_CACHE_ENTRIES)), nullptr);
+}
+
+HWTEST_F(MediaLibraryThumbnailManagerTest, medialib_ThumbnailCache_Trim_test_001, TestSize.Level0)
+{
+    ThumbnailCache cache(TEST_CACHE_BYTES);
+    FillCache(cache, TEST_CACHE_ENTRIES);
+
+    cache.Trim(ThumbnailCacheTrimLevel::TRIM_MODERATE);
+    ThumbnailCacheStats stats = cache.GetStats();
+    EXPECT_EQ(stats.count, TEST_CACHE_ENTRIES / 2);
+    EXPECT_LE(stats.bytes, TEST_CACHE_BYTES / 2);
+    EXPECT_NE(cache.Get(GetTestKey(TEST_CACHE_ENTRIES - 1)), nullptr);
+    EXPECT_EQ(cache.Get(GetTestKey(0)), nullptr);
+
+    cache.Trim(ThumbnailCacheTrimLevel::TRIM_LOW);
+    stats = cache.GetStats();
+    EXPECT_EQ(stats.count, TEST_CACHE_ENTRIES / 4);
+    EXPECT_LE(stats.bytes, TEST_CACHE_BYTES / 4);
+    EXPECT_NE(cache.Get(GetTestKey(TEST_CACHE_ENTRIES - 1)), nullptr);
+
+    cache.Trim(ThumbnailCacheTrimLevel::TRIM_CRITICAL);
+    stats = cache.GetStats();
+    EXPECT_EQ(stats.count, 0);
+    EXPECT_EQ(stats.bytes, 0);
+    EXPECT_EQ(cache.Get(GetTestKey(TEST_CACHE_ENTRIES - 1)), nullptr);
+}
+
+static RequestSharedPtr CreateTestRequest(int32_t priority)
+{
+    RequestPhotoParams params = {
+        .uri = "file://media/Photo/1",
+        .size = { TEST_MAP_SIDE, TEST_MAP_SIDE },
+        .type = RequestPhotoType::REQUEST_ALL,
+        .priority = priority,
+    };
+    return make_shared<ThumbnailRequest>(params, nullptr, nullptr);
+}
+
+HWTEST_F(MediaLibraryThumbnailManagerTest, medialib_ThumbnailRequestQueue_Pop_test_001, TestSize.Level0)
+{
+    // requests are created oldest first, the higher priority wins and then the newer request
+    vector<RequestSharedPtr> requests = { CreateTestRequest(0), CreateTestRequest(1), CreateTestRequest(0),
+        CreateTestRequest(1) };
+    ThumbnailRequestQueue queue;
+    for (const auto &request : requests) {
+        queue.Push(request);
+    }
+
+    vector<RequestSharedPtr> expected = { requests[3], requests[1], requests[2], requests[0] };
+    for (const auto &request : expected) {
+        RequestSharedPtr popped;
+        ASSERT_TRUE(queue.Pop(popped));
+        EXPECT_EQ(popped, request);
+    }
+    RequestSharedPtr popped;
+    EXPECT_FALSE(queue.Pop(popped));
+    EXPECT_TRUE(queue.Empty());
+}
+
+HWTEST_F(MediaLibraryThumbnailManagerTest, medialib_ThumbnailRequestQueue_Pop_test_002, TestSize.Level0)
+{
+    vector<RequestSharedPtr> requests = { CreateTestRequest(0), CreateTestRequest(0), CreateTestRequest(0) };
+    ThumbnailRequestQueue queue;
+    for (const auto &request : requests) {
+        queue.Push(request);
+    }
+
+    // the oldest request is raised while it waits, it is handed out before the newer ones
+    requests[0]->SetPriority(1);
+    vector<RequestSharedPtr> expected = { requests[0], requests[2], requests[1] };
+    for (const auto &request : expected) {
+        RequestSharedPtr popped;
+        ASSERT_TRUE(queue.Pop(popped));
+        EXPECT_EQ(popped, request);
+    }
+}
+
+HWTEST_F(MediaLibraryThumbnailManagerTest, medialib_ThumbnailRequestQueue_Pop_test_003, TestSize.Level0)
+{
+    vector<RequestSharedPtr> requests = { CreateTestRequest(0), CreateTestRequest(1), CreateTestRequest(2) };
+    ThumbnailRequestQueue queue;
+    for (const auto &request : requests) {
+        queue.Push(request);
+    }
+
+    requests[1]->UpdateStatus(ThumbnailStatus::THUMB_REMOVE);
+    requests[2]->UpdateStatus(ThumbnailStatus::THUMB_REMOVE);
+    RequestSharedPtr popped;
+    ASSERT_TRUE(queue.Pop(popped));
+    EXPECT_EQ(popped, requests[0]);
+    EXPECT_FALSE(queue.Pop(popped));
+    EXPECT_TRUE(queue.Empty());
+    EXPECT_EQ(queue.GetDroppedCount(), 2);
+}
+
+HWTEST_F(MediaLibraryThumbnailManagerTest, medialib_ThumbnailRequestQueue_PopBatch_test_001, TestSize.Level0)
+{
+    vector<RequestSharedPtr> requests = { CreateTestRequest(0), CreateTestRequest(2), CreateTestRequest(1),
+        CreateTestRequest(3) };
+    ThumbnailRequestQueue queue;
+    for (const auto &request : requests) {
+        queue.Push(request);
+    }
+    requests[3]->UpdateStatus(ThumbnailStatus::THUMB_REMOVE);
+
+    vector<RequestSharedPtr> batch;
+    queue.PopBatch([](const RequestSharedPtr &request) { return true; }, 2, batch);
+    ASSERT_EQ(batch.size(), 2);
+    EXPECT_EQ(batch[0], requests[1]);
+    EXPECT_EQ(batch[1], requests[2]);
+    EXPECT_EQ(queue.GetDroppedCount(), 1);
+
+    RequestSharedPtr popped;
+    ASSERT_TRUE(queue.Pop(popped));
+    EXPECT_EQ(popped, requests[0]);
+}
+
+HWTEST_F(MediaLibraryThumbnailManagerTest, medialib_ThumbnailManager_OnMemoryLevel_test_001, TestSize.Level0)
+{
+    auto manager = ThumbnailManager::GetInstance();
+    ASSERT_NE(manager, nullptr);
+    manager->OnMemoryLevel(static_cast<int32_t>(ThumbnailCacheTrimLevel::TRIM_CRITICAL));
+    ThumbnailCacheStats stats = manager->GetCacheStats();
+    EXPECT_EQ(stats.count, 0);
+    EXPECT_EQ(stats.bytes, 0);
+}
+HWTEST_F(MediaLibraryThumbnailManagerTest, medialib_ThumbnailManager_RequestStats_test_001, TestSize.Level0)
+{
+    auto manager = ThumbnailManager::GetInstance();
+    ASSERT_NE(manager, nullptr);
+    ThumbnailRequestStats stats = manager->GetRequestStats();
+    for (uint64_t i = 0; i < THUMBNAIL_STATS_LOG_INTERVAL; i++) {
+        manager->RemovePhotoRequest("not_a_request_" + to_string(i));
+    }
+    EXPECT_EQ(manager->GetRequestStats().removed, stats.removed + THUMBNAIL_STATS_LOG_INTERVAL);
+    EXPECT_EQ(manager->GetRequestStats().requests, stats.requests);
+}
+} // namespace Media
+} // namespace OHOS
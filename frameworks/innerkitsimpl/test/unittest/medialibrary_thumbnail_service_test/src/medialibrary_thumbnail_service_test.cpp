@@ -13,12 +13,21 @@
  * limitations under the License.
  */
 
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "foundation/ability/form_fwk/test/mock/include/mock_single_kv_store.h"
 #include "kvstore.h"
 #include "medialibrary_thumbnail_service_test.h"
 #define private public
+#include "thumbnail_buffer_pool.h"
+#include "thumbnail_generate_engine.h"
+#include "thumbnail_manager.h"
 #include "thumbnail_service.h"
+#include "thumbnail_store.h"
+#include "thumbnail_utils.h"
 #undef private
+#include "unique_fd.h"
 
 using namespace std;
 using namespace OHOS;
@@ -204,5 +213,287 @@ HWTEST_F(MediaLibraryThumbnailServiceTest, medialib_CreateThumbnailAsync_test_00
     serverTest.ReleaseService();
 }
 
+HWTEST_F(MediaLibraryThumbnailServiceTest, medialib_ThumbnailStore_test_001, TestSize.Level0)
+{
+    const string packPath = "/data/test/medialibrary_thumbnail_store_test/thumbs.pack";
+    const string path = "/storage/cloud/files/Photo/1/IMG_001.jpg";
+    unlink(packPath.c_str());
+    vector<uint8_t> thumb(1024, 1);
+    vector<uint8_t> lcd(4096, 2);
+    {
+        ThumbnailStore store(packPath);
+        EXPECT_EQ(store.Put(path, ThumbnailType::THUMB, thumb.data(), thumb.size()), E_OK);
+        EXPECT_EQ(store.Put(path, ThumbnailType::LCD, lcd.data(), lcd.size()), E_OK);
+        EXPECT_EQ(store.Sync(), E_OK);
+        EXPECT_EQ(store.Contains(path, ThumbnailType::THUMB), true);
+        EXPECT_EQ(store.Contains(path, ThumbnailType::MTH), false);
+
+        int fd = store.OpenFd(path, ThumbnailType::THUMB);
+        ASSERT_GE(fd, 0);
+        struct stat statInfo;
+        EXPECT_EQ(fstat(fd, &statInfo), 0);
+        EXPECT_EQ(statInfo.st_size, thumb.size());
+        close(fd);
+
+        EXPECT_EQ(store.Remove(path, ThumbnailType::LCD), true);
+        EXPECT_EQ(store.Remove(path, ThumbnailType::LCD), false);
+        EXPECT_EQ(store.OpenFd(path, ThumbnailType::LCD), E_NO_SUCH_FILE);
+    }
+
+    // the index is rebuilt from the segment, and compaction keeps the live records only
+    ThumbnailStore store(packPath);
+    vector<uint8_t> data;
+    EXPECT_EQ(store.Read(path, ThumbnailType::THUMB, data), E_OK);
+    EXPECT_EQ(data, thumb);
+    EXPECT_EQ(store.Contains(path, ThumbnailType::LCD), false);
+    EXPECT_EQ(store.Compact(), E_OK);
+    EXPECT_EQ(store.deadBytes_, 0);
+    EXPECT_EQ(store.Read(path, ThumbnailType::THUMB, data), E_OK);
+    EXPECT_EQ(data, thumb);
+
+    // a corrupted last record is dropped and does not fail compaction
+    EXPECT_EQ(store.Put(path, ThumbnailType::MTH, lcd.data(), lcd.size()), E_OK);
+    EXPECT_EQ(store.Sync(), E_OK);
+    off_t mthOffset = store.index_[ThumbnailStore::GetKey(path, ThumbnailType::MTH)].offset;
+    uint8_t garbage = 0xFF;
+    EXPECT_EQ(pwrite(store.fd_, &garbage, sizeof(garbage), mthOffset), sizeof(garbage));
+    EXPECT_EQ(store.Compact(), E_OK);
+    EXPECT_EQ(store.Contains(path, ThumbnailType::MTH), false);
+    EXPECT_EQ(store.Read(path, ThumbnailType::THUMB, data), E_OK);
+    EXPECT_EQ(data, thumb);
+}
+
+HWTEST_F(MediaLibraryThumbnailServiceTest, medialib_GenThumbSourceFromLcd_test_001, TestSize.Level0)
+{
+    ThumbnailData data;
+    EXPECT_EQ(ThumbnailUtils::GenThumbSourceFromLcd(data), false);
+
+    const int32_t lcdWidth = 1080;
+    const int32_t lcdHeight = 720;
+    vector<uint32_t> colors(lcdWidth * lcdHeight, 0xFF0000FF);
+    InitializationOptions opts;
+    opts.size = { lcdWidth, lcdHeight };
+    opts.pixelFormat = PixelFormat::RGBA_8888;
+    data.source = PixelMap::Create(colors.data(), colors.size(), opts);
+    ASSERT_NE(data.source, nullptr);
+    EXPECT_EQ(ThumbnailUtils::GenThumbSourceFromLcd(data), true);
+    EXPECT_EQ(data.source->GetWidth(), DEFAULT_THUMB_SIZE);
+    EXPECT_EQ(data.source->GetHeight(), DEFAULT_THUMB_SIZE);
+
+    // a panorama lcd is too narrow to crop a thumbnail from
+    opts.size = { lcdWidth, DEFAULT_YEAR_SIZE };
+    data.source = PixelMap::Create(colors.data(), lcdWidth * DEFAULT_YEAR_SIZE, opts);
+    ASSERT_NE(data.source, nullptr);
+    EXPECT_EQ(ThumbnailUtils::GenThumbSourceFromLcd(data), false);
+}
+
+HWTEST_F(MediaLibraryThumbnailServiceTest, medialib_ThumbnailBufferPool_test_001, TestSize.Level0)
+{
+    const size_t lcdSize = 4096;
+    ThumbnailBufferPool pool;
+    vector<uint8_t> buffer = pool.Acquire(ThumbnailType::LCD, lcdSize);
+    EXPECT_EQ(buffer.size(), lcdSize);
+    const uint8_t *pooledData = buffer.data();
+    pool.Release(ThumbnailType::LCD, move(buffer));
+
+    // a smaller request of the same type reuses the released buffer, another type allocates
+    buffer = pool.Acquire(ThumbnailType::LCD, lcdSize / 2);
+    EXPECT_EQ(buffer.size(), lcdSize / 2);
+    EXPECT_EQ(buffer.data(), pooledData);
+    vector<uint8_t> thumb = pool.Acquire(ThumbnailType::THUMB, lcdSize);
+    ThumbnailBufferPoolStats stats = pool.GetStats();
+    EXPECT_EQ(stats.acquires, 3);
+    EXPECT_EQ(stats.reuses, 1);
+    EXPECT_EQ(stats.allocations, 2);
+    EXPECT_EQ(stats.allocatedBytes, lcdSize * 2);
+    EXPECT_EQ(stats.pooledBytes, 0);
+
+    // only a few idle buffers are kept per type
+    vector<vector<uint8_t>> buffers;
+    for (int i = 0; i < 8; i++) {
+        buffers.push_back(pool.Acquire(ThumbnailType::MTH, lcdSize));
+    }
+    for (auto &mth : buffers) {
+        pool.Release(ThumbnailType::MTH, move(mth));
+    }
+    pool.Release(ThumbnailType::LCD, move(buffer));
+    stats = pool.GetStats();
+    EXPECT_GT(stats.pooledBytes, 0);
+    EXPECT_LT(stats.pooledBytes, lcdSize * 9);
+    EXPECT_GE(stats.peakRss, stats.startRss);
+
+    pool.Trim();
+    EXPECT_EQ(pool.GetStats().pooledBytes, 0);
+    pool.ResetStats();
+    EXPECT_EQ(pool.GetStats().acquires, 0);
+}
+
+HWTEST_F(MediaLibraryThumbnailServiceTest, medialib_ThumbnailGenerateEngine_test_001, TestSize.Level0)
+{
+    const int32_t cores = 8;
+    const int32_t cool = static_cast<int32_t>(ThumbnailThermalLevel::COOL);
+    EXPECT_EQ(ThumbnailGenerateEngine::GetWorkerNum(cores, cool), 4);
+    EXPECT_EQ(ThumbnailGenerateEngine::GetWorkerNum(cores, static_cast<int32_t>(ThumbnailThermalLevel::WARM)), 2);
+    EXPECT_EQ(ThumbnailGenerateEngine::GetWorkerNum(cores, static_cast<int32_t>(ThumbnailThermalLevel::HOT)), 1);
+    EXPECT_EQ(ThumbnailGenerateEngine::GetWorkerNum(cores,
+        static_cast<int32_t>(ThumbnailThermalLevel::OVERHEATED)), 0);
+    EXPECT_EQ(ThumbnailGenerateEngine::GetWorkerNum(1, cool), 1);
+    EXPECT_EQ(ThumbnailGenerateEngine::GetWorkerNum(64, cool), 4);
+
+    // the checkpoints survive a round trip through the file
+    const string path = "/data/test/thumbnail_generate_checkpoint";
+    const string photos = "Photos";
+    const string audios = "Audios";
+    map<string, ThumbnailCursor> cursors;
+    EXPECT_EQ(ThumbnailGenerateEngine::ReadCheckpoints(path + "_none", cursors), false);
+    cursors[photos] = { 1700000000000, 42 };
+    cursors[audios] = { 1600000000000, 7 };
+    ASSERT_EQ(ThumbnailGenerateEngine::WriteCheckpoints(path, cursors), true);
+    map<string, ThumbnailCursor> readCursors;
+    EXPECT_EQ(ThumbnailGenerateEngine::ReadCheckpoints(path, readCursors), true);
+    ASSERT_EQ(readCursors.size(), cursors.size());
+    EXPECT_EQ(readCursors[photos].dateAdded, 1700000000000);
+    EXPECT_EQ(readCursors[photos].fileId, 42);
+    EXPECT_EQ(readCursors[audios].fileId, 7);
+    unlink(path.c_str());
+}
+
+HWTEST_F(MediaLibraryThumbnailServiceTest, medialib_QueryNoThumbnailInfos_test_001, TestSize.Level0)
+{
+    if (storePtr == nullptr) {
+        exit(1);
+    }
+    // a page whose rows have no path is not the end of the scan, and the cursor moves past those rows
+    const string table = "thumbnail_scan_test";
+    ASSERT_EQ(storePtr->ExecuteSql("CREATE TABLE IF NOT EXISTS " + table + " (" + MEDIA_DATA_DB_ID +
+        " INTEGER PRIMARY KEY, " + MEDIA_DATA_DB_FILE_PATH + " TEXT, " + MEDIA_DATA_DB_MEDIA_TYPE + " INT, " +
+        MEDIA_DATA_DB_DATE_ADDED + " BIGINT, " + MEDIA_DATA_DB_TIME_VISIT + " BIGINT DEFAULT 0, " +
+        MEDIA_DATA_DB_IS_TRASH + " INT DEFAULT 0, " + MEDIA_DATA_DB_TIME_PENDING + " BIGINT DEFAULT 0)"), E_OK);
+    const int32_t rowNum = 5;
+    for (int32_t id = 1; id <= rowNum; id++) {
+        ValuesBucket values;
+        values.PutInt(MEDIA_DATA_DB_ID, id);
+        // the two newest rows have no path
+        values.PutString(MEDIA_DATA_DB_FILE_PATH, (id > rowNum - 2) ? "" : "/storage/cloud/files/" + to_string(id));
+        values.PutInt(MEDIA_DATA_DB_MEDIA_TYPE, MEDIA_TYPE_IMAGE);
+        values.PutLong(MEDIA_DATA_DB_DATE_ADDED, id * 1000);
+        int64_t rowId = 0;
+        ASSERT_EQ(storePtr->Insert(rowId, table, values), E_OK);
+    }
+    ThumbRdbOpt opts = { .store = storePtr, .table = table };
+    ThumbnailCursor cursor;
+    const int32_t limit = 2;
+    vector<ThumbnailData> infos;
+    bool isEnd = true;
+    int err = E_OK;
+    EXPECT_EQ(ThumbnailUtils::QueryNoThumbnailInfos(opts, cursor, limit, infos, isEnd, err), true);
+    EXPECT_TRUE(infos.empty());
+    EXPECT_FALSE(isEnd);
+    EXPECT_EQ(cursor.fileId, rowNum - 1);
+    EXPECT_EQ(cursor.dateAdded, (rowNum - 1) * 1000);
+
+    EXPECT_EQ(ThumbnailUtils::QueryNoThumbnailInfos(opts, cursor, limit, infos, isEnd, err), true);
+    ASSERT_EQ(infos.size(), 2);
+    EXPECT_EQ(infos[0].id, "3");
+    EXPECT_FALSE(isEnd);
+    infos.clear();
+    EXPECT_EQ(ThumbnailUtils::QueryNoThumbnailInfos(opts, cursor, limit, infos, isEnd, err), true);
+    ASSERT_EQ(infos.size(), 1);
+    EXPECT_EQ(infos[0].id, "1");
+    EXPECT_TRUE(isEnd);
+    storePtr->ExecuteSql("DROP TABLE " + table);
+}
+
+HWTEST_F(MediaLibraryThumbnailServiceTest, medialib_WriteBatchFd_test_001, TestSize.Level0)
+{
+    // odd data lengths, so the entries after the first one need padding to stay aligned
+    vector<ThumbnailBatchEntry> entries = {
+        { 1, THUMBNAIL_BATCH_OK, 0, 0 },
+        { 2, THUMBNAIL_BATCH_NEED_GENERATE, 0, 0 },
+        { 3, THUMBNAIL_BATCH_OK, 0, 0 },
+        { 4, THUMBNAIL_BATCH_FAIL, 0, 0 },
+        { 5, THUMBNAIL_BATCH_OK, 0, 0 },
+    };
+    vector<vector<uint8_t>> datas = { vector<uint8_t>(13, 0x11), {}, vector<uint8_t>(7, 0x33), {},
+        vector<uint8_t>(1, 0x55) };
+    UniqueFd fd(ThumbnailUtils::WriteBatchFd(entries, datas));
+    ASSERT_GE(fd.Get(), 0);
+    struct stat st;
+    ASSERT_EQ(fstat(fd.Get(), &st), 0);
+    vector<uint8_t> buffer(static_cast<size_t>(st.st_size));
+    ASSERT_EQ(pread(fd.Get(), buffer.data(), buffer.size(), 0), static_cast<ssize_t>(buffer.size()));
+    // sealed, the client maps it read only
+    EXPECT_LT(write(fd.Get(), buffer.data(), 1), 0);
+
+    size_t tableEnd = sizeof(ThumbnailBatchHeader) + entries.size() * sizeof(ThumbnailBatchEntry);
+    ASSERT_GE(buffer.size(), tableEnd);
+    ThumbnailBatchHeader header;
+    memcpy(&header, buffer.data(), sizeof(header));
+    EXPECT_EQ(header.magic, THUMBNAIL_BATCH_MAGIC);
+    ASSERT_EQ(header.count, entries.size());
+    vector<ThumbnailBatchEntry> readEntries(entries.size());
+    memcpy(readEntries.data(), buffer.data() + sizeof(header), entries.size() * sizeof(ThumbnailBatchEntry));
+    size_t dataEnd = tableEnd;
+    for (size_t i = 0; i < entries.size(); i++) {
+        EXPECT_EQ(readEntries[i].fileId, entries[i].fileId);
+        EXPECT_EQ(readEntries[i].status, entries[i].status);
+        if (entries[i].status != THUMBNAIL_BATCH_OK) {
+            EXPECT_EQ(readEntries[i].offset, 0);
+            EXPECT_EQ(readEntries[i].length, 0);
+            continue;
+        }
+        EXPECT_EQ(readEntries[i].offset % THUMBNAIL_BATCH_ALIGN, 0);
+        EXPECT_GE(readEntries[i].offset, dataEnd);
+        ASSERT_EQ(readEntries[i].length, datas[i].size());
+        ASSERT_LE(readEntries[i].offset + readEntries[i].length, buffer.size());
+        EXPECT_TRUE(equal(datas[i].begin(), datas[i].end(), buffer.begin() + readEntries[i].offset));
+        dataEnd = readEntries[i].offset + readEntries[i].length;
+    }
+    EXPECT_EQ(dataEnd, buffer.size());
+}
+
+HWTEST_F(MediaLibraryThumbnailServiceTest, medialib_DecodeThumbnailBatch_test_001, TestSize.Level0)
+{
+    // mth data is raw pixels, which the client wraps without a decoder
+    Size size = { DEFAULT_MTH_SIZE, DEFAULT_MTH_SIZE };
+    size_t pixelBytes = static_cast<size_t>(size.width * size.height) * sizeof(uint32_t);
+    vector<ThumbnailBatchEntry> entries = {
+        { 10, THUMBNAIL_BATCH_OK, 0, 0 },
+        { 11, THUMBNAIL_BATCH_NEED_GENERATE, 0, 0 },
+        { 12, THUMBNAIL_BATCH_OK, 0, 0 },
+    };
+    // transparent black and opaque white, which read back the same whatever the alpha type
+    vector<vector<uint8_t>> datas = { vector<uint8_t>(pixelBytes, 0x00), {}, vector<uint8_t>(pixelBytes, 0xff) };
+    UniqueFd fd(ThumbnailUtils::WriteBatchFd(entries, datas));
+    ASSERT_GE(fd.Get(), 0);
+
+    vector<string> ids = { "10", "11", "12" };
+    vector<PixelMapPtr> pixelMaps(ids.size());
+    ThumbnailManager::DecodeThumbnailBatch(fd.Get(), ids, size, pixelMaps);
+    ASSERT_NE(pixelMaps[0], nullptr);
+    EXPECT_EQ(pixelMaps[0]->GetWidth(), size.width);
+    EXPECT_EQ(pixelMaps[0]->GetHeight(), size.height);
+    EXPECT_EQ(pixelMaps[1], nullptr);
+    ASSERT_NE(pixelMaps[2], nullptr);
+    uint32_t color = 0;
+    EXPECT_TRUE(pixelMaps[0]->GetARGB32Color(0, 0, color));
+    EXPECT_EQ(color, 0);
+    EXPECT_TRUE(pixelMaps[2]->GetARGB32Color(0, 0, color));
+    EXPECT_EQ(color, 0xffffffff);
+
+    // an entry of another asset than asked for is not decoded
+    ids = { "10", "11", "13" };
+    pixelMaps = vector<PixelMapPtr>(ids.size());
+    ThumbnailManager::DecodeThumbnailBatch(fd.Get(), ids, size, pixelMaps);
+    EXPECT_NE(pixelMaps[0], nullptr);
+    EXPECT_EQ(pixelMaps[2], nullptr);
+
+    // a count that does not match the header drops the whole batch
+    ids = { "10", "11" };
+    pixelMaps = vector<PixelMapPtr>(ids.size());
+    ThumbnailManager::DecodeThumbnailBatch(fd.Get(), ids, size, pixelMaps);
+    EXPECT_EQ(pixelMaps[0], nullptr);
+}
+
 } // namespace Media
 } // namespace OHOS
\ No newline at end of file
@@ -77,6 +77,38 @@ HWTEST_F(MediaLibraryUriTest, medialib_ParseThumbnailInfo_test_001, TestSize.Lev
     EXPECT_EQ(ret, true);
 }
 
+HWTEST_F(MediaLibraryUriTest, medialib_ParseBatchThumbnailInfo_test_001, TestSize.Level0)
+{
+    string prefix = "file://media/Photo/" + MEDIA_DATA_DB_THUMBNAIL + "?" + THUMBNAIL_OPERN_KEYWORD + "=";
+    string sizeQuery = "&" + THUMBNAIL_WIDTH + "=256&" + THUMBNAIL_HEIGHT + "=256";
+    vector<string> ids;
+    Size size;
+    string table;
+    string uriString = prefix + THUMBNAIL_BATCH_OPERN + "&" + THUMBNAIL_BATCH_IDS + "=3,1,2" + sizeQuery;
+    EXPECT_EQ(ThumbnailUriUtils::IsBatchThumbnailUri(uriString), true);
+    EXPECT_EQ(ThumbnailUriUtils::ParseBatchThumbnailInfo(uriString, ids, size, table), true);
+    EXPECT_EQ(ids, vector<string>({ "3", "1", "2" }));
+    EXPECT_EQ(size.width, 256);
+    EXPECT_EQ(size.height, 256);
+
+    uriString = prefix + MEDIA_DATA_DB_THUMBNAIL + "&" + THUMBNAIL_BATCH_IDS + "=1" + sizeQuery;
+    EXPECT_EQ(ThumbnailUriUtils::IsBatchThumbnailUri(uriString), false);
+    EXPECT_EQ(ThumbnailUriUtils::ParseBatchThumbnailInfo(uriString, ids, size, table), false);
+    uriString = prefix + THUMBNAIL_BATCH_OPERN + "&" + THUMBNAIL_BATCH_IDS + "=" + sizeQuery;
+    EXPECT_EQ(ThumbnailUriUtils::ParseBatchThumbnailInfo(uriString, ids, size, table), false);
+    uriString = prefix + THUMBNAIL_BATCH_OPERN + "&" + THUMBNAIL_BATCH_IDS + "=1,a" + sizeQuery;
+    EXPECT_EQ(ThumbnailUriUtils::ParseBatchThumbnailInfo(uriString, ids, size, table), false);
+    uriString = prefix + THUMBNAIL_BATCH_OPERN + "&" + THUMBNAIL_BATCH_IDS + "=1&" + THUMBNAIL_WIDTH + "=256";
+    EXPECT_EQ(ThumbnailUriUtils::ParseBatchThumbnailInfo(uriString, ids, size, table), false);
+
+    string idList = "1";
+    for (size_t i = 1; i <= THUMBNAIL_BATCH_MAX_COUNT; i++) {
+        idList += "," + to_string(i + 1);
+    }
+    uriString = prefix + THUMBNAIL_BATCH_OPERN + "&" + THUMBNAIL_BATCH_IDS + "=" + idList + sizeQuery;
+    EXPECT_EQ(ThumbnailUriUtils::ParseBatchThumbnailInfo(uriString, ids, size, table), false);
+}
+
 HWTEST_F(MediaLibraryUriTest, medialib_GetNetworkIdFromUri_test_001, TestSize.Level0)
 {
     string deviceId = ThumbnailUriUtils::GetNetworkIdFromUri("");
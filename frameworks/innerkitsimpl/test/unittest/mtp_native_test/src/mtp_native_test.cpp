@@ -13,6 +13,11 @@
  * limitations under the License.
  */
 #include "mtp_native_test.h"
+
+#include <cerrno>
+#include <chrono>
+#include <unistd.h>
+
 #define private public
 #include "mtp_medialibrary_manager.h"
 #include "mtp_event.h"
@@ -2655,5 +2660,171 @@ HWTEST_F(MtpNativeTest, mtp_medialibrary_manager_001, TestSize.Level0)
     MEDIA_INFO_LOG("mtp_medialibrary_manager_001::End");
 }
 
+/**
+ * @tc.number    : mtp_medialibrary_manager_002
+ * @tc.name      : mtp_medialibrary_manager_002
+ * @tc.desc      : GetHandles reads the ids page by page in ascending order
+ */
+HWTEST_F(MtpNativeTest, mtp_medialibrary_manager_002, TestSize.Level0)
+{
+    auto saManager = SystemAbilityManagerClient::GetInstance().GetSystemAbilityManager();
+    auto remoteObj = saManager->GetSystemAbility(TEST_UID);
+    MtpMedialibraryManager::GetInstance()->Init(remoteObj);
+    shared_ptr<MtpOperationContext> context = make_shared<MtpOperationContext>();
+    context->format = 0;
+    context->parent = 0;
+    shared_ptr<UInt32List> objectHandles = make_shared<UInt32List>();
+    auto start = chrono::steady_clock::now();
+    int32_t ret = MtpMedialibraryManager::GetInstance()->GetHandles(context, objectHandles);
+    auto cost = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+    EXPECT_EQ(ret, MTP_SUCCESS);
+    MEDIA_INFO_LOG("GetHandles of %{public}zu objects cost %{public}lld us", objectHandles->size(),
+        static_cast<long long>(cost));
+    for (size_t i = 1; i < objectHandles->size(); i++) {
+        EXPECT_LT((*objectHandles)[i - 1], (*objectHandles)[i]);
+    }
+
+    vector<int> handles;
+    ret = MtpMedialibraryManager::GetInstance()->GetHandles(0, handles, MEDIA_TYPE_ALL);
+    EXPECT_EQ(ret, MTP_SUCCESS);
+
+    shared_ptr<UInt32List> nullHandles = nullptr;
+    ret = MtpMedialibraryManager::GetInstance()->GetHandles(context, nullHandles);
+    EXPECT_EQ(ret, MTP_ERROR_STORE_NOT_AVAILABLE);
+    MEDIA_INFO_LOG("mtp_medialibrary_manager_002::End");
+}
+
+static constexpr int32_t TEST_IMAGE_SIZE = 512;
+static constexpr size_t JPEG_SOI_SIZE = 2;
+static constexpr uint8_t JPEG_MARKER = 0xFF;
+static constexpr uint8_t JPEG_SOI = 0xD8;
+
+static bool WriteImage(int32_t fd)
+{
+    InitializationOptions opts;
+    opts.size = { .width = TEST_IMAGE_SIZE, .height = TEST_IMAGE_SIZE };
+    opts.pixelFormat = PixelFormat::RGBA_8888;
+    opts.alphaType = AlphaType::IMAGE_ALPHA_TYPE_UNPREMUL;
+    unique_ptr<PixelMap> pixelMap = PixelMap::Create(opts);
+    vector<uint8_t> image;
+    if ((pixelMap == nullptr) || !MtpMedialibraryManager::GetInstance()->CompressImage(pixelMap, opts.size, image)) {
+        MEDIA_ERR_LOG("fail to encode the test image");
+        return false;
+    }
+    size_t offset = 0;
+    while (offset < image.size()) {
+        ssize_t writeSize = write(fd, image.data() + offset, image.size() - offset);
+        if (writeSize <= 0) {
+            MEDIA_ERR_LOG("fail to write the test image, errno: %{public}d", errno);
+            return false;
+        }
+        offset += static_cast<size_t>(writeSize);
+    }
+    return true;
+}
+
+// creates context->name as a jpeg under Pictures and fills in context->handle
+static int32_t CreateImageAsset(const shared_ptr<MtpOperationContext> &context)
+{
+    auto manager = MtpMedialibraryManager::GetInstance();
+    if (manager->GetIdByPath(ROOT_MEDIA_DIR + "Pictures", context->parent) != E_SUCCESS) {
+        return MTP_ERROR_INVALID_PARENTOBJECT;
+    }
+    context->format = MTP_FORMAT_EXIF_JPEG_CODE;
+    uint32_t storageId = 0;
+    uint32_t parent = 0;
+    int32_t ret = manager->SendObjectInfo(context, storageId, parent, context->handle);
+    if (ret != MTP_SUCCESS) {
+        return ret;
+    }
+    int32_t fd = 0;
+    ret = manager->GetFd(context, fd);
+    if (ret != MTP_SUCCESS) {
+        return ret;
+    }
+    bool isWritten = WriteImage(fd);
+    ret = manager->CloseFd(context, fd);
+    return isWritten ? ret : MTP_ERROR_STORE_NOT_AVAILABLE;
+}
+
+/**
+ * @tc.number    : mtp_medialibrary_manager_003
+ * @tc.name      : mtp_medialibrary_manager_003
+ * @tc.desc      : GetThumb serves the stored THUMB jpeg of an image and rejects handles without one
+ */
+HWTEST_F(MtpNativeTest, mtp_medialibrary_manager_003, TestSize.Level0)
+{
+    auto saManager = SystemAbilityManagerClient::GetInstance().GetSystemAbilityManager();
+    auto remoteObj = saManager->GetSystemAbility(TEST_UID);
+    MtpMedialibraryManager::GetInstance()->Init(remoteObj);
+    shared_ptr<MtpOperationContext> context = make_shared<MtpOperationContext>();
+    shared_ptr<UInt8List> outThumb = make_shared<UInt8List>();
+    int32_t ret = MtpMedialibraryManager::GetInstance()->GetThumb(nullptr, outThumb);
+    EXPECT_EQ(ret, MTP_ERROR_STORE_NOT_AVAILABLE);
+
+    context->handle = 0;
+    ret = MtpMedialibraryManager::GetInstance()->GetThumb(context, outThumb);
+    EXPECT_NE(ret, MTP_SUCCESS);
+
+    context->name = "mtp_thumb_" + to_string(chrono::steady_clock::now().time_since_epoch().count()) + ".jpg";
+    ASSERT_EQ(CreateImageAsset(context), MTP_SUCCESS);
+    ret = MtpMedialibraryManager::GetInstance()->GetThumb(context, outThumb);
+    ASSERT_EQ(ret, MTP_SUCCESS);
+    ASSERT_GE(outThumb->size(), JPEG_SOI_SIZE);
+    EXPECT_EQ((*outThumb)[0], JPEG_MARKER);
+    EXPECT_EQ((*outThumb)[1], JPEG_SOI);
+
+    // the first request saved the THUMB, the service hands the same file out again
+    shared_ptr<FileAsset> fileAsset;
+    ASSERT_EQ(MtpMedialibraryManager::GetInstance()->GetAssetById(context->handle, fileAsset), E_SUCCESS);
+    shared_ptr<UInt8List> storedThumb = make_shared<UInt8List>();
+    ret = MtpMedialibraryManager::GetInstance()->GetThumbFromService(fileAsset, storedThumb);
+    ASSERT_EQ(ret, MTP_SUCCESS);
+    EXPECT_EQ(*storedThumb, *outThumb);
+
+    MtpMedialibraryManager::GetInstance()->DeleteObject(context);
+    MEDIA_INFO_LOG("mtp_medialibrary_manager_003::End");
+}
+
+/**
+ * @tc.number    : mtp_medialibrary_manager_004
+ * @tc.name      : mtp_medialibrary_manager_004
+ * @tc.desc      : GetObjectPropList serves a repeated folder listing from the cache until it is cleared
+ */
+HWTEST_F(MtpNativeTest, mtp_medialibrary_manager_004, TestSize.Level0)
+{
+    auto saManager = SystemAbilityManagerClient::GetInstance().GetSystemAbilityManager();
+    auto remoteObj = saManager->GetSystemAbility(TEST_UID);
+    MtpMedialibraryManager::GetInstance()->Init(remoteObj);
+    MtpMedialibraryManager::GetInstance()->ClearPropListCache();
+    shared_ptr<MtpOperationContext> context = make_shared<MtpOperationContext>();
+    context->property = MTP_PROPERTY_ALL_CODE;
+    context->handle = 0;
+    context->depth = 1;
+    shared_ptr<vector<Property>> firstProps = make_shared<vector<Property>>();
+    int32_t ret = MtpMedialibraryManager::GetInstance()->GetObjectPropList(context, firstProps);
+    if (ret != MTP_SUCCESS) {
+        return;
+    }
+    EXPECT_FALSE(firstProps->empty());
+
+    shared_ptr<vector<Property>> cachedProps = make_shared<vector<Property>>();
+    ret = MtpMedialibraryManager::GetInstance()->GetObjectPropList(context, cachedProps);
+    EXPECT_EQ(ret, MTP_SUCCESS);
+    EXPECT_EQ(cachedProps, firstProps);
+
+    MtpMedialibraryManager::GetInstance()->ClearPropListCache();
+    shared_ptr<vector<Property>> freshProps = make_shared<vector<Property>>();
+    ret = MtpMedialibraryManager::GetInstance()->GetObjectPropList(context, freshProps);
+    EXPECT_EQ(ret, MTP_SUCCESS);
+    EXPECT_NE(freshProps, firstProps);
+    ASSERT_EQ(freshProps->size(), firstProps->size());
+    for (size_t i = 0; i < freshProps->size(); i++) {
+        EXPECT_EQ((*freshProps)[i].handle_, (*firstProps)[i].handle_);
+        EXPECT_EQ((*freshProps)[i].code_, (*firstProps)[i].code_);
+    }
+    MEDIA_INFO_LOG("mtp_medialibrary_manager_004::End");
+}
+
 } // namespace Media
 } // ohos
\ No newline at end of file
@@ -183,6 +183,42 @@ HWTEST_F(MtpNativeTest, mtp_packet_tools_test_004, TestSize.Level0)
     MtpPacketTool::GetObjectPropTypeByPropCode(propCode);
 }
 
+HWTEST_F(MtpNativeTest, mtp_packet_tools_test_005, TestSize.Level0)
+{
+    string name = "IMG_2023\u4e2d\u6587\U0001F600.jpg";
+    u16string name16 = MtpPacketTool::Utf8ToUtf16(name);
+    EXPECT_EQ(name16, u"IMG_2023\u4e2d\u6587\U0001F600.jpg");
+    EXPECT_EQ(MtpPacketTool::Utf16ToUtf8(name16), name);
+
+    vector<uint8_t> buffer;
+    MtpPacketTool::PutString(buffer, name);
+    EXPECT_EQ(buffer.size(), MtpPacketTool::GetStringSize(name));
+    size_t offset = 0;
+    EXPECT_EQ(MtpPacketTool::GetString(buffer, offset), name);
+    EXPECT_EQ(offset, buffer.size());
+
+    // malformed input is written as an empty string
+    vector<string> badNames = { "a\xC0\xAF", "a\xED\xA0\x80", "a\xF4\x90\x80\x80", "a\xE4\xB8" };
+    for (const string &badName : badNames) {
+        EXPECT_EQ(MtpPacketTool::Utf8ToUtf16(badName), u"");
+        buffer.clear();
+        MtpPacketTool::PutString(buffer, badName);
+        EXPECT_EQ(buffer, vector<uint8_t>{ 0 });
+        EXPECT_EQ(MtpPacketTool::GetStringSize(badName), 1);
+    }
+    EXPECT_EQ(MtpPacketTool::Utf16ToUtf8(u"a\xD800"), "");
+    EXPECT_EQ(MtpPacketTool::Utf16ToUtf8(u"a\xDC00" u"b"), "");
+
+    // strings longer than the protocol allows are cut to 254 units and the terminator
+    string longName(300, 'a');
+    buffer.clear();
+    MtpPacketTool::PutString(buffer, longName);
+    EXPECT_EQ(buffer[0], 255);
+    EXPECT_EQ(buffer.size(), MtpPacketTool::GetStringSize(longName));
+    offset = 0;
+    EXPECT_EQ(MtpPacketTool::GetString(buffer, offset), string(254, 'a'));
+}
+
 HWTEST_F(MtpNativeTest, mtp_Property_test_001, TestSize.Level0)
 {
     Property propertyOne(0, MTP_TYPE_INT8_CODE, true, 0);
@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <fcntl.h>
+#include <unistd.h>
+#include "mtp_native_test.h"
+#include "mtp_packet_tools.h"
+#include "mtp_transfer_pipeline.h"
+
+using namespace std;
+using namespace testing::ext;
+using namespace OHOS::HDI::Usb::Gadget::Mtp::V1_0;
+namespace OHOS {
+namespace Media {
+namespace {
+const string TEST_SEND_FILE = "/data/local/tmp/mtp_pipeline_send";
+const string TEST_RECEIVE_FILE = "/data/local/tmp/mtp_pipeline_receive";
+constexpr uint32_t TEST_PACKET_SIZE = 512;
+constexpr uint32_t TEST_CHUNK_SIZE = 4096;
+constexpr uint32_t TEST_FILE_SIZE = 5 * TEST_CHUNK_SIZE + 100;
+constexpr uint16_t TEST_COMMAND = 0x1009;
+constexpr uint32_t TEST_TRANSACTION_ID = 7;
+
+// keeps what the device writes and plays back what the host sends, in reads of at most one chunk
+class LoopbackUsbfnMtp : public IUsbfnMtpInterface {
+public:
+    int32_t Start() override { return 0; }
+    int32_t Stop() override { return 0; }
+    int32_t Init() override { return 0; }
+    int32_t Release() override { return 0; }
+
+    int32_t Read(std::vector<uint8_t> &data) override
+    {
+        size_t size = min(data.size(), hostData.size() - readOffset);
+        data.assign(hostData.begin() + readOffset, hostData.begin() + readOffset + size);
+        readOffset += size;
+        return 0;
+    }
+
+    int32_t Write(const std::vector<uint8_t> &data) override
+    {
+        if (data.empty()) {
+            zeroPackets++;
+        }
+        deviceData.insert(deviceData.end(), data.begin(), data.end());
+        return 0;
+    }
+
+    int32_t ReceiveFile(const UsbFnMtpFileSlice &mfs) override { return -1; }
+    int32_t SendFile(const UsbFnMtpFileSlice &mfs) override { return -1; }
+    int32_t SendEvent(const std::vector<uint8_t> &eventData) override { return 0; }
+
+    vector<uint8_t> hostData;
+    size_t readOffset = 0;
+    vector<uint8_t> deviceData;
+    uint32_t zeroPackets = 0;
+};
+
+vector<uint8_t> MakeTestData(size_t size)
+{
+    vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; i++) {
+        data[i] = static_cast<uint8_t>(i * 31 + (i >> 8));
+    }
+    return data;
+}
+
+int CreateTestFile(const string &path, const vector<uint8_t> &data)
+{
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0664);
+    if ((fd >= 0) && !data.empty()) {
+        EXPECT_EQ(write(fd, data.data(), data.size()), static_cast<ssize_t>(data.size()));
+    }
+    return fd;
+}
+} // namespace
+
+/**
+ * @tc.number    : mtp_transfer_pipeline_test_001
+ * @tc.name      : mtp_transfer_pipeline_test_001
+ * @tc.desc      : SendFile writes the data header and the whole file range in order
+ */
+HWTEST_F(MtpNativeTest, mtp_transfer_pipeline_test_001, TestSize.Level0)
+{
+    vector<uint8_t> fileData = MakeTestData(TEST_FILE_SIZE);
+    int fd = CreateTestFile(TEST_SEND_FILE, fileData);
+    ASSERT_GE(fd, 0);
+    sptr<LoopbackUsbfnMtp> loopback = new LoopbackUsbfnMtp();
+    MtpTransferConfig config;
+    config.chunkSize = TEST_CHUNK_SIZE;
+    config.bufferCount = 2;
+    config.maxPacketSize = TEST_PACKET_SIZE;
+    MtpTransferPipeline pipeline(loopback, config);
+
+    MtpFileRange mfr = { fd, 0, TEST_FILE_SIZE, TEST_COMMAND, TEST_TRANSACTION_ID };
+    EXPECT_EQ(pipeline.SendFile(mfr), MTP_SUCCESS);
+    ASSERT_EQ(loopback->deviceData.size(), TEST_FILE_SIZE + PACKET_HEADER_LENGETH);
+    size_t offset = 0;
+    EXPECT_EQ(MtpPacketTool::GetUInt32(loopback->deviceData, offset), TEST_FILE_SIZE + PACKET_HEADER_LENGETH);
+    EXPECT_EQ(MtpPacketTool::GetUInt16(loopback->deviceData, offset), DATA_CONTAINER_TYPE);
+    EXPECT_EQ(MtpPacketTool::GetUInt16(loopback->deviceData, offset), TEST_COMMAND);
+    EXPECT_EQ(MtpPacketTool::GetUInt32(loopback->deviceData, offset), TEST_TRANSACTION_ID);
+    EXPECT_TRUE(equal(fileData.begin(), fileData.end(), loopback->deviceData.begin() + PACKET_HEADER_LENGETH));
+    EXPECT_EQ(loopback->zeroPackets, 0);
+
+    MtpTransferStats stats = pipeline.GetStats();
+    EXPECT_EQ(stats.transfers, 1);
+    EXPECT_EQ(stats.bytes, TEST_FILE_SIZE);
+
+    // a data phase of whole packets ends with a zero length packet
+    loopback->deviceData.clear();
+    mfr.length = TEST_PACKET_SIZE * 2 - PACKET_HEADER_LENGETH;
+    EXPECT_EQ(pipeline.SendFile(mfr), MTP_SUCCESS);
+    EXPECT_EQ(loopback->deviceData.size(), TEST_PACKET_SIZE * 2);
+    EXPECT_EQ(loopback->zeroPackets, 1);
+    close(fd);
+    unlink(TEST_SEND_FILE.c_str());
+}
+
+/**
+ * @tc.number    : mtp_transfer_pipeline_test_002
+ * @tc.name      : mtp_transfer_pipeline_test_002
+ * @tc.desc      : ReceiveFile writes what the host sends behind the initial data
+ */
+HWTEST_F(MtpNativeTest, mtp_transfer_pipeline_test_002, TestSize.Level0)
+{
+    constexpr uint32_t initialSize = 100;
+    vector<uint8_t> fileData = MakeTestData(TEST_FILE_SIZE);
+    int fd = CreateTestFile(TEST_RECEIVE_FILE, vector<uint8_t>(fileData.begin(), fileData.begin() + initialSize));
+    ASSERT_GE(fd, 0);
+    sptr<LoopbackUsbfnMtp> loopback = new LoopbackUsbfnMtp();
+    loopback->hostData.assign(fileData.begin() + initialSize, fileData.end());
+    MtpTransferConfig config;
+    config.chunkSize = TEST_CHUNK_SIZE;
+    config.bufferCount = 3;
+    config.maxPacketSize = TEST_PACKET_SIZE;
+    MtpTransferPipeline pipeline(loopback, config);
+
+    MtpFileRange mfr = { fd, initialSize, TEST_FILE_SIZE - initialSize, 0, 0 };
+    EXPECT_EQ(pipeline.ReceiveFile(mfr), MTP_SUCCESS);
+    vector<uint8_t> received(TEST_FILE_SIZE + 1);
+    EXPECT_EQ(pread(fd, received.data(), received.size(), 0), static_cast<ssize_t>(TEST_FILE_SIZE));
+    received.resize(TEST_FILE_SIZE);
+    EXPECT_EQ(received, fileData);
+    EXPECT_EQ(pipeline.GetStats().bytes, TEST_FILE_SIZE - initialSize);
+
+    // the host stops early
+    loopback->hostData.resize(TEST_CHUNK_SIZE);
+    loopback->readOffset = 0;
+    EXPECT_EQ(pipeline.ReceiveFile(mfr), MTP_ERROR_INCOMPLETE_TRANSFER);
+    close(fd);
+    unlink(TEST_RECEIVE_FILE.c_str());
+}
+
+/**
+ * @tc.number    : mtp_transfer_pipeline_test_003
+ * @tc.name      : mtp_transfer_pipeline_test_003
+ * @tc.desc      : config is clamped and a closed file fails the transfer
+ */
+HWTEST_F(MtpNativeTest, mtp_transfer_pipeline_test_003, TestSize.Level0)
+{
+    sptr<LoopbackUsbfnMtp> loopback = new LoopbackUsbfnMtp();
+    MtpTransferConfig config;
+    config.chunkSize = 1;
+    config.bufferCount = 0;
+    MtpTransferPipeline pipeline(loopback, config);
+    EXPECT_EQ(pipeline.GetConfig().chunkSize, READ_BUFFER_MAX_SIZE);
+    EXPECT_EQ(pipeline.GetConfig().bufferCount, 2);
+    // the packet size is taken from the usb speed once, and the driver keeps the hdi fd path by default
+    EXPECT_NE(pipeline.GetConfig().maxPacketSize, 0);
+    EXPECT_FALSE(pipeline.GetConfig().usePipeline);
+    // a chunk has to fit one hdi parcel
+    config.chunkSize = UINT32_MAX;
+    pipeline.SetConfig(config);
+    EXPECT_LE(pipeline.GetConfig().chunkSize, 1024 * 1024);
+
+    MtpFileRange mfr = { -1, 0, TEST_FILE_SIZE, TEST_COMMAND, TEST_TRANSACTION_ID };
+    EXPECT_EQ(pipeline.SendFile(mfr), MTP_ERROR_INCOMPLETE_TRANSFER);
+    MtpTransferPipeline nullPipeline(nullptr);
+    EXPECT_EQ(nullPipeline.ReceiveFile(mfr), MTP_ERROR_DRIVER_OPEN_FAILED);
+}
+/**
+ * @tc.number    : mtp_transfer_pipeline_test_004
+ * @tc.name      : mtp_transfer_pipeline_test_004
+ * @tc.desc      : ReceiveFile of whole packets reads the zero length packet, and fails when the host sends data
+ */
+HWTEST_F(MtpNativeTest, mtp_transfer_pipeline_test_004, TestSize.Level0)
+{
+    constexpr uint32_t length = TEST_PACKET_SIZE * 2 - PACKET_HEADER_LENGETH;
+    int fd = CreateTestFile(TEST_RECEIVE_FILE, vector<uint8_t>());
+    ASSERT_GE(fd, 0);
+    sptr<LoopbackUsbfnMtp> loopback = new LoopbackUsbfnMtp();
+    loopback->hostData = MakeTestData(length);
+    MtpTransferConfig config;
+    config.chunkSize = TEST_CHUNK_SIZE;
+    config.maxPacketSize = TEST_PACKET_SIZE;
+    MtpTransferPipeline pipeline(loopback, config);
+
+    // the loopback has nothing left after the data, so the last read gets the zero length packet
+    MtpFileRange mfr = { fd, 0, length, 0, 0 };
+    EXPECT_EQ(pipeline.ReceiveFile(mfr), MTP_SUCCESS);
+    EXPECT_EQ(loopback->readOffset, length);
+
+    // the next container instead of the zero length packet
+    constexpr uint32_t nextContainerSize = 8;
+    loopback->hostData = MakeTestData(length + nextContainerSize);
+    loopback->readOffset = 0;
+    EXPECT_EQ(pipeline.ReceiveFile(mfr), MTP_ERROR_INCOMPLETE_TRANSFER);
+    close(fd);
+    unlink(TEST_RECEIVE_FILE.c_str());
+}
+} // namespace Media
+} // ohos
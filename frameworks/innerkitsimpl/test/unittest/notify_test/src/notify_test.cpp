@@ -16,6 +16,8 @@
 
 #include "notify_test.h"
 
+#include <thread>
+
 #include "ability_context_impl.h"
 #include "fetch_result.h"
 #include "get_self_permissions.h"
@@ -60,6 +62,7 @@ static constexpr int OBS_TMP_ALBUM_ID = 10;
 static constexpr int LIST_SIZE = 1;
 static constexpr int64_t DATE_ADD = 6666666;
 static constexpr int64_t DATE_MODIFY = 6666667;
+static constexpr int BENCH_ASSET_COUNT = 5000;
 shared_ptr<DataShare::DataShareHelper> sDataShareHelper_ = nullptr;
 
 void CheckGetAlbumIdBySubType(PhotoAlbumSubType photoAlbumSubType, DefaultAlbumId defaultAlbumId)
@@ -422,4 +425,154 @@ HWTEST_F(NotifyTest, close_asset_on_change_002, TestSize.Level0)
     CheckCloseAssetNotify(false);
     MEDIA_INFO_LOG("close_asset_on_change_002 exit");
 }
+/**
+ * @tc.name: notify_merge_001
+ * @tc.desc: changes of the same asset are merged before they are sent
+ *           1. NOTIFY_ADD then NOTIFY_REMOVE cancel out "notify_merge_001"
+ *           2. NOTIFY_REMOVE then NOTIFY_ADD is sent as NOTIFY_UPDATE
+ * @tc.type: FUNC
+ * @tc.require:
+ */
+HWTEST_F(NotifyTest, notify_merge_001, TestSize.Level0)
+{
+    MEDIA_INFO_LOG("notify_merge_001 enter");
+    string uriStr = PhotoColumn::PHOTO_URI_PREFIX + to_string(OBS_TMP_ID);
+    shared_ptr<TestObserver> obs = make_shared<TestObserver>();
+    ASSERT_NE(sDataShareHelper_, nullptr);
+    sDataShareHelper_->RegisterObserverExt(Uri(uriStr), obs, true);
+    auto watch = MediaLibraryNotify::GetInstance();
+    MediaLibraryNotify::ResetStats();
+    {
+        unique_lock<mutex> lock(obs->mutex_);
+        watch->Notify(uriStr, NotifyType::NOTIFY_ADD);
+        watch->Notify(uriStr, NotifyType::NOTIFY_REMOVE);
+        EXPECT_EQ(MediaLibraryNotify::GetStats().cancelled, 1);
+        EXPECT_EQ(obs->condition_.wait_for(lock, 1s), cv_status::timeout);
+    }
+    {
+        unique_lock<mutex> lock(obs->mutex_);
+        watch->Notify(uriStr, NotifyType::NOTIFY_REMOVE);
+        watch->Notify(uriStr, NotifyType::NOTIFY_ADD);
+        ASSERT_EQ(obs->condition_.wait_for(lock, 2s), cv_status::no_timeout);
+        EXPECT_EQ(obs->changeInfo_.changeType_,
+            static_cast<DataShareObserver::ChangeType>(NotifyType::NOTIFY_UPDATE));
+        EXPECT_EQ(obs->changeInfo_.uris_.size(), 1);
+    }
+    sDataShareHelper_->UnregisterObserverExt(Uri(uriStr), obs);
+    MEDIA_INFO_LOG("notify_merge_001 exit");
+}
+
+/**
+ * @tc.name: notify_bench_001
+ * @tc.desc: notification volume and latency of a bulk update
+ *           1. every asset is updated twice "notify_bench_001"
+ *           2. each asset is sent once, in a few observer calls
+ * @tc.type: PERF
+ * @tc.require:
+ */
+HWTEST_F(NotifyTest, notify_bench_001, TestSize.Level0)
+{
+    MEDIA_INFO_LOG("notify_bench_001 enter");
+    auto watch = MediaLibraryNotify::GetInstance();
+    // the tick would flush in the middle of the burst, so the test stops it and pushes once at the end
+    MediaLibraryNotify::timer_.Unregister(MediaLibraryNotify::timerId_);
+    MediaLibraryNotify::PushNotification(true);
+    MediaLibraryNotify::ResetStats();
+    int64_t start = MediaFileUtils::UTCTimeMilliSeconds();
+    for (int i = 0; i < BENCH_ASSET_COUNT * 2; i++) {
+        watch->Notify(PhotoColumn::PHOTO_URI_PREFIX + to_string(i % BENCH_ASSET_COUNT + 1),
+            NotifyType::NOTIFY_UPDATE);
+    }
+    int64_t notifyCost = MediaFileUtils::UTCTimeMilliSeconds() - start;
+    EXPECT_EQ(MediaLibraryNotify::pendingCount_, BENCH_ASSET_COUNT);
+    MediaLibraryNotify::PushNotification(true);
+    int64_t totalCost = MediaFileUtils::UTCTimeMilliSeconds() - start;
+    MediaLibraryNotify::timerId_ = MediaLibraryNotify::timer_.Register([]() {
+        MediaLibraryNotify::PushNotification();
+    }, MNOTIFY_TIME_INTERVAL);
+
+    NotifyStats stats = MediaLibraryNotify::GetStats();
+    GTEST_LOG_(INFO) << "notify " << stats.received << " changes cost " << notifyCost << "ms, sent " <<
+        stats.sentUris << " uris in " << stats.sentChanges << " calls, all sent in " << totalCost <<
+        "ms, max latency " << stats.maxLatency << "ms";
+    EXPECT_EQ(stats.received, BENCH_ASSET_COUNT * 2);
+    EXPECT_EQ(stats.merged, BENCH_ASSET_COUNT);
+    EXPECT_EQ(stats.flushes, 1);
+    EXPECT_EQ(stats.sentUris, BENCH_ASSET_COUNT);
+    EXPECT_EQ(stats.sentChanges, (BENCH_ASSET_COUNT + MAX_NOTIFY_URIS_PER_CHANGE - 1) / MAX_NOTIFY_URIS_PER_CHANGE);
+    MEDIA_INFO_LOG("notify_bench_001 exit");
+}
+
+static void NotifyAssets(const shared_ptr<MediaLibraryNotify> &watch, int begin, int count)
+{
+    for (int i = begin; i < begin + count; i++) {
+        watch->Notify(PhotoColumn::PHOTO_URI_PREFIX + to_string(i), NotifyType::NOTIFY_UPDATE);
+    }
+}
+
+/**
+ * @tc.name: notify_window_001
+ * @tc.desc: adaptive flush window driven tick by tick
+ *           1. a quiet tick is flushed at once "notify_window_001"
+ *           2. a burst is held back while it grows and flushed at the first quiet tick
+ *           3. a burst is flushed anyway once it is older than the window or has too many changes
+ * @tc.type: FUNC
+ * @tc.require:
+ */
+HWTEST_F(NotifyTest, notify_window_001, TestSize.Level0)
+{
+    MEDIA_INFO_LOG("notify_window_001 enter");
+    auto watch = MediaLibraryNotify::GetInstance();
+    // the test plays the timer, one PushNotification() a tick
+    MediaLibraryNotify::timer_.Unregister(MediaLibraryNotify::timerId_);
+    MediaLibraryNotify::PushNotification(true);
+    MediaLibraryNotify::ResetStats();
+
+    NotifyAssets(watch, 1, MAX_NOTIFY_LIST_SIZE);
+    MediaLibraryNotify::PushNotification();
+    EXPECT_EQ(MediaLibraryNotify::GetStats().flushes, 1);
+    EXPECT_EQ(MediaLibraryNotify::pendingCount_, 0);
+
+    const int burst = MAX_NOTIFY_LIST_SIZE * 2;
+    int64_t start = MediaFileUtils::UTCTimeMilliSeconds();
+    NotifyAssets(watch, 1, burst);
+    MediaLibraryNotify::PushNotification();
+    this_thread::sleep_for(chrono::milliseconds(MNOTIFY_TIME_INTERVAL));
+    NotifyAssets(watch, burst + 1, burst);
+    MediaLibraryNotify::PushNotification();
+    EXPECT_EQ(MediaLibraryNotify::GetStats().flushes, 1);
+    EXPECT_EQ(MediaLibraryNotify::pendingCount_, burst * 2);
+    this_thread::sleep_for(chrono::milliseconds(MNOTIFY_TIME_INTERVAL));
+    MediaLibraryNotify::PushNotification();
+    int64_t latency = MediaFileUtils::UTCTimeMilliSeconds() - start;
+    NotifyStats stats = MediaLibraryNotify::GetStats();
+    EXPECT_EQ(stats.flushes, 2);
+    EXPECT_EQ(MediaLibraryNotify::pendingCount_, 0);
+    EXPECT_GE(stats.maxLatency, static_cast<int64_t>(MNOTIFY_TIME_INTERVAL * 2));
+    EXPECT_LE(stats.maxLatency, latency);
+    GTEST_LOG_(INFO) << "a burst of " << burst * 2 << " changes held back for " << stats.maxLatency << "ms";
+
+    NotifyAssets(watch, 1, burst);
+    MediaLibraryNotify::PushNotification();
+    EXPECT_EQ(MediaLibraryNotify::GetStats().flushes, 2);
+    // the burst keeps growing, but has been pending for the whole window
+    MediaLibraryNotify::windowStart_ -= MAX_NOTIFY_WINDOW;
+    NotifyAssets(watch, burst + 1, burst);
+    MediaLibraryNotify::PushNotification();
+    stats = MediaLibraryNotify::GetStats();
+    EXPECT_EQ(stats.flushes, 3);
+    EXPECT_GE(stats.maxLatency, MAX_NOTIFY_WINDOW);
+
+    // a single tick bringing the pending limit is not held back
+    NotifyAssets(watch, 1, MAX_NOTIFY_PENDING_SIZE);
+    EXPECT_EQ(MediaLibraryNotify::pendingCount_, MAX_NOTIFY_PENDING_SIZE);
+    MediaLibraryNotify::PushNotification();
+    EXPECT_EQ(MediaLibraryNotify::GetStats().flushes, 4);
+    EXPECT_EQ(MediaLibraryNotify::pendingCount_, 0);
+
+    MediaLibraryNotify::timerId_ = MediaLibraryNotify::timer_.Register([]() {
+        MediaLibraryNotify::PushNotification();
+    }, MNOTIFY_TIME_INTERVAL);
+    MEDIA_INFO_LOG("notify_window_001 exit");
+}
 } // namespace OHOS::Media
@@ -24,8 +24,10 @@
 #include "medialibrary_data_manager.h"
 #include "medialibrary_db_const.h"
 #include "medialibrary_errno.h"
+#include "medialibrary_rdb_utils.h"
 #include "medialibrary_rdbstore.h"
 #include "medialibrary_unittest_utils.h"
+#include "media_column.h"
 #include "photo_album_column.h"
 #include "photo_map_column.h"
 #include "rdb_predicates.h"
@@ -495,4 +497,89 @@ HWTEST_F(PhotoAlbumTest, photoalbum_update_album_005, TestSize.Level0)
     CheckUpdatedSystemAlbum(PhotoAlbumSubType::FAVORITE, "", "");
     MEDIA_INFO_LOG("photoalbum_update_album_005 end");
 }
+static int64_t InsertPhoto(const string &name, int64_t dateAdded)
+{
+    ValuesBucket values;
+    values.PutString(MediaColumn::MEDIA_FILE_PATH, "/storage/cloud/files/Photo/16/" + name);
+    values.PutString(MediaColumn::MEDIA_NAME, name);
+    values.PutInt(MediaColumn::MEDIA_TYPE, MEDIA_TYPE_IMAGE);
+    values.PutLong(MediaColumn::MEDIA_DATE_ADDED, dateAdded);
+    int64_t fileId = -1;
+    EXPECT_EQ(g_rdbStore->Insert(fileId, PhotoColumn::PHOTOS_TABLE, values), E_OK);
+    return fileId;
+}
+
+static void MapPhoto(int32_t albumId, int64_t fileId)
+{
+    ValuesBucket values;
+    values.PutInt(PhotoMap::ALBUM_ID, albumId);
+    values.PutInt(PhotoMap::ASSET_ID, static_cast<int32_t>(fileId));
+    int64_t rowId = -1;
+    EXPECT_EQ(g_rdbStore->Insert(rowId, PhotoMap::TABLE, values), E_OK);
+}
+
+static int32_t QueryAlbumCount(int32_t albumId)
+{
+    RdbPredicates predicates(PhotoAlbumColumns::TABLE);
+    predicates.EqualTo(PhotoAlbumColumns::ALBUM_ID, to_string(albumId));
+    auto resultSet = g_rdbStore->Query(predicates, { PhotoAlbumColumns::ALBUM_COUNT });
+    if ((resultSet == nullptr) || (resultSet->GoToFirstRow() != E_OK)) {
+        return -1;
+    }
+    return get<int32_t>(ResultSetUtils::GetValFromColumn(PhotoAlbumColumns::ALBUM_COUNT, resultSet, TYPE_INT32));
+}
+
+/**
+ * @tc.name: photoalbum_incremental_refresh_001
+ * @tc.desc: Refresh album count and cover from the changed assets only.
+ *           1. Trash the cover of a user album, the count drops and the next newest asset becomes the cover.
+ *           2. Recover it, the count and the cover are restored.
+ * @tc.type: FUNC
+ */
+HWTEST_F(PhotoAlbumTest, photoalbum_incremental_refresh_001, TestSize.Level0)
+{
+    MEDIA_INFO_LOG("photoalbum_incremental_refresh_001 enter");
+    int32_t albumId = CreatePhotoAlbum("photoalbum_incremental_refresh_001");
+    ASSERT_GT(albumId, 0);
+    int64_t oldFileId = InsertPhoto("incremental_refresh_old.jpg", 1000);
+    int64_t newFileId = InsertPhoto("incremental_refresh_new.jpg", 2000);
+    ASSERT_GT(oldFileId, 0);
+    ASSERT_GT(newFileId, 0);
+    MapPhoto(albumId, oldFileId);
+    MapPhoto(albumId, newFileId);
+    MediaLibraryRdbUtils::UpdateUserAlbumInternal(g_rdbStore, { to_string(albumId) });
+    EXPECT_EQ(QueryAlbumCount(albumId), 2);
+    string albumName;
+    string fullCover;
+    EXPECT_EQ(QueryAlbumById(albumId, albumName, fullCover), E_OK);
+
+    /* verify repairs a wrong delta behind the assertions, so it must not have had anything to repair */
+    MediaLibraryRdbUtils::SetAlbumRefreshVerify(true);
+    AlbumMembership membership;
+    MediaLibraryRdbUtils::CaptureAlbumMembership(g_rdbStore, { to_string(newFileId) }, membership);
+    EXPECT_EQ(membership.albums[albumId].count(static_cast<int32_t>(newFileId)), 1);
+    ValuesBucket values;
+    values.PutLong(MediaColumn::MEDIA_DATE_TRASHED, 1);
+    RdbPredicates predicates(PhotoColumn::PHOTOS_TABLE);
+    predicates.EqualTo(MediaColumn::MEDIA_ID, to_string(newFileId));
+    int32_t changedRows = 0;
+    EXPECT_EQ(g_rdbStore->Update(changedRows, values, predicates), E_OK);
+    MediaLibraryRdbUtils::UpdateAlbumsByMembership(g_rdbStore, membership);
+    EXPECT_EQ(MediaLibraryRdbUtils::GetAlbumRefreshMismatches(), 0);
+    EXPECT_EQ(QueryAlbumCount(albumId), 1);
+    string cover;
+    EXPECT_EQ(QueryAlbumById(albumId, albumName, cover), E_OK);
+    EXPECT_NE(cover, fullCover);
+    EXPECT_EQ(cover.find(PhotoColumn::PHOTO_URI_PREFIX + to_string(oldFileId) + "/"), static_cast<size_t>(0));
+
+    MediaLibraryRdbUtils::CaptureAlbumMembership(g_rdbStore, { to_string(newFileId) }, membership);
+    values.PutLong(MediaColumn::MEDIA_DATE_TRASHED, 0);
+    EXPECT_EQ(g_rdbStore->Update(changedRows, values, predicates), E_OK);
+    MediaLibraryRdbUtils::UpdateAlbumsByMembership(g_rdbStore, membership);
+    EXPECT_EQ(MediaLibraryRdbUtils::GetAlbumRefreshMismatches(), 0);
+    MediaLibraryRdbUtils::SetAlbumRefreshVerify(false);
+    EXPECT_EQ(QueryAlbumCount(albumId), 2);
+    CheckUpdatedAlbum(albumId, "photoalbum_incremental_refresh_001", fullCover);
+    MEDIA_INFO_LOG("photoalbum_incremental_refresh_001 end");
+}
 } // namespace OHOS::Media
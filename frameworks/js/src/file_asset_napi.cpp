@@ -205,6 +205,7 @@ napi_value FileAssetNapi::PhotoAccessHelperInit(napi_env env, napi_value exports
             DECLARE_NAPI_FUNCTION("setUserComment", PhotoAccessHelperSetUserComment),
             DECLARE_NAPI_FUNCTION("requestPhoto", PhotoAccessHelperRequestPhoto),
             DECLARE_NAPI_FUNCTION("cancelPhotoRequest", PhotoAccessHelperCancelPhotoRequest),
+            DECLARE_NAPI_FUNCTION("setPhotoRequestPriority", PhotoAccessHelperSetPhotoRequestPriority),
         }
     };
     MediaLibraryNapiUtils::NapiDefineClass(env, exports, info);
@@ -1682,7 +1683,7 @@ napi_value GetJSArgsForGetThumbnail(napi_env env, size_t argc, const napi_value
 }
 
 napi_value GetPhotoRequestArgs(napi_env env, size_t argc, const napi_value argv[],
-    unique_ptr<FileAssetAsyncContext> &asyncContext, RequestPhotoType &type)
+    unique_ptr<FileAssetAsyncContext> &asyncContext, RequestPhotoType &type, int32_t &priority)
 {
     if (argc != ARGS_TWO) {
         NapiError::ThrowError(env, JS_ERR_PARAMETER_INVALID, "Invalid parameter number " + to_string(argc));
@@ -1707,6 +1708,7 @@ napi_value GetPhotoRequestArgs(napi_env env, size_t argc, const napi_value argv[
             } else {
                 type = RequestPhotoType::REQUEST_ALL;
             }
+            GetInt32InfoFromNapiObject(env, argv[i], REQUEST_PHOTO_PRIORITY, priority);
         } else if (i == PARAM1 && valueType == napi_function) {
             napi_create_reference(env, argv[i], NAPI_INIT_REF_COUNT, &asyncContext->callbackRef);
             break;
@@ -3499,7 +3501,8 @@ napi_value FileAssetNapi::PhotoAccessHelperRequestPhoto(napi_env env, napi_callb
         napi_ok, result, "Failed to get object info");
     // use current parse args function temporary
     RequestPhotoType type = RequestPhotoType::REQUEST_ALL;
-    result = GetPhotoRequestArgs(env, asyncContext->argc, asyncContext->argv, asyncContext, type);
+    int32_t priority = 0;
+    result = GetPhotoRequestArgs(env, asyncContext->argc, asyncContext->argv, asyncContext, type, priority);
     ASSERT_NULLPTR_CHECK(env, result);
     auto obj = asyncContext->objectInfo;
     napi_value ret = nullptr;
@@ -3509,7 +3512,9 @@ napi_value FileAssetNapi::PhotoAccessHelperRequestPhoto(napi_env env, napi_callb
         .uri = obj->fileAssetPtr->GetUri(),
         .path = obj->fileAssetPtr->GetFilePath(),
         .size = asyncContext->size,
-        .type = type
+        .type = type,
+        .dateModified = obj->fileAssetPtr->GetDateModified(),
+        .priority = priority
     };
     static std::once_flag onceFlag;
     std::call_once(onceFlag, []() mutable {
@@ -3547,6 +3552,32 @@ napi_value FileAssetNapi::PhotoAccessHelperCancelPhotoRequest(napi_env env, napi
     return jsResult;
 }
 
+napi_value FileAssetNapi::PhotoAccessHelperSetPhotoRequestPriority(napi_env env, napi_callback_info info)
+{
+    MediaLibraryTracer tracer;
+    tracer.Start("PhotoAccessHelperSetPhotoRequestPriority");
+
+    napi_value ret = nullptr;
+    unique_ptr<FileAssetAsyncContext> asyncContext = make_unique<FileAssetAsyncContext>();
+    CHECK_NULL_PTR_RETURN_UNDEFINED(env, asyncContext, ret, "asyncContext context is null");
+
+    CHECK_ARGS(env, MediaLibraryNapiUtils::AsyncContextSetObjectInfo(env, info, asyncContext, ARGS_TWO, ARGS_TWO),
+        JS_ERR_PARAMETER_INVALID);
+    string requestKey;
+    int32_t priority = 0;
+    CHECK_ARGS(env, MediaLibraryNapiUtils::GetParamStringPathMax(env, asyncContext->argv[PARAM0], requestKey),
+        JS_ERR_PARAMETER_INVALID);
+    CHECK_ARGS(env, MediaLibraryNapiUtils::GetInt32(env, asyncContext->argv[PARAM1], priority),
+        JS_ERR_PARAMETER_INVALID);
+    napi_value jsResult = nullptr;
+    napi_get_undefined(env, &jsResult);
+
+    if (thumbnailManager_ != nullptr) {
+        thumbnailManager_->UpdatePhotoRequestPriority(requestKey, priority);
+    }
+    return jsResult;
+}
+
 static void PhotoAccessHelperSetHiddenExecute(napi_env env, void *data)
 {
     MediaLibraryTracer tracer;
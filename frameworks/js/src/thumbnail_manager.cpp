@@ -15,16 +15,21 @@
 
 #include "thumbnail_manager.h"
 
+#include <chrono>
+#include <cinttypes>
 #include <memory>
 #include <mutex>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <uuid/uuid.h>
 
+#include "application_context.h"
 #include "ashmem.h"
+#include "environment_callback.h"
 #include "image_source.h"
 #include "image_type.h"
 #include "js_native_api.h"
+#include "media_column.h"
 #include "media_file_uri.h"
 #include "medialibrary_errno.h"
 #include "medialibrary_napi_log.h"
@@ -52,10 +57,17 @@ namespace Media {
 shared_ptr<ThumbnailManager> ThumbnailManager::instance_ = nullptr;
 mutex ThumbnailManager::mutex_;
 bool ThumbnailManager::init_ = false;
+static atomic<uint64_t> g_requestSequence = 0;
+
+static int64_t GetSteadyTimeMs()
+{
+    return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
 
 ThumbnailRequest::ThumbnailRequest(const RequestPhotoParams &params, napi_env env,
     napi_ref callback) : callback_(env, callback), requestPhotoType(params.type), uri_(params.uri),
-    path_(params.path), requestSize_(params.size)
+    path_(params.path), requestSize_(params.size), dateModified_(params.dateModified), priority_(params.priority),
+    sequence_(g_requestSequence++), requestTime_(GetSteadyTimeMs())
 {
 }
 
@@ -100,6 +112,79 @@ static bool NeedQualityThumb(const Size &size, RequestPhotoType type)
     return IsPhotoSizeThumb(size) && (type != RequestPhotoType::REQUEST_FAST_THUMB);
 }
 
+static bool IsPrior(const RequestSharedPtr &left, const RequestSharedPtr &right)
+{
+    return left->GetPriority() > right->GetPriority() ||
+        (left->GetPriority() == right->GetPriority() && left->GetSequence() > right->GetSequence());
+}
+
+void ThumbnailRequestQueue::Push(const RequestSharedPtr &request)
+{
+    lock_guard<mutex> lock(mutex_);
+    queue_.push_back(request);
+}
+
+bool ThumbnailRequestQueue::Pop(RequestSharedPtr &request)
+{
+    lock_guard<mutex> lock(mutex_);
+    auto best = queue_.end();
+    for (auto iter = queue_.begin(); iter != queue_.end();) {
+        if (!(*iter)->NeedContinue()) {
+            iter = queue_.erase(iter);
+            dropped_++;
+            continue;
+        }
+        if (best == queue_.end() || IsPrior(*iter, *best)) {
+            best = iter;
+        }
+        ++iter;
+    }
+    if (best == queue_.end()) {
+        return false;
+    }
+    request = *best;
+    queue_.erase(best);
+    return true;
+}
+
+void ThumbnailRequestQueue::PopBatch(const function<bool(const RequestSharedPtr &)> &match, size_t maxCount,
+    vector<RequestSharedPtr> &requests)
+{
+    lock_guard<mutex> lock(mutex_);
+    vector<list<RequestSharedPtr>::iterator> matched;
+    for (auto iter = queue_.begin(); iter != queue_.end();) {
+        if (!(*iter)->NeedContinue()) {
+            iter = queue_.erase(iter);
+            dropped_++;
+            continue;
+        }
+        if (match(*iter)) {
+            matched.push_back(iter);
+        }
+        ++iter;
+    }
+    sort(matched.begin(), matched.end(), [](const auto &left, const auto &right) {
+        return IsPrior(*left, *right);
+    });
+    matched.resize(min(matched.size(), maxCount));
+    for (auto &iter : matched) {
+        requests.push_back(*iter);
+        queue_.erase(iter);
+    }
+}
+
+bool ThumbnailRequestQueue::Empty()
+{
+    lock_guard<mutex> lock(mutex_);
+    return queue_.empty();
+}
+
+uint64_t ThumbnailRequestQueue::GetDroppedCount()
+{
+    lock_guard<mutex> lock(mutex_);
+    return dropped_;
+}
+
 MMapFdPtr::MMapFdPtr(int32_t fd)
 {
     if (fd < 0) {
@@ -127,7 +212,9 @@ MMapFdPtr::MMapFdPtr(int32_t fd)
 MMapFdPtr::~MMapFdPtr()
 {
     // munmap ptr from fd
-    munmap(fdPtr_, size_);
+    if (isValid_) {
+        munmap(fdPtr_, size_);
+    }
 }
 
 void* MMapFdPtr::GetFdPtr()
@@ -145,6 +232,131 @@ bool MMapFdPtr::IsValid()
     return isValid_;
 }
 
+// entries bigger than this share of the budget would push out too many small ones
+constexpr size_t THUMBNAIL_CACHE_ENTRY_RATIO = 8;
+constexpr size_t THUMBNAIL_CACHE_TRIM_MODERATE_RATIO = 2;
+constexpr size_t THUMBNAIL_CACHE_TRIM_LOW_RATIO = 4;
+
+static PixelMapPtr CopyPixelMap(PixelMap &source)
+{
+    InitializationOptions opts = {
+        .size = { source.GetWidth(), source.GetHeight() },
+        .pixelFormat = source.GetPixelFormat(),
+        .alphaType = source.GetAlphaType()
+    };
+    return PixelMap::Create(source, opts);
+}
+
+static size_t GetPixelMapBytes(PixelMap &pixelMap)
+{
+    int32_t byteCount = pixelMap.GetByteCount();
+    return byteCount > 0 ? static_cast<size_t>(byteCount) : 0;
+}
+
+ThumbnailCache::ThumbnailCache(size_t maxBytes) : maxBytes_(maxBytes)
+{
+}
+
+string ThumbnailCache::GetKey(const string &uri, const Size &size, int64_t dateModified)
+{
+    return uri + "|" + to_string(size.width) + "x" + to_string(size.height) + "|" + to_string(dateModified);
+}
+
+PixelMapPtr ThumbnailCache::Get(const string &key)
+{
+    shared_ptr<PixelMap> cached;
+    {
+        lock_guard<mutex> lock(mutex_);
+        auto iter = lruMap_.find(key);
+        if (iter == lruMap_.end()) {
+            stats_.misses++;
+            return nullptr;
+        }
+        lruList_.splice(lruList_.begin(), lruList_, iter->second);
+        cached = iter->second->second;
+        stats_.hits++;
+    }
+    // cached maps are never written, so the copy can run without the lock
+    return CopyPixelMap(*cached);
+}
+
+void ThumbnailCache::Put(const string &key, PixelMap &pixelMap)
+{
+    size_t bytes = GetPixelMapBytes(pixelMap);
+    if (bytes == 0 || bytes > maxBytes_ / THUMBNAIL_CACHE_ENTRY_RATIO) {
+        return;
+    }
+    shared_ptr<PixelMap> copy = CopyPixelMap(pixelMap);
+    if (copy == nullptr) {
+        return;
+    }
+
+    lock_guard<mutex> lock(mutex_);
+    auto iter = lruMap_.find(key);
+    if (iter != lruMap_.end()) {
+        stats_.bytes -= GetPixelMapBytes(*iter->second->second);
+        lruList_.erase(iter->second);
+        lruMap_.erase(iter);
+    }
+    lruList_.emplace_front(key, copy);
+    lruMap_[key] = lruList_.begin();
+    stats_.bytes += bytes;
+    EvictLocked(maxBytes_);
+}
+
+void ThumbnailCache::EvictLocked(size_t maxBytes)
+{
+    while (stats_.bytes > maxBytes && !lruList_.empty()) {
+        auto &entry = lruList_.back();
+        stats_.bytes -= GetPixelMapBytes(*entry.second);
+        lruMap_.erase(entry.first);
+        lruList_.pop_back();
+        stats_.evictions++;
+    }
+}
+
+void ThumbnailCache::Trim(ThumbnailCacheTrimLevel level)
+{
+    lock_guard<mutex> lock(mutex_);
+    switch (level) {
+        case ThumbnailCacheTrimLevel::TRIM_MODERATE:
+            EvictLocked(maxBytes_ / THUMBNAIL_CACHE_TRIM_MODERATE_RATIO);
+            break;
+        case ThumbnailCacheTrimLevel::TRIM_LOW:
+            EvictLocked(maxBytes_ / THUMBNAIL_CACHE_TRIM_LOW_RATIO);
+            break;
+        default:
+            EvictLocked(0);
+            break;
+    }
+    NAPI_INFO_LOG("Trim thumbnail cache level %{public}d, left %{public}zu bytes in %{public}zu entries",
+        static_cast<int32_t>(level), stats_.bytes, lruList_.size());
+}
+
+ThumbnailCacheStats ThumbnailCache::GetStats()
+{
+    lock_guard<mutex> lock(mutex_);
+    ThumbnailCacheStats stats = stats_;
+    stats.count = lruList_.size();
+    return stats;
+}
+
+class ThumbnailMemoryCallback : public AbilityRuntime::EnvironmentCallback {
+public:
+    explicit ThumbnailMemoryCallback(ThumbnailManager *manager) : manager_(manager) {}
+    ~ThumbnailMemoryCallback() override = default;
+
+    void OnConfigurationUpdated(const AppExecFwk::Configuration &config) override {}
+
+    void OnMemoryLevel(const int level) override
+    {
+        manager_->OnMemoryLevel(level);
+    }
+
+private:
+    ThumbnailManager *manager_;
+};
+
 static string GenerateRequestId()
 {
     uuid_t uuid;
@@ -182,6 +394,13 @@ void ThumbnailManager::Init()
         threads_.emplace_back(bind(&ThumbnailManager::QualityImageWorker, this, i));
         threads_[i].detach();
     }
+    auto context = AbilityRuntime::ApplicationContext::GetInstance();
+    if (context != nullptr) {
+        memoryCallback_ = make_shared<ThumbnailMemoryCallback>(this);
+        context->RegisterEnvironmentCallback(memoryCallback_);
+    } else {
+        NAPI_ERR_LOG("Application context is null, thumbnail cache is not trimmed on memory pressure");
+    }
     return;
 }
 
@@ -193,6 +412,13 @@ string ThumbnailManager::AddPhotoRequest(const RequestPhotoParams &params, napi_
     if (!thumbRequest_.Insert(requestId, request)) {
         return "";
     }
+    {
+        lock_guard<mutex> lock(statsLock_);
+        stats_.requests++;
+    }
+    if (DealWithCachedRequest(request)) {
+        return requestId;
+    }
     // judge from request option
     if (NeedFastThumb(params.size, params.type)) {
         AddFastPhotoRequest(request);
@@ -213,10 +439,101 @@ void ThumbnailManager::RemovePhotoRequest(const string &requestId)
         ptr->UpdateStatus(ThumbnailStatus::THUMB_REMOVE);
     }
     thumbRequest_.Erase(requestId);
+    bool needLog = false;
+    {
+        lock_guard<mutex> lock(statsLock_);
+        stats_.removed++;
+        needLog = (stats_.removed % THUMBNAIL_STATS_LOG_INTERVAL == 0);
+    }
+    if (needLog) {
+        LogRequestStats();
+    }
+}
+
+void ThumbnailManager::UpdatePhotoRequestPriority(const string &requestId, int32_t priority)
+{
+    RequestSharedPtr ptr;
+    if (thumbRequest_.Find(requestId, ptr) && ptr != nullptr) {
+        // queued requests are ordered when popped, so the new priority takes effect right away
+        ptr->SetPriority(priority);
+    }
+}
+
+void ThumbnailManager::RecordImageNotified(const RequestSharedPtr &request)
+{
+    if (!request->MarkImageNotified()) {
+        return;
+    }
+    int64_t time = GetSteadyTimeMs() - request->GetRequestTime();
+    lock_guard<mutex> lock(statsLock_);
+    stats_.firstImages++;
+    stats_.totalFirstImageTime += time;
+    stats_.maxFirstImageTime = max(stats_.maxFirstImageTime, time);
+}
+
+ThumbnailRequestStats ThumbnailManager::GetRequestStats()
+{
+    ThumbnailRequestStats stats;
+    {
+        lock_guard<mutex> lock(statsLock_);
+        stats = stats_;
+    }
+    stats.dropped = fastQueue_.GetDroppedCount() + qualityQueue_.GetDroppedCount();
+    return stats;
+}
+
+void ThumbnailManager::LogRequestStats()
+{
+    ThumbnailRequestStats stats = GetRequestStats();
+    int64_t averageTime = stats.firstImages == 0 ? 0 :
+        stats.totalFirstImageTime / static_cast<int64_t>(stats.firstImages);
+    NAPI_INFO_LOG("Thumbnail requests %{public}" PRIu64 ", removed %{public}" PRIu64 ", dropped %{public}" PRIu64
+        ", first images %{public}" PRIu64 ", average %{public}" PRId64 " ms, max %{public}" PRId64 " ms",
+        stats.requests, stats.removed, stats.dropped, stats.firstImages, averageTime, stats.maxFirstImageTime);
+}
+
+bool ThumbnailManager::DealWithCachedRequest(const RequestSharedPtr &request)
+{
+    Size size = request->GetRequestSize();
+    // a fast only request is answered with the fast size, which RequestFastImage looks up itself
+    if (NeedFastThumb(size, request->requestPhotoType) && !NeedQualityThumb(size, request->requestPhotoType)) {
+        return false;
+    }
+    PixelMapPtr pixelMap = cache_.Get(ThumbnailCache::GetKey(request->GetUri(), size, request->GetDateModified()));
+    if (pixelMap == nullptr) {
+        return false;
+    }
+    request->SetPixelMap(move(pixelMap));
+    request->UpdateStatus(ThumbnailStatus::THUMB_QUALITY);
+    NotifyImage(request, false);
+    return true;
+}
+
+void ThumbnailManager::TrimCache(ThumbnailCacheTrimLevel level)
+{
+    cache_.Trim(level);
+}
+
+ThumbnailCacheStats ThumbnailManager::GetCacheStats()
+{
+    return cache_.GetStats();
+}
+
+void ThumbnailManager::OnMemoryLevel(int32_t level)
+{
+    ThumbnailCacheStats stats = GetCacheStats();
+    NAPI_INFO_LOG("Memory level %{public}d, thumbnail cache hits %{public}" PRIu64 ", misses %{public}" PRIu64
+        ", evictions %{public}" PRIu64 ", %{public}zu bytes in %{public}zu entries", level, stats.hits, stats.misses,
+        stats.evictions, stats.bytes, stats.count);
+    TrimCache(static_cast<ThumbnailCacheTrimLevel>(level));
 }
 
 ThumbnailManager::~ThumbnailManager()
 {
+    auto context = AbilityRuntime::ApplicationContext::GetInstance();
+    if (context != nullptr && memoryCallback_ != nullptr) {
+        context->UnregisterEnvironmentCallback(memoryCallback_);
+    }
     isThreadRunning_ = false;
     fastCv_.notify_all();
     qualityCv_.notify_all();
@@ -357,20 +674,10 @@ static PixelMapPtr CreateThumbnailByAshmem(UniqueFd &uniqueFd, const Size &size)
     return pixel;
 }
 
-static PixelMapPtr DecodeThumbnail(UniqueFd &uniqueFd, const Size &size)
+static PixelMapPtr DecodeImageSource(unique_ptr<ImageSource> &imageSource, const Size &size, int32_t fd)
 {
-    MediaLibraryTracer tracer;
-    tracer.Start("ImageSource::CreateImageSource");
-    SourceOptions opts;
-    uint32_t err = 0;
-    unique_ptr<ImageSource> imageSource = ImageSource::CreateImageSource(uniqueFd.Get(), opts, err);
-    if (imageSource  == nullptr) {
-        NAPI_ERR_LOG("CreateImageSource err %{public}d", err);
-        return nullptr;
-    }
-
     ImageInfo imageInfo;
-    err = imageSource->GetImageInfo(0, imageInfo);
+    uint32_t err = imageSource->GetImageInfo(0, imageInfo);
     if (err != E_OK) {
         NAPI_ERR_LOG("GetImageInfo err %{public}d", err);
         return nullptr;
@@ -386,7 +693,10 @@ static PixelMapPtr DecodeThumbnail(UniqueFd &uniqueFd, const Size &size)
         return nullptr;
     }
 #ifdef IMAGE_PURGEABLE_PIXELMAP
-    PurgeableBuilder::MakePixelMapToBePurgeable(pixelMap, uniqueFd.Get(), opts, decodeOpts);
+    if (fd >= 0) {
+        SourceOptions opts;
+        PurgeableBuilder::MakePixelMapToBePurgeable(pixelMap, fd, opts, decodeOpts);
+    }
 #endif
     PostProc postProc;
     if (size.width != DEFAULT_ORIGINAL && !isEqualsRatio && !postProc.CenterScale(size, *pixelMap)) {
@@ -395,16 +705,66 @@ static PixelMapPtr DecodeThumbnail(UniqueFd &uniqueFd, const Size &size)
     return pixelMap;
 }
 
-unique_ptr<PixelMap> ThumbnailManager::QueryThumbnail(const string &uriStr, const Size &size, const string &path)
+static PixelMapPtr DecodeThumbnail(UniqueFd &uniqueFd, const Size &size)
 {
     MediaLibraryTracer tracer;
-    tracer.Start("QueryThumbnail uri:" + uriStr);
-    tracer.Start("DataShare::OpenFile");
+    tracer.Start("ImageSource::CreateImageSource");
+    SourceOptions opts;
+    uint32_t err = 0;
+    unique_ptr<ImageSource> imageSource = ImageSource::CreateImageSource(uniqueFd.Get(), opts, err);
+    if (imageSource  == nullptr) {
+        NAPI_ERR_LOG("CreateImageSource err %{public}d", err);
+        return nullptr;
+    }
+    return DecodeImageSource(imageSource, size, uniqueFd.Get());
+}
+
+static PixelMapPtr DecodeThumbnailData(const uint8_t *data, uint32_t length, ThumbnailType thumbType,
+    const Size &size)
+{
+    if (thumbType == ThumbnailType::MTH || thumbType == ThumbnailType::YEAR) {
+        // raw pixels, the same as CreateThumbnailByAshmem maps
+        InitializationOptions option = {
+            .size = size,
+            .pixelFormat = PixelFormat::RGBA_8888
+        };
+        return PixelMap::Create(reinterpret_cast<const uint32_t *>(data), length / sizeof(uint32_t), option);
+    }
+    SourceOptions opts;
+    uint32_t err = 0;
+    unique_ptr<ImageSource> imageSource = ImageSource::CreateImageSource(data, length, opts, err);
+    if (imageSource == nullptr) {
+        NAPI_ERR_LOG("CreateImageSource err %{public}d", err);
+        return nullptr;
+    }
+    return DecodeImageSource(imageSource, size, -1);
+}
+
+static ThumbnailType GetQueryThumbType(const string &uriStr, const Size &size)
+{
     ThumbnailType thumbType = GetThumbType(size.width, size.height);
     if (MediaFileUri::GetMediaTypeFromUri(uriStr) == MediaType::MEDIA_TYPE_AUDIO &&
         (thumbType == ThumbnailType::MTH || thumbType == ThumbnailType::YEAR)) {
         thumbType = ThumbnailType::THUMB;
     }
+    return thumbType;
+}
+
+static PixelMapPtr CreateThumbnailFromFd(UniqueFd &uniqueFd, ThumbnailType thumbType, const Size &size)
+{
+    if (thumbType == ThumbnailType::MTH || thumbType == ThumbnailType::YEAR) {
+        return CreateThumbnailByAshmem(uniqueFd, size);
+    } else {
+        return DecodeThumbnail(uniqueFd, size);
+    }
+}
+
+unique_ptr<PixelMap> ThumbnailManager::QueryThumbnail(const string &uriStr, const Size &size, const string &path)
+{
+    MediaLibraryTracer tracer;
+    tracer.Start("QueryThumbnail uri:" + uriStr);
+    tracer.Start("DataShare::OpenFile");
+    ThumbnailType thumbType = GetQueryThumbType(uriStr, size);
     UniqueFd uniqueFd(OpenThumbnail(path, thumbType));
     if (uniqueFd.Get() == E_ERR) {
         string openUriStr = uriStr + "?" + MEDIA_OPERN_KEYWORD + "=" + MEDIA_DATA_DB_THUMBNAIL + "&" +
@@ -421,13 +781,60 @@ unique_ptr<PixelMap> ThumbnailManager::QueryThumbnail(const string &uriStr, cons
         return nullptr;
     }
     tracer.Finish();
-    if (thumbType == ThumbnailType::MTH || thumbType == ThumbnailType::YEAR) {
-        return CreateThumbnailByAshmem(uniqueFd, size);
-    } else {
-        return DecodeThumbnail(uniqueFd, size);
+    return CreateThumbnailFromFd(uniqueFd, thumbType, size);
+}
+
+void ThumbnailManager::DecodeThumbnailBatch(int32_t fd, const vector<string> &ids, const Size &size,
+    vector<PixelMapPtr> &pixelMaps)
+{
+    MMapFdPtr mmapFd(fd);
+    if (!mmapFd.IsValid()) {
+        return;
+    }
+
+    auto base = static_cast<const uint8_t *>(mmapFd.GetFdPtr());
+    auto total = static_cast<size_t>(mmapFd.GetFdSize());
+    auto header = reinterpret_cast<const ThumbnailBatchHeader *>(base);
+    if (total < sizeof(ThumbnailBatchHeader) + ids.size() * sizeof(ThumbnailBatchEntry) ||
+        header->magic != THUMBNAIL_BATCH_MAGIC || header->count != ids.size()) {
+        NAPI_ERR_LOG("invalid batch thumbnail data, size %{public}zu", total);
+        return;
+    }
+    auto entries = reinterpret_cast<const ThumbnailBatchEntry *>(base + sizeof(ThumbnailBatchHeader));
+    ThumbnailType thumbType = GetThumbType(size.width, size.height);
+    for (size_t i = 0; i < ids.size(); i++) {
+        const ThumbnailBatchEntry &entry = entries[i];
+        if (entry.status != THUMBNAIL_BATCH_OK || to_string(entry.fileId) != ids[i] || entry.length == 0 ||
+            entry.offset > total || entry.length > total - entry.offset) {
+            continue;
+        }
+        pixelMaps[i] = DecodeThumbnailData(base + entry.offset, entry.length, thumbType, size);
     }
 }
 
+void ThumbnailManager::QueryThumbnailBatch(const vector<RequestSharedPtr> &requests, const Size &size,
+    vector<PixelMapPtr> &pixelMaps)
+{
+    MediaLibraryTracer tracer;
+    tracer.Start("QueryThumbnailBatch count:" + to_string(requests.size()));
+    vector<string> ids;
+    string idList;
+    for (const auto &request : requests) {
+        ids.push_back(MediaFileUri(request->GetUri()).GetFileId());
+        idList += (idList.empty() ? "" : ",") + ids.back();
+    }
+    string openUriStr = PhotoColumn::PHOTO_URI_PREFIX + MEDIA_DATA_DB_THUMBNAIL + "?" + MEDIA_OPERN_KEYWORD + "=" +
+        THUMBNAIL_BATCH_OPERN + "&" + THUMBNAIL_BATCH_IDS + "=" + idList + "&" + MEDIA_DATA_DB_WIDTH + "=" +
+        to_string(size.width) + "&" + MEDIA_DATA_DB_HEIGHT + "=" + to_string(size.height);
+    Uri openUri(openUriStr);
+    UniqueFd uniqueFd(UserFileClient::OpenFile(openUri, "R"));
+    if (uniqueFd.Get() < 0) {
+        NAPI_ERR_LOG("batch thumbnail open failed, errCode is %{public}d", uniqueFd.Get());
+        return;
+    }
+    DecodeThumbnailBatch(uniqueFd.Get(), ids, size, pixelMaps);
+}
+
 void ThumbnailManager::DeleteRequestIdFromMap(const string &requestId)
 {
     thumbRequest_.Erase(requestId);
@@ -439,12 +846,21 @@ bool ThumbnailManager::RequestFastImage(const RequestSharedPtr &request)
     tracer.Start("ThumbnailManager::RequestFastImage");
     Size fastSize;
     GetFastThumbNewSize(request->GetRequestSize(), fastSize);
+    string key = ThumbnailCache::GetKey(request->GetUri(), fastSize, request->GetDateModified());
+    PixelMapPtr pixelMap = cache_.Get(key);
+    if (pixelMap != nullptr) {
+        request->SetFastPixelMap(move(pixelMap));
+        return true;
+    }
     UniqueFd uniqueFd(OpenThumbnail(request->GetPath(), GetThumbType(fastSize.width, fastSize.height)));
     if (uniqueFd.Get() < 0) {
         return false;
     }
-    
-    PixelMapPtr pixelMap = CreateThumbnailByAshmem(uniqueFd, fastSize);
+
+    pixelMap = CreateThumbnailByAshmem(uniqueFd, fastSize);
+    if (pixelMap != nullptr) {
+        cache_.Put(key, *pixelMap);
+    }
     request->SetFastPixelMap(move(pixelMap));
     return true;
 }
@@ -495,6 +911,63 @@ void ThumbnailManager::FastImageWorker(int num)
     }
 }
 
+void ThumbnailManager::NotifyQualityImage(const RequestSharedPtr &request, PixelMapPtr pixelMap)
+{
+    if (pixelMap != nullptr) {
+        cache_.Put(ThumbnailCache::GetKey(request->GetUri(), request->GetRequestSize(), request->GetDateModified()),
+            *pixelMap);
+    }
+    request->SetPixelMap(move(pixelMap));
+    // callback
+    NotifyImage(request, false);
+}
+
+bool ThumbnailManager::DealWithBatchRequest(const RequestSharedPtr &request)
+{
+    Size size = request->GetRequestSize();
+    auto isBatchable = [size](const RequestSharedPtr &item) {
+        Size itemSize = item->GetRequestSize();
+        return !item->IsBatchSkipped() && itemSize.width == size.width && itemSize.height == size.height &&
+            MediaFileUri::GetMediaTypeFromUri(item->GetUri()) == MediaType::MEDIA_TYPE_PHOTO;
+    };
+    if (!IsThumbnail(size.width, size.height) || !isBatchable(request)) {
+        return false;
+    }
+    vector<RequestSharedPtr> requests = { request };
+    qualityQueue_.PopBatch(isBatchable, THUMBNAIL_BATCH_REQUEST_COUNT - 1, requests);
+    if (requests.size() == 1) {
+        return false;
+    }
+
+    vector<PixelMapPtr> pixelMaps(requests.size());
+    QueryThumbnailBatch(requests, size, pixelMaps);
+    for (size_t i = 0; i < requests.size(); i++) {
+        if (pixelMaps[i] != nullptr) {
+            NotifyQualityImage(requests[i], move(pixelMaps[i]));
+        } else {
+            // still to be generated, queued again for a single open so they do not hold up this worker
+            requests[i]->SkipBatch();
+            AddQualityPhotoRequest(requests[i]);
+        }
+    }
+    return true;
+}
+
+void ThumbnailManager::DealWithQualityRequest(const RequestSharedPtr &request)
+{
+    // request quality image, from the sandbox when readable and else through the data share
+    ThumbnailType thumbType = GetQueryThumbType(request->GetUri(), request->GetRequestSize());
+    UniqueFd uniqueFd(OpenThumbnail(request->GetPath(), thumbType));
+    if (uniqueFd.Get() >= 0) {
+        NotifyQualityImage(request, CreateThumbnailFromFd(uniqueFd, thumbType, request->GetRequestSize()));
+        return;
+    }
+    if (DealWithBatchRequest(request)) {
+        return;
+    }
+    NotifyQualityImage(request, QueryThumbnail(request->GetUri(), request->GetRequestSize(), request->GetPath()));
+}
+
 void ThumbnailManager::QualityImageWorker(int num)
 {
     SetThreadName("QualityImageWorker", num);
@@ -510,30 +983,26 @@ void ThumbnailManager::QualityImageWorker(int num)
         } else {
             RequestSharedPtr request;
             if (qualityQueue_.Pop(request) && request->NeedContinue()) {
-                // request quality image
-                request->SetPixelMap(QueryThumbnail(request->GetUri(),
-                    request->GetRequestSize(), request->GetPath()));
-                // callback
-                NotifyImage(request, false);
+                DealWithQualityRequest(request);
             }
         }
     }
 }
 
-static void HandlePixelCallback(const RequestSharedPtr &request, bool isFastImage)
+static bool HandlePixelCallback(const RequestSharedPtr &request, bool isFastImage)
 {
     napi_env env = request->callback_.env_;
     napi_value jsCallback = nullptr;
     napi_status status = napi_get_reference_value(env, request->callback_.callBackRef_, &jsCallback);
     if (status != napi_ok) {
         NAPI_ERR_LOG("Create reference fail, status: %{public}d", status);
-        return;
+        return false;
     }
 
     napi_value retVal = nullptr;
     napi_value result[ARGS_ONE];
     if (request->GetStatus() == ThumbnailStatus::THUMB_REMOVE) {
-        return;
+        return false;
     }
         
     if (isFastImage) {
@@ -547,8 +1016,9 @@ static void HandlePixelCallback(const RequestSharedPtr &request, bool isFastImag
     napi_call_function(env, nullptr, jsCallback, ARGS_ONE, result, &retVal);
     if (status != napi_ok) {
         NAPI_ERR_LOG("CallJs napi_call_function fail, status: %{public}d", status);
-        return;
+        return false;
     }
+    return true;
 }
 
 static void UvJsExecute(uv_work_t *work)
@@ -571,7 +1041,9 @@ static void UvJsExecute(uv_work_t *work)
         if (!scopeHandler.IsValid()) {
             break;
         }
-        HandlePixelCallback(uvMsg->request_, uvMsg->isFastImage_);
+        if (HandlePixelCallback(uvMsg->request_, uvMsg->isFastImage_) && uvMsg->manager_ != nullptr) {
+            uvMsg->manager_->RecordImageNotified(uvMsg->request_);
+        }
     } while (0);
     if ((uvMsg->request_->GetStatus() == ThumbnailStatus::THUMB_QUALITY && !uvMsg->isFastImage_) ||
         (uvMsg->request_->GetStatus() == ThumbnailStatus::THUMB_REMOVE)) {
@@ -16,12 +16,16 @@
 #ifndef FRAMEWORKS_SERVICE_MEDIA_ASYNC_WORKER_INCLUDE_MEDIALIBRARY_ASYNC_WORKER_H_
 #define FRAMEWORKS_SERVICE_MEDIA_ASYNC_WORKER_INCLUDE_MEDIALIBRARY_ASYNC_WORKER_H_
 
+#include <array>
 #include <atomic>
 #include <condition_variable>
-#include <list>
+#include <deque>
+#include <functional>
+#include <memory>
 #include <mutex>
-#include <queue>
+#include <string>
 #include <thread>
+#include <vector>
 
 #define ASYNC_WORKER_API_EXPORT __attribute__ ((visibility ("default")))
 namespace OHOS {
@@ -35,9 +39,19 @@ public:
 
 using MediaLibraryExecute = void (*)(AsyncTaskData *data);
 
+/* tasks of a higher class always run first, BACKGROUND and IDLE are throttled while foreground work is pending */
+enum class AsyncTaskPriority : int32_t {
+    HIGH = 0,
+    FOREGROUND,
+    BACKGROUND,
+    IDLE,
+    COUNT,
+};
+
 class MediaLibraryAsyncTask {
 public:
     MediaLibraryAsyncTask(MediaLibraryExecute executor, AsyncTaskData *data) : executor_(executor), data_(data) {}
+    explicit MediaLibraryAsyncTask(std::function<void()> func) : func_(std::move(func)) {}
     MediaLibraryAsyncTask() : MediaLibraryAsyncTask(nullptr, nullptr) {}
     virtual ~MediaLibraryAsyncTask()
     {
@@ -45,46 +59,85 @@ public:
         data_ = nullptr;
     }
 
-    MediaLibraryExecute executor_;
-    AsyncTaskData *data_;
+    void Execute()
+    {
+        if (func_) {
+            func_();
+        } else if (executor_ != nullptr) {
+            executor_(data_);
+        }
+    }
+
+    /* a cancelled task is dropped when a worker takes it, a running task is not interrupted */
+    void Cancel()
+    {
+        isCancelled_ = true;
+    }
+
+    bool IsCancelled() const
+    {
+        return isCancelled_.load();
+    }
+
+    MediaLibraryExecute executor_ = nullptr;
+    AsyncTaskData *data_ = nullptr;
+
+private:
+    std::function<void()> func_;
+    std::atomic<bool> isCancelled_{false};
 };
 
 class MediaLibraryAsyncWorker {
 public:
     virtual ~MediaLibraryAsyncWorker();
     ASYNC_WORKER_API_EXPORT static std::shared_ptr<MediaLibraryAsyncWorker> GetInstance();
+    /* drops the queued BACKGROUND and IDLE tasks */
     ASYNC_WORKER_API_EXPORT void Interrupt();
+    /* drops every queued task */
     ASYNC_WORKER_API_EXPORT void Stop();
     ASYNC_WORKER_API_EXPORT int32_t AddTask(const std::shared_ptr<MediaLibraryAsyncTask> &task, bool isFg);
+    ASYNC_WORKER_API_EXPORT int32_t AddTask(const std::shared_ptr<MediaLibraryAsyncTask> &task,
+        AsyncTaskPriority priority);
+    ASYNC_WORKER_API_EXPORT void SetThreadNum(int32_t num);
+    ASYNC_WORKER_API_EXPORT int32_t GetThreadNum();
 
 private:
+    using TaskQueues = std::array<std::deque<std::shared_ptr<MediaLibraryAsyncTask>>,
+        static_cast<size_t>(AsyncTaskPriority::COUNT)>;
+    /* every worker owns one, idle workers steal the oldest tasks of the others and drain those of retired ones */
+    struct WorkerQueue {
+        std::mutex lock;
+        TaskQueues tasks;
+    };
+
     MediaLibraryAsyncWorker();
-    void StartWorker(int num);
+    void StartWorker(int32_t index);
     void Init();
-    std::shared_ptr<MediaLibraryAsyncTask> GetFgTask();
-    std::shared_ptr<MediaLibraryAsyncTask> GetBgTask();
-    void ReleaseFgTask();
-    void ReleaseBgTask();
-    void WaitForTask();
-    bool IsFgQueueEmpty();
-    bool IsBgQueueEmpty();
-    void SleepFgWork();
-    void SleepBgWork();
+    bool IsRetired(int32_t index);
+    bool HasRunnableTask();
+    int32_t GetBgLimit();
+    bool IsBgThrottled();
+    bool TryAcquireBgSlot();
+    std::shared_ptr<MediaLibraryAsyncTask> GetTask(int32_t index, AsyncTaskPriority &priority);
+    std::shared_ptr<MediaLibraryAsyncTask> PopTask(int32_t queueIndex, size_t priority);
+    void ReleaseTask(AsyncTaskPriority priority);
+    void RunTask(const std::shared_ptr<MediaLibraryAsyncTask> &task, AsyncTaskPriority priority);
 
     static std::mutex instanceLock_;
     static std::shared_ptr<MediaLibraryAsyncWorker> asyncWorkerInstance_;
     std::atomic<bool> isThreadRunning_;
-    std::mutex bgTaskLock_;
-    std::queue<std::shared_ptr<MediaLibraryAsyncTask>> bgTaskQueue_;
-
-    std::mutex fgTaskLock_;
-    std::queue<std::shared_ptr<MediaLibraryAsyncTask>> fgTaskQueue_;
+    std::atomic<int32_t> threadNum_;
+    std::atomic<uint32_t> nextQueue_;
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::array<std::atomic<int32_t>, static_cast<size_t>(AsyncTaskPriority::COUNT)> pendingCount_;
+    std::atomic<int32_t> runningFgCount_;
+    std::atomic<int32_t> runningBgCount_;
 
-    std::mutex bgWorkLock_;
-    std::condition_variable bgWorkCv_;
-    std::atomic<uint32_t> doneTotal_;
+    std::mutex workLock_;
+    std::condition_variable workCv_;
 
-    std::list<std::thread> threads_;
+    std::mutex threadLock_;
+    std::vector<std::thread> threads_;
 };
 } // namespace Media
 } // namespace OHOS
@@ -15,6 +15,7 @@
 
 #include "medialibrary_async_worker.h"
 
+#include <algorithm>
 #include <pthread.h>
 #include "media_log.h"
 
@@ -23,14 +24,18 @@ using namespace std;
 namespace OHOS {
 namespace Media {
 static const int32_t SUCCESS = 0;
-static const int32_t BG_SLEEP_COUNT = 500;
-static const int32_t FG_SLEEP_COUNT = 50;
-static const int32_t REST_FOR_MILLISECOND = 20;
-static const int32_t REST_FOR_LONG_SECOND = 2;
-static const int32_t THREAD_NUM = 2;
+static const int32_t MIN_THREAD_NUM = 2;
+static const int32_t DEFAULT_MAX_THREAD_NUM = 4;
+static const int32_t MAX_THREAD_NUM = 8;
+static const size_t PRIORITY_COUNT = static_cast<size_t>(AsyncTaskPriority::COUNT);
 shared_ptr<MediaLibraryAsyncWorker> MediaLibraryAsyncWorker::asyncWorkerInstance_{nullptr};
 mutex MediaLibraryAsyncWorker::instanceLock_;
 
+static inline bool IsBgPriority(size_t priority)
+{
+    return priority >= static_cast<size_t>(AsyncTaskPriority::BACKGROUND);
+}
+
 shared_ptr<MediaLibraryAsyncWorker> MediaLibraryAsyncWorker::GetInstance()
 {
     if (asyncWorkerInstance_ == nullptr) {
@@ -43,13 +48,25 @@ shared_ptr<MediaLibraryAsyncWorker> MediaLibraryAsyncWorker::GetInstance()
     return asyncWorkerInstance_;
 }
 
-MediaLibraryAsyncWorker::MediaLibraryAsyncWorker() : isThreadRunning_(false), doneTotal_(0)
-{}
+MediaLibraryAsyncWorker::MediaLibraryAsyncWorker() : isThreadRunning_(false), threadNum_(0), nextQueue_(0),
+    runningFgCount_(0), runningBgCount_(0)
+{
+    for (auto &count : pendingCount_) {
+        count = 0;
+    }
+    for (int32_t i = 0; i < MAX_THREAD_NUM; i++) {
+        queues_.emplace_back(make_unique<WorkerQueue>());
+    }
+    threads_.resize(MAX_THREAD_NUM);
+}
 
 MediaLibraryAsyncWorker::~MediaLibraryAsyncWorker()
 {
-    isThreadRunning_ = false;
-    bgWorkCv_.notify_all();
+    {
+        lock_guard<mutex> lock(workLock_);
+        isThreadRunning_ = false;
+    }
+    workCv_.notify_all();
     for (auto &thread : threads_) {
         if (thread.joinable()) {
             thread.join();
@@ -61,132 +78,217 @@ MediaLibraryAsyncWorker::~MediaLibraryAsyncWorker()
 void MediaLibraryAsyncWorker::Init()
 {
     isThreadRunning_ = true;
-    doneTotal_ = 0;
-    for (auto i = 0; i < THREAD_NUM; i++) {
-        threads_.emplace_back(bind(&MediaLibraryAsyncWorker::StartWorker, this, i));
+    int32_t num = static_cast<int32_t>(thread::hardware_concurrency() / 2);
+    SetThreadNum(min(max(num, MIN_THREAD_NUM), DEFAULT_MAX_THREAD_NUM));
+}
+
+void MediaLibraryAsyncWorker::SetThreadNum(int32_t num)
+{
+    num = min(max(num, 1), MAX_THREAD_NUM);
+    lock_guard<mutex> lockGuard(threadLock_);
+    int32_t current = threadNum_.load();
+    if (num <= current) {
+        {
+            lock_guard<mutex> lock(workLock_);
+            threadNum_ = num;
+        }
+        /* the retired workers exit once their running task is done, their queued tasks get stolen */
+        workCv_.notify_all();
+        return;
+    }
+
+    for (int32_t i = current; i < num; i++) {
+        if (threads_[i].joinable()) {
+            threads_[i].join();
+        }
+    }
+    threadNum_ = num;
+    for (int32_t i = current; i < num; i++) {
+        threads_[i] = thread(bind(&MediaLibraryAsyncWorker::StartWorker, this, i));
     }
 }
 
+int32_t MediaLibraryAsyncWorker::GetThreadNum()
+{
+    return threadNum_.load();
+}
+
 void MediaLibraryAsyncWorker::Interrupt()
 {
-    ReleaseBgTask();
+    ReleaseTask(AsyncTaskPriority::BACKGROUND);
 }
 
 void MediaLibraryAsyncWorker::Stop()
 {
-    ReleaseBgTask();
-    ReleaseFgTask();
+    ReleaseTask(AsyncTaskPriority::HIGH);
 }
 
-int32_t MediaLibraryAsyncWorker::AddTask(const shared_ptr<MediaLibraryAsyncTask> &task, bool isFg)
+/* drops the queued tasks of the given class and every class below it */
+void MediaLibraryAsyncWorker::ReleaseTask(AsyncTaskPriority priority)
 {
-    if (isFg) {
-        lock_guard<mutex> lockGuard(fgTaskLock_);
-        fgTaskQueue_.push(task);
-    } else {
-        lock_guard<mutex> lockGuard(bgTaskLock_);
-        bgTaskQueue_.push(task);
+    for (auto &queue : queues_) {
+        lock_guard<mutex> lockGuard(queue->lock);
+        for (size_t i = static_cast<size_t>(priority); i < PRIORITY_COUNT; i++) {
+            pendingCount_[i] -= static_cast<int32_t>(queue->tasks[i].size());
+            queue->tasks[i].clear();
+        }
     }
+}
 
-    bgWorkCv_.notify_one();
-    return SUCCESS;
+int32_t MediaLibraryAsyncWorker::AddTask(const shared_ptr<MediaLibraryAsyncTask> &task, bool isFg)
+{
+    return AddTask(task, isFg ? AsyncTaskPriority::FOREGROUND : AsyncTaskPriority::BACKGROUND);
 }
 
-shared_ptr<MediaLibraryAsyncTask> MediaLibraryAsyncWorker::GetFgTask()
+int32_t MediaLibraryAsyncWorker::AddTask(const shared_ptr<MediaLibraryAsyncTask> &task, AsyncTaskPriority priority)
 {
-    lock_guard<mutex> lockGuard(fgTaskLock_);
-    if (fgTaskQueue_.empty()) {
-        return nullptr;
+    size_t index = static_cast<size_t>(priority);
+    if (task == nullptr || index >= PRIORITY_COUNT) {
+        return SUCCESS;
     }
-    shared_ptr<MediaLibraryAsyncTask> task = fgTaskQueue_.front();
-    fgTaskQueue_.pop();
-    return task;
+    int32_t threadNum = max(threadNum_.load(), 1);
+    auto &queue = queues_[nextQueue_++ % static_cast<uint32_t>(threadNum)];
+    {
+        lock_guard<mutex> lockGuard(queue->lock);
+        queue->tasks[index].push_back(task);
+        pendingCount_[index]++;
+    }
+
+    {
+        lock_guard<mutex> lock(workLock_);
+    }
+    workCv_.notify_one();
+    return SUCCESS;
 }
 
-void MediaLibraryAsyncWorker::ReleaseFgTask()
+bool MediaLibraryAsyncWorker::IsRetired(int32_t index)
 {
-    lock_guard<mutex> lockGuard(fgTaskLock_);
-    std::queue<std::shared_ptr<MediaLibraryAsyncTask>> tmp;
-    fgTaskQueue_.swap(tmp);
+    return index >= threadNum_.load();
 }
 
-shared_ptr<MediaLibraryAsyncTask> MediaLibraryAsyncWorker::GetBgTask()
+/* background work keeps one worker while foreground work is queued or running, instead of sleeping */
+int32_t MediaLibraryAsyncWorker::GetBgLimit()
 {
-    lock_guard<mutex> lockGuard(bgTaskLock_);
-    if (bgTaskQueue_.empty()) {
-        return nullptr;
-    }
-    shared_ptr<MediaLibraryAsyncTask> task = bgTaskQueue_.front();
-    bgTaskQueue_.pop();
-    return task;
+    bool isFgBusy = (runningFgCount_.load() > 0) ||
+        (pendingCount_[static_cast<size_t>(AsyncTaskPriority::HIGH)].load() > 0) ||
+        (pendingCount_[static_cast<size_t>(AsyncTaskPriority::FOREGROUND)].load() > 0);
+    return isFgBusy ? 1 : threadNum_.load();
 }
 
-void MediaLibraryAsyncWorker::ReleaseBgTask()
+bool MediaLibraryAsyncWorker::IsBgThrottled()
 {
-    lock_guard<mutex> lockGuard(bgTaskLock_);
-    std::queue<std::shared_ptr<MediaLibraryAsyncTask>> tmp;
-    bgTaskQueue_.swap(tmp);
+    return runningBgCount_.load() >= GetBgLimit();
 }
 
-bool MediaLibraryAsyncWorker::IsFgQueueEmpty()
+bool MediaLibraryAsyncWorker::TryAcquireBgSlot()
 {
-    lock_guard<mutex> lock_Guard(fgTaskLock_);
-    return fgTaskQueue_.empty();
+    int32_t running = runningBgCount_.load();
+    do {
+        if (running >= GetBgLimit()) {
+            return false;
+        }
+    } while (!runningBgCount_.compare_exchange_weak(running, running + 1));
+    return true;
 }
 
-bool MediaLibraryAsyncWorker::IsBgQueueEmpty()
+bool MediaLibraryAsyncWorker::HasRunnableTask()
 {
-    lock_guard<mutex> lock_Guard(bgTaskLock_);
-    return bgTaskQueue_.empty();
+    for (size_t i = 0; i < PRIORITY_COUNT; i++) {
+        if (pendingCount_[i].load() <= 0) {
+            continue;
+        }
+        if (!IsBgPriority(i) || !IsBgThrottled()) {
+            return true;
+        }
+    }
+    return false;
 }
 
-void MediaLibraryAsyncWorker::WaitForTask()
+/* the oldest task first, for the owner as well as for thieves, so a drained queue keeps its submission order */
+shared_ptr<MediaLibraryAsyncTask> MediaLibraryAsyncWorker::PopTask(int32_t queueIndex, size_t priority)
 {
-    std::unique_lock<std::mutex> lock(bgWorkLock_);
-    bgWorkCv_.wait(lock,
-        [this]() { return !isThreadRunning_ || !IsFgQueueEmpty() || !IsBgQueueEmpty(); });
+    auto &queue = queues_[queueIndex];
+    lock_guard<mutex> lockGuard(queue->lock);
+    auto &tasks = queue->tasks[priority];
+    if (tasks.empty()) {
+        return nullptr;
+    }
+    shared_ptr<MediaLibraryAsyncTask> task = tasks.front();
+    tasks.pop_front();
+    pendingCount_[priority]--;
+    return task;
 }
 
-void MediaLibraryAsyncWorker::SleepFgWork()
+shared_ptr<MediaLibraryAsyncTask> MediaLibraryAsyncWorker::GetTask(int32_t index, AsyncTaskPriority &priority)
 {
-    if ((doneTotal_.load() % FG_SLEEP_COUNT) == 0) {
-        this_thread::sleep_for(chrono::milliseconds(REST_FOR_MILLISECOND));
+    for (size_t i = 0; i < PRIORITY_COUNT; i++) {
+        if (pendingCount_[i].load() <= 0) {
+            continue;
+        }
+        bool isBg = IsBgPriority(i);
+        /* take the slot before the task, so two workers can not both pass the throttle */
+        if (isBg && !TryAcquireBgSlot()) {
+            return nullptr;
+        }
+        shared_ptr<MediaLibraryAsyncTask> task = PopTask(index, i);
+        for (int32_t j = 1; (task == nullptr) && (j < MAX_THREAD_NUM); j++) {
+            task = PopTask((index + j) % MAX_THREAD_NUM, i);
+        }
+        if (task != nullptr) {
+            priority = static_cast<AsyncTaskPriority>(i);
+            return task;
+        }
+        if (isBg) {
+            runningBgCount_--;
+        }
     }
+    return nullptr;
 }
 
-void MediaLibraryAsyncWorker::SleepBgWork()
+void MediaLibraryAsyncWorker::RunTask(const shared_ptr<MediaLibraryAsyncTask> &task, AsyncTaskPriority priority)
 {
-    this_thread::sleep_for(chrono::milliseconds(REST_FOR_MILLISECOND));
-    if ((doneTotal_.load() % BG_SLEEP_COUNT) == 0) {
-        this_thread::sleep_for(chrono::seconds(REST_FOR_LONG_SECOND));
+    bool isBg = IsBgPriority(static_cast<size_t>(priority));
+    if (!isBg) {
+        runningFgCount_++;
+    }
+    if (!task->IsCancelled()) {
+        task->Execute();
+    }
+    if (isBg) {
+        runningBgCount_--;
+    } else {
+        runningFgCount_--;
+    }
+
+    /* a finished task may lift the throttle for the background workers */
+    bool hasBgTask = (pendingCount_[static_cast<size_t>(AsyncTaskPriority::BACKGROUND)].load() > 0) ||
+        (pendingCount_[static_cast<size_t>(AsyncTaskPriority::IDLE)].load() > 0);
+    if (hasBgTask) {
+        {
+            lock_guard<mutex> lock(workLock_);
+        }
+        workCv_.notify_all();
     }
 }
 
-void MediaLibraryAsyncWorker::StartWorker(int num)
+void MediaLibraryAsyncWorker::StartWorker(int32_t index)
 {
     string name("MediaLibraryAsyncWorker");
-    name.append(to_string(num));
+    name.append(to_string(index));
     pthread_setname_np(pthread_self(), name.c_str());
     while (true) {
-        WaitForTask();
-        if (!isThreadRunning_) {
+        {
+            unique_lock<mutex> lock(workLock_);
+            workCv_.wait(lock,
+                [this, index]() { return !isThreadRunning_ || IsRetired(index) || HasRunnableTask(); });
+        }
+        if (!isThreadRunning_ || IsRetired(index)) {
             return;
         }
-        if (!IsFgQueueEmpty()) {
-            shared_ptr<MediaLibraryAsyncTask> fgTask = GetFgTask();
-            if (fgTask != nullptr) {
-                fgTask->executor_(fgTask->data_);
-                fgTask = nullptr;
-                doneTotal_++;
-            }
-        } else if (!IsBgQueueEmpty()) {
-            shared_ptr<MediaLibraryAsyncTask> bgTask = GetBgTask();
-            if (bgTask != nullptr) {
-                bgTask->executor_(bgTask->data_);
-                bgTask = nullptr;
-                doneTotal_++;
-                SleepBgWork();
-            }
+        AsyncTaskPriority priority = AsyncTaskPriority::BACKGROUND;
+        shared_ptr<MediaLibraryAsyncTask> task = GetTask(index, priority);
+        if (task != nullptr) {
+            RunTask(task, priority);
         }
     }
 }
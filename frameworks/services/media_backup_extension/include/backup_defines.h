@@ -36,6 +36,15 @@ struct FileInfo {
     int32_t height;
     int32_t width;
 };
+
+struct RestoreProgress {
+    uint64_t total = 0;
+    uint64_t processed = 0;
+    uint64_t succeeded = 0;
+    uint64_t failed = 0;
+    // source files that are gone, mostly ones restored by an earlier run
+    uint64_t skipped = 0;
+};
 } // namespace Media
 } // namespace OHOS
 
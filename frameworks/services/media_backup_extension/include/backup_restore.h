@@ -16,6 +16,9 @@
 #ifndef OHOS_MEDIA_BACKUP_RESTORE_H_
 #define OHOS_MEDIA_BACKUP_RESTORE_H_
 
+#include <map>
+#include <mutex>
+
 #include "backup_defines.h"
 #include "rdb_helper.h"
 #include "result_set.h"
@@ -27,13 +30,28 @@ public:
     static BackupRestore &GetInstance(void);
     void StartRestore(std::vector<FileInfo> &fileInfos);
     void MoveFiles(const std::string &originPath) const;
+    RestoreProgress GetProgress(void);
 
 private:
+    struct RestoreEntry {
+        FileInfo *fileInfo = nullptr;
+        std::string cloudPath;
+        std::string localPath;
+        bool moved = false;
+        bool copied = false;
+        bool inserted = false;
+    };
+    struct AlbumUpdate {
+        int32_t count = 0;
+        std::string coverUri;
+    };
+
     BackupRestore() = default;
     virtual ~BackupRestore() = default;
     int32_t InitRdb(void);
-    int32_t GetFileId(int32_t mediaType) const;
-    int32_t ExecuteSql(const std::string &sql) const;
+    int32_t GetFileIds(int32_t mediaType, int32_t count, int32_t &outStartId) const;
+    int32_t ExecuteSql(const std::string &sql,
+        const std::vector<NativeRdb::ValueObject> &bindArgs = std::vector<NativeRdb::ValueObject>()) const;
     std::shared_ptr<NativeRdb::ResultSet> QuerySql(const std::string &sql,
         const std::vector<std::string> &selectionArgs = std::vector<std::string>()) const;
     void SetUniqueNumber(std::vector<int32_t> &value) const;
@@ -42,13 +60,22 @@ private:
         std::string &name) const;
     int32_t CreateAssetPathById(int32_t fileId, FileInfo &fileInfo, std::string &cloudPath,
         std::string &localPath) const;
-    int32_t InsertSql(FileInfo &fileInfo, std::string &newPath) const;
-    int32_t UpdaterAlbum(const std::string &notifyUri, const std::string &albumSubtype) const;
-    int32_t QueryMaxId(void) const;
-    void NotifyPhotoAdd(const std::string &path, const FileInfo &fileInfo) const;
+    void RestoreBatch(std::vector<FileInfo> &fileInfos, size_t begin, size_t end);
+    void PrepareBatch(std::vector<FileInfo> &fileInfos, size_t begin, size_t end,
+        std::vector<RestoreEntry> &outEntries);
+    void MoveBatchFiles(std::vector<RestoreEntry> &entries) const;
+    int32_t InsertBatch(std::vector<RestoreEntry> &entries) const;
+    void RevertFile(const RestoreEntry &entry) const;
+    int32_t WriteJournal(const std::vector<RestoreEntry> &entries) const;
+    void RecoverFromJournal(void) const;
+    void AddAlbumUpdates(int64_t rowId, const RestoreEntry &entry,
+        std::map<int32_t, AlbumUpdate> &albumUpdates) const;
+    int32_t UpdateAlbums(const std::map<int32_t, AlbumUpdate> &albumUpdates) const;
 
 private:
     std::shared_ptr<NativeRdb::RdbStore> rdb_;
+    std::mutex progressMutex_;
+    RestoreProgress progress_;
 };
 
 class RdbCallback : public NativeRdb::RdbOpenCallback {
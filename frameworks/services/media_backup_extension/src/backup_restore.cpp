@@ -16,11 +16,20 @@
 #define MLOG_TAG "MediaLibraryRestore"
 
 #include "backup_restore.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fcntl.h>
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+
 #include "media_log.h"
 #include "media_file_utils.h"
 #include "medialibrary_errno.h"
 #include "result_set_utils.h"
 #include "media_column.h"
+#include "photo_album_column.h"
 #include "userfile_manager_types.h"
 
 namespace OHOS {
@@ -39,6 +48,12 @@ const std::string DEFAULT_IMAGE_NAME = "IMG_";
 const std::string DEFAULT_VIDEO_NAME = "VID_";
 const std::string RESTORE_MEDIA_DIR = "/storage/cloud/files/Photo/";
 const std::string RESTORE_LOCAL_DIR = "/storage/media/local/files/Photo/";
+// files of the batch in flight, so that a restore killed between moving files and committing rows can be undone
+const std::string RESTORE_JOURNAL_PATH = "/data/storage/el2/base/files/media_restore_journal";
+constexpr size_t RESTORE_BATCH_SIZE = 200;
+constexpr size_t RESTORE_IO_THREAD_NUM = 4;
+constexpr char JOURNAL_SEPARATOR = '\t';
+constexpr mode_t JOURNAL_FILE_MODE = 0660;
 
 BackupRestore &BackupRestore::GetInstance(void)
 {
@@ -79,13 +94,13 @@ int32_t BackupRestore::InitRdb(void)
     return E_OK;
 }
 
-int32_t BackupRestore::ExecuteSql(const std::string &sql) const
+int32_t BackupRestore::ExecuteSql(const std::string &sql, const std::vector<NativeRdb::ValueObject> &bindArgs) const
 {
     if (rdb_ == nullptr) {
         MEDIA_ERR_LOG("Pointer rdb_ is nullptr. Maybe it didn't init successfully.");
         return E_FAIL;
     }
-    int32_t ret = rdb_->ExecuteSql(sql);
+    int32_t ret = rdb_->ExecuteSql(sql, bindArgs);
     if (ret != NativeRdb::E_OK) {
         MEDIA_ERR_LOG("rdbStore_->ExecuteSql failed, ret = %{public}d", ret);
         return E_HAS_DB_ERROR;
@@ -190,9 +205,8 @@ int32_t BackupRestore::CreateAssetPathById(int32_t fileId, FileInfo &fileInfo, s
     return E_OK;
 }
 
-int32_t BackupRestore::GetFileId(int32_t type) const
+int32_t BackupRestore::GetFileIds(int32_t type, int32_t count, int32_t &outStartId) const
 {
-    int32_t result = -1;
     string typeString;
     switch (type) {
         case IMAGE_TYPE:
@@ -203,132 +217,350 @@ int32_t BackupRestore::GetFileId(int32_t type) const
             break;
         default:
             MEDIA_ERR_LOG("This type %{public}d can not get unique id", type);
-            return result;
+            return E_FAIL;
     }
 
+    // one update reserves the ids of the whole batch, they are handed out from the old number on
     const string updateSql = "UPDATE " + ASSET_UNIQUE_NUMBER_TABLE + " SET " + UNIQUE_NUMBER +
-        "=" + UNIQUE_NUMBER + "+1" " WHERE " + ASSET_MEDIA_TYPE + "='" + typeString + "';";
+        "=" + UNIQUE_NUMBER + "+? WHERE " + ASSET_MEDIA_TYPE + "=?;";
     const string querySql = "SELECT " + UNIQUE_NUMBER + " FROM " + ASSET_UNIQUE_NUMBER_TABLE +
-        " WHERE " + ASSET_MEDIA_TYPE + "='" + typeString + "';";
+        " WHERE " + ASSET_MEDIA_TYPE + "=?;";
 
-    int32_t errCode = ExecuteSql(updateSql);
+    int32_t errCode = ExecuteSql(updateSql, { NativeRdb::ValueObject(count), NativeRdb::ValueObject(typeString) });
     if (errCode < 0) {
         MEDIA_ERR_LOG("execute update unique number failed, ret=%{public}d", errCode);
         return errCode;
     }
 
-    auto resultSet = QuerySql(querySql);
+    auto resultSet = QuerySql(querySql, { typeString });
     if (resultSet == nullptr || resultSet->GoToFirstRow() != NativeRdb::E_OK) {
         return E_HAS_DB_ERROR;
     }
-    return GetInt32Val(UNIQUE_NUMBER, resultSet) - 1;
+    outStartId = GetInt32Val(UNIQUE_NUMBER, resultSet) - count;
+    return E_OK;
 }
 
-int32_t BackupRestore::QueryMaxId(void) const
+RestoreProgress BackupRestore::GetProgress(void)
 {
-    const string querySql = "SELECT MAX(file_id) as maxId FROM Photos;";
+    std::lock_guard<std::mutex> lock(progressMutex_);
+    return progress_;
+}
 
-    auto resultSet = QuerySql(querySql);
-    if (resultSet == nullptr || resultSet->GoToFirstRow() != NativeRdb::E_OK) {
-        return E_HAS_DB_ERROR;
+void BackupRestore::StartRestore(std::vector<FileInfo> &fileInfos)
+{
+    if (InitRdb() != E_OK) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(progressMutex_);
+        progress_ = RestoreProgress();
+        progress_.total = fileInfos.size();
+    }
+    RecoverFromJournal();
+
+    for (size_t begin = 0; begin < fileInfos.size(); begin += RESTORE_BATCH_SIZE) {
+        size_t end = std::min(begin + RESTORE_BATCH_SIZE, fileInfos.size());
+        RestoreBatch(fileInfos, begin, end);
+        RestoreProgress progress = GetProgress();
+        MEDIA_INFO_LOG("Restore progress %{public}llu/%{public}llu, succeeded %{public}llu, failed %{public}llu, "
+            "skipped %{public}llu", static_cast<unsigned long long>(progress.processed),
+            static_cast<unsigned long long>(progress.total), static_cast<unsigned long long>(progress.succeeded),
+            static_cast<unsigned long long>(progress.failed), static_cast<unsigned long long>(progress.skipped));
     }
-    return GetInt32Val("maxId", resultSet);
 }
 
-void BackupRestore::StartRestore(std::vector<FileInfo> &fileInfos)
+void BackupRestore::RestoreBatch(std::vector<FileInfo> &fileInfos, size_t begin, size_t end)
 {
-    InitRdb();
-    for (size_t i = 0; i < fileInfos.size(); i++) {
+    std::vector<RestoreEntry> entries;
+    PrepareBatch(fileInfos, begin, end, entries);
+    if (!entries.empty()) {
+        // without a journal the batch still restores, only a crash in the middle of it is not undone
+        WriteJournal(entries);
+        MoveBatchFiles(entries);
+        if (InsertBatch(entries) != E_OK) {
+            for (auto &entry : entries) {
+                entry.inserted = false;
+            }
+        }
+        for (const auto &entry : entries) {
+            if (!entry.inserted) {
+                RevertFile(entry);
+            } else if (entry.copied) {
+                // the copy is in the library now, drop the source so that a rerun does not restore it again
+                MediaFileUtils::DeleteFile(entry.fileInfo->filePath);
+            }
+        }
+        MediaFileUtils::DeleteFile(RESTORE_JOURNAL_PATH);
+    }
+
+    size_t succeeded = 0;
+    for (const auto &entry : entries) {
+        succeeded += entry.inserted ? 1 : 0;
+    }
+    std::lock_guard<std::mutex> lock(progressMutex_);
+    progress_.processed += entries.size();
+    progress_.succeeded += succeeded;
+    progress_.failed += entries.size() - succeeded;
+}
+
+void BackupRestore::PrepareBatch(std::vector<FileInfo> &fileInfos, size_t begin, size_t end,
+    std::vector<RestoreEntry> &outEntries)
+{
+    size_t skipped = 0;
+    size_t failed = 0;
+    std::map<int32_t, int32_t> typeCounts;
+    std::vector<FileInfo *> batch;
+    batch.reserve(end - begin);
+    for (size_t i = begin; i < end; i++) {
         if (!MediaFileUtils::IsFileExists(fileInfos[i].filePath)) {
             MEDIA_WARN_LOG("File is not exist, filePath = %{private}s.", fileInfos[i].filePath.c_str());
+            skipped++;
             continue;
         }
-        std::string localPath;
-        std::string cloudPath;
-        int32_t fileId = GetFileId(fileInfos[i].fileType);
-        if (CreateAssetPathById(fileId, fileInfos[i], cloudPath, localPath) != E_OK) {
-            MEDIA_ERR_LOG("CreateAssetPathById failed, filePath = %{private}s.", fileInfos[i].filePath.c_str());
+        typeCounts[fileInfos[i].fileType]++;
+        batch.push_back(&fileInfos[i]);
+    }
+
+    std::map<int32_t, int32_t> nextIds;
+    for (const auto &typeCount : typeCounts) {
+        int32_t startId = 0;
+        if (GetFileIds(typeCount.first, typeCount.second, startId) == E_OK) {
+            nextIds[typeCount.first] = startId;
+        }
+    }
+    outEntries.reserve(batch.size());
+    for (FileInfo *fileInfo : batch) {
+        auto iter = nextIds.find(fileInfo->fileType);
+        RestoreEntry entry;
+        if (iter == nextIds.end() ||
+            CreateAssetPathById(iter->second++, *fileInfo, entry.cloudPath, entry.localPath) != E_OK) {
+            MEDIA_ERR_LOG("CreateAssetPathById failed, filePath = %{private}s.", fileInfo->filePath.c_str());
+            failed++;
             continue;
         }
-        if (InsertSql(fileInfos[i], cloudPath) != E_OK) {
-            MEDIA_ERR_LOG("InsertSql failed, filePath = %{private}s.", fileInfos[i].filePath.c_str());
+        entry.fileInfo = fileInfo;
+        outEntries.push_back(std::move(entry));
+    }
+
+    std::lock_guard<std::mutex> lock(progressMutex_);
+    progress_.skipped += skipped;
+    progress_.failed += failed;
+    progress_.processed += skipped + failed;
+}
+
+void BackupRestore::MoveBatchFiles(std::vector<RestoreEntry> &entries) const
+{
+    // moves fall back to copies across file systems, so they are spread over a few threads
+    std::atomic<size_t> next(0);
+    auto moveFiles = [&entries, &next]() {
+        for (size_t i = next++; i < entries.size(); i = next++) {
+            RestoreEntry &entry = entries[i];
+            if (MediaFileUtils::MoveFile(entry.fileInfo->filePath, entry.localPath)) {
+                entry.moved = true;
+            } else if (MediaFileUtils::CopyFileUtil(entry.fileInfo->filePath, entry.localPath)) {
+                entry.moved = true;
+                entry.copied = true;
+            } else {
+                MEDIA_ERR_LOG("MoveFile failed, filePath = %{private}s.", entry.fileInfo->filePath.c_str());
+            }
+        }
+    };
+    size_t threadNum = std::min(RESTORE_IO_THREAD_NUM, entries.size());
+    std::vector<std::thread> threads;
+    threads.reserve(threadNum);
+    for (size_t i = 1; i < threadNum; i++) {
+        threads.emplace_back(moveFiles);
+    }
+    moveFiles();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+int32_t BackupRestore::InsertBatch(std::vector<RestoreEntry> &entries) const
+{
+    if (rdb_ == nullptr) {
+        MEDIA_ERR_LOG("Pointer rdb_ is nullptr. Maybe it didn't init successfully.");
+        return E_FAIL;
+    }
+    int32_t ret = rdb_->BeginTransaction();
+    if (ret != NativeRdb::E_OK) {
+        MEDIA_ERR_LOG("BeginTransaction failed, ret = %{public}d", ret);
+        return E_HAS_DB_ERROR;
+    }
+    std::map<int32_t, AlbumUpdate> batchAlbumUpdates;
+    for (auto &entry : entries) {
+        if (!entry.moved) {
             continue;
         }
-        if (!MediaFileUtils::MoveFile(fileInfos[i].filePath, localPath) &&
-            !MediaFileUtils::CopyFileUtil(fileInfos[i].filePath, localPath)) {
-            MEDIA_ERR_LOG("MoveFile failed, filePath = %{private}s.", fileInfos[i].filePath.c_str());
+        const FileInfo &fileInfo = *entry.fileInfo;
+        NativeRdb::ValuesBucket values;
+        values.PutString(MediaColumn::MEDIA_FILE_PATH, entry.cloudPath);
+        values.PutString(MediaColumn::MEDIA_TITLE, MediaFileUtils::GetTitleFromDisplayName(fileInfo.displayName));
+        values.PutString(MediaColumn::MEDIA_NAME, fileInfo.displayName);
+        values.PutInt(MediaColumn::MEDIA_TYPE, fileInfo.fileType == IMAGE_TYPE ?
+            MediaType::MEDIA_TYPE_IMAGE : MediaType::MEDIA_TYPE_VIDEO);
+        values.PutLong(MediaColumn::MEDIA_DATE_ADDED, fileInfo.showDateToken);
+        values.PutInt(MediaColumn::MEDIA_IS_FAV, fileInfo.is_hw_favorite);
+        values.PutLong(MediaColumn::MEDIA_DATE_TRASHED, fileInfo.recycledTime);
+        values.PutInt(MediaColumn::MEDIA_HIDDEN, fileInfo.hidden);
+        values.PutLong(MediaColumn::MEDIA_SIZE, fileInfo._size);
+        values.PutLong(MediaColumn::MEDIA_DURATION, fileInfo.duration);
+        values.PutInt(PhotoColumn::PHOTO_HEIGHT, fileInfo.height);
+        values.PutInt(PhotoColumn::PHOTO_WIDTH, fileInfo.width);
+        int64_t rowId = 0;
+        ret = rdb_->Insert(rowId, PhotoColumn::PHOTOS_TABLE, values);
+        if (ret != NativeRdb::E_OK || rowId <= 0) {
+            MEDIA_ERR_LOG("Insert failed, ret = %{public}d, filePath = %{private}s.", ret,
+                fileInfo.filePath.c_str());
             continue;
         }
-        NotifyPhotoAdd(cloudPath, fileInfos[i]);
+        entry.inserted = true;
+        AddAlbumUpdates(rowId, entry, batchAlbumUpdates);
+    }
+    // the albums count the batch in the same transaction, so a restore killed later leaves them matching the rows
+    if (UpdateAlbums(batchAlbumUpdates) != E_OK) {
+        rdb_->RollBack();
+        return E_HAS_DB_ERROR;
     }
+    ret = rdb_->Commit();
+    if (ret != NativeRdb::E_OK) {
+        MEDIA_ERR_LOG("Commit failed, ret = %{public}d", ret);
+        rdb_->RollBack();
+        return E_HAS_DB_ERROR;
+    }
+    return E_OK;
 }
 
-void BackupRestore::MoveFiles(const std::string &originPath) const
+void BackupRestore::RevertFile(const RestoreEntry &entry) const
 {
-    const std::string DOCUMENT_PATH = "/storage/media/local/files/Documents";
-    if (!MediaFileUtils::RenameDir(originPath, DOCUMENT_PATH)) {
-        MEDIA_ERR_LOG("Move media file failed.");
+    if (!entry.moved) {
+        return;
+    }
+    if (entry.copied || MediaFileUtils::IsFileExists(entry.fileInfo->filePath)) {
+        MediaFileUtils::DeleteFile(entry.localPath);
+    } else if (!MediaFileUtils::MoveFile(entry.localPath, entry.fileInfo->filePath)) {
+        MEDIA_ERR_LOG("Move back failed, filePath = %{private}s.", entry.fileInfo->filePath.c_str());
     }
 }
 
-int32_t BackupRestore::InsertSql(FileInfo &fileInfo, std::string &newPath) const
+int32_t BackupRestore::WriteJournal(const std::vector<RestoreEntry> &entries) const
 {
-    std::string displayName = fileInfo.displayName;
-    std::string data = newPath;
-    std::string fileSize = std::to_string(fileInfo._size);
-    std::string duration = std::to_string(fileInfo.duration);
-    std::string date_added = std::to_string(fileInfo.showDateToken);
-    std::string media_type = std::to_string(fileInfo.fileType == IMAGE_TYPE ?
-        MediaType::MEDIA_TYPE_IMAGE : MediaType::MEDIA_TYPE_VIDEO);
-    std::string title = MediaFileUtils::GetTitleFromDisplayName(fileInfo.displayName);
-    std::string is_favorite = std::to_string(fileInfo.is_hw_favorite);
-    std::string date_trashed = std::to_string(fileInfo.recycledTime);
-    std::string hidden = std::to_string(fileInfo.hidden);
-    std::string height = std::to_string(fileInfo.height);
-    std::string width = std::to_string(fileInfo.width);
-
-    std::string insertStatement = "INSERT INTO Photos (data,title,display_name,media_type,date_added, \
-        is_favorite, date_trashed, hidden, size, duration, height, width) VALUES ('" + data +
-        "','" + title + "','" + displayName + "'," + media_type + "," + date_added + "," + is_favorite +
-        "," + date_trashed + "," + hidden + "," + fileSize + "," + duration + "," + height + "," + width + ");";
-    return ExecuteSql(insertStatement);
+    std::string content;
+    for (const auto &entry : entries) {
+        content += entry.fileInfo->filePath + JOURNAL_SEPARATOR + entry.localPath + JOURNAL_SEPARATOR +
+            entry.cloudPath + '\n';
+    }
+    int fd = open(RESTORE_JOURNAL_PATH.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, JOURNAL_FILE_MODE);
+    if (fd < 0) {
+        MEDIA_ERR_LOG("Open restore journal failed, errno = %{public}d", errno);
+        return E_FAIL;
+    }
+    size_t written = 0;
+    while (written < content.size()) {
+        ssize_t ret = write(fd, content.data() + written, content.size() - written);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            break;
+        }
+        written += static_cast<size_t>(ret);
+    }
+    // the journal has to be on disk before any file is moved, or a power loss can leave moves it does not know of
+    bool isSynced = (written == content.size()) && (fsync(fd) == 0);
+    close(fd);
+    if (!isSynced) {
+        MEDIA_ERR_LOG("Write restore journal failed, errno = %{public}d", errno);
+        return E_FAIL;
+    }
+    return E_OK;
 }
 
-int32_t BackupRestore::UpdaterAlbum(const std::string &notifyUri, const std::string &albumSubtype) const
+void BackupRestore::RecoverFromJournal(void) const
 {
-    std::string updaterSql = "UPDATE PhotoAlbum SET cover_uri = '" + notifyUri +
-        "', count = count + 1 WHERE album_subtype = " + albumSubtype + ";";
-    return ExecuteSql(updaterSql);
+    std::ifstream journal(RESTORE_JOURNAL_PATH);
+    if (!journal.is_open()) {
+        return;
+    }
+    // files of rows that made it into the database stay, the others go back to where they came from
+    const string querySql = "SELECT " + MediaColumn::MEDIA_ID + " FROM " + PhotoColumn::PHOTOS_TABLE +
+        " WHERE " + MediaColumn::MEDIA_FILE_PATH + "=?;";
+    std::string line;
+    while (std::getline(journal, line)) {
+        size_t first = line.find(JOURNAL_SEPARATOR);
+        size_t second = (first == std::string::npos) ? first : line.find(JOURNAL_SEPARATOR, first + 1);
+        if (second == std::string::npos) {
+            continue;
+        }
+        FileInfo fileInfo;
+        fileInfo.filePath = line.substr(0, first);
+        RestoreEntry entry;
+        entry.fileInfo = &fileInfo;
+        entry.localPath = line.substr(first + 1, second - first - 1);
+        entry.cloudPath = line.substr(second + 1);
+        if (!MediaFileUtils::IsFileExists(entry.localPath)) {
+            continue;
+        }
+        auto resultSet = QuerySql(querySql, { entry.cloudPath });
+        if (resultSet != nullptr && resultSet->GoToFirstRow() == NativeRdb::E_OK) {
+            continue;
+        }
+        entry.moved = true;
+        RevertFile(entry);
+    }
+    journal.close();
+    MediaFileUtils::DeleteFile(RESTORE_JOURNAL_PATH);
 }
 
-void BackupRestore::NotifyPhotoAdd(const std::string &path, const FileInfo &fileInfo) const
+void BackupRestore::MoveFiles(const std::string &originPath) const
 {
-    std::string prefix = PhotoColumn::PHOTO_URI_PREFIX;
-    int32_t rowId = QueryMaxId();
-    if (rowId <= 0) {
-        MEDIA_ERR_LOG("Invalid rowId for query max id.");
+    const std::string DOCUMENT_PATH = "/storage/media/local/files/Documents";
+    if (!MediaFileUtils::RenameDir(originPath, DOCUMENT_PATH)) {
+        MEDIA_ERR_LOG("Move media file failed.");
     }
-    std::string extraUri = MediaFileUtils::GetExtraUri(fileInfo.displayName, path);
-    std::string notifyUri = MediaFileUtils::GetUriByExtrConditions(prefix, std::to_string(rowId), extraUri);
+}
+
+void BackupRestore::AddAlbumUpdates(int64_t rowId, const RestoreEntry &entry,
+    std::map<int32_t, AlbumUpdate> &albumUpdates) const
+{
+    const FileInfo &fileInfo = *entry.fileInfo;
+    std::string extraUri = MediaFileUtils::GetExtraUri(fileInfo.displayName, entry.cloudPath);
+    std::string notifyUri = MediaFileUtils::GetUriByExtrConditions(PhotoColumn::PHOTO_URI_PREFIX,
+        std::to_string(rowId), extraUri);
+    auto addTo = [&albumUpdates, &notifyUri](int32_t subtype) {
+        albumUpdates[subtype].count++;
+        albumUpdates[subtype].coverUri = notifyUri;
+    };
 
     if (fileInfo.recycledTime != 0) {
-        UpdaterAlbum(notifyUri, std::to_string(PhotoAlbumSubType::TRASH));
+        addTo(PhotoAlbumSubType::TRASH);
         return;
     }
     if (fileInfo.hidden != 0) {
-        UpdaterAlbum(notifyUri, std::to_string(PhotoAlbumSubType::HIDDEN));
+        addTo(PhotoAlbumSubType::HIDDEN);
         return;
     }
-
-    if (fileInfo.fileType == IMAGE_TYPE) {
-        UpdaterAlbum(notifyUri, std::to_string(PhotoAlbumSubType::IMAGES));
-    } else {
-        UpdaterAlbum(notifyUri, std::to_string(PhotoAlbumSubType::VIDEO));
+    addTo(fileInfo.fileType == IMAGE_TYPE ? PhotoAlbumSubType::IMAGES : PhotoAlbumSubType::VIDEO);
+    if (fileInfo.is_hw_favorite != 0) {
+        addTo(PhotoAlbumSubType::FAVORITE);
     }
+}
 
-    if (fileInfo.is_hw_favorite != 0) {
-        UpdaterAlbum(notifyUri, std::to_string(PhotoAlbumSubType::FAVORITE));
+int32_t BackupRestore::UpdateAlbums(const std::map<int32_t, AlbumUpdate> &albumUpdates) const
+{
+    const std::string updateSql = "UPDATE " + PhotoAlbumColumns::TABLE + " SET " +
+        PhotoAlbumColumns::ALBUM_COVER_URI + " = ?, " + PhotoAlbumColumns::ALBUM_COUNT + " = " +
+        PhotoAlbumColumns::ALBUM_COUNT + " + ? WHERE " + PhotoAlbumColumns::ALBUM_SUBTYPE + " = ?;";
+    for (const auto &update : albumUpdates) {
+        int32_t ret = ExecuteSql(updateSql, { NativeRdb::ValueObject(update.second.coverUri),
+            NativeRdb::ValueObject(update.second.count), NativeRdb::ValueObject(update.first) });
+        if (ret != E_OK) {
+            MEDIA_ERR_LOG("Update album %{public}d failed, ret = %{public}d", update.first, ret);
+            return ret;
+        }
     }
+    return E_OK;
 }
 } // namespace Media
 } // namespace OHOS
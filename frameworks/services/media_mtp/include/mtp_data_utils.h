@@ -34,6 +34,16 @@ struct PropertyValue {
     uint128_t outLongVal = {0};
     std::string outStrVal;
 };
+// where one requested property is read from in every row of a prop list result set
+struct PropColumnIndex {
+    uint16_t property = 0;
+    uint16_t type = 0;
+    std::string column;
+    ResultSetDataType dataType = TYPE_NULL;
+    int32_t index = -1;
+    // object format is derived from the media type column and, for files, the path column
+    int32_t pathIndex = -1;
+};
 const std::string MTP_FORMAT_ALL = ".all"; // Undefined
 const std::string MTP_FORMAT_UNDEFINED = ".undefined"; // Undefined
 const std::string MTP_FORMAT_ASSOCIATION = ".floader"; // associations (folders and directories)
@@ -119,25 +129,30 @@ public:
     static int32_t GetPropListBySet(const uint32_t property,
         const uint16_t format, const std::shared_ptr<DataShare::DataShareResultSet> &resultSet,
         std::shared_ptr<std::vector<Property>> &outProps);
+    static void GetPropColumns(const uint32_t property, const uint16_t format, std::vector<std::string> &outColumns);
     static int32_t GetPropValueBySet(const uint32_t property,
         const std::shared_ptr<DataShare::DataShareResultSet> &resultSet,
         PropertyValue &outPropValue);
     static int32_t GetMediaTypeByName(std::string &displayName, MediaType &outMediaType);
 private:
+    static void GetProperties(const uint32_t property, const uint16_t format, UInt16List &outProperties);
     static int32_t GetPropList(const std::shared_ptr<DataShare::DataShareResultSet> &resultSet,
         const std::shared_ptr<UInt16List> &properties, std::shared_ptr<std::vector<Property>> &outProps);
     static void GetFormatByPath(const std::string &path, uint16_t &outFormat);
     static std::variant<int32_t, int64_t, std::string> ReturnError(const std::string &errMsg,
         const ResultSetDataType &type);
-    static int32_t GetFormat(const std::shared_ptr<DataShare::DataShareResultSet> &resultSet, uint16_t &outFormat);
+    static int32_t GetFormat(const std::shared_ptr<DataShare::DataShareResultSet> &resultSet,
+        const PropColumnIndex &propColumn, uint16_t &outFormat);
+    static void GetPropColumnIndexes(const std::shared_ptr<DataShare::DataShareResultSet> &resultSet,
+        const UInt16List &properties, std::vector<PropColumnIndex> &outPropColumns);
     static void GetOneRowPropList(uint32_t handle, const std::shared_ptr<DataShare::DataShareResultSet> &resultSet,
-        const std::shared_ptr<UInt16List> &properties, std::shared_ptr<std::vector<Property>> &outProps);
+        const std::vector<PropColumnIndex> &propColumns, std::shared_ptr<std::vector<Property>> &outProps);
     static void GetOneRowPropVal(const std::shared_ptr<DataShare::DataShareResultSet> &resultSet,
         const uint32_t property, PropertyValue &outPropValue);
     static void SetOneDefaultlPropList(uint32_t handle,
         uint16_t property, std::shared_ptr<std::vector<Property>> &outProps);
-    static void SetProperty(const std::string &column,
-        const std::shared_ptr<DataShare::DataShareResultSet> &resultSet, ResultSetDataType &type, Property &prop);
+    static void SetProperty(const PropColumnIndex &propColumn,
+        const std::shared_ptr<DataShare::DataShareResultSet> &resultSet, Property &prop);
 };
 } // namespace Media
 } // namespace OHOS
@@ -18,6 +18,7 @@
 #include <stdint.h>
 #include <vector>
 #include "mtp_constants.h"
+#include "mtp_transfer_pipeline.h"
 #include "v1_0/iusbfn_mtp_interface.h"
 namespace OHOS {
 namespace Media {
@@ -34,9 +35,14 @@ public:
     int ReceiveObj(MtpFileRange &mfr);
     int SendObj(MtpFileRange &mfr);
     int WriteEvent(EventMtp &em);
+
+    void SetTransferConfig(const MtpTransferConfig &config);
+    MtpTransferStats GetTransferStats();
 private:
     bool usbOpenFlag {false};
     sptr<OHOS::HDI::Usb::Gadget::Mtp::V1_0::IUsbfnMtpInterface> usbfnMtpInterface = nullptr;
+    MtpTransferConfig transferConfig_;
+    std::unique_ptr<MtpTransferPipeline> transferPipeline_;
 };
 } // namespace Media
 } // namespace OHOS
@@ -15,6 +15,8 @@
 #ifndef FRAMEWORKS_SERVICES_MEDIA_MTP_INCLUDE_MTP_MEDIALIBRARY_MANAGER_H_
 #define FRAMEWORKS_SERVICES_MEDIA_MTP_INCLUDE_MTP_MEDIALIBRARY_MANAGER_H_
 
+#include <map>
+#include <tuple>
 #include "datashare_helper.h"
 #include "datashare_result_set.h"
 #include "file_asset.h"
@@ -51,22 +53,38 @@ public:
         std::shared_ptr<std::vector<Property>> &outProps);
     int32_t GetObjectPropValue(const std::shared_ptr<MtpOperationContext> &context,
         uint64_t &outIntVal, uint128_t &outLongVal, std::string &outStrVal);
+    void ClearPropListCache();
 private:
     int32_t SetObjectInfo(const std::unique_ptr<FileAsset> &fileAsset, std::shared_ptr<ObjectInfo> &outObjectInfo);
     bool CompressImage(std::unique_ptr<PixelMap> &pixelMap, Size &size, std::vector<uint8_t> &data);
+    int32_t GetThumbFromService(const std::shared_ptr<FileAsset> &fileAsset, std::shared_ptr<UInt8List> &outThumb);
+    int32_t GetThumbFromOrigin(const std::shared_ptr<MtpOperationContext> &context,
+        std::shared_ptr<UInt8List> &outThumb);
     int32_t GetAssetById(const int32_t id, std::shared_ptr<FileAsset> &outFileAsset);
     int32_t GetAssetByPath(const std::string &path, std::shared_ptr<FileAsset> &outFileAsset);
     int32_t GetAssetByPredicates(const DataShare::DataSharePredicates &predicates,
         std::shared_ptr<FileAsset> &outFileAsset);
-    std::shared_ptr<DataShare::DataShareResultSet> GetAllRootsChildren(const uint16_t format);
-    std::shared_ptr<DataShare::DataShareResultSet> GetHandle(const uint16_t format, const uint32_t handle);
-    std::shared_ptr<DataShare::DataShareResultSet> GetRootsDepthChildren(const uint16_t format);
+    std::shared_ptr<DataShare::DataShareResultSet> GetAllRootsChildren(const uint16_t format,
+        const std::vector<std::string> &columns = {});
+    std::shared_ptr<DataShare::DataShareResultSet> GetHandle(const uint16_t format, const uint32_t handle,
+        const std::vector<std::string> &columns = {});
+    std::shared_ptr<DataShare::DataShareResultSet> GetRootsDepthChildren(const uint16_t format,
+        const std::vector<std::string> &columns = {});
     int32_t GetRootIdList(std::vector<std::string> &outRootIdList);
-    std::shared_ptr<DataShare::DataShareResultSet> GetHandleDepthChildren(const uint16_t format, const uint32_t handle);
+    std::shared_ptr<DataShare::DataShareResultSet> GetHandleDepthChildren(const uint16_t format, const uint32_t handle,
+        const std::vector<std::string> &columns = {});
+    bool GetPropListFromCache(const std::shared_ptr<MtpOperationContext> &context,
+        std::shared_ptr<std::vector<Property>> &outProps);
+    void AddPropListToCache(const std::shared_ptr<MtpOperationContext> &context,
+        const std::shared_ptr<std::vector<Property>> &props);
 private:
+    // handle, depth, format and property of a GetObjectPropList request
+    using PropListCacheKey = std::tuple<uint32_t, uint32_t, uint16_t, uint32_t>;
     static std::mutex mutex_;
     static std::shared_ptr<MtpMedialibraryManager> instance_;
     static std::shared_ptr<DataShare::DataShareHelper> dataShareHelper_;
+    static std::mutex propListMutex_;
+    static std::map<PropListCacheKey, std::shared_ptr<std::vector<Property>>> propListCache_;
 };
 } // namespace Media
 } // namespace OHOS
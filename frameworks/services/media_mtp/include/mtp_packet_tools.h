@@ -71,6 +71,8 @@ public:
     static void PutInt128(std::vector<uint8_t> &outBuffer, int64_t value);
     static void PutInt128(std::vector<uint8_t> &outBuffer, const int128_t value);
     static void PutString(std::vector<uint8_t> &outBuffer, const std::string &string);
+    /* bytes PutString writes for the string */
+    static uint32_t GetStringSize(const std::string &string);
     
     static uint8_t GetUInt8(const std::vector<uint8_t> &buffer, size_t &offset);
     static uint16_t GetUInt16(const std::vector<uint8_t> &buffer, size_t &offset);
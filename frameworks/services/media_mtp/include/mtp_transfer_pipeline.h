@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef FRAMEWORKS_SERVICES_MEDIA_MTP_INCLUDE_MTP_TRANSFER_PIPELINE_H_
+#define FRAMEWORKS_SERVICES_MEDIA_MTP_INCLUDE_MTP_TRANSFER_PIPELINE_H_
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+#include "mtp_constants.h"
+#include "v1_0/iusbfn_mtp_interface.h"
+namespace OHOS {
+namespace Media {
+struct MtpTransferConfig {
+    // the driver moves object data through the fd of the hdi SendFile and ReceiveFile unless this is set, the
+    // pipeline copies every chunk into a binder parcel and is only worth it where it measures faster
+    bool usePipeline = false;
+    // bytes moved by one usb read or write
+    uint32_t chunkSize = 128 * 1024;
+    // chunks in flight between the file and the usb side, 2 for double and 3 for triple buffering
+    uint32_t bufferCount = 3;
+    // max packet size of the bulk endpoints, a data phase of a multiple of it ends with a zero length packet,
+    // 0 takes it from the speed the usb device controller was connected at when the pipeline was created
+    uint32_t maxPacketSize = 0;
+};
+
+struct MtpTransferStats {
+    uint32_t transfers = 0;
+    uint64_t bytes = 0;
+    // time spent in usb reads and writes, in file reads and writes, and from start to end of the transfers
+    uint64_t usbTimeUs = 0;
+    uint64_t fileTimeUs = 0;
+    uint64_t elapsedUs = 0;
+
+    uint64_t GetBytesPerSecond() const;
+};
+
+/**
+ * Moves object data between a file and the usb function in chunks, with the file side running on a worker
+ * thread of its own so that file reads overlap usb writes in SendFile and usb reads overlap file writes in
+ * ReceiveFile. The worker is started by the first transfer and kept until the pipeline is destroyed.
+ */
+class MtpTransferPipeline {
+public:
+    explicit MtpTransferPipeline(const sptr<HDI::Usb::Gadget::Mtp::V1_0::IUsbfnMtpInterface> &usbfnMtpInterface,
+        const MtpTransferConfig &config = MtpTransferConfig());
+    ~MtpTransferPipeline();
+
+    /* sends the file range to the host, behind a data packet header built from command and transaction_id */
+    int32_t SendFile(const MtpFileRange &mfr);
+    /* writes length bytes from the host to the file, starting at offset */
+    int32_t ReceiveFile(const MtpFileRange &mfr);
+
+    void SetConfig(const MtpTransferConfig &config);
+    MtpTransferConfig GetConfig();
+    MtpTransferStats GetStats();
+    void ResetStats();
+
+private:
+    using Producer = std::function<int32_t(std::vector<uint8_t> &)>;
+    using Consumer = std::function<int32_t(const std::vector<uint8_t> &)>;
+
+    int32_t Run(const MtpTransferConfig &config, const Producer &produce, const Consumer &consume);
+    void StartJob(const std::function<void()> &job);
+    void WaitJob();
+    void Work();
+    static uint32_t GetUdcMaxPacketSize();
+    void AddStats(uint64_t bytes, uint64_t usbTimeUs, uint64_t fileTimeUs, uint64_t elapsedUs);
+
+    sptr<HDI::Usb::Gadget::Mtp::V1_0::IUsbfnMtpInterface> usbfnMtpInterface_;
+    uint32_t udcMaxPacketSize_ = 0;
+    std::mutex mutex_;
+    MtpTransferConfig config_;
+    MtpTransferStats stats_;
+
+    std::mutex workerMutex_;
+    std::condition_variable workerCv_;
+    std::thread worker_;
+    // the job the worker runs, it is cleared when the job returns
+    std::function<void()> job_;
+    bool isWorkerExit_ = false;
+};
+} // namespace Media
+} // namespace OHOS
+#endif  // FRAMEWORKS_SERVICES_MEDIA_MTP_INCLUDE_MTP_TRANSFER_PIPELINE_H_
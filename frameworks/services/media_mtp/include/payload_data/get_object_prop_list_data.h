@@ -31,6 +31,7 @@ public:
     bool SetProps(std::shared_ptr<std::vector<Property>> &props);
 
 private:
+    static uint32_t GetPropertySize(const Property &prop);
     static void WriteProperty(std::vector<uint8_t> &outBuffer, const Property &prop);
     static void WritePropertyStrValue(std::vector<uint8_t> &outBuffer, const Property &prop);
     static void WritePropertyIntValue(std::vector<uint8_t> &outBuffer, const Property &prop);
@@ -12,6 +12,7 @@
 * See the License for the specific language governing permissions and
 * limitations under the License.
 */
+#include <algorithm>
 #include <map>
 #include "medialibrary_errno.h"
 #include "medialibrary_db_const.h"
@@ -273,37 +274,93 @@ void MtpDataUtils::GetMediaTypeByformat(const uint16_t format, MediaType &outMed
     }
 }
 
-int32_t MtpDataUtils::GetPropListBySet(const uint32_t property, const uint16_t format,
-    const shared_ptr<DataShare::DataShareResultSet> &resultSet, shared_ptr<vector<Property>> &outProps)
+void MtpDataUtils::GetProperties(const uint32_t property, const uint16_t format, UInt16List &outProperties)
 {
-    shared_ptr<UInt16List> properties = make_shared<UInt16List>();
     if (property == MTP_PROPERTY_ALL_CODE) {
         shared_ptr<MtpOperationContext> context = make_shared<MtpOperationContext>();
         context->format = format;
         shared_ptr<GetObjectPropsSupportedData> payLoadData = make_shared<GetObjectPropsSupportedData>(context);
-        payLoadData->GetObjectProps(*properties);
+        payLoadData->GetObjectProps(outProperties);
     } else {
-        properties->push_back(property);
+        outProperties.push_back(property);
     }
+}
+
+int32_t MtpDataUtils::GetPropListBySet(const uint32_t property, const uint16_t format,
+    const shared_ptr<DataShare::DataShareResultSet> &resultSet, shared_ptr<vector<Property>> &outProps)
+{
+    shared_ptr<UInt16List> properties = make_shared<UInt16List>();
+    GetProperties(property, format, *properties);
     return GetPropList(resultSet, properties, outProps);
 }
 
+void MtpDataUtils::GetPropColumns(const uint32_t property, const uint16_t format, vector<string> &outColumns)
+{
+    UInt16List properties;
+    GetProperties(property, format, properties);
+    outColumns.push_back(MEDIA_DATA_DB_ID);
+    auto addColumn = [&outColumns](const string &column) {
+        if (find(outColumns.begin(), outColumns.end(), column) == outColumns.end()) {
+            outColumns.push_back(column);
+        }
+    };
+    for (uint16_t prop : properties) {
+        auto iter = PropColumnMap.find(prop);
+        if (iter == PropColumnMap.end()) {
+            continue;
+        }
+        if (iter->second.compare(MEDIA_DATA_DB_FORMAT) == 0) {
+            addColumn(MEDIA_DATA_DB_MEDIA_TYPE);
+            addColumn(MEDIA_DATA_DB_FILE_PATH);
+        } else {
+            addColumn(iter->second);
+        }
+    }
+}
+
+void MtpDataUtils::GetPropColumnIndexes(const shared_ptr<DataShare::DataShareResultSet> &resultSet,
+    const UInt16List &properties, vector<PropColumnIndex> &outPropColumns)
+{
+    outPropColumns.reserve(properties.size());
+    for (uint16_t property : properties) {
+        PropColumnIndex propColumn;
+        propColumn.property = property;
+        auto iter = PropColumnMap.find(property);
+        if (iter != PropColumnMap.end()) {
+            propColumn.column = iter->second;
+            propColumn.dataType = ColumnTypeMap.at(propColumn.column);
+            if (propColumn.column.compare(MEDIA_DATA_DB_FORMAT) == 0) {
+                resultSet->GetColumnIndex(MEDIA_DATA_DB_MEDIA_TYPE, propColumn.index);
+                resultSet->GetColumnIndex(MEDIA_DATA_DB_FILE_PATH, propColumn.pathIndex);
+            } else if (resultSet->GetColumnIndex(propColumn.column, propColumn.index) != NativeRdb::E_OK) {
+                MEDIA_ERR_LOG("GetColumnIndex failed, column %{private}s", propColumn.column.c_str());
+                propColumn.index = -1;
+            }
+        } else if (PropDefaultMap.find(property) == PropDefaultMap.end()) {
+            continue;
+        }
+        propColumn.type = static_cast<uint16_t>(MtpPacketTool::GetObjectPropTypeByPropCode(property));
+        outPropColumns.push_back(propColumn);
+    }
+}
+
 int32_t MtpDataUtils::GetPropList(const shared_ptr<DataShare::DataShareResultSet> &resultSet,
     const shared_ptr<UInt16List> &properties, shared_ptr<vector<Property>> &outProps)
 {
-    int count = 0;
-    resultSet->GetRowCount(count);
     if (properties->size() == 0) {
         return MTP_INVALID_OBJECTPROPCODE_CODE;
     }
-    ResultSetDataType idType = TYPE_INT32;
-    int32_t handle = 0;
-    for (int32_t row = 0; row < count; row++) {
-        resultSet->GoToRow(row);
-        handle = get<int32_t>(ResultSetUtils::GetValFromColumn(MEDIA_DATA_DB_ID, resultSet, idType));
-        MEDIA_INFO_LOG("GetPropList %{public}d",
-            get<int32_t>(ResultSetUtils::GetValFromColumn(MEDIA_DATA_DB_ID, resultSet, idType)));
-        GetOneRowPropList(static_cast<uint32_t>(handle), resultSet, properties, outProps);
+    int count = 0;
+    resultSet->GetRowCount(count);
+    int32_t idIndex = -1;
+    resultSet->GetColumnIndex(MEDIA_DATA_DB_ID, idIndex);
+    // column lookups are the same for every row, resolve them once for the whole set
+    vector<PropColumnIndex> propColumns;
+    GetPropColumnIndexes(resultSet, *properties, propColumns);
+    outProps->reserve(outProps->size() + static_cast<size_t>(max(count, 0)) * propColumns.size());
+    for (int32_t status = resultSet->GoToFirstRow(); status == NativeRdb::E_OK; status = resultSet->GoToNextRow()) {
+        int32_t handle = ResultSetUtils::GetIntValFromColumn(idIndex, resultSet);
+        GetOneRowPropList(static_cast<uint32_t>(handle), resultSet, propColumns, outProps);
     }
     return MTP_SUCCESS;
 }
@@ -353,26 +410,19 @@ void MtpDataUtils::GetFormatByPath(const std::string &path, uint16_t &outFormat)
 }
 
 int32_t MtpDataUtils::GetFormat(const shared_ptr<DataShare::DataShareResultSet> &resultSet,
-    uint16_t &outFormat)
+    const PropColumnIndex &propColumn, uint16_t &outFormat)
 {
-    int index, status, mediaType;
-    status = resultSet->GetColumnIndex(MEDIA_DATA_DB_MEDIA_TYPE, index);
-    if (status != NativeRdb::E_OK) {
-        MEDIA_ERR_LOG("GetColumnIndex failed");
+    int mediaType = MEDIA_TYPE_DEFAULT;
+    if (resultSet->GetInt(propColumn.index, mediaType) != NativeRdb::E_OK) {
+        MEDIA_ERR_LOG("GetInt failed");
         return E_FAIL;
     }
-    resultSet->GetInt(index, mediaType);
     if (mediaType == MEDIA_TYPE_ALBUM) {
         outFormat = MTP_FORMAT_ASSOCIATION_CODE;
         return E_SUCCESS;
     }
-    status = resultSet->GetColumnIndex(MEDIA_DATA_DB_FILE_PATH, index);
-    if (status != NativeRdb::E_OK) {
-        MEDIA_ERR_LOG("GetColumnIndex failed");
-        return E_FAIL;
-    }
     std::string pathVal;
-    status = resultSet->GetString(index, pathVal);
+    int status = resultSet->GetString(propColumn.pathIndex, pathVal);
     if (status != NativeRdb::E_OK) {
         MEDIA_ERR_LOG("GetString failed");
         return E_FAIL;
@@ -409,24 +459,23 @@ std::string Strftime(const std::string &format, time_t curTime)
     return szDTime;
 }
 
-void MtpDataUtils::SetProperty(const std::string &column, const shared_ptr<DataShare::DataShareResultSet> &resultSet,
-    ResultSetDataType &type, Property &prop)
+void MtpDataUtils::SetProperty(const PropColumnIndex &propColumn,
+    const shared_ptr<DataShare::DataShareResultSet> &resultSet, Property &prop)
 {
-    variant<int32_t, std::string, int64_t, double> columnValue =
-        ResultSetUtils::GetValFromColumn(column, resultSet, type);
-    switch (type) {
+    switch (propColumn.dataType) {
         case TYPE_STRING:
-            prop.currentValue->str_ = make_shared<std::string>(get<std::string>(columnValue));
+            prop.currentValue->str_ =
+                make_shared<std::string>(ResultSetUtils::GetStringValFromColumn(propColumn.index, resultSet));
             break;
         case TYPE_INT32:
-            prop.currentValue->bin_.i32 = get<int32_t>(columnValue);
+            prop.currentValue->bin_.i32 = ResultSetUtils::GetIntValFromColumn(propColumn.index, resultSet);
             break;
         case TYPE_INT64:
-            if (column.compare(MEDIA_DATA_DB_DATE_MODIFIED) == 0) {
-                prop.currentValue->str_ =
-                    make_shared<std::string>(MtpPacketTool::FormatDateTime(get<int64_t>(columnValue)));
+            if (propColumn.column.compare(MEDIA_DATA_DB_DATE_MODIFIED) == 0) {
+                prop.currentValue->str_ = make_shared<std::string>(
+                    MtpPacketTool::FormatDateTime(ResultSetUtils::GetLongValFromColumn(propColumn.index, resultSet)));
             } else {
-                prop.currentValue->bin_.i64 = get<int64_t>(columnValue);
+                prop.currentValue->bin_.i64 = ResultSetUtils::GetLongValFromColumn(propColumn.index, resultSet);
             }
             break;
         default:
@@ -435,29 +484,23 @@ void MtpDataUtils::SetProperty(const std::string &column, const shared_ptr<DataS
 }
 
 void MtpDataUtils::GetOneRowPropList(uint32_t handle, const shared_ptr<DataShare::DataShareResultSet> &resultSet,
-    const shared_ptr<UInt16List> &properties, shared_ptr<vector<Property>> &outProps)
+    const vector<PropColumnIndex> &propColumns, shared_ptr<vector<Property>> &outProps)
 {
-    std::string column;
-    ResultSetDataType type;
-    for (uint16_t property : *properties) {
-        if (PropColumnMap.find(property) != PropColumnMap.end()) {
-            auto properType = MtpPacketTool::GetObjectPropTypeByPropCode(property);
-            Property prop(property, properType);
-            prop.handle_ = handle;
-            column = PropColumnMap.at(property);
-            type = ColumnTypeMap.at(column);
-            if (column.compare(MEDIA_DATA_DB_FORMAT) == 0) {
-                uint16_t format = MTP_FORMAT_UNDEFINED_CODE;
-                GetFormat(resultSet, format);
-                prop.currentValue->bin_.ui16 = format;
-                MEDIA_INFO_LOG("prop.currentValue->bin_.ui16 %{public}u", format);
-            } else {
-                SetProperty(column, resultSet, type, prop);
-            }
-            outProps->push_back(prop);
-        } else if (PropDefaultMap.find(property) != PropDefaultMap.end()) {
-            SetOneDefaultlPropList(handle, property, outProps);
+    for (const PropColumnIndex &propColumn : propColumns) {
+        if (propColumn.column.empty()) {
+            SetOneDefaultlPropList(handle, propColumn.property, outProps);
+            continue;
+        }
+        Property prop(propColumn.property, propColumn.type);
+        prop.handle_ = handle;
+        if (propColumn.column.compare(MEDIA_DATA_DB_FORMAT) == 0) {
+            uint16_t format = MTP_FORMAT_UNDEFINED_CODE;
+            GetFormat(resultSet, propColumn, format);
+            prop.currentValue->bin_.ui16 = format;
+        } else {
+            SetProperty(propColumn, resultSet, prop);
         }
+        outProps->push_back(prop);
     }
 }
 
@@ -66,6 +66,7 @@ int MtpDriver::OpenDriver()
         MEDIA_ERR_LOG("MtpDriver::OpenDriver Start() failed error = %{public}d", ret);
         return ret;
     }
+    transferPipeline_ = std::make_unique<MtpTransferPipeline>(usbfnMtpInterface, transferConfig_);
     usbOpenFlag = true;
     return MTP_SUCCESS;
 }
@@ -113,6 +114,9 @@ void MtpDriver::Write(std::vector<uint8_t> &buffer, uint32_t &bufferSize)
 
 int MtpDriver::ReceiveObj(MtpFileRange &mfr)
 {
+    if ((transferPipeline_ != nullptr) && transferConfig_.usePipeline) {
+        return transferPipeline_->ReceiveFile(mfr);
+    }
     struct UsbFnMtpFileSlice mfs = {
         .fd = mfr.fd,
         .offset = mfr.offset,
@@ -125,6 +129,9 @@ int MtpDriver::ReceiveObj(MtpFileRange &mfr)
 
 int MtpDriver::SendObj(MtpFileRange &mfr)
 {
+    if ((transferPipeline_ != nullptr) && transferConfig_.usePipeline) {
+        return transferPipeline_->SendFile(mfr);
+    }
     struct UsbFnMtpFileSlice mfs = {
         .fd = mfr.fd,
         .offset = 0,
@@ -139,5 +146,18 @@ int MtpDriver::WriteEvent(EventMtp &em)
 {
     return usbfnMtpInterface->SendEvent(em.data);
 }
+
+void MtpDriver::SetTransferConfig(const MtpTransferConfig &config)
+{
+    transferConfig_ = config;
+    if (transferPipeline_ != nullptr) {
+        transferPipeline_->SetConfig(config);
+    }
+}
+
+MtpTransferStats MtpDriver::GetTransferStats()
+{
+    return (transferPipeline_ == nullptr) ? MtpTransferStats() : transferPipeline_->GetStats();
+}
 } // namespace Media
 } // namespace OHOS
\ No newline at end of file
@@ -19,6 +19,7 @@
 #include <sys/inotify.h>
 #include <unistd.h>
 #include "media_log.h"
+#include "mtp_medialibrary_manager.h"
 
 using namespace std;
 namespace OHOS {
@@ -35,6 +36,10 @@ void MtpFileObserver::SendEvent(const inotify_event &event, const std::string &p
 {
     string fileName;
     std::shared_ptr<MtpEvent> eventPtr = std::make_shared<OHOS::Media::MtpEvent>(context);
+    if (event.mask & (IN_CREATE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM | IN_CLOSE_WRITE)) {
+        // listings served to the host are stale once anything under the storage changes
+        MtpMedialibraryManager::GetInstance()->ClearPropListCache();
+    }
     if ((event.mask & IN_CREATE) || (event.mask & IN_MOVED_TO)) {
         fileName = path + "/" + event.name;
         MEDIA_DEBUG_LOG("MtpFileObserver AddInotifyEvents create/MOVED_TO: path:%{private}s", fileName.c_str());
@@ -15,6 +15,7 @@
 
 #include "mtp_medialibrary_manager.h"
 
+#include <sys/stat.h>
 #include <unistd.h>
 #include "datashare_predicates.h"
 #include "datashare_abs_result_set.h"
@@ -39,9 +40,14 @@ constexpr int32_t COMPRE_SIZE_LEVEL_1 = 256;
 constexpr int32_t COMPRE_SIZE_LEVEL_2 = 204800;
 const string THUMBNAIL_FORMAT = "image/jpeg";
 static constexpr uint8_t THUMBNAIL_MID = 90;
+constexpr int32_t HANDLES_QUERY_BATCH = 5000;
+constexpr size_t PROP_LIST_CACHE_MAX = 32;
 std::shared_ptr<MtpMedialibraryManager> MtpMedialibraryManager::instance_ = nullptr;
 std::mutex MtpMedialibraryManager::mutex_;
 shared_ptr<DataShare::DataShareHelper> MtpMedialibraryManager::dataShareHelper_ = nullptr;
+std::mutex MtpMedialibraryManager::propListMutex_;
+std::map<MtpMedialibraryManager::PropListCacheKey, shared_ptr<vector<Property>>>
+    MtpMedialibraryManager::propListCache_;
 MtpMedialibraryManager::MtpMedialibraryManager(void)
 {
 }
@@ -68,39 +74,54 @@ void MtpMedialibraryManager::Init(const sptr<IRemoteObject> &token)
     }
 }
 
-int32_t MtpMedialibraryManager::GetHandles(int32_t parentId, vector<int> &outHandles, MediaType mediaType)
+template <class Handle, class SetConditions>
+static int32_t QueryHandleIds(const shared_ptr<DataShare::DataShareHelper> &dataShareHelper,
+    const SetConditions &setConditions, vector<Handle> &outHandles)
 {
-    DataShare::DataSharePredicates predicates;
-    if (mediaType != MEDIA_TYPE_DEFAULT) {
-        predicates.EqualTo(MEDIA_DATA_DB_PARENT_ID, to_string(parentId));
-    } else {
-        predicates.EqualTo(MEDIA_DATA_DB_PARENT_ID, to_string(parentId))->And()->EqualTo(MEDIA_DATA_DB_MEDIA_TYPE,
-            to_string(mediaType));
-    }
-    if (dataShareHelper_ == nullptr) {
-        return MtpErrorUtils::SolveGetHandlesError(E_HAS_DB_ERROR);
-    }
+    // Only the id column is read, page on it so a huge folder never lands in one result set, and every page
+    // continues from the last id instead of an offset which sqlite would have to skip again.
     Uri uri(MEDIALIBRARY_DATA_URI);
-    vector<string> columns;
-    shared_ptr<DataShare::DataShareResultSet> resultSet = dataShareHelper_->Query(uri, predicates, columns);
-    if (resultSet == nullptr) {
-        return MtpErrorUtils::SolveGetHandlesError(E_NO_SUCH_FILE);
+    vector<string> columns = { MEDIA_DATA_DB_ID };
+    int32_t lastId = 0;
+    while (true) {
+        DataShare::DataSharePredicates predicates;
+        setConditions(predicates);
+        predicates.And()->GreaterThan(MEDIA_DATA_DB_ID, lastId);
+        predicates.OrderByAsc(MEDIA_DATA_DB_ID);
+        predicates.Limit(HANDLES_QUERY_BATCH, 0);
+        shared_ptr<DataShare::DataShareResultSet> resultSet = dataShareHelper->Query(uri, predicates, columns);
+        CHECK_AND_RETURN_RET_LOG(resultSet != nullptr, E_NO_SUCH_FILE, "fail to get handles");
+        int32_t rows = 0;
+        while (resultSet->GoToNextRow() == NativeRdb::E_OK) {
+            if (resultSet->GetInt(0, lastId) != NativeRdb::E_OK) {
+                MEDIA_ERR_LOG("fail to get handle of row %{public}d", rows);
+                resultSet->Close();
+                return E_HAS_DB_ERROR;
+            }
+            outHandles.push_back(static_cast<Handle>(lastId));
+            rows++;
+        }
+        resultSet->Close();
+        if (rows < HANDLES_QUERY_BATCH) {
+            return E_SUCCESS;
+        }
     }
-    auto count = 0;
-    auto ret = resultSet->GetRowCount(count);
-    if (ret != NativeRdb::E_OK) {
-        MEDIA_ERR_LOG("get rdbstore failed");
+}
+
+int32_t MtpMedialibraryManager::GetHandles(int32_t parentId, vector<int> &outHandles, MediaType mediaType)
+{
+    if (dataShareHelper_ == nullptr) {
         return MtpErrorUtils::SolveGetHandlesError(E_HAS_DB_ERROR);
-    } else if (count == 0) {
-        MEDIA_ERR_LOG("have no handles");
-        return MtpErrorUtils::SolveGetHandlesError(E_SUCCESS);
     }
-    unique_ptr<FetchResult<FileAsset>> fetchFileResult = make_unique<FetchResult<FileAsset>>(resultSet);
-    for (int32_t row = 0; row < count; row++) {
-        unique_ptr<FileAsset> fileAsset = fetchFileResult->GetObjectAtPosition(row);
-        outHandles.push_back(fileAsset->GetId());
-    }
-    return MtpErrorUtils::SolveGetHandlesError(E_SUCCESS);
+    auto setConditions = [parentId, mediaType](DataShare::DataSharePredicates &predicates) {
+        if (mediaType != MEDIA_TYPE_DEFAULT) {
+            predicates.EqualTo(MEDIA_DATA_DB_PARENT_ID, to_string(parentId));
+        } else {
+            predicates.EqualTo(MEDIA_DATA_DB_PARENT_ID, to_string(parentId))->And()->EqualTo(MEDIA_DATA_DB_MEDIA_TYPE,
+                to_string(mediaType));
+        }
+    };
+    return MtpErrorUtils::SolveGetHandlesError(QueryHandleIds(dataShareHelper_, setConditions, outHandles));
 }
 
 int32_t MtpMedialibraryManager::GetHandles(const shared_ptr<MtpOperationContext> &context,
@@ -108,50 +129,27 @@ int32_t MtpMedialibraryManager::GetHandles(const shared_ptr<MtpOperationContext>
 {
     string extension;
     MediaType mediaType;
-    CHECK_AND_RETURN_RET_LOG(context != nullptr,
-        MtpErrorUtils::SolveGetHandlesError(E_HAS_DB_ERROR), "context is nullptr");
+    CHECK_AND_RETURN_RET_LOG((context != nullptr) && (outHandles != nullptr),
+        MtpErrorUtils::SolveGetHandlesError(E_HAS_DB_ERROR), "context or outHandles is nullptr");
     CHECK_AND_RETURN_RET_LOG(dataShareHelper_ != nullptr,
         MtpErrorUtils::SolveGetHandlesError(E_HAS_DB_ERROR), "fail to get datasharehelper");
     int32_t errCode = MtpDataUtils::SolveHandlesFormatData(context->format, extension, mediaType);
     CHECK_AND_RETURN_RET_LOG(errCode == MTP_SUCCESS,
         MtpErrorUtils::SolveGetHandlesError(errCode), "fail to SolveHandlesFormatData");
-    DataShare::DataSharePredicates predicates;
-    string whereClause;
-    vector<string> whereArgs;
-    if (mediaType == MEDIA_TYPE_DEFAULT) {
-        whereClause = MEDIA_DATA_DB_PARENT_ID + " = ? AND " + MEDIA_DATA_DB_NAME + " Like ? AND " +
-            MEDIA_DATA_DB_DATE_TRASHED + " = 0 AND " + MEDIA_DATA_DB_MEDIA_TYPE + " != ?";
-        whereArgs = {to_string(context->parent), extension, to_string(MEDIA_TYPE_NOFILE)};
-    } else if (mediaType == MEDIA_TYPE_ALL) {
-        whereClause = MEDIA_DATA_DB_PARENT_ID + " = ? AND " + MEDIA_DATA_DB_DATE_TRASHED +
-            " = 0 AND " + MEDIA_DATA_DB_MEDIA_TYPE + " != ?" ;
-        whereArgs = {to_string(context->parent), to_string(MEDIA_TYPE_NOFILE)};
-    } else {
-        whereClause = MEDIA_DATA_DB_PARENT_ID + " = ? AND " + MEDIA_DATA_DB_MEDIA_TYPE + " = ? AND " +
-            MEDIA_DATA_DB_DATE_TRASHED + " = 0";
-        whereArgs = {to_string(context->parent), to_string(mediaType)};
-    }
-    predicates.SetWhereClause(whereClause);
-    predicates.SetWhereArgs(whereArgs);
-    Uri uri(MEDIALIBRARY_DATA_URI);
-    vector<string> columns;
-    shared_ptr<DataShare::DataShareResultSet> resultSet = dataShareHelper_->Query(uri, predicates, columns);
-    CHECK_AND_RETURN_RET_LOG(resultSet != nullptr,
-        MtpErrorUtils::SolveGetHandlesError(E_NO_SUCH_FILE), "fail to get handles");
-    unique_ptr<FetchResult<FileAsset>> fetchFileResult = make_unique<FetchResult<FileAsset>>(resultSet);
-    auto count = 0;
-    auto ret = resultSet->GetRowCount(count);
-    CHECK_AND_RETURN_RET_LOG(ret == NativeRdb::E_OK,
-        MtpErrorUtils::SolveGetHandlesError(E_HAS_DB_ERROR), "fail to get GetRowCount");
+    string parent = to_string(context->parent);
+    auto setConditions = [&parent, &extension, mediaType](DataShare::DataSharePredicates &predicates) {
+        predicates.EqualTo(MEDIA_DATA_DB_PARENT_ID, parent)->And()->EqualTo(MEDIA_DATA_DB_DATE_TRASHED, 0);
+        if (mediaType == MEDIA_TYPE_DEFAULT) {
+            predicates.And()->Like(MEDIA_DATA_DB_NAME, extension)->And()->NotEqualTo(MEDIA_DATA_DB_MEDIA_TYPE,
+                to_string(MEDIA_TYPE_NOFILE));
+        } else if (mediaType == MEDIA_TYPE_ALL) {
+            predicates.And()->NotEqualTo(MEDIA_DATA_DB_MEDIA_TYPE, to_string(MEDIA_TYPE_NOFILE));
+        } else {
+            predicates.And()->EqualTo(MEDIA_DATA_DB_MEDIA_TYPE, to_string(mediaType));
+        }
+    };
     // have no handles is not error(maybe it is really have no files)
-    CHECK_AND_RETURN_RET_LOG(count > 0,
-        MtpErrorUtils::SolveGetHandlesError(E_SUCCESS), "have no handles");
-    unique_ptr<FileAsset> fileAsset = fetchFileResult->GetFirstObject();
-    while (fileAsset != nullptr) {
-        outHandles->push_back(fileAsset->GetId());
-        fileAsset = fetchFileResult->GetNextObject();
-    }
-    return MtpErrorUtils::SolveGetHandlesError(E_SUCCESS);
+    return MtpErrorUtils::SolveGetHandlesError(QueryHandleIds(dataShareHelper_, setConditions, *outHandles));
 }
 
 int32_t MtpMedialibraryManager::GetObjectInfo(const shared_ptr<MtpOperationContext> &context,
@@ -267,25 +265,63 @@ bool MtpMedialibraryManager::CompressImage(std::unique_ptr<PixelMap> &pixelMap,
     return true;
 }
 
-int32_t MtpMedialibraryManager::GetThumb(const shared_ptr<MtpOperationContext> &context,
+static int32_t ReadThumb(int fd, UInt8List &outThumb)
+{
+    struct stat statInfo;
+    CHECK_AND_RETURN_RET_LOG(fstat(fd, &statInfo) == 0, MTP_ERROR_NO_THUMBNAIL_PRESENT,
+        "fail to stat thumbnail, errno: %{public}d", errno);
+    CHECK_AND_RETURN_RET_LOG(statInfo.st_size > 0, MTP_ERROR_NO_THUMBNAIL_PRESENT, "thumbnail is empty");
+    outThumb.resize(static_cast<size_t>(statInfo.st_size));
+    size_t offset = 0;
+    while (offset < outThumb.size()) {
+        ssize_t readSize = read(fd, outThumb.data() + offset, outThumb.size() - offset);
+        if (readSize <= 0) {
+            MEDIA_ERR_LOG("fail to read thumbnail, errno: %{public}d", errno);
+            outThumb.clear();
+            return MTP_ERROR_NO_THUMBNAIL_PRESENT;
+        }
+        offset += static_cast<size_t>(readSize);
+    }
+    return MTP_SUCCESS;
+}
+
+int32_t MtpMedialibraryManager::GetThumbFromService(const shared_ptr<FileAsset> &fileAsset,
+    shared_ptr<UInt8List> &outThumb)
+{
+    // the thumbnail service hands out the THUMB it keeps for the asset, and creates and saves it on a miss
+    string thumbUri = fileAsset->GetUri() + "?" + MEDIA_OPERN_KEYWORD + "=" + MEDIA_DATA_DB_THUMBNAIL + "&" +
+        MEDIA_DATA_DB_WIDTH + "=" + to_string(NORMAL_WIDTH) + "&" + MEDIA_DATA_DB_HEIGHT + "=" +
+        to_string(NORMAL_HEIGHT);
+    Uri uri(thumbUri);
+    int fd = dataShareHelper_->OpenFile(uri, MEDIA_FILEMODE_READONLY);
+    CHECK_AND_RETURN_RET_LOG(fd >= 0, MTP_ERROR_NO_THUMBNAIL_PRESENT,
+        "fail to open thumbnail of %{public}d, err: %{public}d", fileAsset->GetId(), fd);
+    int32_t errCode = ReadThumb(fd, *outThumb);
+    close(fd);
+    return errCode;
+}
+
+int32_t MtpMedialibraryManager::GetThumbFromOrigin(const shared_ptr<MtpOperationContext> &context,
     shared_ptr<UInt8List> &outThumb)
 {
-    CHECK_AND_RETURN_RET_LOG(context != nullptr, MTP_ERROR_STORE_NOT_AVAILABLE, "context is nullptr");
-    CHECK_AND_RETURN_RET_LOG(dataShareHelper_ != nullptr,
-        MTP_ERROR_STORE_NOT_AVAILABLE, "fail to get datasharehelper");
     int fd = 0;
-    GetFd(context, fd);
+    CHECK_AND_RETURN_RET_LOG(GetFd(context, fd) == MTP_SUCCESS, MTP_ERROR_NO_THUMBNAIL_PRESENT, "fail to open file");
     uint32_t errorCode = 0;
     SourceOptions opts;
     std::unique_ptr<ImageSource> imageSource = ImageSource::CreateImageSource(fd, opts, errorCode);
+    if (imageSource == nullptr) {
+        close(fd);
+        MEDIA_ERR_LOG("ImageSource is nullptr");
+        return MTP_ERROR_NO_THUMBNAIL_PRESENT;
+    }
     DecodeOptions decodeOpts;
     decodeOpts.desiredSize = {
         .width = NORMAL_WIDTH,
         .height = NORMAL_HEIGHT
     };
     std::unique_ptr<PixelMap> cropPixelMap = imageSource->CreatePixelMap(decodeOpts, errorCode);
-    CHECK_AND_RETURN_RET_LOG(cropPixelMap != nullptr, MTP_ERROR_NO_THUMBNAIL_PRESENT, "PixelMap is nullptr");
     close(fd);
+    CHECK_AND_RETURN_RET_LOG(cropPixelMap != nullptr, MTP_ERROR_NO_THUMBNAIL_PRESENT, "PixelMap is nullptr");
     Size size = {
         .width = NORMAL_WIDTH,
         .height = NORMAL_HEIGHT
@@ -294,6 +330,30 @@ int32_t MtpMedialibraryManager::GetThumb(const shared_ptr<MtpOperationContext> &
     return MTP_SUCCESS;
 }
 
+int32_t MtpMedialibraryManager::GetThumb(const shared_ptr<MtpOperationContext> &context,
+    shared_ptr<UInt8List> &outThumb)
+{
+    CHECK_AND_RETURN_RET_LOG((context != nullptr) && (outThumb != nullptr), MTP_ERROR_STORE_NOT_AVAILABLE,
+        "context or outThumb is nullptr");
+    CHECK_AND_RETURN_RET_LOG(dataShareHelper_ != nullptr,
+        MTP_ERROR_STORE_NOT_AVAILABLE, "fail to get datasharehelper");
+    shared_ptr<FileAsset> fileAsset;
+    int32_t errCode = GetAssetById(static_cast<int32_t>(context->handle), fileAsset);
+    CHECK_AND_RETURN_RET_LOG((errCode == E_SUCCESS) && (fileAsset != nullptr), MTP_ERROR_INVALID_OBJECTHANDLE,
+        "fail to get asset of handle %{public}u", context->handle);
+    MediaType mediaType = fileAsset->GetMediaType();
+    CHECK_AND_RETURN_RET_LOG((mediaType == MEDIA_TYPE_IMAGE) || (mediaType == MEDIA_TYPE_VIDEO),
+        MTP_ERROR_NO_THUMBNAIL_PRESENT, "media type %{public}d has no thumbnail", mediaType);
+    if (GetThumbFromService(fileAsset, outThumb) == MTP_SUCCESS) {
+        return MTP_SUCCESS;
+    }
+    if (mediaType != MEDIA_TYPE_IMAGE) {
+        return MTP_ERROR_NO_THUMBNAIL_PRESENT;
+    }
+    MEDIA_WARN_LOG("fail to get thumbnail from service, decode the image of %{public}u", context->handle);
+    return GetThumbFromOrigin(context, outThumb);
+}
+
 int32_t MtpMedialibraryManager::GetAssetById(const int32_t id, shared_ptr<FileAsset> &outFileAsset)
 {
     DataShare::DataSharePredicates predicates;
@@ -363,6 +423,7 @@ int32_t MtpMedialibraryManager::SendObjectInfo(const std::shared_ptr<MtpOperatio
     uint32_t &outStorageID, uint32_t &outParent, uint32_t &outHandle)
 {
     CHECK_AND_RETURN_RET_LOG(context != nullptr, MTP_ERROR_STORE_NOT_AVAILABLE, "context is nullptr");
+    ClearPropListCache();
     shared_ptr<FileAsset> fileAsset;
     int errCode = GetAssetById(context->parent, fileAsset);
     CHECK_AND_RETURN_RET_LOG(errCode == E_SUCCESS,
@@ -396,6 +457,7 @@ int32_t MtpMedialibraryManager::SendObjectInfo(const std::shared_ptr<MtpOperatio
 int32_t MtpMedialibraryManager::MoveObject(const std::shared_ptr<MtpOperationContext> &context)
 {
     CHECK_AND_RETURN_RET_LOG(context != nullptr, MTP_ERROR_STORE_NOT_AVAILABLE, "context is nullptr");
+    ClearPropListCache();
     DataShare::DataSharePredicates predicates;
     predicates.SetWhereClause(MEDIA_DATA_DB_ID + " = " + std::to_string(context->handle));
     DataShare::DataShareValuesBucket valuesBucket;
@@ -422,6 +484,7 @@ int32_t MtpMedialibraryManager::CopyObject(const std::shared_ptr<MtpOperationCon
     uint32_t &outObjectHandle)
 {
     CHECK_AND_RETURN_RET_LOG(context != nullptr, MTP_ERROR_INVALID_OBJECTHANDLE, "context is nullptr");
+    ClearPropListCache();
     DataShare::DataSharePredicates predicates;
     predicates.SetWhereClause(MEDIA_DATA_DB_ID + " = " + std::to_string(context->handle));
     shared_ptr<FileAsset> parentAsset;
@@ -442,6 +505,7 @@ int32_t MtpMedialibraryManager::CopyObject(const std::shared_ptr<MtpOperationCon
 int32_t MtpMedialibraryManager::DeleteObject(const std::shared_ptr<MtpOperationContext> &context)
 {
     CHECK_AND_RETURN_RET_LOG(context != nullptr, MTP_ERROR_STORE_NOT_AVAILABLE, "context is nullptr");
+    ClearPropListCache();
     DataShare::DataShareValuesBucket valuesBucket;
     valuesBucket.Put(SMARTALBUMMAP_DB_ALBUM_ID, TRASH_ALBUM_ID_VALUES);
     valuesBucket.Put(SMARTALBUMMAP_DB_CHILD_ASSET_ID, static_cast<int32_t>(context->handle));
@@ -454,6 +518,7 @@ int32_t MtpMedialibraryManager::DeleteObject(const std::shared_ptr<MtpOperationC
 int32_t MtpMedialibraryManager::SetObjectPropValue(const std::shared_ptr<MtpOperationContext> &context)
 {
     CHECK_AND_RETURN_RET_LOG(context != nullptr, MTP_ERROR_INVALID_OBJECTHANDLE, "context is nullptr");
+    ClearPropListCache();
     string colName;
     variant<int64_t, string> colValue;
     int32_t errCode = MtpDataUtils::SolveSetObjectPropValueData(context, colName, colValue);
@@ -498,6 +563,7 @@ int32_t MtpMedialibraryManager::SetObjectPropValue(const std::shared_ptr<MtpOper
 
 int32_t MtpMedialibraryManager::CloseFd(const shared_ptr<MtpOperationContext> &context, int32_t fd)
 {
+    ClearPropListCache();
     shared_ptr<FileAsset> fileAsset;
     int32_t errCode = GetAssetById(context->handle, fileAsset);
     CHECK_AND_RETURN_RET_LOG(errCode == E_SUCCESS,
@@ -531,39 +597,84 @@ int32_t MtpMedialibraryManager::GetObjectPropList(const std::shared_ptr<MtpOpera
         MEDIA_ERR_LOG("depth error");
         return MTP_ERROR_SPECIFICATION_BY_DEPTH_UNSUPPORTED;
     }
+    if (GetPropListFromCache(context, outProps)) {
+        return MTP_SUCCESS;
+    }
+    // only the columns behind the requested properties are read
+    vector<string> columns;
+    MtpDataUtils::GetPropColumns(context->property, context->format, columns);
     shared_ptr<DataShare::DataShareResultSet> resultSet;
     if (context->handle != 0) {
         // Add the requested object if format matches
         if (context->depth == 0) {
             if (context->handle == MTP_ALL_HANDLE_ID) {
                 // get root dirs children deep : all:success
-                resultSet = GetAllRootsChildren(context->format);
+                resultSet = GetAllRootsChildren(context->format, columns);
             } else {
                 // get handle:success
-                resultSet = GetHandle(context->format, context->handle);
+                resultSet = GetHandle(context->format, context->handle, columns);
             }
         }
         if (context->depth == 1) {
             if (context->handle == MTP_ALL_HANDLE_ID) {
                 // get root dirs children deep : 1:success
-                resultSet = GetRootsDepthChildren(context->format);
+                resultSet = GetRootsDepthChildren(context->format, columns);
             } else {
                 // get handle children and handle deep : 1
-                resultSet = GetHandleDepthChildren(context->format,  context->handle);
+                resultSet = GetHandleDepthChildren(context->format, context->handle, columns);
             }
         }
     } else {
         // get root dirs children deep : 1:success
-        resultSet = GetRootsDepthChildren(context->format);
+        resultSet = GetRootsDepthChildren(context->format, columns);
     }
     int count = 0;
     CHECK_AND_RETURN_RET_LOG(resultSet != nullptr, MTP_ERROR_INVALID_OBJECTHANDLE, "fail to getSet");
     resultSet->GetRowCount(count);
     CHECK_AND_RETURN_RET_LOG(count != 0, MTP_ERROR_INVALID_OBJECTHANDLE, "fail to get set count");
-    return MtpDataUtils::GetPropListBySet(context->property, context->format, resultSet, outProps);
+    int32_t errCode = MtpDataUtils::GetPropListBySet(context->property, context->format, resultSet, outProps);
+    if (errCode == MTP_SUCCESS) {
+        AddPropListToCache(context, outProps);
+    }
+    return errCode;
+}
+
+bool MtpMedialibraryManager::GetPropListFromCache(const shared_ptr<MtpOperationContext> &context,
+    shared_ptr<vector<Property>> &outProps)
+{
+    std::lock_guard<std::mutex> lock(propListMutex_);
+    auto iter = propListCache_.find(PropListCacheKey(context->handle, context->depth, context->format,
+        context->property));
+    if (iter == propListCache_.end()) {
+        return false;
+    }
+    // cached lists are only read by the packet makers, so the same list is handed out again
+    outProps = iter->second;
+    return true;
+}
+
+void MtpMedialibraryManager::AddPropListToCache(const shared_ptr<MtpOperationContext> &context,
+    const shared_ptr<vector<Property>> &props)
+{
+    // folder listings are asked for again and again while the host browses, single objects are not
+    if ((context->depth == 0) && (context->handle != MTP_ALL_HANDLE_ID)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(propListMutex_);
+    if (propListCache_.size() >= PROP_LIST_CACHE_MAX) {
+        propListCache_.clear();
+    }
+    propListCache_[PropListCacheKey(context->handle, context->depth, context->format, context->property)] = props;
+}
+
+void MtpMedialibraryManager::ClearPropListCache()
+{
+    std::lock_guard<std::mutex> lock(propListMutex_);
+    propListCache_.clear();
 }
 
-shared_ptr<DataShare::DataShareResultSet> MtpMedialibraryManager::GetAllRootsChildren(const uint16_t format)
+shared_ptr<DataShare::DataShareResultSet> MtpMedialibraryManager::GetAllRootsChildren(const uint16_t format,
+    const vector<string> &columns)
 {
     DataShare::DataSharePredicates predicates;
     MediaType mediaType;
@@ -580,12 +691,11 @@ shared_ptr<DataShare::DataShareResultSet> MtpMedialibraryManager::GetAllRootsChi
     predicates.SetWhereClause(whereClause);
     predicates.SetWhereArgs(whereArgs);
     Uri uri(MEDIALIBRARY_DATA_URI);
-    vector<string> columns;
     return dataShareHelper_->Query(uri, predicates, columns);
 }
 
 shared_ptr<DataShare::DataShareResultSet> MtpMedialibraryManager::GetHandle(const uint16_t format,
-    const uint32_t handle)
+    const uint32_t handle, const vector<string> &columns)
 {
     DataShare::DataSharePredicates predicates;
     MediaType mediaType;
@@ -603,7 +713,6 @@ shared_ptr<DataShare::DataShareResultSet> MtpMedialibraryManager::GetHandle(cons
     predicates.SetWhereClause(whereClause);
     predicates.SetWhereArgs(whereArgs);
     Uri uri(MEDIALIBRARY_DATA_URI);
-    vector<string> columns;
     return dataShareHelper_->Query(uri, predicates, columns);
 }
 
@@ -616,49 +725,51 @@ int32_t MtpMedialibraryManager::GetRootIdList(std::vector<string> &outRootIdList
     predicates.SetWhereClause(whereClause);
     predicates.SetWhereArgs(whereArgs);
     Uri uri(MEDIALIBRARY_DATA_URI);
-    vector<string> columns;
+    vector<string> columns = { MEDIA_DATA_DB_ID };
     shared_ptr<DataShare::DataShareResultSet> resultSet = dataShareHelper_->Query(uri, predicates, columns);
+    CHECK_AND_RETURN_RET_LOG(resultSet != nullptr, E_NO_SUCH_FILE, "fail to get root ids");
     auto count = 0;
     auto ret = resultSet->GetRowCount(count);
     if (ret != NativeRdb::E_OK || count == 0) {
         MEDIA_ERR_LOG("have no file");
         return E_NO_SUCH_FILE;
     }
-    unique_ptr<FetchResult<FileAsset>> fetchFileResult = make_unique<FetchResult<FileAsset>>(resultSet);
-    for (int32_t row = 0; row < count; row++) {
-        unique_ptr<FileAsset> fileAsset = fetchFileResult->GetObjectAtPosition(row);
-        outRootIdList.push_back(to_string(fileAsset->GetId()));
+    outRootIdList.reserve(outRootIdList.size() + count);
+    while (resultSet->GoToNextRow() == NativeRdb::E_OK) {
+        outRootIdList.push_back(to_string(ResultSetUtils::GetIntValFromColumn(0, resultSet)));
     }
     return E_SUCCESS;
 }
 
-shared_ptr<DataShare::DataShareResultSet> MtpMedialibraryManager::GetRootsDepthChildren(const uint16_t format)
+shared_ptr<DataShare::DataShareResultSet> MtpMedialibraryManager::GetRootsDepthChildren(const uint16_t format,
+    const vector<string> &columns)
 {
-    vector<string> rootIdList;
-    int errCode = GetRootIdList(rootIdList);
+    vector<string> whereArgs;
+    int errCode = GetRootIdList(whereArgs);
     CHECK_AND_RETURN_RET_LOG(errCode == E_SUCCESS, nullptr, "fail to GetRootIdList");
-    string whereClause;
-    for (size_t row = 0; row < rootIdList.size(); row++) {
-        if (row == 0) {
-            whereClause = MEDIA_DATA_DB_PARENT_ID + " = ?";
-        } else {
-            whereClause = whereClause + " OR " + MEDIA_DATA_DB_PARENT_ID + " = ?";
-        }
-    }
-    whereClause = whereClause + " AND " + MEDIA_DATA_DB_MEDIA_TYPE + " = ?";
+    // children of all roots in one set, the filters apply to every parent. Trashed files are left out as in the
+    // other listings, the host would otherwise see them in the roots but not when it opens a folder
+    string whereClause = MEDIA_DATA_DB_PARENT_ID + " IN (?";
+    for (size_t row = 1; row < whereArgs.size(); row++) {
+        whereClause += ", ?";
+    }
+    whereClause += ") AND " + MEDIA_DATA_DB_DATE_TRASHED + " = ?";
+    whereArgs.push_back(to_string(0));
     MediaType mediaType;
     MtpDataUtils::GetMediaTypeByformat(format, mediaType);
-    rootIdList.push_back(to_string(mediaType));
+    if (mediaType != MEDIA_TYPE_ALL) {
+        whereClause += " AND " + MEDIA_DATA_DB_MEDIA_TYPE + " = ?";
+        whereArgs.push_back(to_string(mediaType));
+    }
     DataShare::DataSharePredicates predicates;
     predicates.SetWhereClause(whereClause);
-    predicates.SetWhereArgs(rootIdList);
+    predicates.SetWhereArgs(whereArgs);
     Uri uri(MEDIALIBRARY_DATA_URI);
-    vector<string> columns;
     return dataShareHelper_->Query(uri, predicates, columns);
 }
 
 shared_ptr<DataShare::DataShareResultSet> MtpMedialibraryManager::GetHandleDepthChildren(const uint16_t format,
-    const uint32_t handle)
+    const uint32_t handle, const vector<string> &columns)
 {
     DataShare::DataSharePredicates predicates;
     MediaType mediaType;
@@ -677,7 +788,6 @@ shared_ptr<DataShare::DataShareResultSet> MtpMedialibraryManager::GetHandleDepth
     predicates.SetWhereClause(whereClause);
     predicates.SetWhereArgs(whereArgs);
     Uri uri(MEDIALIBRARY_DATA_URI);
-    vector<string> columns;
     return dataShareHelper_->Query(uri, predicates, columns);
 }
 
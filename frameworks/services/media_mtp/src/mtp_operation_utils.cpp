@@ -606,6 +606,7 @@ uint16_t MtpOperationUtils::GetOpenSession(shared_ptr<PayloadData> &data, int er
     }
     if (respCode == MTP_OK_CODE) {
         context_->sessionOpen = true;
+        mtpMedialibraryManager_->ClearPropListCache();
     }
     data = openSessionData;
     return respCode;
@@ -656,6 +657,7 @@ uint16_t MtpOperationUtils::CheckErrorCode(int errorCode)
 uint16_t MtpOperationUtils::GetCloseSession(shared_ptr<PayloadData> &data)
 {
     data = make_shared<CloseSessionData>(context_);
+    mtpMedialibraryManager_->ClearPropListCache();
     return MTP_OK_CODE;
 }
 
@@ -21,6 +21,7 @@ using namespace std;
 namespace OHOS {
 namespace Media {
 const int EVENT_LENGTH = 16;
+const uint32_t MAX_WRITE_BUFFER_RESERVE = 64 * 1024 * 1024;
 MtpPacket::MtpPacket(std::shared_ptr<MtpOperationContext> &context)
     : context_(context), readSize_(0), headerData_(nullptr), payloadData_(nullptr)
 {
@@ -149,6 +150,10 @@ int MtpPacket::Maker(bool isPayload)
 {
     writeSize_ = payloadData_->CalculateSize() + PACKET_HEADER_LENGETH;
     headerData_->SetContainerLength(writeSize_);
+    // CalculateSize hands back a negative error code when the payload can not be made
+    if (writeSize_ <= MAX_WRITE_BUFFER_RESERVE) {
+        writeBuffer_.reserve(writeSize_);
+    }
 
     int errorCode = MakeHead();
     if (errorCode != MTP_SUCCESS) {
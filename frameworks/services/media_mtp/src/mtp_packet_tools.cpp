@@ -13,11 +13,9 @@
  * limitations under the License.
  */
 #include "mtp_packet_tools.h"
-#include <codecvt>
 #include <cctype>
 #include <cinttypes>
 #include <cstdlib>
-#include <locale>
 #include "media_log.h"
 #include "mtp_packet.h"
 #include "securec.h"
@@ -38,8 +36,29 @@ namespace {
     static const int INDENT_SIZE = INDENT_BLANKSTR.length();
     static const std::string DATE_TIME_INIT = "19700101T080000";
     static const std::string UNKNOWN_STR = "Unknown";
-    static const char *UTF16_CERROR = "__CONVERSION_ERROR__";
-    static const char16_t *UTF8_CERROR = u"__CONVERSION_ERROR__";
+    static const uint8_t UTF8_CONTINUATION = 0x80;
+    static const uint8_t UTF8_CONTINUATION_MASK = 0xC0;
+    static const uint8_t UTF8_PAYLOAD_MASK = 0x3F;
+    static const int UTF8_PAYLOAD_BITS = 6;
+    static const uint8_t UTF8_2_BYTES_LEAD = 0xC0;
+    static const uint8_t UTF8_MIN_2_BYTES_LEAD = 0xC2;
+    static const uint8_t UTF8_3_BYTES_LEAD = 0xE0;
+    static const uint8_t UTF8_4_BYTES_LEAD = 0xF0;
+    static const uint8_t UTF8_MAX_LEAD = 0xF4;
+    static const size_t UTF8_2_BYTES = 2;
+    static const size_t UTF8_3_BYTES = 3;
+    static const size_t UTF8_4_BYTES = 4;
+    static const char32_t UTF8_MIN_3_BYTES = 0x800;
+    static const char32_t UTF8_MIN_4_BYTES = 0x10000;
+    static const char32_t UTF16_MAX_SINGLE = 0xFFFF;
+    static const char32_t UTF16_HIGH_SURROGATE = 0xD800;
+    static const char32_t UTF16_LOW_SURROGATE = 0xDC00;
+    static const char32_t UTF16_LOW_SURROGATE_END = 0xDFFF;
+    static const char32_t UTF16_SUPPLEMENTARY_BASE = 0x10000;
+    static const char32_t UTF16_SURROGATE_MASK = 0x3FF;
+    static const int UTF16_SURROGATE_BITS = 10;
+    static const int UTF16_PAIR = 2;
+    static const char32_t UNICODE_MAX = 0x10FFFF;
     static const std::map<uint32_t, std::string> AssociationMap = {
         { MTP_ASSOCIATION_TYPE_UNDEFINED_CODE, "MTP_ASSOCIATION_TYPE_UNDEFINED" },
         { MTP_ASSOCIATION_TYPE_GENERIC_FOLDER_CODE, "MTP_ASSOCIATION_TYPE_GENERIC_FOLDER" },
@@ -428,6 +447,14 @@ uint32_t MtpPacketTool::GetUInt32(uint8_t numFirst, uint8_t numSecond, uint8_t n
         (uint32_t)numFirst;
 }
 
+// grows the buffer at most once for size more bytes, and keeps the growth geometric across calls
+static inline void ReserveAppend(std::vector<uint8_t> &outBuffer, size_t size)
+{
+    if (outBuffer.capacity() - outBuffer.size() < size) {
+        outBuffer.reserve(std::max(outBuffer.size() + size, outBuffer.capacity() * 2));
+    }
+}
+
 void MtpPacketTool::PutUInt8(std::vector<uint8_t> &outBuffer, uint16_t value)
 {
     outBuffer.push_back((uint8_t)(value & 0xFF));
@@ -475,6 +502,7 @@ void MtpPacketTool::PutUInt128(std::vector<uint8_t> &outBuffer, const uint128_t
 
 void MtpPacketTool::PutAUInt16(std::vector<uint8_t> &outBuffer, const uint16_t *values, int count)
 {
+    ReserveAppend(outBuffer, sizeof(uint32_t) + sizeof(uint16_t) * std::max(count, 0));
     PutUInt32(outBuffer, count);
     for (int i = 0; i < count; i++) {
         PutUInt16(outBuffer, *values++);
@@ -483,6 +511,7 @@ void MtpPacketTool::PutAUInt16(std::vector<uint8_t> &outBuffer, const uint16_t *
 
 void MtpPacketTool::PutAUInt32(std::vector<uint8_t> &outBuffer, const uint32_t *values, int count)
 {
+    ReserveAppend(outBuffer, sizeof(uint32_t) + sizeof(uint32_t) * std::max(count, 0));
     PutUInt32(outBuffer, count);
     for (int i = 0; i < count; i++) {
         PutUInt32(outBuffer, *values++);
@@ -523,48 +552,172 @@ void MtpPacketTool::PutInt128(std::vector<uint8_t> &outBuffer, const int128_t va
     PutUInt32(outBuffer, static_cast<uint32_t>(value[OFFSET_3]));
 }
 
+/*
+ * Decodes the code point at pos and moves pos behind it, returns false on a malformed, overlong or surrogate
+ * sequence, like codecvt_utf8_utf16 did.
+ */
+static bool DecodeUtf8(const std::string &str, size_t &pos, char32_t &codePoint)
+{
+    auto byteAt = [&str](size_t i) { return static_cast<uint8_t>(str[i]); };
+    uint8_t lead = byteAt(pos);
+    if (lead < UTF8_2_BYTES_LEAD) {
+        codePoint = lead;
+        pos++;
+        return lead < UTF8_CONTINUATION;
+    }
+    size_t length = (lead < UTF8_3_BYTES_LEAD) ? UTF8_2_BYTES : ((lead < UTF8_4_BYTES_LEAD) ? UTF8_3_BYTES :
+        UTF8_4_BYTES);
+    if ((lead < UTF8_MIN_2_BYTES_LEAD) || (lead > UTF8_MAX_LEAD) || (pos + length > str.size())) {
+        return false;
+    }
+    codePoint = lead & (UTF8_PAYLOAD_MASK >> (length - 1));
+    for (size_t i = 1; i < length; i++) {
+        uint8_t next = byteAt(pos + i);
+        if ((next & UTF8_CONTINUATION_MASK) != UTF8_CONTINUATION) {
+            return false;
+        }
+        codePoint = (codePoint << UTF8_PAYLOAD_BITS) | (next & UTF8_PAYLOAD_MASK);
+    }
+    pos += length;
+    bool overlong = ((length == UTF8_3_BYTES) && (codePoint < UTF8_MIN_3_BYTES)) ||
+        ((length == UTF8_4_BYTES) && (codePoint < UTF8_MIN_4_BYTES));
+    bool surrogate = (codePoint >= UTF16_HIGH_SURROGATE) && (codePoint <= UTF16_LOW_SURROGATE_END);
+    return !overlong && !surrogate && (codePoint <= UNICODE_MAX);
+}
+
+// returns the number of utf-16 units of the utf-8 string, or -1 when it is malformed
+static int64_t GetUtf16Length(const std::string &str)
+{
+    int64_t length = 0;
+    size_t pos = 0;
+    char32_t codePoint = 0;
+    while (pos < str.size()) {
+        if (static_cast<uint8_t>(str[pos]) < UTF8_CONTINUATION) {
+            pos++;
+            length++;
+            continue;
+        }
+        if (!DecodeUtf8(str, pos, codePoint)) {
+            return -1;
+        }
+        length += (codePoint > UTF16_MAX_SINGLE) ? UTF16_PAIR : 1;
+    }
+    return length;
+}
+
+// calls putUnit with each utf-16 unit of the well formed utf-8 string, until it returns false
+template<typename PutUnit>
+static void ForEachUtf16Unit(const std::string &str, PutUnit putUnit)
+{
+    size_t pos = 0;
+    char32_t codePoint = 0;
+    while (pos < str.size()) {
+        uint8_t lead = static_cast<uint8_t>(str[pos]);
+        if (lead < UTF8_CONTINUATION) {
+            pos++;
+            if (!putUnit(static_cast<char16_t>(lead))) {
+                return;
+            }
+            continue;
+        }
+        if (!DecodeUtf8(str, pos, codePoint)) {
+            return;
+        }
+        if (codePoint <= UTF16_MAX_SINGLE) {
+            if (!putUnit(static_cast<char16_t>(codePoint))) {
+                return;
+            }
+            continue;
+        }
+        codePoint -= UTF16_SUPPLEMENTARY_BASE;
+        if (!putUnit(static_cast<char16_t>(UTF16_HIGH_SURROGATE + (codePoint >> UTF16_SURROGATE_BITS))) ||
+            !putUnit(static_cast<char16_t>(UTF16_LOW_SURROGATE + (codePoint & UTF16_SURROGATE_MASK)))) {
+            return;
+        }
+    }
+}
+
 void MtpPacketTool::PutString(std::vector<uint8_t> &outBuffer, const std::string &string)
 {
-    std::u16string src16 = Utf8ToUtf16(string);
-
-    uint16_t count = src16.length();
-    if (count == 0) {
+    int64_t count = GetUtf16Length(string);
+    if (count <= 0) {
         PutUInt8(outBuffer, 0);
         return;
     }
-    PutUInt8(outBuffer, std::min(count + 1, MAX_LENGTH));
+    int64_t written = std::min<int64_t>(count, MAX_LENGTH - 1);
+    PutUInt8(outBuffer, static_cast<uint16_t>(written + 1));
 
-    int i = 0;
-    for (char16_t &c : src16) {
-        if (i == MAX_LENGTH - 1) {
-            break;
+    int64_t i = 0;
+    ForEachUtf16Unit(string, [&outBuffer, &i, written](char16_t unit) {
+        if (i == written) {
+            return false;
         }
-        PutUInt16(outBuffer, c);
+        PutUInt16(outBuffer, unit);
         i++;
-    }
+        return true;
+    });
     PutUInt16(outBuffer, 0);
 }
 
-std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t> gConvert(UTF16_CERROR, UTF8_CERROR);
+uint32_t MtpPacketTool::GetStringSize(const std::string &string)
+{
+    int64_t count = GetUtf16Length(string);
+    if (count <= 0) {
+        return sizeof(uint8_t);
+    }
+    return sizeof(uint8_t) + static_cast<uint32_t>(std::min<int64_t>(count + 1, MAX_LENGTH)) * sizeof(uint16_t);
+}
 
 std::u16string MtpPacketTool::Utf8ToUtf16(const std::string &inputStr)
 {
-    std::u16string conversion = gConvert.from_bytes(inputStr);
-    if (conversion == UTF8_CERROR) {
-        return u"";
-    } else {
+    std::u16string conversion;
+    int64_t count = GetUtf16Length(inputStr);
+    if (count <= 0) {
         return conversion;
     }
+    conversion.reserve(static_cast<size_t>(count));
+    ForEachUtf16Unit(inputStr, [&conversion](char16_t unit) {
+        conversion.push_back(unit);
+        return true;
+    });
+    return conversion;
 }
 
 std::string MtpPacketTool::Utf16ToUtf8(const std::u16string &inputStr)
 {
-    std::string conversion = gConvert.to_bytes(inputStr);
-    if (conversion == UTF16_CERROR) {
-        return "";
-    } else {
-        return conversion;
+    std::string conversion;
+    conversion.reserve(inputStr.size());
+    for (size_t i = 0; i < inputStr.size(); i++) {
+        char32_t codePoint = inputStr[i];
+        if ((codePoint >= UTF16_HIGH_SURROGATE) && (codePoint <= UTF16_LOW_SURROGATE_END)) {
+            // a low surrogate must follow a high one
+            if ((codePoint >= UTF16_LOW_SURROGATE) || (i + 1 == inputStr.size()) ||
+                (inputStr[i + 1] < UTF16_LOW_SURROGATE) || (inputStr[i + 1] > UTF16_LOW_SURROGATE_END)) {
+                return "";
+            }
+            codePoint = UTF16_SUPPLEMENTARY_BASE + ((codePoint - UTF16_HIGH_SURROGATE) << UTF16_SURROGATE_BITS) +
+                (inputStr[++i] - UTF16_LOW_SURROGATE);
+        }
+        if (codePoint < UTF8_CONTINUATION) {
+            conversion.push_back(static_cast<char>(codePoint));
+        } else if (codePoint < UTF8_MIN_3_BYTES) {
+            conversion.push_back(static_cast<char>(UTF8_2_BYTES_LEAD | (codePoint >> UTF8_PAYLOAD_BITS)));
+            conversion.push_back(static_cast<char>(UTF8_CONTINUATION | (codePoint & UTF8_PAYLOAD_MASK)));
+        } else if (codePoint < UTF8_MIN_4_BYTES) {
+            conversion.push_back(static_cast<char>(UTF8_3_BYTES_LEAD | (codePoint >> (UTF8_PAYLOAD_BITS * 2))));
+            conversion.push_back(static_cast<char>(UTF8_CONTINUATION |
+                ((codePoint >> UTF8_PAYLOAD_BITS) & UTF8_PAYLOAD_MASK)));
+            conversion.push_back(static_cast<char>(UTF8_CONTINUATION | (codePoint & UTF8_PAYLOAD_MASK)));
+        } else {
+            conversion.push_back(static_cast<char>(UTF8_4_BYTES_LEAD | (codePoint >> (UTF8_PAYLOAD_BITS * 3))));
+            conversion.push_back(static_cast<char>(UTF8_CONTINUATION |
+                ((codePoint >> (UTF8_PAYLOAD_BITS * 2)) & UTF8_PAYLOAD_MASK)));
+            conversion.push_back(static_cast<char>(UTF8_CONTINUATION |
+                ((codePoint >> UTF8_PAYLOAD_BITS) & UTF8_PAYLOAD_MASK)));
+            conversion.push_back(static_cast<char>(UTF8_CONTINUATION | (codePoint & UTF8_PAYLOAD_MASK)));
+        }
     }
+    return conversion;
 }
 
 uint8_t MtpPacketTool::GetUInt8(const std::vector<uint8_t> &buffer, size_t &offset)
@@ -744,14 +897,17 @@ std::string MtpPacketTool::GetString(const std::vector<uint8_t> &buffer, size_t
     if (count < 1) {
         return std::string();
     }
-    std::vector<char16_t> tmpbuf(count);
-    uint16_t ch = 0;
+    std::u16string str16;
+    str16.reserve(count);
+    bool terminated = false;
     for (int i = 0; i < count; i++) {
-        ch = GetUInt16(buffer, offset);
-        tmpbuf[i] = ch;
+        uint16_t ch = GetUInt16(buffer, offset);
+        terminated = terminated || (ch == 0);
+        if (!terminated) {
+            str16.push_back(ch);
+        }
     }
-    std::string String = Utf16ToUtf8(std::u16string(tmpbuf.data()));
-    return String;
+    return Utf16ToUtf8(str16);
 }
 
 bool MtpPacketTool::GetString(const std::vector<uint8_t> &buffer, size_t &offset, std::string &str)
@@ -766,16 +922,21 @@ bool MtpPacketTool::GetString(const std::vector<uint8_t> &buffer, size_t &offset
         return true;
     }
 
-    std::vector<char16_t> tmpbuf(count);
+    std::u16string str16;
+    str16.reserve(count);
+    bool terminated = false;
     uint16_t ch = 0;
     for (int i = 0; ((i < count) && ((offset + sizeof(uint16_t) - 1) < buffer.size())); i++) {
         if (!GetUInt16(buffer, offset, ch)) {
             return false;
         }
-        tmpbuf[i] = ch;
+        terminated = terminated || (ch == 0);
+        if (!terminated) {
+            str16.push_back(ch);
+        }
     }
 
-    str = Utf16ToUtf8(std::u16string(tmpbuf.data()));
+    str = Utf16ToUtf8(str16);
     return true;
 }
 
@@ -970,6 +1131,10 @@ std::string MtpPacketTool::GetIndentBlank(size_t indent)
 
 void MtpPacketTool::Dump(const std::vector<uint8_t> &data, uint32_t offset, uint32_t sum)
 {
+    // the dump is formatted a byte at a time, skip it unless the debug log is going to show it
+    if (!HiLogIsLoggable(LOG_DOMAIN, LOG_TAG, LOG_DEBUG)) {
+        return;
+    }
     std::unique_ptr<char[]> hexBuf = std::make_unique<char[]>(DUMP_HEXBUF_MAX);
     std::unique_ptr<char[]> txtBuf = std::make_unique<char[]>(DUMP_TXTBUF_MAX);
     if (!DumpClear(offset, hexBuf, DUMP_HEXBUF_MAX, txtBuf, DUMP_TXTBUF_MAX)) {
@@ -0,0 +1,404 @@
+/*
+ * Copyright (C) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mtp_transfer_pipeline.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <condition_variable>
+#include <deque>
+#include <dirent.h>
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+#include "media_log.h"
+#include "media_mtp_utils.h"
+#include "mtp_packet_tools.h"
+
+using namespace std;
+using namespace OHOS::HDI::Usb::Gadget::Mtp::V1_0;
+namespace OHOS {
+namespace Media {
+constexpr uint32_t MIN_CHUNK_SIZE = READ_BUFFER_MAX_SIZE;
+// every chunk crosses the hdi ipc in one parcel, which has to fit the 1 MiB binder buffer with room to spare
+constexpr uint32_t MAX_CHUNK_SIZE = 512 * 1024;
+constexpr uint32_t MIN_BUFFER_COUNT = 2;
+constexpr uint32_t MAX_BUFFER_COUNT = 8;
+constexpr uint64_t MAX_CONTAINER_LENGTH = 0xFFFFFFFF;
+constexpr uint64_t US_PER_SECOND = 1000000;
+const string UDC_CLASS_DIR = "/sys/class/udc/";
+const string UDC_SPEED_FILE = "/current_speed";
+// bulk endpoint max packet size of each usb speed, as the device controller reports the speed
+const vector<pair<string, uint32_t>> UDC_SPEED_PACKET_SIZES = {
+    { "super-speed-plus", 1024 },
+    { "super-speed", 1024 },
+    { "high-speed", 512 },
+    { "full-speed", 64 },
+};
+constexpr uint32_t DEFAULT_MAX_PACKET_SIZE = 512;
+
+static uint64_t GetElapsedUs(const chrono::steady_clock::time_point &start)
+{
+    return static_cast<uint64_t>(
+        chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count());
+}
+
+uint64_t MtpTransferStats::GetBytesPerSecond() const
+{
+    return (elapsedUs == 0) ? 0 : bytes * US_PER_SECOND / elapsedUs;
+}
+
+MtpTransferPipeline::MtpTransferPipeline(const sptr<IUsbfnMtpInterface> &usbfnMtpInterface,
+    const MtpTransferConfig &config) : usbfnMtpInterface_(usbfnMtpInterface)
+{
+    SetConfig(config);
+}
+
+MtpTransferPipeline::~MtpTransferPipeline()
+{
+    {
+        lock_guard<mutex> lock(workerMutex_);
+        isWorkerExit_ = true;
+    }
+    workerCv_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+void MtpTransferPipeline::SetConfig(const MtpTransferConfig &config)
+{
+    lock_guard<mutex> lock(mutex_);
+    config_ = config;
+    config_.chunkSize = clamp(config_.chunkSize, MIN_CHUNK_SIZE, MAX_CHUNK_SIZE);
+    config_.bufferCount = clamp(config_.bufferCount, MIN_BUFFER_COUNT, MAX_BUFFER_COUNT);
+    // the speed is read once per pipeline, which the driver creates when it opens
+    if (config_.maxPacketSize == 0) {
+        if (udcMaxPacketSize_ == 0) {
+            udcMaxPacketSize_ = GetUdcMaxPacketSize();
+        }
+        config_.maxPacketSize = udcMaxPacketSize_;
+    }
+}
+
+MtpTransferConfig MtpTransferPipeline::GetConfig()
+{
+    lock_guard<mutex> lock(mutex_);
+    return config_;
+}
+
+MtpTransferStats MtpTransferPipeline::GetStats()
+{
+    lock_guard<mutex> lock(mutex_);
+    return stats_;
+}
+
+void MtpTransferPipeline::ResetStats()
+{
+    lock_guard<mutex> lock(mutex_);
+    stats_ = MtpTransferStats();
+}
+
+uint32_t MtpTransferPipeline::GetUdcMaxPacketSize()
+{
+    DIR *dir = opendir(UDC_CLASS_DIR.c_str());
+    CHECK_AND_RETURN_RET_LOG(dir != nullptr, DEFAULT_MAX_PACKET_SIZE, "open udc dir error = %{public}d", errno);
+    string speed;
+    for (struct dirent *entry = readdir(dir); entry != nullptr; entry = readdir(dir)) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        ifstream speedFile(UDC_CLASS_DIR + entry->d_name + UDC_SPEED_FILE);
+        if ((speedFile >> speed) && (speed != "UNKNOWN")) {
+            break;
+        }
+        speed.clear();
+    }
+    closedir(dir);
+    for (const auto &[name, packetSize] : UDC_SPEED_PACKET_SIZES) {
+        if (speed == name) {
+            return packetSize;
+        }
+    }
+    MEDIA_WARN_LOG("unknown usb speed %{public}s, take high speed packets", speed.c_str());
+    return DEFAULT_MAX_PACKET_SIZE;
+}
+
+void MtpTransferPipeline::AddStats(uint64_t bytes, uint64_t usbTimeUs, uint64_t fileTimeUs, uint64_t elapsedUs)
+{
+    lock_guard<mutex> lock(mutex_);
+    stats_.transfers++;
+    stats_.bytes += bytes;
+    stats_.usbTimeUs += usbTimeUs;
+    stats_.fileTimeUs += fileTimeUs;
+    stats_.elapsedUs += elapsedUs;
+}
+
+void MtpTransferPipeline::Work()
+{
+    while (true) {
+        function<void()> job;
+        {
+            unique_lock<mutex> lock(workerMutex_);
+            workerCv_.wait(lock, [this]() { return isWorkerExit_ || job_; });
+            if (!job_) {
+                return;
+            }
+            job = job_;
+        }
+        job();
+        {
+            lock_guard<mutex> lock(workerMutex_);
+            job_ = nullptr;
+        }
+        workerCv_.notify_all();
+    }
+}
+
+void MtpTransferPipeline::StartJob(const function<void()> &job)
+{
+    {
+        unique_lock<mutex> lock(workerMutex_);
+        workerCv_.wait(lock, [this]() { return !job_; });
+        job_ = job;
+        if (!worker_.joinable()) {
+            worker_ = thread([this]() { Work(); });
+        }
+    }
+    workerCv_.notify_all();
+}
+
+void MtpTransferPipeline::WaitJob()
+{
+    unique_lock<mutex> lock(workerMutex_);
+    workerCv_.wait(lock, [this]() { return !job_; });
+}
+
+/*
+ * The producer fills chunks on the worker thread and the consumer drains them on the calling thread. The chunk
+ * buffers are moved between a free and a filled queue and reused for the whole transfer, but the usb side is the
+ * hdi Read and Write, which copy every chunk through a binder parcel. The producer returns the size of the chunk,
+ * 0 at the end of the data or an error code, the consumer returns MTP_SUCCESS or an error code.
+ */
+int32_t MtpTransferPipeline::Run(const MtpTransferConfig &config, const Producer &produce, const Consumer &consume)
+{
+    mutex queueMutex;
+    condition_variable queueCv;
+    deque<vector<uint8_t>> freeChunks(config.bufferCount);
+    deque<vector<uint8_t>> filledChunks;
+    bool producerDone = false;
+    bool aborted = false;
+    int32_t producerErr = MTP_SUCCESS;
+    for (auto &chunk : freeChunks) {
+        chunk.reserve(config.chunkSize);
+    }
+
+    StartJob([&]() {
+        while (true) {
+            vector<uint8_t> chunk;
+            {
+                unique_lock<mutex> lock(queueMutex);
+                queueCv.wait(lock, [&]() { return aborted || !freeChunks.empty(); });
+                if (aborted) {
+                    return;
+                }
+                chunk = move(freeChunks.front());
+                freeChunks.pop_front();
+            }
+            int32_t ret = produce(chunk);
+            lock_guard<mutex> lock(queueMutex);
+            if (ret <= 0) {
+                producerErr = ret;
+                producerDone = true;
+                queueCv.notify_all();
+                return;
+            }
+            filledChunks.push_back(move(chunk));
+            queueCv.notify_all();
+        }
+    });
+
+    int32_t consumerErr = MTP_SUCCESS;
+    while (true) {
+        vector<uint8_t> chunk;
+        {
+            unique_lock<mutex> lock(queueMutex);
+            queueCv.wait(lock, [&]() { return producerDone || !filledChunks.empty(); });
+            if (filledChunks.empty()) {
+                break;
+            }
+            chunk = move(filledChunks.front());
+            filledChunks.pop_front();
+        }
+        consumerErr = consume(chunk);
+        lock_guard<mutex> lock(queueMutex);
+        if (consumerErr != MTP_SUCCESS) {
+            aborted = true;
+            queueCv.notify_all();
+            break;
+        }
+        freeChunks.push_back(move(chunk));
+        queueCv.notify_all();
+    }
+    WaitJob();
+    return (consumerErr != MTP_SUCCESS) ? consumerErr : producerErr;
+}
+
+static int32_t ReadFull(int fd, uint8_t *data, size_t size, off_t offset)
+{
+    size_t done = 0;
+    while (done < size) {
+        ssize_t ret = pread(fd, data + done, size - done, offset + static_cast<off_t>(done));
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            MEDIA_ERR_LOG("MtpTransferPipeline read file error = %{public}d", errno);
+            return MTP_ERROR_INCOMPLETE_TRANSFER;
+        }
+        done += static_cast<size_t>(ret);
+    }
+    return MTP_SUCCESS;
+}
+
+static int32_t WriteFull(int fd, const uint8_t *data, size_t size, off_t offset)
+{
+    size_t done = 0;
+    while (done < size) {
+        ssize_t ret = pwrite(fd, data + done, size - done, offset + static_cast<off_t>(done));
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            MEDIA_ERR_LOG("MtpTransferPipeline write file error = %{public}d", errno);
+            return MTP_ERROR_INCOMPLETE_TRANSFER;
+        }
+        done += static_cast<size_t>(ret);
+    }
+    return MTP_SUCCESS;
+}
+
+int32_t MtpTransferPipeline::SendFile(const MtpFileRange &mfr)
+{
+    CHECK_AND_RETURN_RET_LOG(usbfnMtpInterface_ != nullptr, MTP_ERROR_DRIVER_OPEN_FAILED, "usbfn is nullptr");
+    CHECK_AND_RETURN_RET_LOG((mfr.fd >= 0) && (mfr.offset >= 0) && (mfr.length >= 0), MTP_ERROR_INCOMPLETE_TRANSFER,
+        "invalid file range");
+    MtpTransferConfig config = GetConfig();
+    uint64_t length = static_cast<uint64_t>(mfr.length);
+    uint64_t containerLength = length + PACKET_HEADER_LENGETH;
+    off_t offset = static_cast<off_t>(mfr.offset);
+    uint64_t remaining = length;
+    bool needHeader = true;
+    uint64_t fileTimeUs = 0;
+    uint64_t usbTimeUs = 0;
+    auto start = chrono::steady_clock::now();
+
+    Producer readFile = [&](vector<uint8_t> &chunk) -> int32_t {
+        if (!needHeader && (remaining == 0)) {
+            return 0;
+        }
+        chunk.clear();
+        if (needHeader) {
+            MtpPacketTool::PutUInt32(chunk, static_cast<uint32_t>(min(containerLength, MAX_CONTAINER_LENGTH)));
+            MtpPacketTool::PutUInt16(chunk, DATA_CONTAINER_TYPE);
+            MtpPacketTool::PutUInt16(chunk, mfr.command);
+            MtpPacketTool::PutUInt32(chunk, mfr.transaction_id);
+            needHeader = false;
+        }
+        size_t headerSize = chunk.size();
+        size_t readSize = static_cast<size_t>(min<uint64_t>(remaining, config.chunkSize - headerSize));
+        chunk.resize(headerSize + readSize);
+        auto readStart = chrono::steady_clock::now();
+        int32_t ret = ReadFull(mfr.fd, chunk.data() + headerSize, readSize, offset);
+        fileTimeUs += GetElapsedUs(readStart);
+        if (ret != MTP_SUCCESS) {
+            return ret;
+        }
+        offset += static_cast<off_t>(readSize);
+        remaining -= readSize;
+        return static_cast<int32_t>(chunk.size());
+    };
+    Consumer writeUsb = [&](const vector<uint8_t> &chunk) -> int32_t {
+        auto writeStart = chrono::steady_clock::now();
+        int32_t ret = usbfnMtpInterface_->Write(chunk);
+        usbTimeUs += GetElapsedUs(writeStart);
+        CHECK_AND_RETURN_RET_LOG(ret >= 0, MTP_ERROR_INCOMPLETE_TRANSFER, "usb write error = %{public}d", ret);
+        return MTP_SUCCESS;
+    };
+
+    int32_t errCode = Run(config, readFile, writeUsb);
+    if ((errCode == MTP_SUCCESS) && (containerLength % config.maxPacketSize == 0)) {
+        errCode = writeUsb(vector<uint8_t>());
+    }
+    AddStats(length - remaining, usbTimeUs, fileTimeUs, GetElapsedUs(start));
+    return errCode;
+}
+
+int32_t MtpTransferPipeline::ReceiveFile(const MtpFileRange &mfr)
+{
+    CHECK_AND_RETURN_RET_LOG(usbfnMtpInterface_ != nullptr, MTP_ERROR_DRIVER_OPEN_FAILED, "usbfn is nullptr");
+    CHECK_AND_RETURN_RET_LOG((mfr.fd >= 0) && (mfr.offset >= 0) && (mfr.length >= 0), MTP_ERROR_INCOMPLETE_TRANSFER,
+        "invalid file range");
+    MtpTransferConfig config = GetConfig();
+    uint64_t length = static_cast<uint64_t>(mfr.length);
+    off_t offset = static_cast<off_t>(mfr.offset);
+    uint64_t remaining = length;
+    uint64_t fileTimeUs = 0;
+    uint64_t usbTimeUs = 0;
+    auto start = chrono::steady_clock::now();
+
+    Producer readUsb = [&](vector<uint8_t> &chunk) -> int32_t {
+        if (remaining == 0) {
+            return 0;
+        }
+        chunk.resize(static_cast<size_t>(min<uint64_t>(remaining, config.chunkSize)));
+        auto readStart = chrono::steady_clock::now();
+        int32_t ret = usbfnMtpInterface_->Read(chunk);
+        usbTimeUs += GetElapsedUs(readStart);
+        CHECK_AND_RETURN_RET_LOG((ret == 0) && !chunk.empty(), MTP_ERROR_INCOMPLETE_TRANSFER,
+            "usb read error = %{public}d, %{public}" PRIu64 " bytes left", ret, remaining);
+        if (chunk.size() > remaining) {
+            chunk.resize(static_cast<size_t>(remaining));
+        }
+        remaining -= chunk.size();
+        return static_cast<int32_t>(chunk.size());
+    };
+    Consumer writeFile = [&](const vector<uint8_t> &chunk) -> int32_t {
+        auto writeStart = chrono::steady_clock::now();
+        int32_t ret = WriteFull(mfr.fd, chunk.data(), chunk.size(), offset);
+        fileTimeUs += GetElapsedUs(writeStart);
+        offset += static_cast<off_t>(chunk.size());
+        return ret;
+    };
+
+    int32_t errCode = Run(config, readUsb, writeFile);
+    // the host ends a data phase of a multiple of the packet size with a zero length packet, which is not data
+    uint64_t containerLength = length + static_cast<uint64_t>(mfr.offset) + PACKET_HEADER_LENGETH;
+    if ((errCode == MTP_SUCCESS) && (length != 0) && (containerLength % config.maxPacketSize == 0)) {
+        vector<uint8_t> zeroPacket(config.maxPacketSize);
+        int32_t ret = usbfnMtpInterface_->Read(zeroPacket);
+        // anything else than an empty packet is the next container, and the transfer is out of step with the host
+        if ((ret != 0) || !zeroPacket.empty()) {
+            MEDIA_ERR_LOG("usb read zero length packet error = %{public}d, %{public}zu bytes", ret,
+                zeroPacket.size());
+            errCode = MTP_ERROR_INCOMPLETE_TRANSFER;
+        }
+    }
+    AddStats(length - remaining, usbTimeUs, fileTimeUs, GetElapsedUs(start));
+    return errCode;
+}
+} // namespace Media
+} // namespace OHOS
@@ -69,13 +69,13 @@ int GetObjectHandlesData::Maker(std::vector<uint8_t> &outBuffer)
 
 uint32_t GetObjectHandlesData::CalculateSize()
 {
-    std::vector<uint8_t> tmpVar;
-    int res = Maker(tmpVar);
-    if (res != MTP_SUCCESS) {
-        return res;
+    auto handles = GetObjectHandles();
+    if (handles == nullptr) {
+        MEDIA_ERR_LOG("GetObjectHandlesData::CalculateSize handles");
+        return MTP_ERROR_INVALID_OBJECTHANDLE;
     }
 
-    return tmpVar.size();
+    return sizeof(uint32_t) + handles->size() * sizeof(uint32_t);
 }
 
 bool GetObjectHandlesData::SetObjectHandles(std::shared_ptr<UInt32List> &objectHandles)
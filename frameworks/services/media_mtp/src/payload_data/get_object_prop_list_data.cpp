@@ -80,12 +80,54 @@ int GetObjectPropListData::Maker(std::vector<uint8_t> &outBuffer)
 
 uint32_t GetObjectPropListData::CalculateSize()
 {
-    std::vector<uint8_t> tmpVar;
-    int res = Maker(tmpVar);
-    if (res != MTP_SUCCESS) {
-        return res;
+    if ((context_ == nullptr) || (!MtpStorageManager::GetInstance()->HasStorage())) {
+        MEDIA_ERR_LOG("GetObjectPropListData::CalculateSize null or storage");
+        return MTP_FAIL;
+    }
+    if (!hasSetProps_) {
+        MEDIA_ERR_LOG("GetObjectPropListData::CalculateSize set");
+        return MTP_INVALID_OBJECTHANDLE_CODE;
+    }
+
+    // the same layout Maker writes, counted without building it
+    uint32_t size = sizeof(uint32_t);
+    if (props_ == nullptr) {
+        return size;
+    }
+    for (const Property &prop : *props_) {
+        size += GetPropertySize(prop);
+    }
+    return size;
+}
+
+uint32_t GetObjectPropListData::GetPropertySize(const Property &prop)
+{
+    uint32_t size = sizeof(uint32_t) + sizeof(uint16_t) + sizeof(uint16_t);
+    auto &value = prop.currentValue;
+    if (value == nullptr) {
+        return size;
+    }
+    switch (prop.type_) {
+        case MTP_TYPE_STRING_CODE:
+            return size + ((value->str_ == nullptr) ? sizeof(uint8_t) : MtpPacketTool::GetStringSize(*(value->str_)));
+        case MTP_TYPE_INT8_CODE:
+        case MTP_TYPE_UINT8_CODE:
+            return size + sizeof(uint8_t);
+        case MTP_TYPE_INT16_CODE:
+        case MTP_TYPE_UINT16_CODE:
+            return size + sizeof(uint16_t);
+        case MTP_TYPE_INT32_CODE:
+        case MTP_TYPE_UINT32_CODE:
+            return size + sizeof(uint32_t);
+        case MTP_TYPE_INT64_CODE:
+        case MTP_TYPE_UINT64_CODE:
+            return size + sizeof(uint64_t);
+        case MTP_TYPE_INT128_CODE:
+        case MTP_TYPE_UINT128_CODE:
+            return size + sizeof(uint128_t);
+        default:
+            return size;
     }
-    return tmpVar.size();
 }
 
 bool GetObjectPropListData::SetProps(std::shared_ptr<std::vector<Property>> &props)
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MEDIA_SCAN_WALKER_H
+#define MEDIA_SCAN_WALKER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace OHOS {
+namespace Media {
+struct ScanDirEntry {
+    std::string path;
+    std::string name;
+    struct stat statInfo;
+};
+
+struct ScanDirFingerprint {
+    int64_t inode = 0;
+    int64_t mtime = 0;
+
+    bool operator==(const ScanDirFingerprint &other) const
+    {
+        return inode == other.inode && mtime == other.mtime;
+    }
+};
+
+using ScanJournal = std::unordered_map<std::string, ScanDirFingerprint>;
+
+struct ScanDirListing {
+    std::string path;
+    int32_t err = 0;
+    ScanDirFingerprint fingerprint;
+    /* fingerprint matches the journal, files are listed by name only and are not stat-ed */
+    bool unchanged = false;
+    std::vector<ScanDirEntry> dirs;
+    std::vector<ScanDirEntry> files;
+};
+
+/**
+ * Walks a directory tree on a bounded pool of worker threads. Every worker owns a deque of directories,
+ * pops its own work from the back and steals from the front of the other deques when it runs dry.
+ *
+ * A listing is always published before the subdirectories it contains are queued, so the consumer
+ * receives the listing of a directory before the listings of any of its children.
+ *
+ * With a journal set, a directory whose inode and mtime match its journal entry has no entry added, removed
+ * or renamed since the journal was written, its files are then listed without an lstat each.
+ */
+class MediaScanWalker {
+public:
+    MediaScanWalker(const std::string &root, const std::shared_ptr<bool> &stopFlag, size_t threadNum = 0);
+    MediaScanWalker(const MediaScanWalker &other) = delete;
+    MediaScanWalker &operator=(const MediaScanWalker &other) = delete;
+    virtual ~MediaScanWalker();
+
+    /* must be called before Start */
+    void SetJournal(const std::shared_ptr<const ScanJournal> &journal);
+    void Start();
+    /* blocks until a listing is ready, returns false when the whole tree has been walked or stopped */
+    bool Fetch(ScanDirListing &listing);
+    void Stop();
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<std::string> dirs;
+    };
+
+    void Work(size_t index);
+    bool PopTask(size_t index, std::string &dir);
+    void PushTasks(size_t index, const std::vector<ScanDirEntry> &dirs);
+    void PublishListing(ScanDirListing &&listing);
+    void FinishTask();
+    bool IsStopped() const;
+    void ReadDir(const std::string &path, ScanDirListing &listing);
+
+    static constexpr size_t MAX_WALK_THREAD = 4;
+    static constexpr size_t MAX_PENDING_LISTING = 64;
+
+    std::string root_;
+    std::shared_ptr<bool> stopFlag_;
+    size_t threadNum_;
+    std::shared_ptr<const ScanJournal> journal_;
+
+    std::vector<std::unique_ptr<WorkQueue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<bool> stop_ {false};
+    /* directories queued or being read */
+    std::atomic<size_t> pendingDirs_ {0};
+    std::atomic<size_t> queuedDirs_ {0};
+
+    std::mutex taskMutex_;
+    std::condition_variable taskCv_;
+
+    std::mutex resultMutex_;
+    std::condition_variable resultCv_;
+    std::condition_variable spaceCv_;
+    std::queue<ScanDirListing> results_;
+};
+} // namespace Media
+} // namespace OHOS
+
+#endif // MEDIA_SCAN_WALKER_H
@@ -39,6 +39,7 @@
 #include "medialibrary_errno.h"
 #include "media_scanner_const.h"
 #include "media_scanner_db.h"
+#include "media_scan_walker.h"
 #include "metadata.h"
 #include "metadata_extractor.h"
 #include "scanner_utils.h"
@@ -134,6 +135,11 @@ private:
     std::set<std::pair<std::string, int32_t>> scannedIds_;
     std::vector<std::unique_ptr<Metadata>> dataBuffer_;
     MediaLibraryApi api_;
+
+    /* journal */
+    bool useJournal_ = false;
+    std::shared_ptr<const ScanJournal> journal_;
+    ScanJournal scannedDirs_;
 };
 
 class ScanErrCallback : public IMediaScannerCallback {
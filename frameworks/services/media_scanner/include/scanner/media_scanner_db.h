@@ -22,8 +22,10 @@
 #include <unordered_map>
 #include <vector>
 
+#include "media_scan_walker.h"
 #include "medialibrary_command.h"
 #include "medialibrary_db_const.h"
+#include "medialibrary_rdb_utils.h"
 #include "medialibrary_type_const.h"
 #include "metadata.h"
 #include "datashare_values_bucket.h"
@@ -37,6 +39,21 @@
 
 namespace OHOS {
 namespace Media {
+struct ScanBasicInfo {
+    int32_t fileId = FILE_ID_DEFAULT;
+    int64_t size = FILE_SIZE_DEFAULT;
+    int64_t dateModified = FILE_DATE_MODIFIED_DEFAULT;
+    int32_t orientation = FILE_ORIENTATION_DEFAULT;
+    std::string name;
+};
+
+struct ScanCommitResult {
+    std::string uri;
+    std::string tableName;
+    int32_t fileId = FILE_ID_DEFAULT;
+    int32_t err = 0;
+};
+
 class MediaScannerDb {
 public:
     MediaScannerDb();
@@ -55,6 +72,8 @@ public:
         MediaLibraryApi api = MediaLibraryApi::API_OLD);
     std::string GetFileDBUriFromPath(const std::string &path);
     std::vector<std::string> BatchInsert(const std::vector<Metadata> &metadataList);
+    int32_t CommitMetadataBatch(const std::vector<std::unique_ptr<Metadata>> &metadataList,
+        std::vector<ScanCommitResult> &results);
 
     int32_t InsertAlbum(const Metadata &metadata);
     int32_t UpdateAlbum(const Metadata &metadata);
@@ -65,12 +84,20 @@ public:
     int32_t GetIdFromPath(const std::string &path);
     int32_t GetFileBasicInfo(const std::string &path, std::unique_ptr<Metadata> &ptr,
         MediaLibraryApi api = MediaLibraryApi::API_OLD);
+    int32_t PrefetchFileBasicInfo(const std::string &dir);
+    void ClearFileBasicInfo();
+    bool GetIndexedFileId(const std::string &path, std::string &tableName, int32_t &fileId);
+
+    int32_t ReadScanJournal(const std::string &dir, ScanJournal &journal);
+    int32_t UpdateScanJournal(const std::string &dir, const ScanJournal &journal);
 
     int32_t RecordError(const std::string &err);
     std::set<std::string> ReadError();
     int32_t DeleteError(const std::string &err);
     static void UpdateAlbumInfo(const std::vector<std::string> &subtypes = {},
         const std::vector<std::string> &userAlbumIds = {});
+    static void CaptureAlbumMembership(const std::string &fileId, AlbumMembership &membership);
+    static void UpdateAlbumInfo(const AlbumMembership &membership);
 
 private:
     int32_t FillMetadata(const std::shared_ptr<NativeRdb::ResultSet> &resultSet,
@@ -80,6 +107,20 @@ private:
     void ExtractMetaFromColumn(const std::shared_ptr<NativeRdb::ResultSet> &resultSet,
         std::unique_ptr<Metadata> &metadata, const std::string &col);
     bool InsertData(const NativeRdb::ValuesBucket values, const std::string &tableName, int64_t &rowNum);
+    int32_t InsertMetadata(const Metadata &metadata, ScanCommitResult &result,
+        MediaLibraryApi api = MediaLibraryApi::API_OLD);
+    int32_t UpdateMetadata(const Metadata &metadata, ScanCommitResult &result,
+        MediaLibraryApi api = MediaLibraryApi::API_OLD);
+    bool CommitMetadataRows(const std::vector<std::unique_ptr<Metadata>> &metadataList,
+        std::vector<ScanCommitResult> &results);
+    int32_t ReadFileBasicInfo(const std::string &dir, const std::string &tableName,
+        std::unordered_map<std::string, ScanBasicInfo> &infoMap);
+    bool GetFileBasicInfoFromIndex(const std::string &path, const std::string &tableName,
+        std::unique_ptr<Metadata> &ptr);
+
+    /* scan-scoped index of table -> path -> basic info under indexedDir_ */
+    std::string indexedDir_;
+    std::unordered_map<std::string, std::unordered_map<std::string, ScanBasicInfo>> basicInfoIndex_;
 };
 } // namespace Media
 } // namespace OHOS
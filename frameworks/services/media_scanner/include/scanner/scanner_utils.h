@@ -38,7 +38,7 @@ enum ErrorCodes {
     ERR_SCAN_NOT_INIT
 };
 
-const int32_t MAX_BATCH_SIZE = 5;
+const int32_t MAX_BATCH_SIZE = 50;
 
 constexpr int32_t UNKNOWN_ID = -1;
 
@@ -0,0 +1,273 @@
+/*
+ * Copyright (C) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MLOG_TAG "Scanner"
+
+#include "media_scan_walker.h"
+
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+
+#include "media_log.h"
+#include "medialibrary_errno.h"
+#include "post_event_utils.h"
+#include "scanner_utils.h"
+
+namespace OHOS {
+namespace Media {
+using namespace std;
+
+static constexpr int32_t WAIT_INTERVAL_MS = 50;
+static constexpr int64_t NSEC_PER_SEC = 1000000000;
+
+MediaScanWalker::MediaScanWalker(const string &root, const shared_ptr<bool> &stopFlag, size_t threadNum)
+    : root_(root), stopFlag_(stopFlag), threadNum_(threadNum)
+{
+    if (threadNum_ == 0) {
+        threadNum_ = thread::hardware_concurrency();
+    }
+    threadNum_ = max(static_cast<size_t>(1), min(threadNum_, MAX_WALK_THREAD));
+}
+
+MediaScanWalker::~MediaScanWalker()
+{
+    Stop();
+}
+
+void MediaScanWalker::SetJournal(const shared_ptr<const ScanJournal> &journal)
+{
+    journal_ = journal;
+}
+
+void MediaScanWalker::Start()
+{
+    for (size_t i = 0; i < threadNum_; i++) {
+        queues_.emplace_back(make_unique<WorkQueue>());
+    }
+
+    pendingDirs_ = 1;
+    queuedDirs_ = 1;
+    queues_[0]->dirs.push_back(root_);
+
+    for (size_t i = 0; i < threadNum_; i++) {
+        workers_.emplace_back(&MediaScanWalker::Work, this, i);
+    }
+}
+
+void MediaScanWalker::Stop()
+{
+    stop_ = true;
+    {
+        lock_guard<mutex> lock(taskMutex_);
+    }
+    taskCv_.notify_all();
+    {
+        lock_guard<mutex> lock(resultMutex_);
+    }
+    resultCv_.notify_all();
+    spaceCv_.notify_all();
+
+    for (auto &worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers_.clear();
+}
+
+bool MediaScanWalker::IsStopped() const
+{
+    return stop_ || (stopFlag_ != nullptr && *stopFlag_);
+}
+
+bool MediaScanWalker::Fetch(ScanDirListing &listing)
+{
+    unique_lock<mutex> lock(resultMutex_);
+    while (true) {
+        if (!results_.empty()) {
+            listing = move(results_.front());
+            results_.pop();
+            spaceCv_.notify_one();
+            return true;
+        }
+        if (pendingDirs_ == 0 || IsStopped()) {
+            return false;
+        }
+        resultCv_.wait_for(lock, chrono::milliseconds(WAIT_INTERVAL_MS));
+    }
+}
+
+bool MediaScanWalker::PopTask(size_t index, string &dir)
+{
+    {
+        /* own work is taken from the back to stay depth first and cache friendly */
+        lock_guard<mutex> lock(queues_[index]->mutex);
+        if (!queues_[index]->dirs.empty()) {
+            dir = move(queues_[index]->dirs.back());
+            queues_[index]->dirs.pop_back();
+            queuedDirs_--;
+            return true;
+        }
+    }
+
+    /* steal the oldest, and usually biggest, subtree of another worker */
+    for (size_t i = 1; i < threadNum_; i++) {
+        auto &victim = queues_[(index + i) % threadNum_];
+        lock_guard<mutex> lock(victim->mutex);
+        if (!victim->dirs.empty()) {
+            dir = move(victim->dirs.front());
+            victim->dirs.pop_front();
+            queuedDirs_--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void MediaScanWalker::PushTasks(size_t index, const vector<ScanDirEntry> &dirs)
+{
+    if (dirs.empty()) {
+        return;
+    }
+
+    pendingDirs_ += dirs.size();
+    queuedDirs_ += dirs.size();
+    {
+        lock_guard<mutex> lock(queues_[index]->mutex);
+        for (auto it = dirs.rbegin(); it != dirs.rend(); ++it) {
+            queues_[index]->dirs.push_back(it->path);
+        }
+    }
+
+    {
+        lock_guard<mutex> lock(taskMutex_);
+    }
+    taskCv_.notify_all();
+}
+
+void MediaScanWalker::PublishListing(ScanDirListing &&listing)
+{
+    unique_lock<mutex> lock(resultMutex_);
+    while (results_.size() >= MAX_PENDING_LISTING && !IsStopped()) {
+        spaceCv_.wait_for(lock, chrono::milliseconds(WAIT_INTERVAL_MS));
+    }
+    results_.push(move(listing));
+    resultCv_.notify_one();
+}
+
+void MediaScanWalker::FinishTask()
+{
+    if (--pendingDirs_ != 0) {
+        return;
+    }
+
+    {
+        lock_guard<mutex> lock(taskMutex_);
+    }
+    taskCv_.notify_all();
+    {
+        lock_guard<mutex> lock(resultMutex_);
+    }
+    resultCv_.notify_all();
+}
+
+void MediaScanWalker::Work(size_t index)
+{
+    while (!IsStopped()) {
+        string dir;
+        if (!PopTask(index, dir)) {
+            unique_lock<mutex> lock(taskMutex_);
+            taskCv_.wait_for(lock, chrono::milliseconds(WAIT_INTERVAL_MS), [this]() {
+                return IsStopped() || queuedDirs_ > 0 || pendingDirs_ == 0;
+            });
+            if (pendingDirs_ == 0) {
+                break;
+            }
+            continue;
+        }
+
+        ScanDirListing listing;
+        listing.path = dir;
+        ReadDir(dir, listing);
+
+        /* publish before queueing children, so that the consumer always resolves parents first */
+        vector<ScanDirEntry> subDirs = listing.dirs;
+        PublishListing(move(listing));
+        PushTasks(index, subDirs);
+        FinishTask();
+    }
+}
+
+void MediaScanWalker::ReadDir(const string &path, ScanDirListing &listing)
+{
+    DIR *dirPath = opendir(path.c_str());
+    if (dirPath == nullptr) {
+        MEDIA_ERR_LOG("Failed to opendir %{private}s, errno %{private}d", path.c_str(), errno);
+        VariantMap map = {{KEY_ERR_FILE, __FILE__}, {KEY_ERR_LINE, __LINE__}, {KEY_ERR_CODE, -errno},
+            {KEY_OPT_FILE, path}, {KEY_OPT_TYPE, OptType::SCAN}};
+        PostEventUtils::GetInstance().PostErrorProcess(ErrType::FILE_OPT_ERR, map);
+        listing.err = ERR_NOT_ACCESSIBLE;
+        return;
+    }
+
+    struct stat dirStat;
+    if (fstat(dirfd(dirPath), &dirStat) == 0) {
+        listing.fingerprint.inode = static_cast<int64_t>(dirStat.st_ino);
+        listing.fingerprint.mtime = static_cast<int64_t>(dirStat.st_mtim.tv_sec) * NSEC_PER_SEC +
+            dirStat.st_mtim.tv_nsec;
+        if (journal_ != nullptr) {
+            auto itr = journal_->find(path);
+            listing.unchanged = (itr != journal_->end()) && (itr->second == listing.fingerprint);
+        }
+    }
+
+    struct dirent *ent = nullptr;
+    while ((ent = readdir(dirPath)) != nullptr) {
+        if (!strcmp(ent->d_name, ".") || !strcmp(ent->d_name, "..")) {
+            continue;
+        }
+
+        ScanDirEntry entry;
+        entry.name = ent->d_name;
+        entry.path = path + "/" + entry.name;
+        if (entry.path.length() >= FILENAME_MAX) {
+            continue;
+        }
+
+        if (listing.unchanged && ent->d_type == DT_REG) {
+            entry.statInfo = {};
+            listing.files.push_back(move(entry));
+            continue;
+        }
+
+        if (lstat(entry.path.c_str(), &entry.statInfo) == -1) {
+            continue;
+        }
+
+        if (S_ISDIR(entry.statInfo.st_mode)) {
+            if (ScannerUtils::IsDirHidden(entry.path)) {
+                continue;
+            }
+            listing.dirs.push_back(move(entry));
+        } else {
+            listing.files.push_back(move(entry));
+        }
+    }
+
+    closedir(dirPath);
+}
+} // namespace Media
+} // namespace OHOS
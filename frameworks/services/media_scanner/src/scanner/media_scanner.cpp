@@ -35,7 +35,8 @@ using namespace OHOS::AppExecFwk;
 using namespace OHOS::DataShare;
 
 MediaScannerObj::MediaScannerObj(const std::string &path, const std::shared_ptr<IMediaScannerCallback> &callback,
-    MediaScannerObj::ScanType type, MediaLibraryApi api) : type_(type), callback_(callback), api_(api)
+    MediaScannerObj::ScanType type, MediaLibraryApi api) : type_(type),
+    mediaScannerDb_(MediaScannerDb::GetDatabaseInstance()), callback_(callback), api_(api)
 {
     if (type_ == DIRECTORY) {
         dir_ = path;
@@ -45,7 +46,8 @@ MediaScannerObj::MediaScannerObj(const std::string &path, const std::shared_ptr<
     stopFlag_ = make_shared<bool>(false);
 }
 
-MediaScannerObj::MediaScannerObj(MediaScannerObj::ScanType type) : type_(type)
+MediaScannerObj::MediaScannerObj(MediaScannerObj::ScanType type) : type_(type),
+    mediaScannerDb_(MediaScannerDb::GetDatabaseInstance())
 {
 }
 
@@ -128,28 +130,32 @@ int32_t MediaScannerObj::InvokeCallback(int32_t err)
 int32_t MediaScannerObj::CommitTransaction()
 {
     unordered_set<MediaType> mediaTypeSet = {};
-    string uri;
-    unique_ptr<Metadata> data;
-    string tableName;
-
-    // will begin a transaction in later pr
-    for (uint32_t i = 0; i < dataBuffer_.size(); i++) {
-        data = move(dataBuffer_[i]);
-        if (data->GetFileId() != FILE_ID_DEFAULT) {
-            uri = mediaScannerDb_->UpdateMetadata(*data, tableName);
-            scannedIds_.insert(make_pair(tableName, data->GetFileId()));
-        } else {
-            uri = mediaScannerDb_->InsertMetadata(*data, tableName);
-            scannedIds_.insert(make_pair(tableName,
-                stoi(MediaLibraryDataManagerUtils::GetIdFromUri(uri))));
+    vector<ScanCommitResult> results;
+
+    int32_t err = mediaScannerDb_->CommitMetadataBatch(dataBuffer_, results);
+    for (size_t i = 0; i < results.size() && i < dataBuffer_.size(); i++) {
+        const ScanCommitResult &result = results[i];
+        // a row that failed to update still exists and must not be cleaned up
+        if (result.fileId > 0) {
+            scannedIds_.insert(make_pair(result.tableName, result.fileId));
+        }
+        if (result.err != E_OK) {
+            MEDIA_ERR_LOG("failed to commit %{private}s", dataBuffer_[i]->GetFilePath().c_str());
+            VariantMap map = {{KEY_ERR_FILE, __FILE__}, {KEY_ERR_LINE, __LINE__}, {KEY_ERR_CODE, result.err},
+                {KEY_OPT_FILE, dataBuffer_[i]->GetFilePath()}, {KEY_OPT_TYPE, OptType::SCAN}};
+            PostEventUtils::GetInstance().PostErrorProcess(ErrType::DB_OPT_ERR, map);
+            continue;
         }
 
         // set uri for callback
-        uri_ = uri;
-        mediaTypeSet.insert(data->GetFileMediaType());
+        uri_ = result.uri;
+        mediaTypeSet.insert(dataBuffer_[i]->GetFileMediaType());
     }
 
     dataBuffer_.clear();
+    if (err != E_OK) {
+        MEDIA_ERR_LOG("some rows of the batch failed to commit, err %{public}d", err);
+    }
 
     mediaScannerDb_->UpdateAlbumInfo();
     for (const MediaType &mediaType : mediaTypeSet) {
@@ -183,9 +189,18 @@ int32_t MediaScannerObj::Commit()
 {
     string tableName;
     auto watch = MediaLibraryNotify::GetInstance();
+    AlbumMembership membership;
     if (data_->GetFileId() != FILE_ID_DEFAULT) {
+        /* only photos are in albums, the ids of the other tables mean other assets there */
+        MediaType mediaType = data_->GetFileMediaType();
+        bool isPhoto = (mediaType == MEDIA_TYPE_IMAGE) || (mediaType == MEDIA_TYPE_VIDEO);
+        if (isPhoto) {
+            mediaScannerDb_->CaptureAlbumMembership(to_string(data_->GetFileId()), membership);
+        }
         uri_ = mediaScannerDb_->UpdateMetadata(*data_, tableName, api_);
-        mediaScannerDb_->UpdateAlbumInfo();
+        if (isPhoto && (tableName == PhotoColumn::PHOTOS_TABLE)) {
+            mediaScannerDb_->UpdateAlbumInfo(membership);
+        }
         if (watch != nullptr) {
             if (data_->GetForAdd()) {
                 watch->Notify(GetUriWithoutSeg(uri_), NOTIFY_ADD);
@@ -195,7 +210,11 @@ int32_t MediaScannerObj::Commit()
         }
     } else {
         uri_ = mediaScannerDb_->InsertMetadata(*data_, tableName, api_);
-        mediaScannerDb_->UpdateAlbumInfo();
+        /* a new asset was in no album before */
+        if (!uri_.empty() && (tableName == PhotoColumn::PHOTOS_TABLE)) {
+            membership.fileIds = { MediaFileUtils::GetIdFromUri(uri_) };
+            mediaScannerDb_->UpdateAlbumInfo(membership);
+        }
         if (watch != nullptr) {
             watch->Notify(GetUriWithoutSeg(uri_), NOTIFY_ADD);
         }
@@ -621,74 +640,71 @@ int32_t MediaScannerObj::CleanupDirectory()
 int32_t MediaScannerObj::WalkFileTree(const string &path, int32_t parentId)
 {
     int err = E_OK;
-    DIR *dirPath = nullptr;
-    struct dirent *ent = nullptr;
-    size_t len = path.length();
-    struct stat statInfo;
-
-    if (len >= FILENAME_MAX - 1) {
+    if (path.length() >= FILENAME_MAX - 1) {
         return ERR_INCORRECT_PATH;
     }
 
-    auto fName = (char *)calloc(FILENAME_MAX, sizeof(char));
-    if (fName == nullptr) {
-        return ERR_MEM_ALLOC_FAIL;
-    }
-
-    if (strcpy_s(fName, FILENAME_MAX, path.c_str()) != ERR_SUCCESS) {
-        FREE_MEMORY_AND_SET_NULL(fName);
-        return ERR_MEM_ALLOC_FAIL;
-    }
-    fName[len++] = '/';
-
-    if ((dirPath = opendir(path.c_str())) == nullptr) {
-        MEDIA_ERR_LOG("Failed to opendir %{private}s, errno %{private}d", path.c_str(), errno);
-        FREE_MEMORY_AND_SET_NULL(fName);
-        VariantMap map = {{KEY_ERR_FILE, __FILE__}, {KEY_ERR_LINE, __LINE__}, {KEY_ERR_CODE, -errno},
-            {KEY_OPT_FILE, path}, {KEY_OPT_TYPE, OptType::SCAN}};
-        PostEventUtils::GetInstance().PostErrorProcess(ErrType::FILE_OPT_ERR, map);
-        return ERR_NOT_ACCESSIBLE;
-    }
+    /*
+     * Directories are read on the walker threads, while albums and files are still committed here,
+     * so that dataBuffer_, albumMap_ and scannedIds_ are only ever touched by the scanner thread.
+     */
+    MediaScanWalker walker(path, stopFlag_);
+    walker.SetJournal(journal_);
+    walker.Start();
 
-    while ((ent = readdir(dirPath)) != nullptr) {
+    unordered_map<string, int32_t> dirIds = { { path, parentId } };
+    ScanDirListing listing;
+    while (walker.Fetch(listing)) {
         if (*stopFlag_) {
-            err = E_STOP;
             break;
         }
 
-        if (!strcmp(ent->d_name, ".") || !strcmp(ent->d_name, "..")) {
+        auto dirItr = dirIds.find(listing.path);
+        if (dirItr == dirIds.end()) {
+            /* its album failed to be inserted or updated, skip the whole subtree */
             continue;
         }
+        int32_t dirId = dirItr->second;
+        dirIds.erase(dirItr);
 
-        if (strncpy_s(fName + len, FILENAME_MAX - len, ent->d_name, FILENAME_MAX - len)) {
+        if (listing.err != E_OK) {
+            if (listing.path == path) {
+                return listing.err;
+            }
             continue;
         }
-
-        if (lstat(fName, &statInfo) == -1) {
-            continue;
+        if (listing.fingerprint.inode != 0) {
+            scannedDirs_.emplace(listing.path, listing.fingerprint);
         }
 
-        string currentPath = fName;
-        if (S_ISDIR(statInfo.st_mode)) {
-            if (ScannerUtils::IsDirHidden(currentPath)) {
-                continue;
-            }
-
-            int32_t albumId = InsertOrUpdateAlbumInfo(currentPath, parentId, ent->d_name);
+        for (const auto &dir : listing.dirs) {
+            int32_t albumId = InsertOrUpdateAlbumInfo(dir.path, dirId, dir.name);
             if (albumId == UNKNOWN_ID) {
                 err = E_DATA;
                 // might break in later pr for a rescan
                 continue;
             }
+            dirIds.emplace(dir.path, albumId);
+        }
 
-            (void)WalkFileTree(currentPath, albumId);
-        } else {
-            (void)ScanFileInTraversal(currentPath, path, parentId);
+        for (const auto &file : listing.files) {
+            if (*stopFlag_) {
+                break;
+            }
+            /* files of an unchanged dir known to the index are kept as they are, others are scanned as usual */
+            string tableName;
+            int32_t fileId = FILE_ID_DEFAULT;
+            if (listing.unchanged && mediaScannerDb_->GetIndexedFileId(file.path, tableName, fileId)) {
+                scannedIds_.insert(make_pair(tableName, fileId));
+                continue;
+            }
+            (void)ScanFileInTraversal(file.path, listing.path, dirId);
         }
     }
 
-    closedir(dirPath);
-    FREE_MEMORY_AND_SET_NULL(fName);
+    if (*stopFlag_) {
+        err = E_STOP;
+    }
 
     return err;
 }
@@ -715,8 +731,23 @@ int32_t MediaScannerObj::ScanDirInternal()
         PostEventUtils::GetInstance().PostErrorProcess(ErrType::DB_OPT_ERR, map);
         return err;
     }
+    /* per file lookups fall back to single queries if the prefetch fails */
+    bool indexed = (mediaScannerDb_->PrefetchFileBasicInfo(dir_) == E_OK);
+
+    /* unchanged dirs are only skipped when their files can be resolved from the index */
+    scannedDirs_.clear();
+    journal_ = nullptr;
+    if (useJournal_ && indexed) {
+        auto journal = make_shared<ScanJournal>();
+        if (mediaScannerDb_->ReadScanJournal(dir_, *journal) == E_OK) {
+            journal_ = journal;
+        }
+    }
+
     /* no further operation when stopped */
     err = WalkFileTree(dir_, NO_PARENT);
+    mediaScannerDb_->ClearFileBasicInfo();
+    journal_ = nullptr;
     if (err != E_OK) {
         MEDIA_ERR_LOG("walk file tree err %{public}d", err);
         VariantMap map = {{KEY_ERR_FILE, __FILE__}, {KEY_ERR_LINE, __LINE__}, {KEY_ERR_CODE, err},
@@ -741,6 +772,13 @@ int32_t MediaScannerObj::ScanDirInternal()
         return err;
     }
 
+    /* the journal only ever records a complete scan, a failure here costs a full walk next time */
+    err = mediaScannerDb_->UpdateScanJournal(dir_, scannedDirs_);
+    if (err != E_OK) {
+        MEDIA_ERR_LOG("update scan journal err %{public}d", err);
+    }
+    scannedDirs_.clear();
+
     return E_OK;
 }
 
@@ -769,6 +807,8 @@ int32_t MediaScannerObj::Start()
 
 int32_t MediaScannerObj::ScanError(bool isBoot)
 {
+    /* dirs replayed from the error table only descend into what changed since their last successful scan */
+    useJournal_ = true;
     auto errSet = mediaScannerDb_->ReadError();
     for (auto &err : errSet) {
         string realPath;
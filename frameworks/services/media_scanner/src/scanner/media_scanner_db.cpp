@@ -24,8 +24,10 @@
 #include "media_log.h"
 #include "medialibrary_command.h"
 #include "medialibrary_data_manager.h"
+#include "medialibrary_data_manager_utils.h"
 #include "medialibrary_db_const.h"
 #include "medialibrary_errno.h"
+#include "medialibrary_rdb_transaction.h"
 #include "medialibrary_rdb_utils.h"
 #include "medialibrary_smartalbum_map_operations.h"
 #include "medialibrary_type_const.h"
@@ -248,8 +250,23 @@ bool MediaScannerDb::InsertData(const ValuesBucket values, const string &tableNa
     return true;
 }
 
-string MediaScannerDb::InsertMetadata(const Metadata &metadata, string &tableName, MediaLibraryApi api)
+/* the uri of a written row, empty for a media type without one */
+static string GetMetadataUri(const Metadata &metadata, const string &mediaTypeUri, int32_t fileId,
+    MediaLibraryApi api)
+{
+    if (mediaTypeUri.empty()) {
+        return "";
+    }
+    if (api == MediaLibraryApi::API_10) {
+        return MediaFileUtils::GetUriByExtrConditions(mediaTypeUri + "/", to_string(fileId),
+            MediaFileUtils::GetExtraUri(metadata.GetFileName(), metadata.GetFilePath())) + "?api_version=10";
+    }
+    return MediaFileUtils::GetUriByExtrConditions(mediaTypeUri + "/", to_string(fileId));
+}
+
+int32_t MediaScannerDb::InsertMetadata(const Metadata &metadata, ScanCommitResult &result, MediaLibraryApi api)
 {
+    string &tableName = result.tableName;
     MediaType mediaType = metadata.GetFileMediaType();
     string mediaTypeUri;
     ValuesBucket values;
@@ -280,17 +297,19 @@ string MediaScannerDb::InsertMetadata(const Metadata &metadata, string &tableNam
 
     int64_t rowNum = 0;
     if (!InsertData(values, tableName, rowNum)) {
-        return "";
+        return E_HAS_DB_ERROR;
     }
+    result.fileId = static_cast<int32_t>(rowNum);
+    result.uri = GetMetadataUri(metadata, mediaTypeUri, result.fileId, api);
+    return E_OK;
+}
 
-    if (mediaTypeUri.empty()) {
-        return "";
-    }
-    if (api == MediaLibraryApi::API_10) {
-        return MediaFileUtils::GetUriByExtrConditions(mediaTypeUri + "/", to_string(rowNum),
-            MediaFileUtils::GetExtraUri(metadata.GetFileName(), metadata.GetFilePath())) + "?api_version=10";
-    }
-    return MediaFileUtils::GetUriByExtrConditions(mediaTypeUri + "/", to_string(rowNum));
+string MediaScannerDb::InsertMetadata(const Metadata &metadata, string &tableName, MediaLibraryApi api)
+{
+    ScanCommitResult result;
+    InsertMetadata(metadata, result, api);
+    tableName = result.tableName;
+    return result.uri;
 }
 
 vector<string> MediaScannerDb::BatchInsert(const vector<Metadata> &metadataList)
@@ -304,6 +323,80 @@ vector<string> MediaScannerDb::BatchInsert(const vector<Metadata> &metadataList)
     return insertUriList;
 }
 
+bool MediaScannerDb::CommitMetadataRows(const vector<unique_ptr<Metadata>> &metadataList,
+    vector<ScanCommitResult> &results)
+{
+    bool allCommitted = true;
+    results.clear();
+    results.reserve(metadataList.size());
+    for (const auto &metadata : metadataList) {
+        ScanCommitResult result;
+        /* a media type without an uri still writes its row, so success does not depend on the uri */
+        if (metadata->GetFileId() != FILE_ID_DEFAULT) {
+            result.err = UpdateMetadata(*metadata, result);
+            result.fileId = metadata->GetFileId();
+        } else {
+            result.err = InsertMetadata(*metadata, result);
+        }
+
+        if (result.err != E_OK) {
+            allCommitted = false;
+        }
+        results.push_back(move(result));
+    }
+
+    return allCommitted;
+}
+
+/**
+ * @brief Commit a batch of scanned metadata in one transaction
+ *
+ * If any row fails the whole transaction is rolled back and the rows are committed again one by one,
+ * so that a single bad row does not drop the rest of the batch.
+ *
+ * @param metadataList The metadata to insert (file id is default) or update
+ * @param results The uri, table and file id of every row, in the order of metadataList
+ * @return int32_t E_OK if every row has been committed
+ */
+int32_t MediaScannerDb::CommitMetadataBatch(const vector<unique_ptr<Metadata>> &metadataList,
+    vector<ScanCommitResult> &results)
+{
+    if (metadataList.empty()) {
+        results.clear();
+        return E_OK;
+    }
+
+    auto rdbStore = MediaLibraryUnistoreManager::GetInstance().GetRdbStoreRaw();
+    if (rdbStore == nullptr) {
+        VariantMap map = {{KEY_ERR_FILE, __FILE__}, {KEY_ERR_LINE, __LINE__}, {KEY_ERR_CODE, E_HAS_DB_ERROR},
+            {KEY_OPT_TYPE, OptType::SCAN}};
+        PostEventUtils::GetInstance().PostErrorProcess(ErrType::DB_OPT_ERR, map);
+        return E_HAS_DB_ERROR;
+    }
+
+    {
+        TransactionOperations transactionOprn(rdbStore->GetRaw());
+        int32_t err = transactionOprn.Start();
+        if (err == E_OK) {
+            if (CommitMetadataRows(metadataList, results)) {
+                err = transactionOprn.Finish();
+                if (err == E_OK) {
+                    return E_OK;
+                }
+                MEDIA_ERR_LOG("failed to commit the batch of %{public}zu rows, err %{public}d", metadataList.size(),
+                    err);
+            } else {
+                MEDIA_ERR_LOG("batch commit of %{public}zu rows failed, roll back", metadataList.size());
+            }
+        } else {
+            MEDIA_ERR_LOG("failed to start transaction, err %{public}d", err);
+        }
+        /* transactionOprn rolls back when destructed without finish */
+    }
+
+    return CommitMetadataRows(metadataList, results) ? E_OK : E_HAS_DB_ERROR;
+}
+
 static inline void GetUriStringInUpdate(MediaType mediaType, MediaLibraryApi api, string &mediaTypeUri,
     ValuesBucket &values)
 {
@@ -328,8 +421,9 @@ static inline void GetUriStringInUpdate(MediaType mediaType, MediaLibraryApi api
  * @param metadata The metadata object which has the information about the file
  * @return string The mediatypeUri corresponding to the given metadata
  */
-string MediaScannerDb::UpdateMetadata(const Metadata &metadata, string &tableName, MediaLibraryApi api)
+int32_t MediaScannerDb::UpdateMetadata(const Metadata &metadata, ScanCommitResult &result, MediaLibraryApi api)
 {
+    string &tableName = result.tableName;
     int32_t updateCount(0);
     ValuesBucket values;
     string whereClause = MEDIA_DATA_DB_ID + " = ?";
@@ -351,17 +445,17 @@ string MediaScannerDb::UpdateMetadata(const Metadata &metadata, string &tableNam
 
     auto rdbStore = MediaLibraryUnistoreManager::GetInstance().GetRdbStoreRaw();
     if (rdbStore == nullptr) {
-        return "";
+        return E_HAS_DB_ERROR;
     }
     auto rdbStorePtr = rdbStore->GetRaw();
     if (rdbStorePtr == nullptr) {
-        return "";
+        return E_HAS_DB_ERROR;
     }
-    int32_t result = rdbStorePtr->Update(updateCount, tableName, values, whereClause, whereArgs);
-    if (result != NativeRdb::E_OK || updateCount <= 0) {
-        MEDIA_ERR_LOG("Update operation failed. Result %{public}d. Updated %{public}d", result, updateCount);
-        if (result != NativeRdb::E_OK) {
-            VariantMap map = {{KEY_ERR_FILE, __FILE__}, {KEY_ERR_LINE, __LINE__}, {KEY_ERR_CODE, result},
+    int32_t ret = rdbStorePtr->Update(updateCount, tableName, values, whereClause, whereArgs);
+    if (ret != NativeRdb::E_OK || updateCount <= 0) {
+        MEDIA_ERR_LOG("Update operation failed. Result %{public}d. Updated %{public}d", ret, updateCount);
+        if (ret != NativeRdb::E_OK) {
+            VariantMap map = {{KEY_ERR_FILE, __FILE__}, {KEY_ERR_LINE, __LINE__}, {KEY_ERR_CODE, ret},
                 {KEY_OPT_TYPE, OptType::SCAN}};
             PostEventUtils::GetInstance().PostErrorProcess(ErrType::DB_OPT_ERR, map);
         }
@@ -370,16 +464,18 @@ string MediaScannerDb::UpdateMetadata(const Metadata &metadata, string &tableNam
                 {KEY_OPT_TYPE, OptType::SCAN}};
             PostEventUtils::GetInstance().PostErrorProcess(ErrType::DB_OPT_ERR, map);
         }
-        return "";
-    }
-    if (mediaTypeUri.empty()) {
-        return "";
-    }
-    if (api == MediaLibraryApi::API_10) {
-        return MediaFileUtils::GetUriByExtrConditions(mediaTypeUri + "/", to_string(metadata.GetFileId()),
-            MediaFileUtils::GetExtraUri(metadata.GetFileName(), metadata.GetFilePath())) + "?api_version=10";
+        return E_HAS_DB_ERROR;
     }
-    return MediaFileUtils::GetUriByExtrConditions(mediaTypeUri + "/", to_string(metadata.GetFileId()));
+    result.uri = GetMetadataUri(metadata, mediaTypeUri, metadata.GetFileId(), api);
+    return E_OK;
+}
+
+string MediaScannerDb::UpdateMetadata(const Metadata &metadata, string &tableName, MediaLibraryApi api)
+{
+    ScanCommitResult result;
+    UpdateMetadata(metadata, result, api);
+    tableName = result.tableName;
+    return result.uri;
 }
 
 /**
@@ -474,6 +570,16 @@ static void GetQueryParamsByPath(const string &path, MediaLibraryApi api, vector
     }
 }
 
+static const string &GetTableNameByOprnObject(OperationObject oprnObject)
+{
+    if (oprnObject == OperationObject::FILESYSTEM_PHOTO) {
+        return PhotoColumn::PHOTOS_TABLE;
+    } else if (oprnObject == OperationObject::FILESYSTEM_AUDIO) {
+        return AudioColumn::AUDIOS_TABLE;
+    }
+    return MEDIALIBRARY_TABLE;
+}
+
 int32_t MediaScannerDb::GetFileSet(MediaLibraryCommand &cmd, const vector<string> &columns,
     shared_ptr<NativeRdb::ResultSet> &resultSet)
 {
@@ -531,6 +637,11 @@ int32_t MediaScannerDb::GetFileBasicInfo(const string &path, unique_ptr<Metadata
     OperationObject oprnObject = OperationObject::FILESYSTEM_ASSET;
     GetQueryParamsByPath(path, api, columns, oprnObject, whereClause);
 
+    if ((api == MediaLibraryApi::API_OLD) &&
+        GetFileBasicInfoFromIndex(path, GetTableNameByOprnObject(oprnObject), ptr)) {
+        return E_OK;
+    }
+
     vector<string> args;
     if (oprnObject == OperationObject::FILESYSTEM_PHOTO || oprnObject == OperationObject::FILESYSTEM_AUDIO) {
         args = { path };
@@ -555,6 +666,242 @@ int32_t MediaScannerDb::GetFileBasicInfo(const string &path, unique_ptr<Metadata
     return FillMetadata(resultSet, ptr);
 }
 
+bool MediaScannerDb::GetFileBasicInfoFromIndex(const string &path, const string &tableName,
+    unique_ptr<Metadata> &ptr)
+{
+    if (indexedDir_.empty() || path.compare(0, indexedDir_.length(), indexedDir_) != 0) {
+        return false;
+    }
+    auto tableItr = basicInfoIndex_.find(tableName);
+    if (tableItr == basicInfoIndex_.end()) {
+        return false;
+    }
+
+    /* a miss inside the indexed dir means the file is new, exactly as an empty query result */
+    ptr->SetTableName(tableName);
+    auto infoItr = tableItr->second.find(path);
+    if (infoItr == tableItr->second.end()) {
+        return true;
+    }
+
+    const ScanBasicInfo &info = infoItr->second;
+    ptr->SetFileId(info.fileId);
+    ptr->SetFileSize(info.size);
+    ptr->SetFileDateModified(info.dateModified);
+    ptr->SetFileName(info.name);
+    ptr->SetOrientation(info.orientation);
+    return true;
+}
+
+int32_t MediaScannerDb::ReadFileBasicInfo(const string &dir, const string &tableName,
+    unordered_map<string, ScanBasicInfo> &infoMap)
+{
+    AbsRdbPredicates predicates(tableName);
+    vector<string> columns = { MEDIA_DATA_DB_ID, MEDIA_DATA_DB_FILE_PATH, MEDIA_DATA_DB_SIZE,
+        MEDIA_DATA_DB_DATE_MODIFIED, MEDIA_DATA_DB_NAME };
+    if (tableName == MEDIALIBRARY_TABLE) {
+        predicates.SetWhereClause(MEDIA_DATA_DB_FILE_PATH + " LIKE ? AND " + MEDIA_DATA_DB_IS_TRASH + " = ?");
+        predicates.SetWhereArgs({ dir + "%", to_string(NOT_TRASHED) });
+        columns.push_back(MEDIA_DATA_DB_ORIENTATION);
+    } else {
+        predicates.SetWhereClause(MEDIA_DATA_DB_FILE_PATH + " LIKE ?");
+        predicates.SetWhereArgs({ dir + "%" });
+        if (tableName == PhotoColumn::PHOTOS_TABLE) {
+            columns.push_back(PhotoColumn::PHOTO_ORIENTATION);
+        }
+    }
+
+    auto rdbStore = MediaLibraryUnistoreManager::GetInstance().GetRdbStoreRaw();
+    if (rdbStore == nullptr) {
+        return E_HAS_DB_ERROR;
+    }
+    auto rdbStorePtr = rdbStore->GetRaw();
+    if (rdbStorePtr == nullptr) {
+        return E_HAS_DB_ERROR;
+    }
+    auto resultSet = rdbStorePtr->Query(predicates, columns);
+    if (resultSet == nullptr) {
+        VariantMap map = {{KEY_ERR_FILE, __FILE__}, {KEY_ERR_LINE, __LINE__}, {KEY_ERR_CODE, E_HAS_DB_ERROR},
+            {KEY_OPT_TYPE, OptType::SCAN}};
+        PostEventUtils::GetInstance().PostErrorProcess(ErrType::DB_OPT_ERR, map);
+        return E_HAS_DB_ERROR;
+    }
+
+    bool hasOrientation = (tableName != AudioColumn::AUDIOS_TABLE);
+    while (resultSet->GoToNextRow() == NativeRdb::E_OK) {
+        ScanBasicInfo info;
+        info.fileId = GetInt32Val(MEDIA_DATA_DB_ID, resultSet);
+        info.size = GetInt64Val(MEDIA_DATA_DB_SIZE, resultSet);
+        info.dateModified = GetInt64Val(MEDIA_DATA_DB_DATE_MODIFIED, resultSet);
+        info.name = GetStringVal(MEDIA_DATA_DB_NAME, resultSet);
+        if (hasOrientation) {
+            info.orientation = GetInt32Val(MEDIA_DATA_DB_ORIENTATION, resultSet);
+        }
+        infoMap.emplace(GetStringVal(MEDIA_DATA_DB_FILE_PATH, resultSet), move(info));
+    }
+    return E_OK;
+}
+
+/**
+ * @brief Load the basic info of every file under a dir with one query per table, so that
+ * GetFileBasicInfo is answered from memory for the rest of the directory scan
+ *
+ * @param dir The directory about to be scanned
+ * @return int32_t E_OK if the index is ready, otherwise GetFileBasicInfo keeps querying per file
+ */
+int32_t MediaScannerDb::PrefetchFileBasicInfo(const string &dir)
+{
+    ClearFileBasicInfo();
+    if (dir.empty()) {
+        return E_INVALID_ARGUMENTS;
+    }
+
+    string queryDir = dir.back() != '/' ? dir + "/" : dir;
+    vector<string> tables = { MEDIALIBRARY_TABLE, PhotoColumn::PHOTOS_TABLE, AudioColumn::AUDIOS_TABLE };
+    for (const auto &table : tables) {
+        int32_t err = ReadFileBasicInfo(queryDir, table, basicInfoIndex_[table]);
+        if (err != E_OK) {
+            MEDIA_ERR_LOG("failed to prefetch basic info from %{public}s, err %{public}d", table.c_str(), err);
+            ClearFileBasicInfo();
+            return err;
+        }
+    }
+    indexedDir_ = move(queryDir);
+
+    return E_OK;
+}
+
+void MediaScannerDb::ClearFileBasicInfo()
+{
+    indexedDir_.clear();
+    basicInfoIndex_.clear();
+}
+
+/**
+ * @brief Look a file up in the prefetched index only, neither the db nor the file system is touched
+ *
+ * @param path The file path
+ * @param tableName The table the file lives in
+ * @param fileId The id of the file
+ * @return bool true if the file is known to the index
+ */
+bool MediaScannerDb::GetIndexedFileId(const string &path, string &tableName, int32_t &fileId)
+{
+    vector<string> columns;
+    string whereClause;
+    OperationObject oprnObject = OperationObject::FILESYSTEM_ASSET;
+    GetQueryParamsByPath(path, MediaLibraryApi::API_OLD, columns, oprnObject, whereClause);
+
+    unique_ptr<Metadata> data = make_unique<Metadata>();
+    if (!GetFileBasicInfoFromIndex(path, GetTableNameByOprnObject(oprnObject), data) ||
+        data->GetFileId() == FILE_ID_DEFAULT) {
+        return false;
+    }
+    tableName = data->GetTableName();
+    fileId = data->GetFileId();
+    return true;
+}
+
+static const string SCAN_JOURNAL_WHERE_CLAUSE = SCAN_JOURNAL_DIR + " = ? OR " + SCAN_JOURNAL_DIR + " LIKE ?";
+
+/**
+ * @brief Read the directory fingerprints recorded by the last successful scan of dir and its subdirectories
+ *
+ * @param dir The directory about to be scanned, without a trailing slash
+ * @param journal The fingerprint of every recorded directory
+ * @return int32_t E_OK if the journal has been read
+ */
+int32_t MediaScannerDb::ReadScanJournal(const string &dir, ScanJournal &journal)
+{
+    auto rdbStore = MediaLibraryUnistoreManager::GetInstance().GetRdbStoreRaw();
+    if (rdbStore == nullptr) {
+        return E_HAS_DB_ERROR;
+    }
+    auto rdbStorePtr = rdbStore->GetRaw();
+    if (rdbStorePtr == nullptr) {
+        return E_HAS_DB_ERROR;
+    }
+
+    AbsRdbPredicates predicates(MEDIALIBRARY_SCAN_JOURNAL_TABLE);
+    predicates.SetWhereClause(SCAN_JOURNAL_WHERE_CLAUSE);
+    predicates.SetWhereArgs({ dir, dir + "/%" });
+    vector<string> columns = { SCAN_JOURNAL_DIR, SCAN_JOURNAL_INODE, SCAN_JOURNAL_MTIME };
+    auto resultSet = rdbStorePtr->Query(predicates, columns);
+    if (resultSet == nullptr) {
+        MEDIA_ERR_LOG("rdb query return nullptr");
+        VariantMap map = {{KEY_ERR_FILE, __FILE__}, {KEY_ERR_LINE, __LINE__}, {KEY_ERR_CODE, E_HAS_DB_ERROR},
+            {KEY_OPT_TYPE, OptType::SCAN}};
+        PostEventUtils::GetInstance().PostErrorProcess(ErrType::DB_OPT_ERR, map);
+        return E_HAS_DB_ERROR;
+    }
+
+    journal.clear();
+    while (resultSet->GoToNextRow() == NativeRdb::E_OK) {
+        ScanDirFingerprint fingerprint;
+        fingerprint.inode = GetInt64Val(SCAN_JOURNAL_INODE, resultSet);
+        fingerprint.mtime = GetInt64Val(SCAN_JOURNAL_MTIME, resultSet);
+        journal.emplace(GetStringVal(SCAN_JOURNAL_DIR, resultSet), fingerprint);
+    }
+    return E_OK;
+}
+
+/**
+ * @brief Replace the recorded fingerprints of dir and its subdirectories, in one transaction
+ *
+ * @param dir The directory that has been scanned successfully, without a trailing slash
+ * @param journal The fingerprint of every directory seen by the scan
+ * @return int32_t E_OK if the journal has been replaced, otherwise the previous journal is kept
+ */
+int32_t MediaScannerDb::UpdateScanJournal(const string &dir, const ScanJournal &journal)
+{
+    auto rdbStore = MediaLibraryUnistoreManager::GetInstance().GetRdbStoreRaw();
+    if (rdbStore == nullptr) {
+        return E_HAS_DB_ERROR;
+    }
+    auto rdbStorePtr = rdbStore->GetRaw();
+    if (rdbStorePtr == nullptr) {
+        return E_HAS_DB_ERROR;
+    }
+
+    TransactionOperations transactionOprn(rdbStorePtr);
+    int32_t err = transactionOprn.Start();
+    if (err != E_OK) {
+        MEDIA_ERR_LOG("failed to start transaction, err %{public}d", err);
+        return err;
+    }
+
+    int32_t deletedRows = 0;
+    vector<string> whereArgs = { dir, dir + "/%" };
+    int32_t ret = rdbStorePtr->Delete(deletedRows, MEDIALIBRARY_SCAN_JOURNAL_TABLE, SCAN_JOURNAL_WHERE_CLAUSE,
+        whereArgs);
+    if (ret != NativeRdb::E_OK) {
+        MEDIA_ERR_LOG("rdb delete err %{public}d", ret);
+        VariantMap map = {{KEY_ERR_FILE, __FILE__}, {KEY_ERR_LINE, __LINE__}, {KEY_ERR_CODE, ret},
+            {KEY_OPT_TYPE, OptType::SCAN}};
+        PostEventUtils::GetInstance().PostErrorProcess(ErrType::DB_OPT_ERR, map);
+        return E_HAS_DB_ERROR;
+    }
+
+    for (const auto &itr : journal) {
+        ValuesBucket values;
+        values.PutString(SCAN_JOURNAL_DIR, itr.first);
+        values.PutLong(SCAN_JOURNAL_INODE, itr.second.inode);
+        values.PutLong(SCAN_JOURNAL_MTIME, itr.second.mtime);
+        int64_t rowId = -1;
+        ret = rdbStorePtr->Insert(rowId, MEDIALIBRARY_SCAN_JOURNAL_TABLE, values);
+        if (ret != NativeRdb::E_OK) {
+            MEDIA_ERR_LOG("rdb insert err %{public}d", ret);
+            VariantMap map = {{KEY_ERR_FILE, __FILE__}, {KEY_ERR_LINE, __LINE__}, {KEY_ERR_CODE, ret},
+                {KEY_OPT_TYPE, OptType::SCAN}};
+            PostEventUtils::GetInstance().PostErrorProcess(ErrType::DB_OPT_ERR, map);
+            return E_HAS_DB_ERROR;
+        }
+    }
+    transactionOprn.Finish();
+
+    return E_OK;
+}
+
 static void PreparePredicatesAndColumns(const string &path, const string &tableName, const string &whitePath,
     AbsRdbPredicates &predicates, vector<string> &columns)
 {
@@ -975,5 +1322,17 @@ void MediaScannerDb::UpdateAlbumInfo(const std::vector<std::string> &subtypes,
     MediaLibraryRdbUtils::UpdateUserAlbumInternal(
         MediaLibraryUnistoreManager::GetInstance().GetRdbStoreRaw()->GetRaw(), userAlbumIds);
 }
+
+void MediaScannerDb::CaptureAlbumMembership(const string &fileId, AlbumMembership &membership)
+{
+    MediaLibraryRdbUtils::CaptureAlbumMembership(MediaLibraryUnistoreManager::GetInstance().GetRdbStoreRaw()->GetRaw(),
+        { fileId }, membership);
+}
+
+void MediaScannerDb::UpdateAlbumInfo(const AlbumMembership &membership)
+{
+    MediaLibraryRdbUtils::UpdateAlbumsByMembership(
+        MediaLibraryUnistoreManager::GetInstance().GetRdbStoreRaw()->GetRaw(), membership);
+}
 } // namespace Media
 } // namespace OHOS
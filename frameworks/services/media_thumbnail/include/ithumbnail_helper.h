@@ -74,12 +74,15 @@ public:
     static void CreateLcd(AsyncTaskData *data);
     static void CreateThumbnail(AsyncTaskData *data);
     static void AddAsyncTask(MediaLibraryExecute executor, ThumbRdbOpt &opts, ThumbnailData &data, bool isFront);
+    static bool DoCreateThumbnail(ThumbRdbOpt &opts, ThumbnailData &data);
+    static bool DoCreateThumbnailAndLcd(ThumbRdbOpt &opts, ThumbnailData &data);
 protected:
     static void GetThumbnailInfo(ThumbRdbOpt &opts, ThumbnailData &outData);
     static std::unique_ptr<PixelMap> GetPixelMap(const std::vector<uint8_t> &image, Size &size);
     static bool DoCreateLcd(ThumbRdbOpt &opts, ThumbnailData &data);
-    static bool DoCreateThumbnail(ThumbRdbOpt &opts, ThumbnailData &data);
 private:
+    static bool GenLcd(ThumbRdbOpt &opts, ThumbnailData &data);
+    static bool GenThumbnails(ThumbRdbOpt &opts, ThumbnailData &data);
     static bool GenThumbnail(ThumbRdbOpt &opts, ThumbnailData &data, const ThumbnailType type);
     static bool TryLoadSource(ThumbRdbOpt &opts, ThumbnailData &data, const Size &size, const std::string &suffix);
 };
@@ -23,14 +23,6 @@
 
 namespace OHOS {
 namespace Media {
-class AgingAsyncTaskData : public AsyncTaskData {
-public:
-    AgingAsyncTaskData() = default;
-    virtual ~AgingAsyncTaskData() override = default;
-    ThumbRdbOpt opts;
-    ThumbnailData thumbnailData;
-};
-
 class ThumbnailAgingHelper {
 public:
     ThumbnailAgingHelper() = delete;
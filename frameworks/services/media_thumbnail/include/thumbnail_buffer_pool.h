@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FRAMEWORKS_SERVICES_THUMBNAIL_SERVICE_INCLUDE_THUMBNAIL_BUFFER_POOL_H_
+#define FRAMEWORKS_SERVICES_THUMBNAIL_SERVICE_INCLUDE_THUMBNAIL_BUFFER_POOL_H_
+
+#include <mutex>
+#include <stdint.h>
+#include <vector>
+
+#include "thumbnail_const.h"
+
+namespace OHOS {
+namespace Media {
+struct ThumbnailBufferPoolStats {
+    uint64_t acquires = 0;
+    // acquires served by a pooled buffer that was big enough
+    uint64_t reuses = 0;
+    // acquires that had to allocate, and the bytes they asked for
+    uint64_t allocations = 0;
+    uint64_t allocatedBytes = 0;
+    size_t pooledBytes = 0;
+    // resident set size when the stats were reset and the largest one seen on Release since
+    size_t startRss = 0;
+    size_t peakRss = 0;
+};
+
+/**
+ * Keeps the encode buffers of the thumbnail pipeline for reuse instead of freeing them after every asset, so
+ * generating thousands of thumbnails does not churn the allocator of the long living service. Idle buffers are
+ * kept per ThumbnailType up to a small count each, and are only given back to the system by Trim.
+ */
+class ThumbnailBufferPool {
+public:
+    ThumbnailBufferPool() = default;
+    ThumbnailBufferPool(const ThumbnailBufferPool &other) = delete;
+    ThumbnailBufferPool &operator=(const ThumbnailBufferPool &other) = delete;
+    ~ThumbnailBufferPool() = default;
+
+    static ThumbnailBufferPool &GetInstance();
+
+    /* returns a buffer of size bytes, reusing a pooled one of the type when there is one */
+    std::vector<uint8_t> Acquire(ThumbnailType type, size_t size);
+    void Release(ThumbnailType type, std::vector<uint8_t> &&buffer);
+    /* frees every idle buffer, for memory pressure */
+    void Trim();
+
+    ThumbnailBufferPoolStats GetStats();
+    void ResetStats();
+
+private:
+    static constexpr size_t TYPE_COUNT = static_cast<size_t>(ThumbnailType::YEAR) + 1;
+
+    std::mutex mutex_;
+    std::vector<std::vector<uint8_t>> idle_[TYPE_COUNT];
+    ThumbnailBufferPoolStats stats_;
+};
+} // namespace Media
+} // namespace OHOS
+
+#endif  // FRAMEWORKS_SERVICES_THUMBNAIL_SERVICE_INCLUDE_THUMBNAIL_BUFFER_POOL_H_
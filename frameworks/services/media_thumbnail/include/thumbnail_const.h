@@ -69,6 +69,39 @@ const int32_t CREATE_THUMB_ASYNC_STATUS = 0;
 
 // request photo type
 const std::string REQUEST_PHOTO_TYPE = "request_photo_type";
+// request photo priority, bigger ones are decoded first
+const std::string REQUEST_PHOTO_PRIORITY = "request_photo_priority";
+
+// batch thumbnail open, file://media/Photo/thumbnail?operation=thumbnail_batch&ids=1,2,3&width=256&height=256
+const std::string THUMBNAIL_BATCH_OPERN = "thumbnail_batch";
+const std::string THUMBNAIL_BATCH_IDS = "ids";
+constexpr size_t THUMBNAIL_BATCH_MAX_COUNT = 100;
+constexpr size_t THUMBNAIL_BATCH_MAX_DATA_SIZE = 32 * 1024 * 1024;
+constexpr uint32_t THUMBNAIL_BATCH_MAGIC = 0x54484231;
+// data offsets are aligned so raw pixels can be read in place
+constexpr size_t THUMBNAIL_BATCH_ALIGN = 8;
+
+/* the opened fd holds a ThumbnailBatchHeader, count ThumbnailBatchEntry in request order, then the data */
+struct ThumbnailBatchHeader {
+    uint32_t magic;
+    uint32_t count;
+};
+
+enum ThumbnailBatchStatus : int32_t {
+    THUMBNAIL_BATCH_OK = 0,
+    // no thumbnail yet, open it alone to have it generated
+    THUMBNAIL_BATCH_NEED_GENERATE,
+    // asset not found or over the data size limit
+    THUMBNAIL_BATCH_FAIL,
+};
+
+struct ThumbnailBatchEntry {
+    int32_t fileId;
+    int32_t status;
+    // from the start of the fd, valid with THUMBNAIL_BATCH_OK only
+    uint32_t offset;
+    uint32_t length;
+};
 
 static inline std::string GetThumbnailPath(const std::string &path, const std::string &key)
 {
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FRAMEWORKS_SERVICES_THUMBNAIL_SERVICE_INCLUDE_THUMBNAIL_GENERATE_ENGINE_H_
+#define FRAMEWORKS_SERVICES_THUMBNAIL_SERVICE_INCLUDE_THUMBNAIL_GENERATE_ENGINE_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ithumbnail_helper.h"
+#include "thumbnail_utils.h"
+
+namespace OHOS {
+namespace Media {
+const std::string THUMBNAIL_GENERATE_CHECKPOINT_FILE = ROOT_MEDIA_DIR + ".thumbs/.generate_checkpoint";
+
+/* levels of the thermal manager, the engine slows down from WARM and pauses from OVERHEATED */
+enum class ThumbnailThermalLevel : int32_t {
+    COOL = 0,
+    NORMAL,
+    WARM,
+    HOT,
+    OVERHEATED,
+};
+
+struct ThumbnailGenerateStats {
+    uint32_t generated = 0;
+    uint32_t failed = 0;
+    int32_t workers = 0;
+    // time spent decoding sources and encoding and saving thumbnails, summed over the workers
+    uint64_t decodeTimeMs = 0;
+    uint64_t encodeTimeMs = 0;
+    uint64_t elapsedMs = 0;
+};
+
+/**
+ * Generates the thumbnails and lcds missing in the tables on its own worker pool, sized from the cores and the
+ * thermal level, instead of on the shared async worker. A worker either decodes the source of an asset or encodes
+ * and saves the thumbnails of an asset decoded by another one, so file reads and decoding overlap encoding. Assets
+ * are scanned a page at a time, and the position after every finished page is saved, so a run stopped by the
+ * screen turning on goes on from there in the next run.
+ */
+class ThumbnailGenerateEngine {
+public:
+    ThumbnailGenerateEngine() = default;
+    ThumbnailGenerateEngine(const ThumbnailGenerateEngine &other) = delete;
+    ThumbnailGenerateEngine &operator=(const ThumbnailGenerateEngine &other) = delete;
+    ~ThumbnailGenerateEngine();
+
+    static ThumbnailGenerateEngine &GetInstance();
+
+    /* starts a run over the tables in order, does nothing while a run is going on */
+    int32_t Start(const std::vector<ThumbRdbOpt> &tables);
+    /* the assets being worked on are finished, the rest of the run is dropped */
+    void Stop();
+    bool IsRunning();
+    void SetThermalLevel(int32_t level);
+    ThumbnailGenerateStats GetStats();
+
+    static int32_t GetWorkerNum(int32_t cores, int32_t thermalLevel);
+
+private:
+    /* encodes and saves the thumbnails of a decoded asset, returns whether all of them were saved */
+    using Executor = bool (*)(ThumbRdbOpt &opts, ThumbnailData &data);
+
+    struct Task {
+        Executor executor = nullptr;
+        GenerateAsyncTaskData data;
+        Size decodeSize;
+        bool isThumb = false;
+    };
+
+    void Run(std::vector<ThumbRdbOpt> tables);
+    int32_t GenerateTable(ThumbRdbOpt &opts);
+    bool GeneratePage(ThumbRdbOpt &opts, std::vector<ThumbnailData> &infos, int32_t &lcdBudget);
+    void StartWorkers();
+    void StopWorkers();
+    void Work(int32_t index);
+    bool CanWork(int32_t index);
+    void Decode(const std::shared_ptr<Task> &task);
+    void Encode(const std::shared_ptr<Task> &task);
+    void FinishTask(bool isGenerated);
+
+    void LoadCheckpoints();
+    void SaveCheckpoints();
+    static bool ReadCheckpoints(const std::string &path, std::map<std::string, ThumbnailCursor> &cursors);
+    static bool WriteCheckpoints(const std::string &path, const std::map<std::string, ThumbnailCursor> &cursors);
+
+    std::mutex runLock_;
+    std::thread runThread_;
+    std::atomic<bool> isRunning_{false};
+    std::atomic<bool> isStopped_{false};
+    std::atomic<int32_t> thermalLevel_{0};
+
+    std::mutex mutex_;
+    std::condition_variable workCv_;
+    std::condition_variable doneCv_;
+    std::deque<std::shared_ptr<Task>> decodeQueue_;
+    std::deque<std::shared_ptr<Task>> encodeQueue_;
+    int32_t decodingCount_ = 0;
+    int32_t pendingCount_ = 0;
+    int32_t activeWorkers_ = 0;
+    bool isWorkerExit_ = false;
+    std::vector<std::thread> workers_;
+    ThumbnailGenerateStats stats_;
+
+    bool isCheckpointLoaded_ = false;
+    std::map<std::string, ThumbnailCursor> cursors_;
+};
+} // namespace Media
+} // namespace OHOS
+
+#endif  // FRAMEWORKS_SERVICES_THUMBNAIL_SERVICE_INCLUDE_THUMBNAIL_GENERATE_ENGINE_H_
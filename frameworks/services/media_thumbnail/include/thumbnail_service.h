@@ -37,6 +37,7 @@ public:
     THUMBNAIL_API_EXPORT void ReleaseService();
 
     THUMBNAIL_API_EXPORT int GetThumbnailFd(const std::string &uri);
+    THUMBNAIL_API_EXPORT int GetBatchThumbnailFd(const std::string &uri);
     THUMBNAIL_API_EXPORT int32_t LcdAging();
 #ifdef DISTRIBUTED
     THUMBNAIL_API_EXPORT int32_t LcdDistributeAging(const std::string &udid);
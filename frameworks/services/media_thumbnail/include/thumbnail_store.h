@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FRAMEWORKS_SERVICES_THUMBNAIL_SERVICE_INCLUDE_THUMBNAIL_STORE_H_
+#define FRAMEWORKS_SERVICES_THUMBNAIL_SERVICE_INCLUDE_THUMBNAIL_STORE_H_
+
+#include <shared_mutex>
+#include <string>
+#include <sys/types.h>
+#include <unordered_map>
+#include <vector>
+
+#include "thumbnail_const.h"
+
+namespace OHOS {
+namespace Media {
+const std::string THUMBNAIL_STORE_DIR = ROOT_MEDIA_DIR + ".thumbs/.pack";
+const std::string THUMBNAIL_STORE_FILE = THUMBNAIL_STORE_DIR + "/thumbs.pack";
+
+/**
+ * Packs every thumbnail of every asset into one append-only segment file instead of one file per thumbnail.
+ *
+ * A record is a header, the key (thumbnail type and asset path) and the image bytes. Removing a thumbnail
+ * appends a tombstone record, the space is only given back by Compact, which rewrites the live records into
+ * a new segment. The offset index is kept in memory and rebuilt from the record headers on first use, a torn
+ * record at the tail of the segment is cut off.
+ */
+class ThumbnailStore {
+public:
+    explicit ThumbnailStore(const std::string &packPath);
+    ThumbnailStore(const ThumbnailStore &other) = delete;
+    ThumbnailStore &operator=(const ThumbnailStore &other) = delete;
+    ~ThumbnailStore();
+
+    static ThumbnailStore &GetInstance();
+    /* true when thumbnails are saved into the store instead of per file */
+    static bool IsEnabled();
+
+    /* the record reaches the disk on the next Sync */
+    int32_t Put(const std::string &path, ThumbnailType type, const uint8_t *data, uint32_t size);
+    int32_t Sync();
+    bool Contains(const std::string &path, ThumbnailType type);
+    int32_t Read(const std::string &path, ThumbnailType type, std::vector<uint8_t> &data);
+    /* returns a read only fd which holds the image bytes only, or a negative error code */
+    int32_t OpenFd(const std::string &path, ThumbnailType type);
+    bool Remove(const std::string &path, ThumbnailType type);
+
+    int32_t Compact();
+    int32_t CompactIfNeeded();
+
+private:
+    struct IndexEntry {
+        off_t offset;
+        uint32_t length;
+        uint32_t checksum;
+    };
+
+    int32_t Load();
+    int32_t EnsureLoaded();
+    int32_t Recover();
+    int32_t AppendRecord(const std::string &key, const uint8_t *data, uint32_t size, uint32_t flags,
+        off_t &dataOffset, uint32_t &checksum);
+    static int32_t ReadEntry(int fd, const IndexEntry &entry, std::vector<uint8_t> &data);
+    void CloseFd();
+    static std::string GetKey(const std::string &path, ThumbnailType type);
+
+    std::shared_mutex mutex_;
+    std::string packPath_;
+    int fd_ = -1;
+    bool loaded_ = false;
+    off_t tail_ = 0;
+    uint64_t liveBytes_ = 0;
+    uint64_t deadBytes_ = 0;
+    std::unordered_map<std::string, IndexEntry> index_;
+};
+} // namespace Media
+} // namespace OHOS
+
+#endif  // FRAMEWORKS_SERVICES_THUMBNAIL_SERVICE_INCLUDE_THUMBNAIL_STORE_H_
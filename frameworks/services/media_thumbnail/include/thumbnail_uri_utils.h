@@ -16,6 +16,8 @@
 #ifndef FRAMEWORKS_SERVICES_THUMBNAIL_SERVICE_INCLUDE_THUMBNAIL_URI_UTILS_H_
 #define FRAMEWORKS_SERVICES_THUMBNAIL_SERVICE_INCLUDE_THUMBNAIL_URI_UTILS_H_
 
+#include <vector>
+
 #include "pixel_map.h"
 #include "userfile_manager_types.h"
 
@@ -29,6 +31,9 @@ public:
         std::string &outNetworkId, std::string &outTableName);
     static bool ParseThumbnailInfo(const std::string &uriString, std::string &outFileId,
         Size &outSize, std::string &outNetworkId, std::string &outTableName);
+    static bool IsBatchThumbnailUri(const std::string &uriString);
+    static bool ParseBatchThumbnailInfo(const std::string &uriString, std::vector<std::string> &outFileIds,
+        Size &outSize, std::string &outTableName);
 private:
     static void ParseThumbnailVersion(const std::string &key, const std::string &value, MediaLibraryApi api);
     static bool IsOriginalImg(const Size &outSize, const std::string &outPath);
@@ -43,6 +43,12 @@ struct ThumbRdbOpt {
     Size screenSize;
 };
 
+/* position in a date_added, file_id descending scan of a table, the scan goes on behind it */
+struct ThumbnailCursor {
+    int64_t dateAdded{0};
+    int32_t fileId{0};
+};
+
 struct ThumbnailData {
     ThumbnailData() {}
     virtual ~ThumbnailData()
@@ -53,6 +59,7 @@ struct ThumbnailData {
     }
     int mediaType{-1};
     int64_t dateModified{0};
+    int64_t dateAdded{0};
     float degrees;
     std::shared_ptr<PixelMap> source;
     std::vector<uint8_t> thumbnail;
@@ -95,6 +102,11 @@ public:
     static bool DeleteDistributeLcdData(ThumbRdbOpt &opts, ThumbnailData &thumbnailData);
 #endif
     static bool DeleteThumbFile(ThumbnailData &data, ThumbnailType type);
+    static bool IsThumbExist(const std::string &path, ThumbnailType type);
+    static int OpenThumbFd(const std::string &path, ThumbnailType type);
+    static int32_t ReadThumbData(const std::string &path, ThumbnailType type, std::vector<uint8_t> &data);
+    // returns a sealed memfd laid out as described at ThumbnailBatchHeader, and fills in the data offsets
+    static int WriteBatchFd(std::vector<ThumbnailBatchEntry> &entries, const std::vector<std::vector<uint8_t>> &datas);
     static bool DeleteDistributeThumbnailInfo(ThumbRdbOpt &opts);
 
     static bool GetKvResultSet(const std::shared_ptr<DistributedKv::SingleKvStore> &kvStore, const std::string &key,
@@ -104,6 +116,7 @@ public:
     // Steps
     static bool LoadSourceImage(ThumbnailData &data, const Size &desiredSize, const bool isThumbnail = true);
     static bool GenTargetPixelmap(ThumbnailData &data, const Size &desiredSize);
+    static bool GenThumbSourceFromLcd(ThumbnailData &data);
     static DistributedKv::Status SaveThumbnailData(ThumbnailData &data, const std::string &networkId,
         const std::shared_ptr<DistributedKv::SingleKvStore> &kvStore);
 
@@ -128,6 +141,9 @@ public:
         std::vector<ThumbnailData> &infos, int &err);
     static bool QueryNoLcdInfos(ThumbRdbOpt &opts, int LcdLimit, std::vector<ThumbnailData> &infos, int &err);
     static bool QueryNoThumbnailInfos(ThumbRdbOpt &opts, std::vector<ThumbnailData> &infos, int &err);
+    /* a page behind the cursor, which moves to the last row read, isEnd is set once fewer than limit rows are left */
+    static bool QueryNoThumbnailInfos(ThumbRdbOpt &opts, ThumbnailCursor &cursor, int32_t limit,
+        std::vector<ThumbnailData> &infos, bool &isEnd, int &err);
     static bool QueryNewThumbnailCount(ThumbRdbOpt &opts, const int64_t &time, int &count, int &err);
     static bool QueryDeviceThumbnailRecords(ThumbRdbOpt &opts, std::vector<ThumbnailData> &infos, int &err);
     static bool QueryLcdCountByTime(const int64_t &time, const bool &before, ThumbRdbOpt &opts, int &outLcdCount,
@@ -34,8 +34,7 @@ int32_t DefaultThumbnailHelper::CreateThumbnail(ThumbRdbOpt &opts, bool isSync)
     ThumbnailData thumbnailData;
     GetThumbnailInfo(opts, thumbnailData);
 
-    string fileName = GetThumbnailPath(thumbnailData.path, THUMBNAIL_THUMB_SUFFIX);
-    if (access(fileName.c_str(), F_OK) == 0) {
+    if (ThumbnailUtils::IsThumbExist(thumbnailData.path, ThumbnailType::THUMB)) {
         MEDIA_DEBUG_LOG("CreateThumbnail key is same, no need generate");
         return E_OK;
     }
@@ -59,20 +58,15 @@ int32_t DefaultThumbnailHelper::GetThumbnailPixelMap(ThumbRdbOpt &opts, const Si
     if (opts.table == AudioColumn::AUDIOS_TABLE) {
         type = ThumbnailType::THUMB;
     }
-    string fileName = GetThumbnailPath(thumbnailData.path, GetThumbSuffix(type));
-    if (access(fileName.c_str(), F_OK) != 0) {
+    if (!ThumbnailUtils::IsThumbExist(thumbnailData.path, type)) {
         if (!DoCreateThumbnail(opts, thumbnailData)) {
             return E_THUMBNAIL_LOCAL_CREATE_FAIL;
         }
         if (!opts.path.empty()) {
-            fileName = GetThumbnailPath(thumbnailData.path, THUMBNAIL_THUMB_SUFFIX);
+            type = ThumbnailType::THUMB;
         }
     }
-    auto fd = open(fileName.c_str(), O_RDONLY);
-    if (fd >= 0) {
-        return fd;
-    }
-    return -errno;
+    return ThumbnailUtils::OpenThumbFd(thumbnailData.path, type);
 }
 } // namespace Media
 } // namespace OHOS
@@ -25,7 +25,9 @@
 #include "media_log.h"
 #include "rdb_helper.h"
 #include "single_kvstore.h"
+#include "thumbnail_buffer_pool.h"
 #include "thumbnail_const.h"
+#include "thumbnail_store.h"
 #include "post_event_utils.h"
 
 using namespace std;
@@ -190,8 +192,8 @@ bool IThumbnailHelper::TryLoadSource(ThumbRdbOpt &opts, ThumbnailData &data, con
         } else {
             opts.path = "";
             GetThumbnailInfo(opts, data);
-            string fileName = GetThumbnailPath(data.path, suffix);
-            if (access(fileName.c_str(), F_OK) == 0) {
+            ThumbnailType type = (suffix == THUMBNAIL_THUMB_SUFFIX) ? ThumbnailType::THUMB : ThumbnailType::LCD;
+            if (ThumbnailUtils::IsThumbExist(data.path, type)) {
                 return true;
             }
             if (!ThumbnailUtils::LoadSourceImage(data, size, suffix == THUMBNAIL_THUMB_SUFFIX)) {
@@ -213,7 +215,11 @@ bool IThumbnailHelper::DoCreateLcd(ThumbRdbOpt &opts, ThumbnailData &data)
     if (ret == WaitStatus::WAIT_SUCCESS) {
         return true;
     }
+    return GenLcd(opts, data);
+}
 
+bool IThumbnailHelper::GenLcd(ThumbRdbOpt &opts, ThumbnailData &data)
+{
     if (!TryLoadSource(opts, data, opts.screenSize, THUMBNAIL_LCD_SUFFIX)) {
         VariantMap map = {{KEY_ERR_FILE, __FILE__}, {KEY_ERR_LINE, __LINE__}, {KEY_ERR_CODE, E_THUMBNAIL_UNKNOWN},
             {KEY_OPT_FILE, opts.path}, {KEY_OPT_TYPE, OptType::THUMB}};
@@ -229,6 +235,7 @@ bool IThumbnailHelper::DoCreateLcd(ThumbRdbOpt &opts, ThumbnailData &data)
     }
 
     shared_ptr<string> pathPtr = make_shared<string>(data.path);
+    data.lcd = ThumbnailBufferPool::GetInstance().Acquire(ThumbnailType::LCD, data.source->GetByteCount());
     if (!ThumbnailUtils::CompressImage(data.source, data.lcd, data.mediaType == MEDIA_TYPE_AUDIO, pathPtr)) {
         VariantMap map = {{KEY_ERR_FILE, __FILE__}, {KEY_ERR_LINE, __LINE__}, {KEY_ERR_CODE, E_THUMBNAIL_UNKNOWN},
             {KEY_OPT_FILE, opts.path}, {KEY_OPT_TYPE, OptType::THUMB}};
@@ -246,7 +253,11 @@ bool IThumbnailHelper::DoCreateLcd(ThumbRdbOpt &opts, ThumbnailData &data)
         return false;
     }
 
+    ThumbnailBufferPool::GetInstance().Release(ThumbnailType::LCD, move(data.lcd));
     data.lcd.clear();
+    if (ThumbnailStore::IsEnabled()) {
+        (void)ThumbnailStore::GetInstance().Sync();
+    }
     if (!ThumbnailUtils::UpdateLcdInfo(opts, data, err)) {
         MEDIA_INFO_LOG("UpdateLcdInfo faild err : %{public}d", err);
         VariantMap map = {{KEY_ERR_FILE, __FILE__}, {KEY_ERR_LINE, __LINE__}, {KEY_ERR_CODE, err},
@@ -278,6 +289,8 @@ bool IThumbnailHelper::GenThumbnail(ThumbRdbOpt &opts, ThumbnailData &data, cons
             return false;
         }
 
+        data.thumbnail = ThumbnailBufferPool::GetInstance().Acquire(ThumbnailType::THUMB,
+            data.source->GetByteCount());
         if (!ThumbnailUtils::CompressImage(data.source, data.thumbnail)) {
             MEDIA_ERR_LOG("CompressImage faild id %{private}s", opts.row.c_str());
             VariantMap map = {{KEY_ERR_FILE, __FILE__}, {KEY_ERR_LINE, __LINE__}, {KEY_ERR_CODE, E_THUMBNAIL_UNKNOWN},
@@ -302,6 +315,9 @@ bool IThumbnailHelper::GenThumbnail(ThumbRdbOpt &opts, ThumbnailData &data, cons
         PostEventUtils::GetInstance().PostErrorProcess(ErrType::FILE_OPT_ERR, map);
         return false;
     }
+    if (isThumb) {
+        ThumbnailBufferPool::GetInstance().Release(ThumbnailType::THUMB, move(data.thumbnail));
+    }
     data.thumbnail.clear();
     return true;
 }
@@ -313,7 +329,11 @@ bool IThumbnailHelper::DoCreateThumbnail(ThumbRdbOpt &opts, ThumbnailData &data)
     if (ret == WaitStatus::WAIT_SUCCESS) {
         return true;
     }
+    return GenThumbnails(opts, data);
+}
 
+bool IThumbnailHelper::GenThumbnails(ThumbRdbOpt &opts, ThumbnailData &data)
+{
     if (!GenThumbnail(opts, data, ThumbnailType::THUMB)) {
         VariantMap map = {{KEY_ERR_FILE, __FILE__}, {KEY_ERR_LINE, __LINE__}, {KEY_ERR_CODE, E_THUMBNAIL_UNKNOWN},
             {KEY_OPT_FILE, opts.path}, {KEY_OPT_TYPE, OptType::THUMB}};
@@ -334,8 +354,35 @@ bool IThumbnailHelper::DoCreateThumbnail(ThumbRdbOpt &opts, ThumbnailData &data)
             return false;
         }
     }
+    /* one sync for every thumbnail of the asset instead of one per file */
+    if (ThumbnailStore::IsEnabled()) {
+        (void)ThumbnailStore::GetInstance().Sync();
+    }
 
     return true;
 }
+
+bool IThumbnailHelper::DoCreateThumbnailAndLcd(ThumbRdbOpt &opts, ThumbnailData &data)
+{
+    ThumbnailWait lcdWait(true);
+    if (lcdWait.InsertAndWait(data.id, true) == WaitStatus::WAIT_SUCCESS) {
+        /* a source decoded ahead by the generate engine is at lcd size */
+        if ((data.source != nullptr) && !ThumbnailUtils::GenThumbSourceFromLcd(data)) {
+            data.source = nullptr;
+        }
+        return DoCreateThumbnail(opts, data);
+    }
+    ThumbnailWait thumbnailWait(true);
+    if (thumbnailWait.InsertAndWait(data.id, false) == WaitStatus::WAIT_SUCCESS) {
+        return GenLcd(opts, data);
+    }
+
+    /* decode the source once at lcd size, the thumbnails are scaled down from the lcd pixel map */
+    bool isLcdCreated = GenLcd(opts, data);
+    if (!isLcdCreated || !ThumbnailUtils::GenThumbSourceFromLcd(data)) {
+        data.source = nullptr;
+    }
+    return GenThumbnails(opts, data) && isLcdCreated;
+}
 } // namespace Media
 } // namespace OHOS
\ No newline at end of file
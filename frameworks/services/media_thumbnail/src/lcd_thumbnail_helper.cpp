@@ -34,8 +34,7 @@ int32_t LcdThumbnailHelper::CreateThumbnail(ThumbRdbOpt &opts, bool isSync)
     ThumbnailData thumbnailData;
     GetThumbnailInfo(opts, thumbnailData);
 
-    string fileName = GetThumbnailPath(thumbnailData.path, THUMBNAIL_LCD_SUFFIX);
-    if (access(fileName.c_str(), F_OK) == 0) {
+    if (ThumbnailUtils::IsThumbExist(thumbnailData.path, ThumbnailType::LCD)) {
         MEDIA_DEBUG_LOG("CreateThumbnail key is same, no need generate");
         return E_OK;
     }
@@ -56,21 +55,16 @@ int32_t LcdThumbnailHelper::GetThumbnailPixelMap(ThumbRdbOpt &opts, const Size &
     ThumbnailData thumbnailData;
     GetThumbnailInfo(opts, thumbnailData);
 
-    string fileName = GetThumbnailPath(thumbnailData.path, THUMBNAIL_LCD_SUFFIX);
-    if (access(fileName.c_str(), F_OK) != 0) {
+    if (!ThumbnailUtils::IsThumbExist(thumbnailData.path, ThumbnailType::LCD)) {
         if (!DoCreateLcd(opts, thumbnailData)) {
             return E_THUMBNAIL_LOCAL_CREATE_FAIL;
         }
-        if (!opts.path.empty()) {
-            fileName = GetThumbnailPath(thumbnailData.path, THUMBNAIL_LCD_SUFFIX);
-        }
     }
-    auto fd = open(fileName.c_str(), O_RDONLY);
+    auto fd = ThumbnailUtils::OpenThumbFd(thumbnailData.path, ThumbnailType::LCD);
     if (fd >= 0) {
         ThumbnailUtils::UpdateVisitTime(opts, thumbnailData, err);
-        return fd;
     }
-    return -errno;
+    return fd;
 }
 } // namespace Media
 } // namespace OHOS
@@ -26,46 +26,6 @@ using namespace OHOS::NativeRdb;
 
 namespace OHOS {
 namespace Media {
-static void AgingLcd(AsyncTaskData *data)
-{
-    if (data == nullptr) {
-        return;
-    }
-    AgingAsyncTaskData* taskData = static_cast<AgingAsyncTaskData*>(data);
-    int32_t err = ThumbnailAgingHelper::ClearLcdFromFileTable(taskData->opts);
-    if (err != E_OK) {
-        MEDIA_ERR_LOG("Failed to ClearLcdFormFileTable %{public}d", err);
-    }
-}
-
-#ifdef DISTRIBUTED
-static void AgingDistributeLcd(AsyncTaskData* data)
-{
-    if (data == nullptr) {
-        return;
-    }
-    AgingAsyncTaskData* taskData = static_cast<AgingAsyncTaskData*>(data);
-    int32_t err = ThumbnailAgingHelper::ClearRemoteLcdFromFileTable(taskData->opts);
-    if (err != E_OK) {
-        MEDIA_ERR_LOG("Failed to ClearRemoteLcdFormFileTable %{public}d", err);
-    }
-}
-#endif
-
-#ifdef DISTRIBUTED
-static void ClearThumbnailRecordTask(AsyncTaskData* data)
-{
-    if (data == nullptr) {
-        return;
-    }
-    AgingAsyncTaskData* taskData = static_cast<AgingAsyncTaskData*>(data);
-    int32_t err = ThumbnailAgingHelper::ClearKeyAndRecordFromMap(taskData->opts);
-    if (err != E_OK) {
-        MEDIA_ERR_LOG("Failed to ClearKeyAndRecordFromMap %{public}d", err);
-    }
-}
-#endif
-
 int32_t ThumbnailAgingHelper::AgingLcdBatch(ThumbRdbOpt &opts)
 {
     MEDIA_INFO_LOG("IN %{private}s", opts.table.c_str());
@@ -77,14 +37,14 @@ int32_t ThumbnailAgingHelper::AgingLcdBatch(ThumbRdbOpt &opts)
     if (asyncWorker == nullptr) {
         return E_ERR;
     }
-    AgingAsyncTaskData* taskData = new (std::nothrow)AgingAsyncTaskData();
-    if (taskData == nullptr) {
-        return E_ERR;
-    }
-    taskData->opts = opts;
-    shared_ptr<MediaLibraryAsyncTask> agingAsyncTask = make_shared<MediaLibraryAsyncTask>(AgingLcd, taskData);
+    shared_ptr<MediaLibraryAsyncTask> agingAsyncTask = make_shared<MediaLibraryAsyncTask>([opts]() mutable {
+        int32_t err = ThumbnailAgingHelper::ClearLcdFromFileTable(opts);
+        if (err != E_OK) {
+            MEDIA_ERR_LOG("Failed to ClearLcdFormFileTable %{public}d", err);
+        }
+    });
     if (agingAsyncTask != nullptr) {
-        asyncWorker->AddTask(agingAsyncTask, false);
+        asyncWorker->AddTask(agingAsyncTask, AsyncTaskPriority::IDLE);
     }
     return E_OK;
 }
@@ -145,14 +105,14 @@ int32_t ThumbnailAgingHelper::AgingDistributeLcdBatch(ThumbRdbOpt &opts)
     if (asyncWorker == nullptr) {
         return E_ERR;
     }
-    AgingAsyncTaskData* taskData = new AgingAsyncTaskData();
-    if (taskData == nullptr) {
-        return E_ERR;
-    }
-    taskData->opts = opts;
-    shared_ptr<MediaLibraryAsyncTask> agingAsyncTask = make_shared<MediaLibraryAsyncTask>(AgingDistributeLcd, taskData);
+    shared_ptr<MediaLibraryAsyncTask> agingAsyncTask = make_shared<MediaLibraryAsyncTask>([opts]() mutable {
+        int32_t err = ThumbnailAgingHelper::ClearRemoteLcdFromFileTable(opts);
+        if (err != E_OK) {
+            MEDIA_ERR_LOG("Failed to ClearRemoteLcdFormFileTable %{public}d", err);
+        }
+    });
     if (agingAsyncTask != nullptr) {
-        asyncWorker->AddTask(agingAsyncTask, false);
+        asyncWorker->AddTask(agingAsyncTask, AsyncTaskPriority::IDLE);
     }
     return E_OK;
 }
@@ -252,13 +212,12 @@ int32_t ThumbnailAgingHelper::InvalidateDistributeBatch(ThumbRdbOpt &opts)
     if (asyncWorker == nullptr) {
         return E_ERR;
     }
-    AgingAsyncTaskData* taskData = new (std::nothrow)AgingAsyncTaskData();
-    if (taskData == nullptr) {
-        return E_ERR;
-    }
-    taskData->opts = opts;
-    shared_ptr<MediaLibraryAsyncTask> agingAsyncTask = make_shared<MediaLibraryAsyncTask>(
-        ClearThumbnailRecordTask, taskData);
+    shared_ptr<MediaLibraryAsyncTask> agingAsyncTask = make_shared<MediaLibraryAsyncTask>([opts]() mutable {
+        int32_t err = ThumbnailAgingHelper::ClearKeyAndRecordFromMap(opts);
+        if (err != E_OK) {
+            MEDIA_ERR_LOG("Failed to ClearKeyAndRecordFromMap %{public}d", err);
+        }
+    });
     if (agingAsyncTask != nullptr) {
         asyncWorker->AddTask(agingAsyncTask, true);
     }
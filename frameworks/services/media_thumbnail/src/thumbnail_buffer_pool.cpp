@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define MLOG_TAG "Thumbnail"
+
+#include "thumbnail_buffer_pool.h"
+
+#include <fstream>
+#include <unistd.h>
+
+#include "media_log.h"
+
+using namespace std;
+
+namespace OHOS {
+namespace Media {
+// idle buffers kept per type: the background task encodes lcd and thumb of one asset at a time, while
+// requests from clients may encode a few thumbs in parallel
+static const size_t MAX_IDLE_BUFFERS[] = { 2, 4, 2, 2 };
+// a buffer above this is a one-off, such as a panorama lcd, and is not worth holding on to
+static constexpr size_t MAX_POOLED_BUFFER_SIZE = 16 * 1024 * 1024;
+static const string STATM_PATH = "/proc/self/statm";
+
+static size_t GetResidentSetSize()
+{
+    ifstream statm(STATM_PATH);
+    size_t totalPages = 0;
+    size_t residentPages = 0;
+    if (!(statm >> totalPages >> residentPages)) {
+        return 0;
+    }
+    return residentPages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+ThumbnailBufferPool &ThumbnailBufferPool::GetInstance()
+{
+    static ThumbnailBufferPool pool;
+    return pool;
+}
+
+vector<uint8_t> ThumbnailBufferPool::Acquire(ThumbnailType type, size_t size)
+{
+    size_t index = static_cast<size_t>(type);
+    vector<uint8_t> buffer;
+    {
+        lock_guard<mutex> lock(mutex_);
+        stats_.acquires++;
+        if (index < TYPE_COUNT && !idle_[index].empty()) {
+            buffer = move(idle_[index].back());
+            idle_[index].pop_back();
+            stats_.pooledBytes -= buffer.capacity();
+        }
+        if (buffer.capacity() >= size) {
+            stats_.reuses++;
+        } else {
+            stats_.allocations++;
+            stats_.allocatedBytes += size;
+        }
+    }
+    buffer.resize(size);
+    return buffer;
+}
+
+void ThumbnailBufferPool::Release(ThumbnailType type, vector<uint8_t> &&buffer)
+{
+    size_t index = static_cast<size_t>(type);
+    size_t rss = GetResidentSetSize();
+    vector<uint8_t> dropped;
+    lock_guard<mutex> lock(mutex_);
+    stats_.peakRss = max(stats_.peakRss, rss);
+    if (index >= TYPE_COUNT || buffer.capacity() == 0 || buffer.capacity() > MAX_POOLED_BUFFER_SIZE ||
+        idle_[index].size() >= MAX_IDLE_BUFFERS[index]) {
+        dropped = move(buffer);
+        return;
+    }
+    buffer.clear();
+    stats_.pooledBytes += buffer.capacity();
+    idle_[index].push_back(move(buffer));
+}
+
+void ThumbnailBufferPool::Trim()
+{
+    vector<vector<uint8_t>> dropped;
+    size_t trimmedBytes = 0;
+    {
+        lock_guard<mutex> lock(mutex_);
+        for (auto &buffers : idle_) {
+            for (auto &buffer : buffers) {
+                dropped.push_back(move(buffer));
+            }
+            buffers.clear();
+        }
+        trimmedBytes = stats_.pooledBytes;
+        stats_.pooledBytes = 0;
+    }
+    MEDIA_INFO_LOG("Trim thumbnail buffer pool, %{public}zu buffers, %{public}zu bytes", dropped.size(),
+        trimmedBytes);
+}
+
+ThumbnailBufferPoolStats ThumbnailBufferPool::GetStats()
+{
+    lock_guard<mutex> lock(mutex_);
+    return stats_;
+}
+
+void ThumbnailBufferPool::ResetStats()
+{
+    size_t rss = GetResidentSetSize();
+    lock_guard<mutex> lock(mutex_);
+    size_t pooledBytes = stats_.pooledBytes;
+    stats_ = ThumbnailBufferPoolStats();
+    stats_.pooledBytes = pooledBytes;
+    stats_.startRss = rss;
+    stats_.peakRss = rss;
+}
+} // namespace Media
+} // namespace OHOS
@@ -0,0 +1,432 @@
+/*
+ * Copyright (C) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#define MLOG_TAG "Thumbnail"
+
+#include "thumbnail_generate_engine.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "media_column.h"
+#include "medialibrary_errno.h"
+#include "media_log.h"
+#include "thumbnail_const.h"
+
+using namespace std;
+
+namespace OHOS {
+namespace Media {
+// share of the cores a run may keep busy, the rest stays with the foreground and the async worker
+static const int32_t CPU_BUDGET_PERCENT = 50;
+static const int32_t MAX_WORKER_NUM = 4;
+static const int32_t GENERATE_PAGE_SIZE = 100;
+static const string CHECKPOINT_TMP_SUFFIX = ".tmp";
+static constexpr mode_t CHECKPOINT_FILE_MODE = 0660;
+
+static int64_t GetSteadyTimeMs()
+{
+    return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int32_t GetCoreNum()
+{
+    return static_cast<int32_t>(thread::hardware_concurrency());
+}
+
+ThumbnailGenerateEngine::~ThumbnailGenerateEngine()
+{
+    Stop();
+    lock_guard<mutex> lock(runLock_);
+    if (runThread_.joinable()) {
+        runThread_.join();
+    }
+}
+
+ThumbnailGenerateEngine &ThumbnailGenerateEngine::GetInstance()
+{
+    static ThumbnailGenerateEngine engine;
+    return engine;
+}
+
+int32_t ThumbnailGenerateEngine::GetWorkerNum(int32_t cores, int32_t thermalLevel)
+{
+    if (thermalLevel >= static_cast<int32_t>(ThumbnailThermalLevel::OVERHEATED)) {
+        return 0;
+    }
+    if (thermalLevel >= static_cast<int32_t>(ThumbnailThermalLevel::HOT)) {
+        return 1;
+    }
+    int32_t num = max(cores, 1) * CPU_BUDGET_PERCENT / 100;
+    if (thermalLevel >= static_cast<int32_t>(ThumbnailThermalLevel::WARM)) {
+        num /= 2;
+    }
+    return min(max(num, 1), MAX_WORKER_NUM);
+}
+
+int32_t ThumbnailGenerateEngine::Start(const vector<ThumbRdbOpt> &tables)
+{
+    lock_guard<mutex> lock(runLock_);
+    if (isRunning_.load() && !isStopped_.load()) {
+        MEDIA_INFO_LOG("Thumbnail generate is running");
+        return E_OK;
+    }
+    /* a stopped run may still be finishing its last assets */
+    if (runThread_.joinable()) {
+        runThread_.join();
+    }
+    isStopped_ = false;
+    isRunning_ = true;
+    runThread_ = thread([this, tables]() { Run(tables); });
+    return E_OK;
+}
+
+void ThumbnailGenerateEngine::Stop()
+{
+    isStopped_ = true;
+    {
+        lock_guard<mutex> lock(mutex_);
+        pendingCount_ -= static_cast<int32_t>(decodeQueue_.size() + encodeQueue_.size());
+        decodeQueue_.clear();
+        encodeQueue_.clear();
+    }
+    workCv_.notify_all();
+    doneCv_.notify_all();
+}
+
+bool ThumbnailGenerateEngine::IsRunning()
+{
+    return isRunning_.load();
+}
+
+void ThumbnailGenerateEngine::SetThermalLevel(int32_t level)
+{
+    thermalLevel_ = level;
+    {
+        lock_guard<mutex> lock(mutex_);
+        activeWorkers_ = min(GetWorkerNum(GetCoreNum(), level), static_cast<int32_t>(workers_.size()));
+    }
+    workCv_.notify_all();
+}
+
+ThumbnailGenerateStats ThumbnailGenerateEngine::GetStats()
+{
+    lock_guard<mutex> lock(mutex_);
+    return stats_;
+}
+
+void ThumbnailGenerateEngine::Run(vector<ThumbRdbOpt> tables)
+{
+    pthread_setname_np(pthread_self(), "ThumbGenerate");
+    int64_t startTime = GetSteadyTimeMs();
+    LoadCheckpoints();
+    StartWorkers();
+    for (auto &opts : tables) {
+        if (isStopped_.load()) {
+            break;
+        }
+        int32_t err = GenerateTable(opts);
+        if (err != E_OK) {
+            MEDIA_ERR_LOG("Generate thumbnails of %{public}s failed, err %{public}d", opts.table.c_str(), err);
+        }
+    }
+    StopWorkers();
+
+    ThumbnailGenerateStats stats;
+    {
+        lock_guard<mutex> lock(mutex_);
+        stats_.elapsedMs = static_cast<uint64_t>(GetSteadyTimeMs() - startTime);
+        stats = stats_;
+    }
+    MEDIA_INFO_LOG("Thumbnail generate %{public}s: generated %{public}u, failed %{public}u, workers %{public}d, "
+        "decode %{public}llu ms, encode %{public}llu ms, elapsed %{public}llu ms",
+        isStopped_.load() ? "stopped" : "done", stats.generated, stats.failed, stats.workers,
+        static_cast<unsigned long long>(stats.decodeTimeMs), static_cast<unsigned long long>(stats.encodeTimeMs),
+        static_cast<unsigned long long>(stats.elapsedMs));
+    isRunning_ = false;
+}
+
+int32_t ThumbnailGenerateEngine::GenerateTable(ThumbRdbOpt &opts)
+{
+    if (opts.store == nullptr) {
+        MEDIA_ERR_LOG("rdbStore is not init");
+        return E_ERR;
+    }
+    int32_t err = E_OK;
+    int32_t lcdBudget = 0;
+    int lcdCount = 0;
+    if ((opts.table != AudioColumn::AUDIOS_TABLE) && ThumbnailUtils::QueryLcdCount(opts, lcdCount, err)) {
+        lcdBudget = max(THUMBNAIL_LCD_GENERATE_THRESHOLD - lcdCount, 0);
+    }
+
+    while (!isStopped_.load()) {
+        vector<ThumbnailData> infos;
+        ThumbnailCursor cursor = cursors_[opts.table];
+        bool isEnd = false;
+        if (!ThumbnailUtils::QueryNoThumbnailInfos(opts, cursor, GENERATE_PAGE_SIZE, infos, isEnd, err)) {
+            return err;
+        }
+        if (!infos.empty() && !GeneratePage(opts, infos, lcdBudget)) {
+            return E_OK;
+        }
+        /* the scan reached the oldest asset, the next run starts over from the newest one */
+        if (isEnd) {
+            cursors_.erase(opts.table);
+            SaveCheckpoints();
+            return E_OK;
+        }
+        cursors_[opts.table] = cursor;
+        SaveCheckpoints();
+    }
+    return E_OK;
+}
+
+/* queues the page and waits until every asset in it is done, returns false when the run is stopped */
+bool ThumbnailGenerateEngine::GeneratePage(ThumbRdbOpt &opts, vector<ThumbnailData> &infos, int32_t &lcdBudget)
+{
+    vector<shared_ptr<Task>> tasks;
+    for (auto &info : infos) {
+        auto task = make_shared<Task>();
+        task->data.opts = opts;
+        task->data.opts.row = info.id;
+        task->data.thumbnailData = info;
+        if (lcdBudget > 0) {
+            /* one decode at lcd size for the lcd and every thumbnail */
+            lcdBudget--;
+            task->executor = IThumbnailHelper::DoCreateThumbnailAndLcd;
+            task->decodeSize = opts.screenSize;
+            task->isThumb = false;
+        } else {
+            task->executor = IThumbnailHelper::DoCreateThumbnail;
+            task->decodeSize = { DEFAULT_THUMB_SIZE, DEFAULT_THUMB_SIZE };
+            task->isThumb = true;
+        }
+        tasks.push_back(task);
+    }
+
+    unique_lock<mutex> lock(mutex_);
+    if (isStopped_.load()) {
+        return false;
+    }
+    decodeQueue_.insert(decodeQueue_.end(), tasks.begin(), tasks.end());
+    pendingCount_ += static_cast<int32_t>(tasks.size());
+    workCv_.notify_all();
+    doneCv_.wait(lock, [this]() { return isStopped_.load() || (pendingCount_ <= 0); });
+    return !isStopped_.load();
+}
+
+void ThumbnailGenerateEngine::StartWorkers()
+{
+    int32_t num = GetWorkerNum(GetCoreNum(), static_cast<int32_t>(ThumbnailThermalLevel::COOL));
+    lock_guard<mutex> lock(mutex_);
+    isWorkerExit_ = false;
+    /* a task decoded while the last run was stopping may be left behind */
+    decodeQueue_.clear();
+    encodeQueue_.clear();
+    decodingCount_ = 0;
+    pendingCount_ = 0;
+    stats_ = ThumbnailGenerateStats();
+    activeWorkers_ = min(GetWorkerNum(GetCoreNum(), thermalLevel_.load()), num);
+    stats_.workers = activeWorkers_;
+    for (int32_t i = 0; i < num; i++) {
+        workers_.emplace_back([this, i]() { Work(i); });
+    }
+}
+
+void ThumbnailGenerateEngine::StopWorkers()
+{
+    {
+        lock_guard<mutex> lock(mutex_);
+        isWorkerExit_ = true;
+    }
+    workCv_.notify_all();
+    for (auto &worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    lock_guard<mutex> lock(mutex_);
+    workers_.clear();
+}
+
+/* workers above the thermal limit idle, and a source is decoded only while few decoded ones wait for encoding */
+bool ThumbnailGenerateEngine::CanWork(int32_t index)
+{
+    if (index >= activeWorkers_) {
+        return false;
+    }
+    if (!encodeQueue_.empty()) {
+        return true;
+    }
+    return !decodeQueue_.empty() && (decodingCount_ + static_cast<int32_t>(encodeQueue_.size()) < activeWorkers_);
+}
+
+void ThumbnailGenerateEngine::Work(int32_t index)
+{
+    string name("ThumbGenerate");
+    name.append(to_string(index));
+    pthread_setname_np(pthread_self(), name.c_str());
+    while (true) {
+        shared_ptr<Task> task;
+        bool isEncode = false;
+        {
+            unique_lock<mutex> lock(mutex_);
+            workCv_.wait(lock, [this, index]() { return isWorkerExit_ || CanWork(index); });
+            if (isWorkerExit_) {
+                return;
+            }
+            /* encoding first keeps the number of decoded sources in memory bounded */
+            if (!encodeQueue_.empty()) {
+                task = encodeQueue_.front();
+                encodeQueue_.pop_front();
+                isEncode = true;
+            } else {
+                task = decodeQueue_.front();
+                decodeQueue_.pop_front();
+                decodingCount_++;
+            }
+        }
+        if (isEncode) {
+            Encode(task);
+        } else {
+            Decode(task);
+        }
+    }
+}
+
+void ThumbnailGenerateEngine::Decode(const shared_ptr<Task> &task)
+{
+    int64_t startTime = GetSteadyTimeMs();
+    bool isDecoded = ThumbnailUtils::LoadSourceImage(task->data.thumbnailData, task->decodeSize, task->isThumb);
+    bool isDropped = !isDecoded || isStopped_.load();
+    {
+        lock_guard<mutex> lock(mutex_);
+        stats_.decodeTimeMs += static_cast<uint64_t>(GetSteadyTimeMs() - startTime);
+        decodingCount_--;
+        if (!isDropped) {
+            encodeQueue_.push_back(task);
+        }
+    }
+    workCv_.notify_all();
+    if (!isDecoded) {
+        MEDIA_ERR_LOG("Decode source failed, id %{public}s", task->data.thumbnailData.id.c_str());
+    }
+    if (isDropped) {
+        FinishTask(false);
+    }
+}
+
+void ThumbnailGenerateEngine::Encode(const shared_ptr<Task> &task)
+{
+    int64_t startTime = GetSteadyTimeMs();
+    /* the source is decoded already, the helper only encodes and saves, and waits for a foreground request */
+    bool isGenerated = task->executor(task->data.opts, task->data.thumbnailData);
+    task->data.thumbnailData.source = nullptr;
+    {
+        lock_guard<mutex> lock(mutex_);
+        stats_.encodeTimeMs += static_cast<uint64_t>(GetSteadyTimeMs() - startTime);
+    }
+    if (!isGenerated) {
+        MEDIA_ERR_LOG("Encode or save thumbnails failed, id %{public}s", task->data.thumbnailData.id.c_str());
+    }
+    FinishTask(isGenerated);
+}
+
+void ThumbnailGenerateEngine::FinishTask(bool isGenerated)
+{
+    bool isPageDone = false;
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (isGenerated) {
+            stats_.generated++;
+        } else if (!isStopped_.load()) {
+            stats_.failed++;
+        }
+        pendingCount_--;
+        isPageDone = pendingCount_ <= 0;
+    }
+    if (isPageDone) {
+        doneCv_.notify_all();
+    }
+}
+
+void ThumbnailGenerateEngine::LoadCheckpoints()
+{
+    if (isCheckpointLoaded_) {
+        return;
+    }
+    isCheckpointLoaded_ = true;
+    if (ReadCheckpoints(THUMBNAIL_GENERATE_CHECKPOINT_FILE, cursors_)) {
+        MEDIA_INFO_LOG("Thumbnail generate resumes %{public}zu tables", cursors_.size());
+    }
+}
+
+void ThumbnailGenerateEngine::SaveCheckpoints()
+{
+    if (!WriteCheckpoints(THUMBNAIL_GENERATE_CHECKPOINT_FILE, cursors_)) {
+        MEDIA_WARN_LOG("Save thumbnail generate checkpoint failed");
+    }
+}
+
+bool ThumbnailGenerateEngine::ReadCheckpoints(const string &path, map<string, ThumbnailCursor> &cursors)
+{
+    ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    cursors.clear();
+    string table;
+    ThumbnailCursor cursor;
+    while (file >> table >> cursor.dateAdded >> cursor.fileId) {
+        cursors[table] = cursor;
+    }
+    return true;
+}
+
+/* written aside, synced and renamed over the old one, so a crash keeps either of them whole */
+bool ThumbnailGenerateEngine::WriteCheckpoints(const string &path, const map<string, ThumbnailCursor> &cursors)
+{
+    string content;
+    for (const auto &[table, cursor] : cursors) {
+        content += table + ' ' + to_string(cursor.dateAdded) + ' ' + to_string(cursor.fileId) + '\n';
+    }
+    string tmpPath = path + CHECKPOINT_TMP_SUFFIX;
+    int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, CHECKPOINT_FILE_MODE);
+    if (fd < 0) {
+        return false;
+    }
+    size_t written = 0;
+    while (written < content.size()) {
+        ssize_t ret = write(fd, content.data() + written, content.size() - written);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            break;
+        }
+        written += static_cast<size_t>(ret);
+    }
+    // without the sync the rename may reach the disk before the data, and a power loss leaves an empty checkpoint
+    bool isSynced = (written == content.size()) && (fsync(fd) == 0);
+    close(fd);
+    return isSynced && (rename(tmpPath.c_str(), path.c_str()) == 0);
+}
+} // namespace Media
+} // namespace OHOS
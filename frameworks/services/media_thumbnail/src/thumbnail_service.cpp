@@ -16,6 +16,9 @@
 
 #include "thumbnail_service.h"
 
+#include <unordered_map>
+
+#include "abs_rdb_predicates.h"
 #include "ipc_skeleton.h"
 #include "display_manager.h"
 #include "media_column.h"
@@ -25,10 +28,14 @@
 #include "media_log.h"
 #include "result_set_utils.h"
 #include "thumbnail_aging_helper.h"
+#include "thumbnail_buffer_pool.h"
 #include "thumbnail_const.h"
+#include "thumbnail_generate_engine.h"
 #include "thumbnail_generate_helper.h"
 #include "thumbnail_helper_factory.h"
+#include "thumbnail_store.h"
 #include "thumbnail_uri_utils.h"
+#include "thumbnail_utils.h"
 #include "post_event_utils.h"
 
 using namespace std;
@@ -209,6 +216,68 @@ int ThumbnailService::GetThumbnailFd(const string &uri)
     return GetThumbFd(path, table, id, uri, size);
 }
 
+static int32_t QueryBatchPaths(const shared_ptr<RdbStore> &rdbStore, const string &table,
+    const vector<string> &ids, unordered_map<int32_t, string> &paths)
+{
+    if (rdbStore == nullptr) {
+        return E_HAS_DB_ERROR;
+    }
+    AbsRdbPredicates predicates(table);
+    predicates.In(MediaColumn::MEDIA_ID, ids);
+    predicates.EqualTo(MediaColumn::MEDIA_TIME_PENDING, to_string(0));
+    vector<string> columns = { MediaColumn::MEDIA_ID, MediaColumn::MEDIA_FILE_PATH };
+    auto resultSet = rdbStore->Query(predicates, columns);
+    if (resultSet == nullptr) {
+        return E_HAS_DB_ERROR;
+    }
+    while (resultSet->GoToNextRow() == NativeRdb::E_OK) {
+        paths[GetInt32Val(MediaColumn::MEDIA_ID, resultSet)] = GetStringVal(MediaColumn::MEDIA_FILE_PATH, resultSet);
+    }
+    return E_OK;
+}
+
+int ThumbnailService::GetBatchThumbnailFd(const string &uri)
+{
+    if (!CheckSizeValid()) {
+        return E_THUMBNAIL_INVALID_SIZE;
+    }
+    vector<string> ids;
+    Size size;
+    string table;
+    if (!ThumbnailUriUtils::ParseBatchThumbnailInfo(uri, ids, size, table) || !IsThumbnail(size.width, size.height)) {
+        MEDIA_ERR_LOG("invalid batch thumbnail uri %{private}s", uri.c_str());
+        return E_INVALID_URI;
+    }
+    unordered_map<int32_t, string> paths;
+    int32_t err = QueryBatchPaths(rdbStorePtr_, table, ids, paths);
+    if (err != E_OK) {
+        return err;
+    }
+
+    ThumbnailType type = GetThumbType(size.width, size.height);
+    if (table == AudioColumn::AUDIOS_TABLE) {
+        type = ThumbnailType::THUMB;
+    }
+    vector<ThumbnailBatchEntry> entries(ids.size());
+    vector<vector<uint8_t>> datas(ids.size());
+    size_t dataSize = 0;
+    for (size_t i = 0; i < ids.size(); i++) {
+        entries[i] = { stoi(ids[i]), THUMBNAIL_BATCH_FAIL, 0, 0 };
+        auto iter = paths.find(entries[i].fileId);
+        if (iter == paths.end() || dataSize >= THUMBNAIL_BATCH_MAX_DATA_SIZE) {
+            continue;
+        }
+        if (ThumbnailUtils::ReadThumbData(iter->second, type, datas[i]) != E_OK) {
+            // generating here would hold the whole batch, the caller opens these alone instead
+            entries[i].status = THUMBNAIL_BATCH_NEED_GENERATE;
+            continue;
+        }
+        dataSize += datas[i].size();
+        entries[i].status = THUMBNAIL_BATCH_OK;
+    }
+    return ThumbnailUtils::WriteBatchFd(entries, datas);
+}
+
 int32_t ThumbnailService::ParseThumbnailParam(const std::string &uri, string &fileId, string &networkId,
     string &tableName)
 {
@@ -307,6 +376,13 @@ void ThumbnailService::InterruptBgworker()
     if (asyncWorker != nullptr) {
         asyncWorker->Interrupt();
     }
+    ThumbnailGenerateEngine::GetInstance().Stop();
+    ThumbnailBufferPoolStats stats = ThumbnailBufferPool::GetInstance().GetStats();
+    MEDIA_INFO_LOG("Thumbnail buffers since generate: acquires %{public}llu, reuses %{public}llu, "
+        "allocations %{public}llu (%{public}llu bytes), pooled %{public}zu bytes, rss %{public}zu -> peak %{public}zu",
+        static_cast<unsigned long long>(stats.acquires), static_cast<unsigned long long>(stats.reuses),
+        static_cast<unsigned long long>(stats.allocations), static_cast<unsigned long long>(stats.allocatedBytes),
+        stats.pooledBytes, stats.startRss, stats.peakRss);
 }
 
 void ThumbnailService::StopAllWorker()
@@ -315,6 +391,7 @@ void ThumbnailService::StopAllWorker()
     if (asyncWorker != nullptr) {
         asyncWorker->Stop();
     }
+    ThumbnailGenerateEngine::GetInstance().Stop();
 }
 
 int32_t ThumbnailService::GenerateThumbnails()
@@ -322,33 +399,23 @@ int32_t ThumbnailService::GenerateThumbnails()
     if (!CheckSizeValid()) {
         return E_THUMBNAIL_INVALID_SIZE;
     }
-    int32_t err = 0;
+    ThumbnailBufferPool::GetInstance().ResetStats();
     vector<string> tableList;
     tableList.emplace_back(PhotoColumn::PHOTOS_TABLE);
     tableList.emplace_back(AudioColumn::AUDIOS_TABLE);
     tableList.emplace_back(MEDIALIBRARY_TABLE);
 
+    vector<ThumbRdbOpt> tables;
     for (const auto &tableName : tableList) {
         ThumbRdbOpt opts = {
             .store = rdbStorePtr_,
             .kvStore = kvStorePtr_,
-            .table = tableName
+            .table = tableName,
+            .screenSize = screenSize_
         };
-
-        err = ThumbnailGenerateHelper::CreateThumbnailBatch(opts);
-        if (err != E_OK) {
-            MEDIA_ERR_LOG("CreateThumbnailBatch failed : %{public}d", err);
-        }
-
-        if (tableName != AudioColumn::AUDIOS_TABLE) {
-            err = ThumbnailGenerateHelper::CreateLcdBatch(opts);
-            if (err != E_OK) {
-                MEDIA_ERR_LOG("CreateLcdBatch failed : %{public}d", err);
-            }
-        }
+        tables.push_back(opts);
     }
-
-    return err;
+    return ThumbnailGenerateEngine::GetInstance().Start(tables);
 }
 
 int32_t ThumbnailService::LcdAging()
@@ -371,6 +438,13 @@ int32_t ThumbnailService::LcdAging()
         }
     }
 
+    if (ThumbnailStore::IsEnabled()) {
+        err = ThumbnailStore::GetInstance().CompactIfNeeded();
+        if (err != E_OK) {
+            MEDIA_ERR_LOG("CompactIfNeeded failed : %{public}d", err);
+        }
+    }
+
     return E_OK;
 }
 
@@ -0,0 +1,442 @@
+/*
+ * Copyright (C) 2023 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MLOG_TAG "Thumbnail"
+
+#include "thumbnail_store.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "media_file_utils.h"
+#include "media_log.h"
+#include "medialibrary_errno.h"
+#include "post_event_utils.h"
+
+using namespace std;
+
+namespace OHOS {
+namespace Media {
+namespace {
+struct RecordHeader {
+    uint32_t magic;
+    uint32_t flags;
+    uint32_t keyLength;
+    uint32_t dataLength;
+    uint32_t checksum;
+};
+
+constexpr uint32_t RECORD_MAGIC = 0x4B505448; // "HTPK"
+constexpr uint32_t RECORD_FLAG_DELETED = 1;
+constexpr uint32_t MAX_KEY_LENGTH = 4096;
+constexpr uint32_t FNV_OFFSET_BASIS = 2166136261;
+constexpr uint32_t FNV_PRIME = 16777619;
+/* a compaction rewrites every live thumbnail, so it is only worth it once most of the segment is garbage */
+constexpr uint64_t COMPACT_MIN_DEAD_BYTES = 32 * 1024 * 1024;
+const mode_t PACK_FILE_MODE = 0660;
+}
+
+static uint32_t Checksum(const uint8_t *data, uint32_t size)
+{
+    uint32_t hash = FNV_OFFSET_BASIS;
+    for (uint32_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+static inline uint64_t GetRecordSize(const string &key, uint32_t dataLength)
+{
+    return sizeof(RecordHeader) + key.length() + dataLength;
+}
+
+ThumbnailStore::ThumbnailStore(const string &packPath) : packPath_(packPath) {}
+
+ThumbnailStore::~ThumbnailStore()
+{
+    CloseFd();
+}
+
+ThumbnailStore &ThumbnailStore::GetInstance()
+{
+    static ThumbnailStore store(THUMBNAIL_STORE_FILE);
+    return store;
+}
+
+bool ThumbnailStore::IsEnabled()
+{
+#ifdef MEDIALIBRARY_PACKED_THUMBNAIL
+    return true;
+#else
+    return false;
+#endif
+}
+
+string ThumbnailStore::GetKey(const string &path, ThumbnailType type)
+{
+    return GetThumbSuffix(type) + ":" + path;
+}
+
+void ThumbnailStore::CloseFd()
+{
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+}
+
+int32_t ThumbnailStore::Load()
+{
+    if (loaded_) {
+        return E_OK;
+    }
+
+    string dir = MediaFileUtils::GetParentPath(packPath_);
+    if (!MediaFileUtils::CreateDirectory(dir)) {
+        MEDIA_ERR_LOG("failed to create thumbnail store dir, errno %{public}d", errno);
+        return -errno;
+    }
+    fd_ = open(packPath_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, PACK_FILE_MODE);
+    if (fd_ < 0) {
+        MEDIA_ERR_LOG("failed to open thumbnail store, errno %{public}d", errno);
+        VariantMap map = {{KEY_ERR_FILE, __FILE__}, {KEY_ERR_LINE, __LINE__}, {KEY_ERR_CODE, -errno},
+            {KEY_OPT_FILE, packPath_}, {KEY_OPT_TYPE, OptType::THUMB}};
+        PostEventUtils::GetInstance().PostErrorProcess(ErrType::FILE_OPT_ERR, map);
+        return -errno;
+    }
+
+    int32_t err = Recover();
+    if (err != E_OK) {
+        CloseFd();
+        return err;
+    }
+    loaded_ = true;
+    return E_OK;
+}
+
+int32_t ThumbnailStore::Recover()
+{
+    struct stat statInfo;
+    if (fstat(fd_, &statInfo) != 0) {
+        return -errno;
+    }
+
+    index_.clear();
+    liveBytes_ = 0;
+    deadBytes_ = 0;
+    off_t offset = 0;
+    off_t fileSize = statInfo.st_size;
+    while (offset + static_cast<off_t>(sizeof(RecordHeader)) <= fileSize) {
+        RecordHeader header;
+        if (pread(fd_, &header, sizeof(header), offset) != static_cast<ssize_t>(sizeof(header)) ||
+            header.magic != RECORD_MAGIC || header.keyLength == 0 || header.keyLength > MAX_KEY_LENGTH) {
+            break;
+        }
+        off_t dataOffset = offset + static_cast<off_t>(sizeof(header) + header.keyLength);
+        if (dataOffset + static_cast<off_t>(header.dataLength) > fileSize) {
+            break;
+        }
+        string key(header.keyLength, '\0');
+        if (pread(fd_, key.data(), header.keyLength, offset + sizeof(header)) !=
+            static_cast<ssize_t>(header.keyLength)) {
+            break;
+        }
+
+        auto itr = index_.find(key);
+        if (itr != index_.end()) {
+            uint64_t oldSize = GetRecordSize(key, itr->second.length);
+            liveBytes_ -= oldSize;
+            deadBytes_ += oldSize;
+            index_.erase(itr);
+        }
+        uint64_t recordSize = GetRecordSize(key, header.dataLength);
+        if (header.flags & RECORD_FLAG_DELETED) {
+            deadBytes_ += recordSize;
+        } else {
+            index_[key] = { dataOffset, header.dataLength, header.checksum };
+            liveBytes_ += recordSize;
+        }
+        offset = dataOffset + header.dataLength;
+    }
+
+    /* cut off a record torn by a crash, the thumbnail is simply generated again */
+    if (offset != fileSize) {
+        MEDIA_WARN_LOG("drop %{public}lld bytes at the tail of thumbnail store",
+            static_cast<long long>(fileSize - offset));
+        if (ftruncate(fd_, offset) != 0) {
+            return -errno;
+        }
+    }
+    tail_ = offset;
+    return E_OK;
+}
+
+int32_t ThumbnailStore::AppendRecord(const string &key, const uint8_t *data, uint32_t size, uint32_t flags,
+    off_t &dataOffset, uint32_t &checksum)
+{
+    checksum = Checksum(data, size);
+    RecordHeader header = { RECORD_MAGIC, flags, static_cast<uint32_t>(key.length()), size, checksum };
+    struct iovec iov[] = {
+        { &header, sizeof(header) },
+        { const_cast<char *>(key.data()), key.length() },
+        { const_cast<uint8_t *>(data), size },
+    };
+    ssize_t total = static_cast<ssize_t>(GetRecordSize(key, size));
+    ssize_t written = pwritev(fd_, iov, sizeof(iov) / sizeof(iov[0]), tail_);
+    if (written != total) {
+        int32_t err = (written < 0) ? -errno : E_NO_SPACE;
+        MEDIA_ERR_LOG("failed to append thumbnail record, err %{public}d", err);
+        /* never leave half a record in the middle of the segment */
+        (void)ftruncate(fd_, tail_);
+        return err;
+    }
+
+    dataOffset = tail_ + static_cast<off_t>(sizeof(header) + key.length());
+    tail_ += total;
+    return E_OK;
+}
+
+int32_t ThumbnailStore::Put(const string &path, ThumbnailType type, const uint8_t *data, uint32_t size)
+{
+    if (path.empty() || data == nullptr || size == 0) {
+        return E_INVALID_ARGUMENTS;
+    }
+
+    unique_lock<shared_mutex> lock(mutex_);
+    int32_t err = Load();
+    if (err != E_OK) {
+        return err;
+    }
+
+    string key = GetKey(path, type);
+    off_t dataOffset = 0;
+    uint32_t checksum = 0;
+    err = AppendRecord(key, data, size, 0, dataOffset, checksum);
+    if (err != E_OK) {
+        VariantMap map = {{KEY_ERR_FILE, __FILE__}, {KEY_ERR_LINE, __LINE__}, {KEY_ERR_CODE, err},
+            {KEY_OPT_FILE, path}, {KEY_OPT_TYPE, OptType::THUMB}};
+        PostEventUtils::GetInstance().PostErrorProcess(ErrType::FILE_OPT_ERR, map);
+        return err;
+    }
+
+    auto itr = index_.find(key);
+    if (itr != index_.end()) {
+        uint64_t oldSize = GetRecordSize(key, itr->second.length);
+        liveBytes_ -= oldSize;
+        deadBytes_ += oldSize;
+    }
+    index_[key] = { dataOffset, size, checksum };
+    liveBytes_ += GetRecordSize(key, size);
+    return E_OK;
+}
+
+int32_t ThumbnailStore::Sync()
+{
+    shared_lock<shared_mutex> lock(mutex_);
+    if (fd_ < 0) {
+        return E_OK;
+    }
+    if (fdatasync(fd_) != 0) {
+        MEDIA_ERR_LOG("failed to sync thumbnail store, errno %{public}d", errno);
+        return -errno;
+    }
+    return E_OK;
+}
+
+int32_t ThumbnailStore::EnsureLoaded()
+{
+    {
+        shared_lock<shared_mutex> lock(mutex_);
+        if (loaded_) {
+            return E_OK;
+        }
+    }
+    unique_lock<shared_mutex> lock(mutex_);
+    return Load();
+}
+
+bool ThumbnailStore::Contains(const string &path, ThumbnailType type)
+{
+    if (EnsureLoaded() != E_OK) {
+        return false;
+    }
+    shared_lock<shared_mutex> lock(mutex_);
+    return index_.find(GetKey(path, type)) != index_.end();
+}
+
+int32_t ThumbnailStore::ReadEntry(int fd, const IndexEntry &entry, vector<uint8_t> &data)
+{
+    data.resize(entry.length);
+    ssize_t ret = pread(fd, data.data(), entry.length, entry.offset);
+    if (ret != static_cast<ssize_t>(entry.length)) {
+        MEDIA_ERR_LOG("failed to read thumbnail record, errno %{public}d", errno);
+        return (ret < 0) ? -errno : E_HAS_FS_ERROR;
+    }
+    if (Checksum(data.data(), entry.length) != entry.checksum) {
+        MEDIA_ERR_LOG("thumbnail record is corrupted");
+        return E_HAS_FS_ERROR;
+    }
+    return E_OK;
+}
+
+int32_t ThumbnailStore::Read(const string &path, ThumbnailType type, vector<uint8_t> &data)
+{
+    int32_t err = EnsureLoaded();
+    if (err != E_OK) {
+        return err;
+    }
+
+    shared_lock<shared_mutex> lock(mutex_);
+    auto itr = index_.find(GetKey(path, type));
+    if (itr == index_.end()) {
+        return E_NO_SUCH_FILE;
+    }
+    return ReadEntry(fd_, itr->second, data);
+}
+
+int32_t ThumbnailStore::OpenFd(const string &path, ThumbnailType type)
+{
+    vector<uint8_t> data;
+    int32_t err = Read(path, type, data);
+    if (err != E_OK) {
+        return err;
+    }
+
+    int fd = memfd_create("thumbnail", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) {
+        MEDIA_ERR_LOG("failed to create memfd, errno %{public}d", errno);
+        return -errno;
+    }
+    if (write(fd, data.data(), data.size()) != static_cast<ssize_t>(data.size()) ||
+        lseek(fd, 0, SEEK_SET) != 0 ||
+        fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0) {
+        err = -errno;
+        MEDIA_ERR_LOG("failed to fill memfd, errno %{public}d", errno);
+        close(fd);
+        return err;
+    }
+    return fd;
+}
+
+bool ThumbnailStore::Remove(const string &path, ThumbnailType type)
+{
+    unique_lock<shared_mutex> lock(mutex_);
+    if (Load() != E_OK) {
+        return false;
+    }
+
+    string key = GetKey(path, type);
+    auto itr = index_.find(key);
+    if (itr == index_.end()) {
+        return false;
+    }
+
+    off_t dataOffset = 0;
+    uint32_t checksum = 0;
+    if (AppendRecord(key, nullptr, 0, RECORD_FLAG_DELETED, dataOffset, checksum) != E_OK) {
+        return false;
+    }
+    uint64_t oldSize = GetRecordSize(key, itr->second.length);
+    liveBytes_ -= oldSize;
+    deadBytes_ += oldSize + GetRecordSize(key, 0);
+    index_.erase(itr);
+    return true;
+}
+
+/**
+ * @brief Rewrite the live records into a new segment, ordered as they were appended, and swap it in
+ *
+ * @return int32_t E_OK if the segment has been compacted, otherwise the old segment stays in use
+ */
+int32_t ThumbnailStore::Compact()
+{
+    unique_lock<shared_mutex> lock(mutex_);
+    int32_t err = Load();
+    if (err != E_OK) {
+        return err;
+    }
+
+    vector<pair<string, IndexEntry>> entries(index_.begin(), index_.end());
+    sort(entries.begin(), entries.end(), [](const auto &lhs, const auto &rhs) {
+        return lhs.second.offset < rhs.second.offset;
+    });
+
+    string compactPath = packPath_ + ".compact";
+    int compactFd = open(compactPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, PACK_FILE_MODE);
+    if (compactFd < 0) {
+        MEDIA_ERR_LOG("failed to open compact file, errno %{public}d", errno);
+        return -errno;
+    }
+
+    int oldFd = fd_;
+    off_t oldTail = tail_;
+    fd_ = compactFd;
+    tail_ = 0;
+    unordered_map<string, IndexEntry> newIndex;
+    uint64_t liveBytes = 0;
+    uint32_t droppedCount = 0;
+    vector<uint8_t> data;
+    for (const auto &[key, entry] : entries) {
+        if (ReadEntry(oldFd, entry, data) != E_OK) {
+            /* a corrupted record is dropped and generated again on demand, only write errors fail compaction */
+            droppedCount++;
+            continue;
+        }
+        IndexEntry newEntry = { 0, entry.length, 0 };
+        err = AppendRecord(key, data.data(), entry.length, 0, newEntry.offset, newEntry.checksum);
+        if (err != E_OK) {
+            break;
+        }
+        newIndex.emplace(key, newEntry);
+        liveBytes += GetRecordSize(key, entry.length);
+    }
+
+    if (err == E_OK && fsync(compactFd) == 0 && rename(compactPath.c_str(), packPath_.c_str()) == 0) {
+        close(oldFd);
+        index_ = move(newIndex);
+        liveBytes_ = liveBytes;
+        deadBytes_ = 0;
+        MEDIA_INFO_LOG("thumbnail store compacted to %{public}lld bytes, %{public}u corrupted records dropped",
+            static_cast<long long>(tail_), droppedCount);
+        return E_OK;
+    }
+
+    err = (err != E_OK) ? err : -errno;
+    MEDIA_ERR_LOG("failed to compact thumbnail store, err %{public}d", err);
+    close(compactFd);
+    (void)unlink(compactPath.c_str());
+    fd_ = oldFd;
+    tail_ = oldTail;
+    return err;
+}
+
+int32_t ThumbnailStore::CompactIfNeeded()
+{
+    {
+        shared_lock<shared_mutex> lock(mutex_);
+        if (!loaded_ || deadBytes_ < COMPACT_MIN_DEAD_BYTES || deadBytes_ < liveBytes_) {
+            return E_OK;
+        }
+    }
+    return Compact();
+}
+} // namespace Media
+} // namespace OHOS
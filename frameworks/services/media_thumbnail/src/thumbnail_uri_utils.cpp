@@ -18,6 +18,7 @@
 
 #include <algorithm>
 #include <map>
+#include <sstream>
 
 #include "media_file_uri.h"
 #include "media_file_utils.h"
@@ -77,6 +78,50 @@ bool ThumbnailUriUtils::ParseThumbnailInfo(const string &uriString, string &outF
     return true;
 }
 
+// keeps stoi away from out of range values
+constexpr size_t MAX_NUMBER_LENGTH = 9;
+
+static bool IsNumber(const string &str)
+{
+    return !str.empty() && str.size() <= MAX_NUMBER_LENGTH && all_of(str.begin(), str.end(), ::isdigit);
+}
+
+bool ThumbnailUriUtils::IsBatchThumbnailUri(const string &uriString)
+{
+    MediaFileUri uri(uriString);
+    auto &queryKey = uri.GetQueryKeys();
+    auto iter = queryKey.find(THUMBNAIL_OPERN_KEYWORD);
+    return iter != queryKey.end() && iter->second == THUMBNAIL_BATCH_OPERN;
+}
+
+bool ThumbnailUriUtils::ParseBatchThumbnailInfo(const string &uriString, vector<string> &outFileIds,
+    Size &outSize, string &outTableName)
+{
+    MediaFileUri uri(uriString);
+    auto &queryKey = uri.GetQueryKeys();
+    if (queryKey[THUMBNAIL_OPERN_KEYWORD] != THUMBNAIL_BATCH_OPERN || !IsNumber(queryKey[THUMBNAIL_WIDTH]) ||
+        !IsNumber(queryKey[THUMBNAIL_HEIGHT])) {
+        return false;
+    }
+    outSize.width = stoi(queryKey[THUMBNAIL_WIDTH]);
+    outSize.height = stoi(queryKey[THUMBNAIL_HEIGHT]);
+    if (outSize.width <= 0 || outSize.height <= 0) {
+        return false;
+    }
+
+    outFileIds.clear();
+    stringstream ids(queryKey[THUMBNAIL_BATCH_IDS]);
+    string id;
+    while (getline(ids, id, ',')) {
+        if (!IsNumber(id) || outFileIds.size() >= THUMBNAIL_BATCH_MAX_COUNT) {
+            return false;
+        }
+        outFileIds.push_back(id);
+    }
+    outTableName = GetTableFromUri(uriString);
+    return !outFileIds.empty();
+}
+
 bool ThumbnailUriUtils::IsOriginalImg(const Size &outSize, const string &outPath)
 {
     return outSize.width == DEFAULT_ORIGINAL && outSize.height == DEFAULT_ORIGINAL &&
@@ -19,6 +19,8 @@
 
 #include <fcntl.h>
 #include <malloc.h>
+#include <mutex>
+#include <sys/mman.h>
 #include <sys/stat.h>
 
 #include "cloud_sync_helper.h"
@@ -42,6 +44,7 @@
 #include "rdb_errno.h"
 #include "rdb_predicates.h"
 #include "thumbnail_const.h"
+#include "thumbnail_store.h"
 #include "unique_fd.h"
 #include "post_event_utils.h"
 
@@ -138,6 +141,13 @@ static string GetThumbnailSuffix(ThumbnailType type)
 bool ThumbnailUtils::DeleteThumbFile(ThumbnailData &data, ThumbnailType type)
 {
     string fileName = GetThumbnailPath(data.path, GetThumbnailSuffix(type));
+    if (ThumbnailStore::IsEnabled() && ThumbnailStore::GetInstance().Remove(data.path, type)) {
+        /* a file left from before the store was enabled goes along with it */
+        if (MediaFileUtils::IsFileExists(fileName)) {
+            (void)MediaFileUtils::DeleteFile(fileName);
+        }
+        return true;
+    }
     if (!MediaFileUtils::DeleteFile(fileName)) {
         MEDIA_ERR_LOG("delete file faild %{public}d", errno);
         VariantMap map = {{KEY_ERR_FILE, __FILE__}, {KEY_ERR_LINE, __LINE__}, {KEY_ERR_CODE, -errno},
@@ -148,6 +158,114 @@ bool ThumbnailUtils::DeleteThumbFile(ThumbnailData &data, ThumbnailType type)
     return true;
 }
 
+bool ThumbnailUtils::IsThumbExist(const string &path, ThumbnailType type)
+{
+    if (ThumbnailStore::IsEnabled() && ThumbnailStore::GetInstance().Contains(path, type)) {
+        return true;
+    }
+    string fileName = GetThumbnailPath(path, GetThumbnailSuffix(type));
+    return access(fileName.c_str(), F_OK) == 0;
+}
+
+int ThumbnailUtils::OpenThumbFd(const string &path, ThumbnailType type)
+{
+    if (ThumbnailStore::IsEnabled()) {
+        int fd = ThumbnailStore::GetInstance().OpenFd(path, type);
+        if (fd >= 0) {
+            return fd;
+        }
+    }
+    /* thumbnails saved before the store was enabled are still read from their own files */
+    string fileName = GetThumbnailPath(path, GetThumbnailSuffix(type));
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return -errno;
+    }
+    return fd;
+}
+
+int32_t ThumbnailUtils::ReadThumbData(const string &path, ThumbnailType type, vector<uint8_t> &data)
+{
+    if (ThumbnailStore::IsEnabled() && ThumbnailStore::GetInstance().Read(path, type, data) == E_OK) {
+        return E_OK;
+    }
+    string fileName = GetThumbnailPath(path, GetThumbnailSuffix(type));
+    UniqueFd fd(open(fileName.c_str(), O_RDONLY));
+    if (fd.Get() < 0) {
+        return -errno;
+    }
+    struct stat st;
+    if (fstat(fd.Get(), &st) != 0) {
+        return -errno;
+    }
+    data.resize(static_cast<size_t>(st.st_size));
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t ret = pread(fd.Get(), data.data() + done, data.size() - done, done);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            return E_HAS_FS_ERROR;
+        }
+        done += static_cast<size_t>(ret);
+    }
+    return E_OK;
+}
+
+static bool WriteAll(int fd, const void *data, size_t size)
+{
+    auto buf = static_cast<const uint8_t *>(data);
+    while (size > 0) {
+        ssize_t ret = write(fd, buf, size);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            return false;
+        }
+        buf += ret;
+        size -= static_cast<size_t>(ret);
+    }
+    return true;
+}
+
+int ThumbnailUtils::WriteBatchFd(vector<ThumbnailBatchEntry> &entries, const vector<vector<uint8_t>> &datas)
+{
+    ThumbnailBatchHeader header = { THUMBNAIL_BATCH_MAGIC, static_cast<uint32_t>(entries.size()) };
+    size_t offset = sizeof(header) + entries.size() * sizeof(ThumbnailBatchEntry);
+    vector<size_t> paddings(entries.size(), 0);
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (entries[i].status == THUMBNAIL_BATCH_OK) {
+            paddings[i] = (THUMBNAIL_BATCH_ALIGN - offset % THUMBNAIL_BATCH_ALIGN) % THUMBNAIL_BATCH_ALIGN;
+            offset += paddings[i];
+            entries[i].offset = static_cast<uint32_t>(offset);
+            entries[i].length = static_cast<uint32_t>(datas[i].size());
+            offset += datas[i].size();
+        }
+    }
+
+    UniqueFd fd(memfd_create("thumbnail_batch", MFD_CLOEXEC | MFD_ALLOW_SEALING));
+    if (fd.Get() < 0) {
+        MEDIA_ERR_LOG("failed to create memfd, errno %{public}d", errno);
+        return -errno;
+    }
+    bool written = WriteAll(fd.Get(), &header, sizeof(header)) &&
+        WriteAll(fd.Get(), entries.data(), entries.size() * sizeof(ThumbnailBatchEntry));
+    for (size_t i = 0; written && i < entries.size(); i++) {
+        if (entries[i].status == THUMBNAIL_BATCH_OK) {
+            const uint8_t padding[THUMBNAIL_BATCH_ALIGN] = { 0 };
+            written = WriteAll(fd.Get(), padding, paddings[i]) && WriteAll(fd.Get(), datas[i].data(), datas[i].size());
+        }
+    }
+    if (!written || lseek(fd.Get(), 0, SEEK_SET) != 0 ||
+        fcntl(fd.Get(), F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0) {
+        MEDIA_ERR_LOG("failed to fill batch memfd, errno %{public}d", errno);
+        return E_HAS_FS_ERROR;
+    }
+    return fd.Release();
+}
+
 bool ThumbnailUtils::LoadAudioFileInfo(shared_ptr<AVMetadataHelper> avMetadataHelper, ThumbnailData &data,
     const bool isThumbnail, const Size &desiredSize, uint32_t &errCode)
 {
@@ -269,10 +387,48 @@ bool ThumbnailUtils::GenTargetPixelmap(ThumbnailData &data, const Size &desiredS
     return true;
 }
 
+// replace the lcd pixelmap in data.source with the center cropped thumbnail, so the source is decoded only once
+bool ThumbnailUtils::GenThumbSourceFromLcd(ThumbnailData &data)
+{
+    MediaLibraryTracer tracer;
+    tracer.Start("GenThumbSourceFromLcd");
+    if (data.source == nullptr) {
+        return false;
+    }
+    Size lcdSize = { data.source->GetWidth(), data.source->GetHeight() };
+    if (min(lcdSize.width, lcdSize.height) < DEFAULT_THUMB_SIZE) {
+        // cropping would upscale the lcd, e.g. for a panorama, decode the source at thumbnail size instead
+        return false;
+    }
+
+    Size thumbSize = { DEFAULT_THUMB_SIZE, DEFAULT_THUMB_SIZE };
+    InitializationOptions opts;
+    opts.size = ConvertDecodeSize(lcdSize, thumbSize, true);
+    opts.pixelFormat = PixelFormat::RGBA_8888;
+    opts.alphaType = AlphaType::IMAGE_ALPHA_TYPE_UNPREMUL;
+    opts.scaleMode = ScaleMode::FIT_TARGET_SIZE;
+    unique_ptr<PixelMap> thumbnail = PixelMap::Create(*data.source, opts);
+    if (thumbnail == nullptr) {
+        MEDIA_ERR_LOG("Failed to scale lcd pixelmap, path: %{private}s", data.path.c_str());
+        return false;
+    }
+    PostProc postProc;
+    if (!postProc.CenterScale(thumbSize, *thumbnail)) {
+        MEDIA_ERR_LOG("thumbnail center crop failed [%{private}s]", data.id.c_str());
+        return false;
+    }
+    data.source = move(thumbnail);
+    return true;
+}
+
 bool ThumbnailUtils::LoadImageFile(ThumbnailData &data, const bool isThumbnail, const Size &desiredSize)
 {
-    mallopt(M_SET_THREAD_CACHE, M_THREAD_CACHE_DISABLE);
-    mallopt(M_DELAYED_FREE, M_DELAYED_FREE_DISABLE);
+    // process wide allocator settings, setting them on every decode only costs a call into the allocator
+    static once_flag mallocOptionFlag;
+    call_once(mallocOptionFlag, []() {
+        mallopt(M_SET_THREAD_CACHE, M_THREAD_CACHE_DISABLE);
+        mallopt(M_DELAYED_FREE, M_DELAYED_FREE_DISABLE);
+    });
 
     MediaLibraryTracer tracer;
     tracer.Start("ImageSource::CreateImageSource");
@@ -800,6 +956,70 @@ bool ThumbnailUtils::QueryNoThumbnailInfos(ThumbRdbOpt &opts, vector<ThumbnailDa
     return true;
 }
 
+bool ThumbnailUtils::QueryNoThumbnailInfos(ThumbRdbOpt &opts, ThumbnailCursor &cursor, int32_t limit,
+    vector<ThumbnailData> &infos, bool &isEnd, int &err)
+{
+    isEnd = true;
+    vector<string> column = {
+        MEDIA_DATA_DB_ID,
+        MEDIA_DATA_DB_FILE_PATH,
+        MEDIA_DATA_DB_MEDIA_TYPE,
+        MEDIA_DATA_DB_DATE_ADDED,
+    };
+    RdbPredicates rdbPredicates(opts.table);
+    rdbPredicates.EqualTo(MEDIA_DATA_DB_TIME_VISIT, "0");
+    if ((opts.table == PhotoColumn::PHOTOS_TABLE) || (opts.table == AudioColumn::AUDIOS_TABLE)) {
+        rdbPredicates.EqualTo(MediaColumn::MEDIA_DATE_TRASHED, "0");
+    } else {
+        rdbPredicates.EqualTo(MEDIA_DATA_DB_IS_TRASH, "0");
+    }
+    rdbPredicates.EqualTo(MEDIA_DATA_DB_TIME_PENDING, "0");
+    rdbPredicates.NotEqualTo(MEDIA_DATA_DB_MEDIA_TYPE, to_string(MEDIA_TYPE_ALBUM));
+    rdbPredicates.NotEqualTo(MEDIA_DATA_DB_MEDIA_TYPE, to_string(MEDIA_TYPE_FILE));
+    if (cursor.fileId > 0) {
+        rdbPredicates.BeginWrap();
+        rdbPredicates.LessThan(MEDIA_DATA_DB_DATE_ADDED, to_string(cursor.dateAdded));
+        rdbPredicates.Or()->BeginWrap();
+        rdbPredicates.EqualTo(MEDIA_DATA_DB_DATE_ADDED, to_string(cursor.dateAdded));
+        rdbPredicates.LessThan(MEDIA_DATA_DB_ID, to_string(cursor.fileId));
+        rdbPredicates.EndWrap();
+        rdbPredicates.EndWrap();
+    }
+
+    rdbPredicates.Limit(limit);
+    rdbPredicates.OrderByDesc(MEDIA_DATA_DB_DATE_ADDED);
+    rdbPredicates.OrderByDesc(MEDIA_DATA_DB_ID);
+
+    shared_ptr<ResultSet> resultSet = opts.store->QueryByStep(rdbPredicates, column);
+    if (!CheckResultSetCount(resultSet, err)) {
+        if (err == E_EMPTY_VALUES_BUCKET) {
+            return true;
+        }
+        MEDIA_ERR_LOG("CheckResultSetCount failed %{public}d", err);
+        return false;
+    }
+
+    err = resultSet->GoToFirstRow();
+    if (err != E_OK) {
+        MEDIA_ERR_LOG("Failed GoToFirstRow %{public}d", err);
+        return false;
+    }
+
+    int32_t rowCount = 0;
+    do {
+        ThumbnailData data;
+        ParseQueryResult(resultSet, data, err);
+        rowCount++;
+        /* a row without a path is skipped, but the scan still moves past it */
+        cursor = { data.dateAdded, atoi(data.id.c_str()) };
+        if (!data.path.empty()) {
+            infos.push_back(data);
+        }
+    } while (resultSet->GoToNextRow() == E_OK);
+    isEnd = (rowCount < limit);
+    return true;
+}
+
 bool ThumbnailUtils::QueryNewThumbnailCount(ThumbRdbOpt &opts, const int64_t &time, int &count,
     int &err)
 {
@@ -1322,6 +1542,16 @@ int ThumbnailUtils::TrySaveFile(ThumbnailData &data, ThumbnailType type)
     if (writeSize <= 0) {
         return E_THUMBNAIL_LOCAL_CREATE_FAIL;
     }
+    if (ThumbnailStore::IsEnabled()) {
+        /* appended without a sync, the caller syncs the store once all thumbnails of the asset are in */
+        int ret = ThumbnailStore::GetInstance().Put(data.path, type, output, static_cast<uint32_t>(writeSize));
+        if (ret != E_OK) {
+            VariantMap map = {{KEY_ERR_FILE, __FILE__}, {KEY_ERR_LINE, __LINE__}, {KEY_ERR_CODE, ret},
+                {KEY_OPT_FILE, data.path}, {KEY_OPT_TYPE, OptType::THUMB}};
+            PostEventUtils::GetInstance().PostErrorProcess(ErrType::FILE_OPT_ERR, map);
+        }
+        return ret;
+    }
     string fileName;
     int ret = SaveFileCreateDir(data.path, suffix, fileName);
     if (ret != E_OK) {
@@ -1678,6 +1908,11 @@ void ThumbnailUtils::ParseQueryResult(const shared_ptr<ResultSet> &resultSet, Th
         data.mediaType = MediaType::MEDIA_TYPE_ALL;
         err = resultSet->GetInt(index, data.mediaType);
     }
+
+    // only the paged scans of the generate engine ask for it, leave err to the columns above
+    if (resultSet->GetColumnIndex(MEDIA_DATA_DB_DATE_ADDED, index) == NativeRdb::E_OK) {
+        (void)resultSet->GetLong(index, data.dateAdded);
+    }
 }
 } // namespace Media
 } // namespace OHOS
@@ -35,6 +35,9 @@ public:
     int32_t Open();
 
 private:
+    /* lookups of the privacy ranges cache which hit and missed, a stale entry counts as a miss */
+    static void GetRangesCacheStats(uint64_t &hits, uint64_t &misses);
+
     std::string path_;
     std::string mode_;
     /* Privacy ranges in a file, specified by <begin, end> offsets of the file */
@@ -18,7 +18,11 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <list>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 namespace OHOS {
@@ -37,12 +41,21 @@ private:
     static int32_t GenKey(const unsigned char *data, const size_t len, std::string &key);
     static bool CheckIllegalCharacter(const std::string &strCondition);
     static bool CheckKeyWord(const std::string &strCondition);
-    static void SeprateSelection(std::string &strCondition, std::vector<std::string> &sepratedStr);
-    static bool CheckExpressValidation(std::vector<std::string> &sepratedStr);
+    static void NormalizeSelection(const std::string &whereClause, std::string &selection);
+    static bool CheckSelection(const std::string &selection);
     static bool CheckWhiteList(const std::string &express);
-    static void ExtractKeyWord(std::string &str);
     static void removeSpecialCondition(std::string &hacker, const std::string &pattern);
     static void removeSpecialCondition(std::string &hacker);
+    static bool IsCheckedSelection(const std::string &selection);
+    static void AddCheckedSelection(const std::string &selection);
+
+    /* LRU of normalized selections which already passed the check, the front is the most recently used */
+    static std::mutex selectionMutex_;
+    static std::list<std::string> selectionLru_;
+    static std::unordered_map<std::string_view, std::list<std::string>::iterator> selectionCache_;
+    /* lookups of the selection cache which hit and missed */
+    static uint64_t selectionHits_;
+    static uint64_t selectionMisses_;
 };
 } // namespace Media
 } // namespace OHOS
@@ -18,8 +18,14 @@
 
 #include <algorithm>
 #include <cerrno>
+#include <list>
+#include <map>
 #include <mntent.h>
+#include <mutex>
+#include <poll.h>
 #include <securec.h>
+#include <sys/stat.h>
+#include <tuple>
 #include <unistd.h>
 #include <unordered_map>
 #include <fcntl.h>
@@ -40,6 +46,27 @@ namespace Media {
 
 constexpr uint32_t E_NO_EXIF = 1;
 constexpr uint32_t E_NO_PRIVACY_EXIF_TAG = 2;
+constexpr size_t PRIVACY_RANGES_CACHE_MAX = 256;
+constexpr int64_t NSEC_PER_SEC = 1000000000;
+const string PROC_SELF_MOUNTS = "/proc/self/mounts";
+
+/* <device, inode, privacy type> of a file, its cached ranges hold while mtime and size stay the same */
+using RangesCacheKey = tuple<uint64_t, uint64_t, int32_t>;
+struct RangesCacheEntry {
+    int64_t mtime;
+    int64_t size;
+    PrivacyRanges ranges;
+    list<RangesCacheKey>::iterator lruPos;
+};
+static mutex g_rangesCacheLock;
+static map<RangesCacheKey, RangesCacheEntry> g_rangesCache;
+static list<RangesCacheKey> g_rangesLru;
+static uint64_t g_rangesCacheHits = 0;
+static uint64_t g_rangesCacheMisses = 0;
+
+static mutex g_mountsLock;
+static int32_t g_mountsFd = -1;
+static bool g_epfsMounted = false;
 
 MediaPrivacyManager::MediaPrivacyManager(const string &path, const string &mode) : path_(path), mode_(mode)
 {}
@@ -97,6 +124,29 @@ static bool CheckFsMounted(const string &fsType, const string &mountPoint)
     return false;
 }
 
+/*
+ * The mount table is parsed again only when it changed: the kernel flags an open mounts file with POLLPRI when a
+ * file system is mounted or unmounted, and polling it clears the flag.
+ */
+static bool IsEpfsMounted()
+{
+    lock_guard<mutex> lock(g_mountsLock);
+    if (g_mountsFd < 0) {
+        g_mountsFd = open(PROC_SELF_MOUNTS.c_str(), O_RDONLY | O_CLOEXEC);
+        if (g_mountsFd < 0) {
+            MEDIA_ERR_LOG("Failed to open mounts, errno:%{public}d", errno);
+            return CheckFsMounted(FS_TYPE_EPFS, EPFS_MOUNT_POINT);
+        }
+        g_epfsMounted = CheckFsMounted(FS_TYPE_EPFS, EPFS_MOUNT_POINT);
+        return g_epfsMounted;
+    }
+    struct pollfd mountsPoll = { g_mountsFd, POLLPRI, 0 };
+    if ((poll(&mountsPoll, 1, 0) > 0) && ((mountsPoll.revents & (POLLPRI | POLLERR)) != 0)) {
+        g_epfsMounted = CheckFsMounted(FS_TYPE_EPFS, EPFS_MOUNT_POINT);
+    }
+    return g_epfsMounted;
+}
+
 static int32_t BindFilterProxyFdToOrigin(const int32_t originFd, int32_t &proxyFd)
 {
     int ret = ioctl(proxyFd, IOC_SET_ORIGIN_FD, &originFd);
@@ -144,7 +194,7 @@ static int32_t OpenOriginFd(const string &path, const string &mode)
  */
 static int32_t OpenFilterProxyFd(const string &path, const string &mode, const PrivacyRanges &ranges)
 {
-    if (!CheckFsMounted(FS_TYPE_EPFS, EPFS_MOUNT_POINT)) {
+    if (!IsEpfsMounted()) {
         MEDIA_INFO_LOG("Epfs is currently not supported yet");
         return OpenOriginFd(path, mode);
     }
@@ -218,8 +268,79 @@ static int32_t SortRangesAndCheck(PrivacyRanges &ranges)
     return E_SUCCESS;
 }
 
+static inline int64_t GetMtime(const struct stat &st)
+{
+    return static_cast<int64_t>(st.st_mtim.tv_sec) * NSEC_PER_SEC + st.st_mtim.tv_nsec;
+}
+
+static bool GetCachedRanges(const struct stat &st, const PrivacyType &type, PrivacyRanges &ranges)
+{
+    lock_guard<mutex> lock(g_rangesCacheLock);
+    auto iter = g_rangesCache.find(RangesCacheKey(st.st_dev, st.st_ino, type));
+    if (iter == g_rangesCache.end()) {
+        g_rangesCacheMisses++;
+        return false;
+    }
+    RangesCacheEntry &entry = iter->second;
+    if ((entry.mtime != GetMtime(st)) || (entry.size != static_cast<int64_t>(st.st_size))) {
+        g_rangesLru.erase(entry.lruPos);
+        g_rangesCache.erase(iter);
+        g_rangesCacheMisses++;
+        return false;
+    }
+    g_rangesCacheHits++;
+    g_rangesLru.splice(g_rangesLru.begin(), g_rangesLru, entry.lruPos);
+    ranges.insert(ranges.end(), entry.ranges.begin(), entry.ranges.end());
+    return true;
+}
+
+static void PutCachedRanges(const struct stat &st, const PrivacyType &type, const PrivacyRanges &ranges)
+{
+    lock_guard<mutex> lock(g_rangesCacheLock);
+    RangesCacheKey key(st.st_dev, st.st_ino, type);
+    auto iter = g_rangesCache.find(key);
+    if (iter != g_rangesCache.end()) {
+        g_rangesLru.erase(iter->second.lruPos);
+        g_rangesCache.erase(iter);
+    } else if (g_rangesCache.size() >= PRIVACY_RANGES_CACHE_MAX) {
+        g_rangesCache.erase(g_rangesLru.back());
+        g_rangesLru.pop_back();
+    }
+    g_rangesLru.push_front(key);
+    g_rangesCache[key] = { GetMtime(st), static_cast<int64_t>(st.st_size), ranges, g_rangesLru.begin() };
+}
+
+void MediaPrivacyManager::GetRangesCacheStats(uint64_t &hits, uint64_t &misses)
+{
+    lock_guard<mutex> lock(g_rangesCacheLock);
+    hits = g_rangesCacheHits;
+    misses = g_rangesCacheMisses;
+}
+
+static void RemoveCachedRanges(const string &path)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return;
+    }
+    lock_guard<mutex> lock(g_rangesCacheLock);
+    auto iter = g_rangesCache.lower_bound(RangesCacheKey(st.st_dev, st.st_ino, PRIVACY_NONE));
+    while ((iter != g_rangesCache.end()) && (get<0>(iter->first) == st.st_dev) &&
+        (get<1>(iter->first) == st.st_ino)) {
+        g_rangesLru.erase(iter->second.lruPos);
+        iter = g_rangesCache.erase(iter);
+    }
+}
+
 static int32_t CollectRanges(const string &path, const PrivacyType &type, PrivacyRanges &ranges)
 {
+    // stat before parsing, so that a file changed during the parse is stamped older than its content
+    struct stat st;
+    bool hasStat = (stat(path.c_str(), &st) == 0);
+    if (hasStat && GetCachedRanges(st, type, ranges)) {
+        return E_SUCCESS;
+    }
+
     SourceOptions opts;
     opts.formatHint = "image/jpeg";
     uint32_t err = -1;
@@ -235,9 +356,15 @@ static int32_t CollectRanges(const string &path, const PrivacyType &type, Privac
         MEDIA_ERR_LOG("Failed to get privacy area with type %{public}d, err: %{public}u", type, err);
         return E_ERR;
     }
+    PrivacyRanges fileRanges;
+    fileRanges.reserve(areas.size());
     for (auto &range : areas) {
-        ranges.insert(ranges.end(), std::make_pair(range.first, range.first + range.second));
+        fileRanges.push_back(std::make_pair(range.first, range.first + range.second));
+    }
+    if (hasStat) {
+        PutCachedRanges(st, type, fileRanges);
     }
+    ranges.insert(ranges.end(), fileRanges.begin(), fileRanges.end());
     return E_SUCCESS;
 }
 
@@ -261,6 +388,8 @@ static int32_t GetPrivacyRanges(const string &path, const string &mode, PrivacyR
     }
 
     if (mode.find('w') != string::npos) {
+        // the file is about to change, its cached ranges go now instead of at the next stat
+        RemoveCachedRanges(path);
         return E_SUCCESS;
     }
 
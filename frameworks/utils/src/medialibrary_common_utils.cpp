@@ -15,7 +15,7 @@
 #include "medialibrary_common_utils.h"
 
 #include <algorithm>
-#include <regex>
+#include <cctype>
 #include <unordered_set>
 #include "medialibrary_errno.h"
 #include "medialibrary_db_const.h"
@@ -26,6 +26,16 @@
 namespace OHOS {
 namespace Media {
 using namespace std;
+mutex MediaLibraryCommonUtils::selectionMutex_;
+list<string> MediaLibraryCommonUtils::selectionLru_;
+unordered_map<string_view, list<string>::iterator> MediaLibraryCommonUtils::selectionCache_;
+uint64_t MediaLibraryCommonUtils::selectionHits_ = 0;
+uint64_t MediaLibraryCommonUtils::selectionMisses_ = 0;
+
+/* clients send a handful of selection shapes over and over, long ones are rare and not worth keeping */
+constexpr size_t SELECTION_CACHE_CAPACITY = 128;
+constexpr size_t SELECTION_CACHE_MAX_LENGTH = 1024;
+
 const vector<string> CHAR2HEX_TABLE = {
     "00", "01", "02", "03", "04", "05", "06", "07", "08", "09", "0A", "0B", "0C", "0D", "0E", "0F",
     "10", "11", "12", "13", "14", "15", "16", "17", "18", "19", "1A", "1B", "1C", "1D", "1E", "1F",
@@ -87,27 +97,6 @@ int32_t MediaLibraryCommonUtils::GenKeySHA256(const std::string &input, std::str
     return GenKey((const unsigned char *)input.c_str(), input.size(), key);
 }
 
-void MediaLibraryCommonUtils::ExtractKeyWord(std::string &str)
-{
-    if (str.empty()) {
-        return;
-    }
-    // add seprate space symbol,like file_id=?
-    std::regex spacePattern("\\=|\\<>|\\>|\\>=|\\<|\\<=|\\!=",
-        std::regex_constants::ECMAScript | std::regex_constants::icase);
-    str = regex_replace(str, spacePattern, " ");
-    // remove front space of key word
-    auto pos = str.find_first_not_of(" ");
-    if (pos != std::string::npos) {
-        str.erase(0, pos);
-    }
-    // remove back space of key word
-    pos = str.find_first_of(" ");
-    if (pos != std::string::npos) {
-        str = str.substr(0, pos);
-    }
-}
-
 bool MediaLibraryCommonUtils::CheckWhiteList(const std::string &express)
 {
     static const std::unordered_set<std::string> FILE_KEY_WHITE_LIST {
@@ -158,27 +147,11 @@ bool MediaLibraryCommonUtils::CheckWhiteList(const std::string &express)
     return FILE_KEY_WHITE_LIST.find(express) != FILE_KEY_WHITE_LIST.end();
 }
 
-bool MediaLibraryCommonUtils::CheckExpressValidation(std::vector<std::string> &sepratedStr)
-{
-    for (auto &str : sepratedStr) {
-        ExtractKeyWord(str);
-        if (str.empty() || (str.size() == 1 && str == " ")) {
-            continue;
-        }
-        if (!CheckWhiteList(str)) {
-            MEDIA_ERR_LOG("Failed to check key word: %{private}s", str.c_str());
-            return false;
-        }
-    }
-
-    return true;
-}
-
 void MediaLibraryCommonUtils::removeSpecialCondition(std::string &hacker, const std::string &pattern)
 {
     auto pos = hacker.find(pattern);
     while (pos != std::string::npos) {
-        hacker.replace(pos, pos + pattern.size(), " ");
+        hacker.replace(pos, pattern.size(), " ");
         pos = hacker.find(pattern);
     }
 }
@@ -193,45 +166,142 @@ void MediaLibraryCommonUtils::removeSpecialCondition(std::string &hacker)
     removeSpecialCondition(hacker, S3);
 }
 
-void MediaLibraryCommonUtils::SeprateSelection(std::string &strCondition, std::vector<std::string> &sepratedStr)
+void MediaLibraryCommonUtils::NormalizeSelection(const std::string &whereClause, std::string &selection)
 {
-    // 0. transform to lower
-    std::transform(strCondition.begin(), strCondition.end(), strCondition.begin(), ::tolower);
-    // 1.remove brackets
-    std::regex bracketsPattern("\\(|\\)", std::regex_constants::ECMAScript | std::regex_constants::icase);
-    strCondition = regex_replace(strCondition, bracketsPattern, "");
+    // lower case, drop brackets and fold every run of blanks into one space
+    selection.clear();
+    selection.reserve(whereClause.size());
+    bool isSpace = false;
+    for (char c : whereClause) {
+        if (c == '(' || c == ')') {
+            continue;
+        }
+        if (isspace(static_cast<unsigned char>(c))) {
+            if (!isSpace) {
+                selection.push_back(' ');
+                isSpace = true;
+            }
+            continue;
+        }
+        selection.push_back(static_cast<char>(tolower(static_cast<unsigned char>(c))));
+        isSpace = false;
+    }
+}
 
-    // 2.remove redundant space
-    std::regex spacePattern("\\s+", std::regex_constants::ECMAScript | std::regex_constants::icase);
-    strCondition = regex_replace(strCondition, spacePattern, " ");
+static inline size_t GetOperatorLength(const std::string &selection, size_t pos)
+{
+    // =, <>, >, >=, <, <= and != all split a key word from its value
+    char c = selection[pos];
+    if (c == '=' || c == '<' || c == '>') {
+        return 1;
+    }
+    if (c == '!' && pos + 1 < selection.size() && selection[pos + 1] == '=') {
+        return 2; // 2: length of "!="
+    }
+    return 0;
+}
 
-    // 3. remove special condition
-    removeSpecialCondition(strCondition);
+static inline size_t GetBoundLength(const std::string &selection, size_t start, size_t end)
+{
+    static const std::string BOUNDS[] = { "and", "or" };
+    for (const auto &bound : BOUNDS) {
+        if ((end - start >= bound.size()) && (selection.compare(end - bound.size(), bound.size(), bound) == 0)) {
+            return bound.size();
+        }
+    }
+    return 0;
+}
 
-    // 4. seprate core: according bound symbol,for example: and or ..
-    std::regex conditionPattern("\\s*and\\s+|\\s*or\\s+",
-        std::regex_constants::ECMAScript | std::regex_constants::icase);
-    std::sregex_token_iterator iter(strCondition.begin(), strCondition.end(), conditionPattern, -1);
-    decltype(iter) end;
-    while (iter != end) {
-        sepratedStr.push_back(iter->str());
-        ++iter;
+bool MediaLibraryCommonUtils::CheckSelection(const std::string &selection)
+{
+    // The first word of every condition is a column name and must be in the white list, conditions are
+    // separated by "and" or "or" followed by a space, the bound may be glued to the previous token like "?and ".
+    bool isConditionStart = true;
+    size_t size = selection.size();
+    size_t pos = 0;
+    while (pos < size) {
+        if (selection[pos] == ' ') {
+            pos++;
+            continue;
+        }
+        size_t operatorLength = GetOperatorLength(selection, pos);
+        if (operatorLength > 0) {
+            pos += operatorLength;
+            continue;
+        }
+        size_t start = pos;
+        while ((pos < size) && (selection[pos] != ' ') && (GetOperatorLength(selection, pos) == 0)) {
+            pos++;
+        }
+        size_t end = pos;
+        bool isBound = false;
+        if ((pos < size) && (selection[pos] == ' ')) {
+            size_t boundLength = GetBoundLength(selection, start, end);
+            end -= boundLength;
+            isBound = (boundLength > 0);
+        }
+        if (isConditionStart && (end > start)) {
+            string keyWord = selection.substr(start, end - start);
+            if (!CheckWhiteList(keyWord)) {
+                MEDIA_ERR_LOG("Failed to check key word: %{private}s", keyWord.c_str());
+                return false;
+            }
+            isConditionStart = false;
+        }
+        if (isBound) {
+            isConditionStart = true;
+        }
     }
+    return true;
 }
 
 bool MediaLibraryCommonUtils::CheckKeyWord(const std::string &strCondition)
 {
-    std::regex pattern("\\s*exec\\s*|\\s*insert\\s*|\\s*delete\\s*|\\s*update\\s*|" \
-                            "\\s*join\\s*|\\s*union\\s*|\\s*master\\s*|\\s*truncate\\s*",
-                    std::regex_constants::ECMAScript | std::regex_constants::icase);
+    static const vector<string> KEY_WORDS = {
+        "exec", "insert", "delete", "update", "join", "union", "master", "truncate"
+    };
+    auto isSameChar = [](char lhs, char rhs) {
+        return tolower(static_cast<unsigned char>(lhs)) == rhs;
+    };
+    for (const auto &keyWord : KEY_WORDS) {
+        if (search(strCondition.begin(), strCondition.end(), keyWord.begin(), keyWord.end(), isSameChar) !=
+            strCondition.end()) {
+            return false;
+        }
+    }
+    return true;
+}
 
-    if (regex_search(strCondition, pattern)) {
+bool MediaLibraryCommonUtils::IsCheckedSelection(const std::string &selection)
+{
+    lock_guard<mutex> lock(selectionMutex_);
+    auto iter = selectionCache_.find(selection);
+    if (iter == selectionCache_.end()) {
+        selectionMisses_++;
         return false;
     }
-
+    selectionHits_++;
+    selectionLru_.splice(selectionLru_.begin(), selectionLru_, iter->second);
     return true;
 }
 
+void MediaLibraryCommonUtils::AddCheckedSelection(const std::string &selection)
+{
+    if (selection.size() > SELECTION_CACHE_MAX_LENGTH) {
+        return;
+    }
+    lock_guard<mutex> lock(selectionMutex_);
+    if (selectionCache_.find(selection) != selectionCache_.end()) {
+        return;
+    }
+    if (selectionLru_.size() >= SELECTION_CACHE_CAPACITY) {
+        selectionCache_.erase(selectionLru_.back());
+        selectionLru_.pop_back();
+    }
+    selectionLru_.push_front(selection);
+    selectionCache_.emplace(selectionLru_.front(), selectionLru_.begin());
+}
+
 bool MediaLibraryCommonUtils::CheckIllegalCharacter(const std::string &strCondition)
 {
     /* if strCondition contains ';', it will be sepreate to two clause */
@@ -255,17 +325,26 @@ bool MediaLibraryCommonUtils::CheckWhereClause(const std::string &whereClause)
         return false;
     }
 
+    string selection;
+    NormalizeSelection(whereClause, selection);
+    if (IsCheckedSelection(selection)) {
+        return true;
+    }
+
     /* check whether query condition has key word */
-    if (!CheckKeyWord(whereClause)) {
+    if (!CheckKeyWord(selection)) {
         MEDIA_ERR_LOG("CheckKeyWord is failed!");
         return false;
     }
 
-    std::vector<std::string> sepratedStr;
-    auto args = whereClause;
-    SeprateSelection(args, sepratedStr);
+    auto args = selection;
+    removeSpecialCondition(args);
     /* check every query condition */
-    return CheckExpressValidation(sepratedStr);
+    if (!CheckSelection(args)) {
+        return false;
+    }
+    AddCheckedSelection(selection);
+    return true;
 }
 
 void MediaLibraryCommonUtils::AppendSelections(std::string &selections)
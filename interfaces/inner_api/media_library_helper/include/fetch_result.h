@@ -69,6 +69,7 @@ private:
         std::shared_ptr<NativeRdb::ResultSet> &resultSet);
 
     void SetFileAsset(FileAsset *fileAsset, std::shared_ptr<NativeRdb::ResultSet> &resultSet);
+    void ResolveFileAssetSchema(std::shared_ptr<NativeRdb::ResultSet> &resultSet);
     void SetAlbumAsset(AlbumAsset* albumData, std::shared_ptr<NativeRdb::ResultSet> &resultSet);
     void SetPhotoAlbum(PhotoAlbum* photoAlbumData, std::shared_ptr<NativeRdb::ResultSet> &resultSet);
     void SetSmartAlbumAsset(SmartAlbumAsset* smartAlbumData, std::shared_ptr<NativeRdb::ResultSet> &resultSet);
@@ -84,6 +85,12 @@ private:
     ResultNapiType resultNapiType_;
     std::shared_ptr<DataShare::DataShareResultSet> resultset_ = nullptr;
     FetchResType fetchResType_;
+
+    /* resolved from the columns of the first row, every file asset of the same result set shares it */
+    std::shared_ptr<FileAssetSchema> fileAssetSchema_ = nullptr;
+    std::weak_ptr<NativeRdb::ResultSet> schemaResultSet_;
+    bool isRdbSchema_ = false;
+    bool isCountQuery_ = false;
 };
 } // namespace Media
 } // namespace OHOS
@@ -21,6 +21,7 @@
 #include <string>
 #include <variant>
 #include <unordered_map>
+#include <vector>
 #include "medialibrary_type_const.h"
 
 namespace OHOS {
@@ -34,6 +35,31 @@ constexpr int MEMBER_TYPE_DOUBLE = 3;
 constexpr int OPEN_TYPE_READONLY = 0;
 constexpr int OPEN_TYPE_WRITE = 1;
 
+/**
+ * @brief Member layout shared by all file assets read from one result set
+ *
+ * Every member gets a slot index, a file asset with a schema keeps the values of these members in a vector
+ * instead of its member map. A member with a column index is read from that column of the result set.
+ */
+class FileAssetSchema {
+public:
+    void AddMember(const std::string &name, ResultSetDataType type, int32_t columnIndex = -1);
+    int32_t GetSlot(const std::string &name) const;
+    size_t GetSlotCount() const;
+    const std::string &GetName(size_t slot) const;
+    ResultSetDataType GetType(size_t slot) const;
+    int32_t GetColumnIndex(size_t slot) const;
+
+private:
+    struct Slot {
+        std::string name;
+        ResultSetDataType type;
+        int32_t columnIndex;
+    };
+    std::vector<Slot> slots_;
+    std::unordered_map<std::string, int32_t> slotMap_;
+};
+
 /**
  * @brief Class for filling all file asset parameters
  *
@@ -156,6 +182,9 @@ public:
     std::unordered_map<std::string, std::variant<int32_t, int64_t, std::string>> &GetMemberMap();
     std::variant<int32_t, int64_t, std::string> &GetMemberValue(const std::string &name);
 
+    void SetSchema(const std::shared_ptr<const FileAssetSchema> &schema);
+    void SetSlotValue(int32_t slot, std::variant<int32_t, int64_t, std::string> &&value);
+
     std::string GetAssetJson();
     void SetResultTypeMap(const std::string &colName, ResultSetDataType type);
 
@@ -172,9 +201,13 @@ private:
     const std::string &GetStrMember(const std::string &name) const;
     int32_t GetInt32Member(const std::string &name) const;
     int64_t GetInt64Member(const std::string &name) const;
+    const std::variant<int32_t, int64_t, std::string> *FindMember(const std::string &name) const;
+    void SetMember(const std::string &name, std::variant<int32_t, int64_t, std::string> value);
 
     std::string albumUri_;
     ResultNapiType resultNapiType_;
+    std::shared_ptr<const FileAssetSchema> schema_;
+    std::vector<std::variant<int32_t, int64_t, std::string>> slots_;
     std::unordered_map<std::string, std::variant<int32_t, int64_t, std::string>> member_;
     std::mutex openStatusMapMutex_;
     std::shared_ptr<std::unordered_map<int32_t, int32_t>> openStatusMap_;
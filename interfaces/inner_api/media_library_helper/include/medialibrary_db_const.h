@@ -22,7 +22,7 @@
 
 namespace OHOS {
 namespace Media {
-const int32_t MEDIA_RDB_VERSION = 18;
+const int32_t MEDIA_RDB_VERSION = 19;
 enum {
     VERSION_ADD_CLOUD = 2,
     VERSION_ADD_META_MODIFED = 3,
@@ -46,6 +46,7 @@ enum {
     VERSION_ADD_UPDATE_CLOUD_SYNC_TRIGGER = 16,
     VERSION_ADD_YEAR_MONTH_DAY = 17,
     VERSION_ADD_VISION_TABLE = 18,
+    VERSION_ADD_SCAN_JOURNAL = 19,
 };
 
 enum {
@@ -549,6 +550,17 @@ const std::string MEDIA_DATA_ERROR = "err";
 const std::string CREATE_MEDIALIBRARY_ERROR_TABLE = "CREATE TABLE IF NOT EXISTS " + MEDIALIBRARY_ERROR_TABLE + " ("
     + MEDIA_DATA_ERROR + " TEXT PRIMARY KEY)";
 
+/*
+ * Scan Journal Table, fingerprints of the directories seen by the last successful scan
+ */
+const std::string MEDIALIBRARY_SCAN_JOURNAL_TABLE = "ScanJournal";
+const std::string SCAN_JOURNAL_DIR = "dir";
+const std::string SCAN_JOURNAL_INODE = "inode";
+const std::string SCAN_JOURNAL_MTIME = "mtime";
+const std::string CREATE_MEDIALIBRARY_SCAN_JOURNAL_TABLE = "CREATE TABLE IF NOT EXISTS " +
+    MEDIALIBRARY_SCAN_JOURNAL_TABLE + " (" + SCAN_JOURNAL_DIR + " TEXT PRIMARY KEY, " + SCAN_JOURNAL_INODE +
+    " BIGINT, " + SCAN_JOURNAL_MTIME + " BIGINT)";
+
 /*
  * Media Unique Number Table
  */
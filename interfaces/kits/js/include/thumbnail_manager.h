@@ -16,22 +16,28 @@
 #ifndef INTERFACES_KITS_JS_MEDIALIBRARY_INCLUDE_THUMBNAIL_MANAGER_H
 #define INTERFACES_KITS_JS_MEDIALIBRARY_INCLUDE_THUMBNAIL_MANAGER_H
 
+#include <atomic>
 #include <condition_variable>
+#include <functional>
 #include <list>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include "image_type.h"
 #include "napi/native_api.h"
 #include "nocopyable.h"
 #include "safe_map.h"
-#include "safe_queue.h"
 #include "pixel_map.h"
 #include "userfile_manager_types.h"
 
 namespace OHOS {
+namespace AbilityRuntime {
+class EnvironmentCallback;
+} // AbilityRuntime
 namespace Media {
 class ThumbnailRequest;
 class ThumbnailManager;
@@ -50,6 +56,38 @@ struct RequestPhotoParams {
     std::string path;
     Size size;
     RequestPhotoType type;
+    int64_t dateModified = 0;
+    int32_t priority = 0;
+};
+
+// the values are the memory levels the application context reports to OnMemoryLevel
+enum class ThumbnailCacheTrimLevel : int32_t {
+    // keep the most recent half of the cache
+    TRIM_MODERATE = 0,
+    // keep the most recent quarter of the cache
+    TRIM_LOW,
+    // drop everything
+    TRIM_CRITICAL,
+};
+
+struct ThumbnailRequestStats {
+    uint64_t requests = 0;
+    // requests js removed, whether or not they were still queued
+    uint64_t removed = 0;
+    // requests removed while still queued, they never reach a decode thread
+    uint64_t dropped = 0;
+    // time from AddPhotoRequest to the first image handed to js, in milliseconds
+    uint64_t firstImages = 0;
+    int64_t totalFirstImageTime = 0;
+    int64_t maxFirstImageTime = 0;
+};
+
+struct ThumbnailCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    size_t bytes = 0;
+    size_t count = 0;
 };
 
 class ThumbnailCallback {
@@ -93,6 +131,48 @@ public:
         return requestSize_;
     }
 
+    int64_t GetDateModified() const
+    {
+        return dateModified_;
+    }
+
+    int32_t GetPriority() const
+    {
+        return priority_.load();
+    }
+
+    void SetPriority(int32_t priority)
+    {
+        priority_.store(priority);
+    }
+
+    uint64_t GetSequence() const
+    {
+        return sequence_;
+    }
+
+    int64_t GetRequestTime() const
+    {
+        return requestTime_;
+    }
+
+    // true only for the first image handed to js
+    bool MarkImageNotified()
+    {
+        return !imageNotified_.exchange(true);
+    }
+
+    // a request the batch open could not serve is opened alone from then on
+    void SkipBatch()
+    {
+        isBatchSkipped_.store(true);
+    }
+
+    bool IsBatchSkipped() const
+    {
+        return isBatchSkipped_.load();
+    }
+
     PixelMapPtr GetPixelMap()
     {
         return std::move(pixelMap);
@@ -129,6 +209,12 @@ private:
     std::string uri_;
     std::string path_;
     Size requestSize_;
+    int64_t dateModified_;
+    std::atomic<int32_t> priority_;
+    uint64_t sequence_;
+    int64_t requestTime_;
+    std::atomic<bool> imageNotified_ = false;
+    std::atomic<bool> isBatchSkipped_ = false;
     ThumbnailStatus status_ = ThumbnailStatus::THUMB_INITIAL;
     std::mutex mutex_;
     std::string uuid_;
@@ -137,6 +223,27 @@ private:
     PixelMapPtr pixelMap;
 };
 
+/**
+ * Queue of pending requests that hands out the request with the highest priority first, and the newest one among
+ * equal priorities, since while scrolling the newest requests belong to the cells that just came into view.
+ * Priorities may change while requests wait, and requests removed meanwhile are dropped on Pop without decoding.
+ */
+class ThumbnailRequestQueue {
+public:
+    void Push(const RequestSharedPtr &request);
+    bool Pop(RequestSharedPtr &request);
+    // pops up to maxCount more requests that match, in the order Pop would hand them out
+    void PopBatch(const std::function<bool(const RequestSharedPtr &)> &match, size_t maxCount,
+        std::vector<RequestSharedPtr> &requests);
+    bool Empty();
+    uint64_t GetDroppedCount();
+
+private:
+    std::mutex mutex_;
+    std::list<RequestSharedPtr> queue_;
+    uint64_t dropped_ = 0;
+};
+
 class MMapFdPtr {
 public:
     explicit MMapFdPtr(int32_t fd);
@@ -145,13 +252,45 @@ public:
     off_t GetFdSize();
     bool IsValid();
 private:
-    void* fdPtr_;
-    off_t size_;
+    void* fdPtr_ = nullptr;
+    off_t size_ = 0;
     bool isValid_ = false;
 };
 
+/**
+ * Decoded thumbnails kept in memory, keyed by uri, size and date_modified so that an edited asset never hits a
+ * stale entry. Entries are least recently used first out once the cached bytes pass the budget, and callers always
+ * get their own copy so that a PixelMap handed to js can not change what is cached.
+ */
+class ThumbnailCache : NoCopyable {
+public:
+    explicit ThumbnailCache(size_t maxBytes);
+    ~ThumbnailCache() = default;
+
+    static std::string GetKey(const std::string &uri, const Size &size, int64_t dateModified);
+    PixelMapPtr Get(const std::string &key);
+    void Put(const std::string &key, PixelMap &pixelMap);
+    void Trim(ThumbnailCacheTrimLevel level);
+    ThumbnailCacheStats GetStats();
+
+private:
+    using CacheEntry = std::pair<std::string, std::shared_ptr<PixelMap>>;
+    void EvictLocked(size_t maxBytes);
+
+    std::mutex mutex_;
+    std::list<CacheEntry> lruList_;
+    std::unordered_map<std::string, std::list<CacheEntry>::iterator> lruMap_;
+    size_t maxBytes_;
+    ThumbnailCacheStats stats_;
+};
+
 constexpr int FAST_THREAD_NUM = 3;
 constexpr int THREAD_NUM = 2;
+// requests fetched with one batch open when their thumbnails are not readable in the sandbox
+constexpr size_t THUMBNAIL_BATCH_REQUEST_COUNT = 64;
+constexpr size_t THUMBNAIL_CACHE_MAX_BYTES = 32 * 1024 * 1024;
+// the request stats are logged every this many removed requests, about a few screens of a scrolled grid
+constexpr uint64_t THUMBNAIL_STATS_LOG_INTERVAL = 256;
 class ThumbnailManager : NoCopyable {
 public:
     virtual ~ThumbnailManager();
@@ -160,23 +299,38 @@ public:
     void Init();
     std::string AddPhotoRequest(const RequestPhotoParams &params, napi_env env, napi_ref callback);
     void RemovePhotoRequest(const std::string &requestId);
+    void UpdatePhotoRequestPriority(const std::string &requestId, int32_t priority);
+    void RecordImageNotified(const RequestSharedPtr &request);
+    ThumbnailRequestStats GetRequestStats();
     static std::unique_ptr<PixelMap> QueryThumbnail(const std::string &uri, const Size &size,
         const std::string &path);
     void DeleteRequestIdFromMap(const std::string &requestId);
+    void TrimCache(ThumbnailCacheTrimLevel level);
+    ThumbnailCacheStats GetCacheStats();
+    void OnMemoryLevel(int32_t level);
 private:
-    ThumbnailManager() = default;
+    ThumbnailManager() : cache_(THUMBNAIL_CACHE_MAX_BYTES) {}
     void FastImageWorker(int num);
     void DealWithFastRequest(const RequestSharedPtr &request);
     void QualityImageWorker(int num);
+    void DealWithQualityRequest(const RequestSharedPtr &request);
+    bool DealWithBatchRequest(const RequestSharedPtr &request);
+    static void QueryThumbnailBatch(const std::vector<RequestSharedPtr> &requests, const Size &size,
+        std::vector<PixelMapPtr> &pixelMaps);
+    static void DecodeThumbnailBatch(int32_t fd, const std::vector<std::string> &ids, const Size &size,
+        std::vector<PixelMapPtr> &pixelMaps);
+    void NotifyQualityImage(const RequestSharedPtr &request, PixelMapPtr pixelMap);
     void AddFastPhotoRequest(const RequestSharedPtr &request);
     void AddQualityPhotoRequest(const RequestSharedPtr &request);
     void AddNewQualityPhotoRequest(const RequestSharedPtr &request);
     bool NotifyImage(const RequestSharedPtr &request, bool isFastImage);
     bool RequestFastImage(const RequestSharedPtr &request);
+    bool DealWithCachedRequest(const RequestSharedPtr &request);
+    void LogRequestStats();
 
     SafeMap<std::string, RequestSharedPtr> thumbRequest_;
-    SafeQueue<RequestSharedPtr> fastQueue_;
-    SafeQueue<RequestSharedPtr> qualityQueue_;
+    ThumbnailRequestQueue fastQueue_;
+    ThumbnailRequestQueue qualityQueue_;
 
     std::mutex fastLock_;
     std::condition_variable fastCv_;
@@ -184,6 +338,10 @@ private:
     std::condition_variable qualityCv_;
     std::vector<std::thread> fastThreads_;
     std::vector<std::thread> threads_;
+    ThumbnailCache cache_;
+    std::shared_ptr<AbilityRuntime::EnvironmentCallback> memoryCallback_;
+    std::mutex statsLock_;
+    ThumbnailRequestStats stats_;
 
     static std::shared_ptr<ThumbnailManager> instance_;
     static std::mutex mutex_;